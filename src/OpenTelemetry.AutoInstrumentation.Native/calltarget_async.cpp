@@ -0,0 +1,266 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_async.h"
+
+#include <cstring>
+
+#include "calltarget_tokens.h"
+
+namespace trace
+{
+
+const auto AsyncStateMachineAttributeTypeName = WStr("System.Runtime.CompilerServices.AsyncStateMachineAttribute");
+const auto AsyncStateMachineMoveNextName      = WStr("MoveNext");
+const auto AsyncStateMachineBuilderFieldName  = WStr("<>t__builder");
+
+const auto TaskTypeName               = WStr("System.Threading.Tasks.Task");
+const auto TaskWithResultTypeName     = WStr("System.Threading.Tasks.Task`1");
+const auto ValueTaskTypeName          = WStr("System.Threading.Tasks.ValueTask");
+const auto ValueTaskWithResultTypeName = WStr("System.Threading.Tasks.ValueTask`1");
+
+namespace
+{
+    // GetAsyncResult checks that the return type is a Task or a ValueTask and finds the signature of its result.
+    bool GetAsyncResult(const ComPtr<IMetaDataImport2>& metadata_import, const FunctionInfo& kickoff,
+                        CallTargetAsyncStateMachine* state_machine)
+    {
+        PCCOR_SIGNATURE signature        = nullptr;
+        const auto      signature_length = kickoff.method_signature.GetRet().GetSignature(signature);
+        if (signature == nullptr || signature_length < 2)
+        {
+            return false;
+        }
+
+        const bool with_result = signature[0] == ELEMENT_TYPE_GENERICINST;
+        auto       type_signature = with_result ? signature + 1 : signature;
+        if (type_signature[0] != ELEMENT_TYPE_CLASS && type_signature[0] != ELEMENT_TYPE_VALUETYPE)
+        {
+            return false;
+        }
+
+        mdToken    type_token = mdTokenNil;
+        const auto token_size = CorSigUncompressToken(type_signature + 1, &type_token);
+        const auto type_name  = GetTypeInfo(metadata_import, type_token).name;
+        if (!with_result)
+        {
+            return type_name == TaskTypeName || type_name == ValueTaskTypeName;
+        }
+
+        // GENERICINST, CLASS or VALUETYPE, the type token, the number of generic arguments, and the result type.
+        const auto result_offset = 2 + token_size + 1;
+        if ((type_name != TaskWithResultTypeName && type_name != ValueTaskWithResultTypeName) ||
+            type_signature[1 + token_size] != 1 || result_offset >= signature_length)
+        {
+            return false;
+        }
+        state_machine->result_signature        = signature + result_offset;
+        state_machine->result_signature_length = signature_length - result_offset;
+        return true;
+    }
+
+    // GetStateMachineTypeName reads the type argument of the AsyncStateMachineAttribute.
+    bool GetStateMachineTypeName(const ComPtr<IMetaDataImport2>& metadata_import, mdMethodDef method_def,
+                                 WSTRING* type_name)
+    {
+        const void* data      = nullptr;
+        ULONG       data_size = 0;
+        auto hr = metadata_import->GetCustomAttributeByName(method_def, AsyncStateMachineAttributeTypeName, &data,
+                                                            &data_size);
+        if (hr != S_OK || data_size < 3)
+        {
+            return false;
+        }
+
+        // Prolog 0x0001 followed by the type name as a SerString: its compressed length and UTF8 characters.
+        const auto blob = static_cast<PCCOR_SIGNATURE>(data);
+        if (blob[0] != 0x01 || blob[1] != 0x00 || blob[2] == 0xFF)
+        {
+            return false;
+        }
+
+        ULONG      name_length = 0;
+        const auto length_size = CorSigUncompressData(blob + 2, &name_length);
+        if (2 + length_size + name_length > data_size)
+        {
+            return false;
+        }
+
+        std::string name(reinterpret_cast<const char*>(blob + 2 + length_size), name_length);
+        // The state machine is defined in the same assembly, the name is not assembly qualified.
+        *type_name = ToWSTRING(name.substr(0, name.find(',')));
+        return true;
+    }
+
+    mdFieldDef FindField(const ComPtr<IMetaDataImport2>& metadata_import, mdTypeDef type_def, const WSTRING& name)
+    {
+        mdFieldDef field_def  = mdFieldDefNil;
+        HCORENUM   enumerator = nullptr;
+        ULONG      count      = 0;
+        auto hr = metadata_import->EnumFieldsWithName(&enumerator, type_def, name.c_str(), &field_def, 1, &count);
+        metadata_import->CloseEnum(enumerator);
+        return hr == S_OK && count > 0 ? field_def : mdFieldDefNil;
+    }
+
+    HRESULT FindOrDefineField(ModuleMetadata* module_metadata, mdTypeDef type_def, const WSTRING& name,
+                              PCCOR_SIGNATURE signature, ULONG signature_length, mdFieldDef* field_def)
+    {
+        // A method instrumented by several integrations is prepared once per integration.
+        *field_def = FindField(module_metadata->metadata_import, type_def, name);
+        if (*field_def != mdFieldDefNil)
+        {
+            return S_OK;
+        }
+        return module_metadata->metadata_emit->DefineField(type_def, name.c_str(), fdPublic, signature,
+                                                           signature_length, ELEMENT_TYPE_VOID, nullptr, 0,
+                                                           field_def);
+    }
+} // namespace
+
+HRESULT FindAsyncStateMachine(ModuleMetadata* module_metadata, const FunctionInfo& kickoff,
+                              CallTargetAsyncStateMachine* state_machine)
+{
+    const auto& metadata_import = module_metadata->metadata_import;
+
+    // The instance of a value type can't be kept in the state machine, and the state machines of generic types and
+    // methods are generic too.
+    bool is_generic = kickoff.type.type_spec != mdTypeSpecNil ||
+                      (kickoff.method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_GENERIC) != 0;
+    for (const TypeInfo* type = &kickoff.type; type != nullptr; type = type->parent_type.get())
+    {
+        is_generic |= type->isGeneric;
+    }
+    if (is_generic || kickoff.type.valueType || !GetAsyncResult(metadata_import, kickoff, state_machine))
+    {
+        return S_FALSE;
+    }
+
+    WSTRING type_name;
+    if (!GetStateMachineTypeName(metadata_import, kickoff.id, &type_name))
+    {
+        return S_FALSE;
+    }
+
+    if (!FindTypeDefByName(type_name, module_metadata->assemblyName, metadata_import, state_machine->type_def))
+    {
+        return S_FALSE;
+    }
+
+    HCORENUM enumerator = nullptr;
+    ULONG    count      = 0;
+    auto     hr = metadata_import->EnumMethodsWithName(&enumerator, state_machine->type_def,
+                                                       AsyncStateMachineMoveNextName, &state_machine->move_next_def, 1,
+                                                       &count);
+    metadata_import->CloseEnum(enumerator);
+    if (hr != S_OK || count == 0)
+    {
+        return S_FALSE;
+    }
+
+    state_machine->builder_field_def =
+        FindField(metadata_import, state_machine->type_def, AsyncStateMachineBuilderFieldName);
+    if (state_machine->builder_field_def == mdFieldDefNil)
+    {
+        return S_FALSE;
+    }
+
+    state_machine->value_type = GetTypeInfo(metadata_import, state_machine->type_def).valueType;
+    return S_OK;
+}
+
+HRESULT DefineAsyncStateMachineFields(ModuleMetadata* module_metadata, const FunctionInfo& kickoff,
+                                      CallTargetAsyncStateMachine* state_machine)
+{
+    const auto state_type_ref = module_metadata->GetCallTargetTokens()->GetTargetStateTypeRef();
+    if (state_type_ref == mdTypeRefNil)
+    {
+        return E_FAIL;
+    }
+
+    COR_SIGNATURE signature[2 + sizeof(mdToken)];
+    ULONG         offset = 0;
+    signature[offset++]  = IMAGE_CEE_CS_CALLCONV_FIELD;
+    signature[offset++]  = ELEMENT_TYPE_VALUETYPE;
+    offset += CorSigCompressToken(state_type_ref, &signature[offset]);
+
+    auto hr = FindOrDefineField(module_metadata, state_machine->type_def, AsyncStateMachineStateFieldName, signature,
+                                offset, &state_machine->state_field_def);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const bool is_static = !(kickoff.method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS);
+    if (is_static)
+    {
+        return S_OK;
+    }
+
+    offset              = 0;
+    signature[offset++] = IMAGE_CEE_CS_CALLCONV_FIELD;
+    signature[offset++] = ELEMENT_TYPE_CLASS;
+    offset += CorSigCompressToken(kickoff.type.id, &signature[offset]);
+
+    return FindOrDefineField(module_metadata, state_machine->type_def, AsyncStateMachineInstanceFieldName, signature,
+                             offset, &state_machine->instance_field_def);
+}
+
+bool IsAsyncBuilderMember(const ComPtr<IMetaDataImport2>& metadata_import,
+                          const CallTargetAsyncStateMachine& state_machine, mdToken member, const WSTRING& name)
+{
+    // Start<TStateMachine> is a generic method.
+    if (TypeFromToken(member) == mdtMethodSpec &&
+        FAILED(metadata_import->GetMethodSpecProps(member, &member, nullptr, nullptr)))
+    {
+        return false;
+    }
+    if (TypeFromToken(member) != mdtMemberRef)
+    {
+        return false;
+    }
+
+    mdToken         parent = mdTokenNil;
+    WCHAR           member_name[kNameMaxSize]{};
+    ULONG           member_name_length = 0;
+    PCCOR_SIGNATURE member_signature   = nullptr;
+    ULONG           member_signature_length = 0;
+    auto hr = metadata_import->GetMemberRefProps(member, &parent, member_name, kNameMaxSize, &member_name_length,
+                                                 &member_signature, &member_signature_length);
+    if (FAILED(hr) || name != member_name)
+    {
+        return false;
+    }
+
+    PCCOR_SIGNATURE field_signature        = nullptr;
+    ULONG           field_signature_length = 0;
+    hr = metadata_import->GetFieldProps(state_machine.builder_field_def, nullptr, nullptr, 0, nullptr, nullptr,
+                                        &field_signature, &field_signature_length, nullptr, nullptr, nullptr);
+    if (FAILED(hr) || field_signature_length < 2)
+    {
+        return false;
+    }
+
+    // The builder is the type of the field, after the FIELD calling convention.
+    const auto builder_signature        = field_signature + 1;
+    const auto builder_signature_length = field_signature_length - 1;
+    if (TypeFromToken(parent) == mdtTypeSpec)
+    {
+        PCCOR_SIGNATURE type_spec_signature        = nullptr;
+        ULONG           type_spec_signature_length = 0;
+        hr = metadata_import->GetTypeSpecFromToken(parent, &type_spec_signature, &type_spec_signature_length);
+        return SUCCEEDED(hr) && type_spec_signature_length == builder_signature_length &&
+               memcmp(type_spec_signature, builder_signature, builder_signature_length) == 0;
+    }
+
+    if (builder_signature[0] != ELEMENT_TYPE_VALUETYPE && builder_signature[0] != ELEMENT_TYPE_CLASS)
+    {
+        return false;
+    }
+    mdToken builder_type = mdTokenNil;
+    CorSigUncompressToken(builder_signature + 1, &builder_type);
+    return builder_type == parent;
+}
+
+} // namespace trace
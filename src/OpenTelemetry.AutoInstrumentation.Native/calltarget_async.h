@@ -0,0 +1,74 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_ASYNC_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_ASYNC_H_
+
+#include <corhlpr.h>
+
+#include "clr_helpers.h"
+#include "com_ptr.h"
+#include "module_metadata.h"
+
+namespace trace
+{
+
+// Names of the fields added to the async state machines to hand the BeginMethod results from the kickoff method
+// to MoveNext.
+const auto AsyncStateMachineStateFieldName    = WStr("<>otel__state");
+const auto AsyncStateMachineInstanceFieldName = WStr("<>otel__instance");
+
+// Compiler-generated state machine of an async method.
+struct CallTargetAsyncStateMachine
+{
+    mdTypeDef type_def = mdTypeDefNil;
+    mdMethodDef move_next_def = mdMethodDefNil;
+    mdFieldDef builder_field_def = mdFieldDefNil;
+    // The state machines are structs in the release builds and classes in the debug builds.
+    bool value_type = false;
+
+    // Signature of the T of a Task<T> or ValueTask<T>, null for a Task or ValueTask.
+    PCCOR_SIGNATURE result_signature = nullptr;
+    ULONG result_signature_length = 0;
+
+    // Fields defined by DefineAsyncStateMachineFields, the instance field is not defined for the static methods.
+    mdFieldDef state_field_def = mdFieldDefNil;
+    mdFieldDef instance_field_def = mdFieldDefNil;
+};
+
+// The methods rewritten for an async method instrumented through its state machine.
+enum class CallTargetAsyncMethodPart
+{
+    // The method called by the application: it calls BeginMethod and stores the state in the state machine.
+    KickOff,
+    // The MoveNext of the state machine: it calls EndAsyncMethod before the builder completes the task.
+    MoveNext
+};
+
+struct CallTargetAsyncMethod
+{
+    CallTargetAsyncMethodPart part;
+    FunctionInfo kickoff;
+    CallTargetAsyncStateMachine state_machine;
+};
+
+// FindAsyncStateMachine reads the AsyncStateMachineAttribute of an async method returning a Task, Task<T>,
+// ValueTask or ValueTask<T>. It returns S_FALSE for the other methods and for the methods of generic or value types,
+// whose state machines can't be rewritten without their exact instantiation.
+HRESULT FindAsyncStateMachine(ModuleMetadata* module_metadata, const FunctionInfo& kickoff,
+                              CallTargetAsyncStateMachine* state_machine);
+
+// DefineAsyncStateMachineFields adds the CallTarget state and instance fields to the state machine. Fields can only
+// be added to types that are not loaded yet, so this must be called while the module is loading.
+HRESULT DefineAsyncStateMachineFields(ModuleMetadata* module_metadata, const FunctionInfo& kickoff,
+                                      CallTargetAsyncStateMachine* state_machine);
+
+// IsAsyncBuilderMember returns true if the member is a method of the builder of the state machine.
+bool IsAsyncBuilderMember(const ComPtr<IMetaDataImport2>& metadata_import,
+                          const CallTargetAsyncStateMachine& state_machine, mdToken member, const WSTRING& name);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_ASYNC_H_
@@ -0,0 +1,348 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_callsite.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include "il_rewriter_wrapper.h"
+#include "logger.h"
+
+namespace trace
+{
+
+namespace
+{
+    bool IsInstanceTarget(const FunctionInfo& target)
+    {
+        return (target.method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS) != 0;
+    }
+
+    bool IsVersionInRange(const MethodReference& target_method, const Version& version)
+    {
+        return !(target_method.min_version > version) && !(target_method.max_version < version);
+    }
+
+    // Returns the memberRefs of a type referenced by the module with the given name.
+    std::vector<mdToken> FindMemberRefs(const ComPtr<IMetaDataImport2>& metadata_import, mdTypeRef type_ref,
+                                        const WSTRING& name)
+    {
+        std::vector<mdToken> member_refs;
+        auto                 enumMemberRefs = Enumerator<mdMemberRef>(
+            [metadata_import, type_ref](HCORENUM* ptr, mdMemberRef arr[], ULONG max, ULONG* cnt) -> HRESULT {
+                return metadata_import->EnumMemberRefs(ptr, type_ref, arr, max, cnt);
+            },
+            [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
+
+        for (const auto member_ref : enumMemberRefs)
+        {
+            WCHAR member_name[kNameMaxSize]{};
+            ULONG member_name_len = 0;
+            if (SUCCEEDED(metadata_import->GetMemberRefProps(member_ref, nullptr, member_name, kNameMaxSize,
+                                                             &member_name_len, nullptr, nullptr)) &&
+                name == member_name)
+            {
+                member_refs.push_back(member_ref);
+            }
+        }
+        return member_refs;
+    }
+
+    // Returns the methods of a type defined by the module with the given name.
+    std::vector<mdToken> FindMethodDefs(const ComPtr<IMetaDataImport2>& metadata_import, mdTypeDef type_def,
+                                        const WSTRING& name)
+    {
+        std::vector<mdToken> method_defs;
+        auto                 enumMethods = Enumerator<mdMethodDef>(
+            [metadata_import, type_def, name](HCORENUM* ptr, mdMethodDef arr[], ULONG max, ULONG* cnt) -> HRESULT {
+                return metadata_import->EnumMethodsWithName(ptr, type_def, name.c_str(), arr, max, cnt);
+            },
+            [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
+
+        for (const auto method_def : enumMethods)
+        {
+            method_defs.push_back(method_def);
+        }
+        return method_defs;
+    }
+} // namespace
+
+std::vector<FunctionInfo> FindCallSiteTargets(const ComPtr<IMetaDataImport2>&         metadata_import,
+                                              const ComPtr<IMetaDataAssemblyImport>& assembly_import,
+                                              const WSTRING& assembly_name, const MethodReference& target_method)
+{
+    std::vector<mdToken> tokens;
+    if (target_method.assembly.name == assembly_name)
+    {
+        // The calls of a method of the same module use its methodDef.
+        mdTypeDef type_def = mdTypeDefNil;
+        if (IsVersionInRange(target_method, GetAssemblyImportMetadata(assembly_import).version) &&
+            FindTypeDefByName(target_method.type_name, assembly_name, metadata_import, type_def))
+        {
+            tokens = FindMethodDefs(metadata_import, type_def, target_method.method_name);
+        }
+    }
+    else
+    {
+        for (const auto type_ref : EnumTypeRefs(metadata_import))
+        {
+            mdToken resolution_scope = mdTokenNil;
+            WCHAR   type_name[kNameMaxSize]{};
+            ULONG   type_name_len = 0;
+            if (FAILED(metadata_import->GetTypeRefProps(type_ref, &resolution_scope, type_name, kNameMaxSize,
+                                                        &type_name_len)) ||
+                TypeFromToken(resolution_scope) != mdtAssemblyRef || target_method.type_name != type_name)
+            {
+                continue;
+            }
+
+            // The version range applies to the referenced assembly, the one the caller was compiled against.
+            const auto assembly = GetReferencedAssemblyMetadata(assembly_import, resolution_scope);
+            if (assembly.name != target_method.assembly.name || !IsVersionInRange(target_method, assembly.version))
+            {
+                continue;
+            }
+
+            for (const auto member_ref : FindMemberRefs(metadata_import, type_ref, target_method.method_name))
+            {
+                tokens.push_back(member_ref);
+            }
+        }
+    }
+
+    std::vector<FunctionInfo> targets;
+    for (const auto token : tokens)
+    {
+        auto target = GetFunctionInfo(metadata_import, token);
+        if (!target.IsValid() || FAILED(target.method_signature.TryParse()))
+        {
+            continue;
+        }
+
+        const auto calling_convention = target.method_signature.CallingConvention();
+        if ((calling_convention & (IMAGE_CEE_CS_CALLCONV_GENERIC | IMAGE_CEE_CS_CALLCONV_EXPLICITTHIS)) != 0 ||
+            (calling_convention & IMAGE_CEE_CS_CALLCONV_MASK) == IMAGE_CEE_CS_CALLCONV_VARARG ||
+            target.type.type_spec != mdTypeSpecNil || target.type.isGeneric ||
+            (target.type.valueType && IsInstanceTarget(target)))
+        {
+            Logger::Debug("FindCallSiteTargets: the calls of ", target.type.name, ".", target.name,
+                          "() can't be replaced by a call-site wrapper.");
+            continue;
+        }
+
+        if (CallTarget_GetArgumentsRejection(metadata_import, target_method, target).empty())
+        {
+            targets.push_back(target);
+        }
+    }
+    return targets;
+}
+
+bool IsCallSiteCallerType(const TypeInfo& type, const MethodReference& caller_method)
+{
+    if (caller_method.type_name.empty())
+    {
+        return true;
+    }
+
+    for (const TypeInfo* enclosing_type = &type; enclosing_type != nullptr;
+         enclosing_type                 = enclosing_type->parent_type.get())
+    {
+        if (enclosing_type->name == caller_method.type_name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MayCallCallSiteTargets(LPCBYTE body, const std::vector<FunctionInfo>& targets)
+{
+    COR_ILMETHOD_DECODER decoder(reinterpret_cast<const COR_ILMETHOD*>(body));
+    const auto           code      = decoder.Code;
+    const auto           code_size = decoder.GetCodeSize();
+    for (unsigned offset = 0; offset + 1 + sizeof(mdToken) <= code_size; offset++)
+    {
+        if (code[offset] != CEE_CALL && code[offset] != CEE_CALLVIRT)
+        {
+            continue;
+        }
+
+        mdToken token;
+        memcpy(&token, &code[offset + 1], sizeof(mdToken));
+        for (const auto& target : targets)
+        {
+            if (target.id == token)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MatchCallSiteCallers(ICorProfilerInfo* info, ModuleID module_id, ModuleMetadata* module_metadata,
+                          const std::vector<IntegrationMethod>& integrations,
+                          std::vector<CallTargetMethodMatch>& matches)
+{
+    const auto& metadata_import = module_metadata->metadata_import;
+    const auto& assembly_name   = module_metadata->assemblyName;
+
+    // The methods already matched keep their rewrite, a method only has one.
+    std::unordered_set<mdMethodDef> matched_methods;
+    for (const auto& match : matches)
+    {
+        matched_methods.insert(match.method_def);
+    }
+
+    for (const IntegrationMethod& integration : integrations)
+    {
+        const auto& replacement = integration.replacement;
+        if (replacement.integration_kind != IntegrationKind::CallSite ||
+            replacement.caller_method.assembly.name != assembly_name)
+        {
+            continue;
+        }
+
+        const auto targets = FindCallSiteTargets(metadata_import, module_metadata->assembly_import, assembly_name,
+                                                 replacement.target_method);
+        if (targets.empty())
+        {
+            continue;
+        }
+
+        for (const auto type_def : EnumTypeDefs(metadata_import))
+        {
+            if (!IsCallSiteCallerType(GetTypeInfo(metadata_import, type_def), replacement.caller_method))
+            {
+                continue;
+            }
+
+            const auto& method_name = replacement.caller_method.method_name;
+            auto        enumMethods = Enumerator<mdMethodDef>(
+                [metadata_import, type_def, method_name](HCORENUM* ptr, mdMethodDef arr[], ULONG max,
+                                                         ULONG* cnt) -> HRESULT {
+                    return method_name.empty()
+                               ? metadata_import->EnumMethods(ptr, type_def, arr, max, cnt)
+                               : metadata_import->EnumMethodsWithName(ptr, type_def, method_name.c_str(), arr, max,
+                                                                      cnt);
+                },
+                [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
+
+            for (const auto method_def : enumMethods)
+            {
+                // Most methods don't call the targets, their bodies are scanned before being imported.
+                LPCBYTE body = nullptr;
+                if (matched_methods.find(method_def) != matched_methods.end() ||
+                    FAILED(info->GetILFunctionBody(module_id, method_def, &body, nullptr)) || body == nullptr ||
+                    !MayCallCallSiteTargets(body, targets))
+                {
+                    continue;
+                }
+
+                // The calls are replaced in a copy of the body, as the rewrite of the method is going to do.
+                ILRewriter rewriter(method_def);
+                if (FAILED(rewriter.Import(body)))
+                {
+                    continue;
+                }
+                ILRewriterWrapper rewriter_wrapper(&rewriter);
+                bool              calls_target = false;
+                for (const auto& target : targets)
+                {
+                    calls_target |=
+                        rewriter_wrapper.ReplaceMethodCalls(target.id, mdMemberRefNil, IsInstanceTarget(target));
+                }
+                if (!calls_target)
+                {
+                    continue;
+                }
+
+                auto caller = GetFunctionInfo(metadata_import, method_def);
+                if (!caller.IsValid() || FAILED(caller.method_signature.TryParse()) ||
+                    !CallTarget_IsTargetAllowed(assembly_name, caller.type.name, caller.name))
+                {
+                    continue;
+                }
+
+                matched_methods.insert(method_def);
+                matches.push_back({&integration, method_def, caller});
+            }
+        }
+    }
+}
+
+HRESULT GetCallSiteWrapperSignature(const FunctionInfo& target, std::vector<BYTE>& signature)
+{
+    const auto& data = target.signature.data;
+    const auto  ret  = target.method_signature.GetRet();
+    if (data.empty() || ret.offset + ret.length > data.size())
+    {
+        return E_FAIL;
+    }
+
+    const bool is_instance    = IsInstanceTarget(target);
+    const auto argument_count = target.method_signature.NumberOfArguments() + (is_instance ? 1 : 0);
+
+    COR_SIGNATURE buffer[sizeof(mdToken) + 1];
+    signature.clear();
+    signature.push_back(IMAGE_CEE_CS_CALLCONV_DEFAULT);
+    signature.insert(signature.end(), buffer, buffer + CorSigCompressData(argument_count, buffer));
+    signature.insert(signature.end(), data.begin() + ret.offset, data.begin() + ret.offset + ret.length);
+    if (is_instance)
+    {
+        // The instance of a reference type is passed as the first argument.
+        signature.push_back(ELEMENT_TYPE_CLASS);
+        signature.insert(signature.end(), buffer, buffer + CorSigCompressToken(target.type.id, buffer));
+    }
+    signature.insert(signature.end(), data.begin() + ret.offset + ret.length, data.end());
+    return S_OK;
+}
+
+HRESULT RewriteCallSites(ILRewriter* rewriter, ModuleMetadata* module_metadata,
+                         const MethodReplacement& method_replacement, mdTypeRef wrapper_type_ref)
+{
+    const auto& wrapper_method = method_replacement.wrapper_method;
+    const auto& wrapper_method_name =
+        wrapper_method.method_name.empty() ? method_replacement.target_method.method_name : wrapper_method.method_name;
+
+    ILRewriterWrapper rewriter_wrapper(rewriter);
+    bool              replaced = false;
+    for (const auto& target : FindCallSiteTargets(module_metadata->metadata_import, module_metadata->assembly_import,
+                                                  module_metadata->assemblyName, method_replacement.target_method))
+    {
+        std::vector<BYTE> signature;
+        auto              hr = GetCallSiteWrapperSignature(target, signature);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        mdMemberRef wrapper_method_ref = mdMemberRefNil;
+        hr = module_metadata->metadata_import->FindMemberRef(wrapper_type_ref, wrapper_method_name.c_str(),
+                                                             signature.data(), static_cast<ULONG>(signature.size()),
+                                                             &wrapper_method_ref);
+        if (hr == CLDB_E_RECORD_NOTFOUND)
+        {
+            hr = module_metadata->metadata_emit->DefineMemberRef(wrapper_type_ref, wrapper_method_name.c_str(),
+                                                                 signature.data(),
+                                                                 static_cast<ULONG>(signature.size()),
+                                                                 &wrapper_method_ref);
+        }
+        if (FAILED(hr))
+        {
+            Logger::Warn("RewriteCallSites: the wrapper method ", wrapper_method.type_name, ".", wrapper_method_name,
+                         "() could not be referenced, HR=", HResultStr(hr));
+            return hr;
+        }
+
+        replaced |= rewriter_wrapper.ReplaceMethodCalls(target.id, wrapper_method_ref, IsInstanceTarget(target));
+    }
+
+    return replaced ? S_OK : S_FALSE;
+}
+
+} // namespace trace
@@ -0,0 +1,55 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_CALLSITE_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_CALLSITE_H_
+
+#include <corhlpr.h>
+#include <corprof.h>
+#include <vector>
+
+#include "calltarget_planner.h"
+#include "clr_helpers.h"
+#include "il_rewriter.h"
+#include "module_metadata.h"
+
+namespace trace
+{
+
+// FindCallSiteTargets returns the methods of a caller module, memberRefs or methodDefs, that reference the target
+// method of a call-site integration. The generic methods, the methods of the generic types and of the value types are
+// skipped, their calls can't be passed to a static wrapper method.
+std::vector<FunctionInfo> FindCallSiteTargets(const ComPtr<IMetaDataImport2>&         metadata_import,
+                                              const ComPtr<IMetaDataAssemblyImport>& assembly_import,
+                                              const WSTRING& assembly_name, const MethodReference& target_method);
+
+// IsCallSiteCallerType returns true if the methods of a type are selected by the caller of a call-site integration. A
+// caller type also selects the types nested in it, e.g. its lambdas and async state machines, the methods are then
+// selected by the caller method name if there is one.
+bool IsCallSiteCallerType(const TypeInfo& type, const MethodReference& caller_method);
+
+// MayCallCallSiteTargets returns false if the code of a method body has no call or callvirt followed by the token of
+// one of the targets, a byte scan much cheaper than importing the body. It may return true for a body that doesn't
+// call them, e.g. when the bytes are part of another instruction.
+bool MayCallCallSiteTargets(LPCBYTE body, const std::vector<FunctionInfo>& targets);
+
+// MatchCallSiteCallers finds the methods of a module, selected by the caller of a call-site integration, that call
+// its target method. A method is only rewritten for the first call-site integration it matches.
+void MatchCallSiteCallers(ICorProfilerInfo* info, ModuleID module_id, ModuleMetadata* module_metadata,
+                          const std::vector<IntegrationMethod>& integrations,
+                          std::vector<CallTargetMethodMatch>& matches);
+
+// GetCallSiteWrapperSignature returns the signature of the wrapper method called instead of a target method: a
+// static method with the arguments of the target, preceded by the instance for an instance method.
+HRESULT GetCallSiteWrapperSignature(const FunctionInfo& target, std::vector<BYTE>& signature);
+
+// RewriteCallSites replaces the calls of the target methods of a call-site integration, in the imported body of a
+// caller, by calls of the wrapper method. It returns S_FALSE if no call was replaced.
+HRESULT RewriteCallSites(ILRewriter* rewriter, ModuleMetadata* module_metadata,
+                         const MethodReplacement& method_replacement, mdTypeRef wrapper_type_ref);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_CALLSITE_H_
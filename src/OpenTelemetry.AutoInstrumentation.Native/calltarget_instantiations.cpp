@@ -0,0 +1,181 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_instantiations.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "clr_helpers.h"
+#include "logger.h"
+#include "telemetry_region.h"
+
+namespace trace
+{
+
+const WSTRING typed_policy_name     = WStr("typed");
+const WSTRING canonical_policy_name = WStr("canonical");
+
+// Name of the reference types in the canonical instantiations, as the runtime calls it.
+const WSTRING canonical_type_name = WStr("__Canon");
+
+CallTargetInstantiationPolicy ParseCallTargetInstantiationPolicy(const WSTRING& name)
+{
+    if (name == canonical_policy_name)
+    {
+        return CallTargetInstantiationPolicy::Canonical;
+    }
+    if (!name.empty() && name != typed_policy_name)
+    {
+        Logger::Warn("Unknown CallTarget instantiation policy: ", name, ", the ", typed_policy_name,
+                     " policy is used.");
+    }
+    return CallTargetInstantiationPolicy::Typed;
+}
+
+std::vector<CallTargetArgumentUse> GetCallTargetArgumentUses(const ComPtr<IMetaDataImport2>& metadata_import,
+                                                             mdTypeDef integration_type_def, ULONG arguments_count)
+{
+    std::vector<CallTargetArgumentUse> uses(arguments_count, CallTargetArgumentUse::Typed);
+
+    mdMethodDef begin_method_def = mdMethodDefNil;
+    HCORENUM    enumerator       = nullptr;
+    ULONG       count            = 0;
+    auto        hr = metadata_import->EnumMethodsWithName(&enumerator, integration_type_def, WStr("OnMethodBegin"),
+                                                          &begin_method_def, 1, &count);
+    metadata_import->CloseEnum(enumerator);
+    if (FAILED(hr))
+    {
+        return uses;
+    }
+
+    if (count == 0)
+    {
+        std::fill(uses.begin(), uses.end(), CallTargetArgumentUse::Unused);
+        return uses;
+    }
+
+    PCCOR_SIGNATURE signature        = nullptr;
+    ULONG           signature_length = 0;
+    hr = metadata_import->GetMethodProps(begin_method_def, nullptr, nullptr, 0, nullptr, nullptr, &signature,
+                                         &signature_length, nullptr, nullptr);
+    if (FAILED(hr))
+    {
+        return uses;
+    }
+
+    FunctionMethodSignature begin_method_signature(signature, signature_length);
+    if (FAILED(begin_method_signature.TryParse()))
+    {
+        return uses;
+    }
+
+    // OnMethodBegin receives the instance first, unless it only declares the arguments.
+    const auto   parameters      = begin_method_signature.GetMethodArguments();
+    const size_t first_parameter = parameters.size() == arguments_count + 1 ? 1 : 0;
+    if (parameters.size() - first_parameter != arguments_count)
+    {
+        return uses;
+    }
+
+    for (ULONG i = 0; i < arguments_count; i++)
+    {
+        PCCOR_SIGNATURE parameter_signature = nullptr;
+        parameters[first_parameter + i].GetSignature(parameter_signature);
+        if (parameter_signature[0] == ELEMENT_TYPE_OBJECT)
+        {
+            uses[i] = CallTargetArgumentUse::Untyped;
+        }
+    }
+    return uses;
+}
+
+bool SelectCallTargetArguments(const std::vector<USHORT>& argument_indices, ULONG arguments_count,
+                               ULONG max_selected_count, std::vector<ULONG>& positions)
+{
+    positions.clear();
+    if (argument_indices.size() > max_selected_count)
+    {
+        return false;
+    }
+
+    std::vector<bool> selected(arguments_count, false);
+    for (const auto index : argument_indices)
+    {
+        if (index >= arguments_count || selected[index])
+        {
+            positions.clear();
+            return false;
+        }
+        selected[index] = true;
+        positions.push_back(index);
+    }
+    return true;
+}
+
+bool CallTargetInstantiations::Add(const WSTRING&                                method_name,
+                                   const std::vector<CallTargetGenericArgument>& generic_arguments)
+{
+    WSTRING exact_instantiation     = method_name + WStr("<");
+    WSTRING canonical_instantiation = method_name + WStr("<");
+    for (size_t i = 0; i < generic_arguments.size(); i++)
+    {
+        const auto separator = i == 0 ? EmptyWStr : WSTRING(WStr(","));
+        exact_instantiation += separator + generic_arguments[i].type_name;
+        canonical_instantiation +=
+            separator + (generic_arguments[i].value_type ? generic_arguments[i].type_name : canonical_type_name);
+    }
+    exact_instantiation += WStr(">");
+    canonical_instantiation += WStr(">");
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    call_sites_++;
+    TelemetryRegion::Instance()->Add(TelemetryCounter::CallTargetInstantiations);
+    exact_instantiations_.insert(exact_instantiation);
+    if (!canonical_instantiations_.insert(canonical_instantiation).second)
+    {
+        return false;
+    }
+
+    TelemetryRegion::Instance()->Add(TelemetryCounter::CallTargetCompiledInstantiations);
+
+    if (Logger::IsDebugEnabled())
+    {
+        Logger::Debug("New CallTarget instantiation: ", canonical_instantiation);
+    }
+    return true;
+}
+
+size_t CallTargetInstantiations::ExactCount()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return exact_instantiations_.size();
+}
+
+size_t CallTargetInstantiations::CanonicalCount()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return canonical_instantiations_.size();
+}
+
+unsigned long long CallTargetInstantiations::CallSites()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return call_sites_;
+}
+
+std::string CallTargetInstantiations::ToString()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    std::stringstream ss;
+    ss << "[CallSites=" << call_sites_;
+    ss << ", Instantiations=" << exact_instantiations_.size();
+    ss << ", CompiledInstantiations=" << canonical_instantiations_.size();
+    ss << "]";
+    return ss.str();
+}
+
+} // namespace trace
@@ -0,0 +1,90 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_INSTANTIATIONS_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_INSTANTIATIONS_H_
+
+#include <corhlpr.h>
+
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "com_ptr.h"
+#include "string.h" // NOLINT
+#include "util.h"
+
+namespace trace
+{
+
+// How the CallTargetInvoker calls emitted by the rewriter pass the value-type arguments.
+enum class CallTargetInstantiationPolicy
+{
+    // Every argument is passed with its own type, each combination of value types is a new JIT instantiation
+    // of the CallTarget handlers.
+    Typed,
+    // The value-type arguments that the integration doesn't need typed are passed as System.Object, so the
+    // calls share the canonical instantiation of the reference types.
+    Canonical
+};
+
+// ParseCallTargetInstantiationPolicy converts the configured policy name, an unknown name is logged and ignored.
+CallTargetInstantiationPolicy ParseCallTargetInstantiationPolicy(const WSTRING& name);
+
+// How an integration consumes an argument of the instrumented method.
+enum class CallTargetArgumentUse
+{
+    // OnMethodBegin receives the argument with its own type or through a generic parameter.
+    Typed,
+    // OnMethodBegin receives the argument as System.Object.
+    Untyped,
+    // The integration has no OnMethodBegin, the argument is never read.
+    Unused
+};
+
+// GetCallTargetArgumentUses reads the OnMethodBegin of the integration type to find how each argument is consumed.
+// The arguments are reported as Typed when the signature doesn't match the number of arguments.
+std::vector<CallTargetArgumentUse> GetCallTargetArgumentUses(const ComPtr<IMetaDataImport2>& metadata_import,
+                                                             mdTypeDef integration_type_def, ULONG arguments_count);
+
+// SelectCallTargetArguments returns the positions of the arguments declared by an integration, in the declared order.
+// It returns false, and no position, if a declared argument doesn't exist or is declared twice, or if more than
+// max_selected_count arguments are declared.
+bool SelectCallTargetArguments(const std::vector<USHORT>& argument_indices, ULONG arguments_count,
+                               ULONG max_selected_count, std::vector<ULONG>& positions);
+
+// A generic argument of a CallTargetInvoker call.
+struct CallTargetGenericArgument
+{
+    WSTRING type_name;
+    // The value types get their own JIT instantiation, the reference types share the canonical one.
+    bool value_type;
+};
+
+// CallTargetInstantiations counts the instantiations of the CallTargetInvoker methods called by the rewritten
+// methods. Each exact instantiation initializes its own CallTarget handlers, only the instantiations that differ
+// by a value type make the JIT compile new code.
+class CallTargetInstantiations : public Singleton<CallTargetInstantiations>
+{
+private:
+    std::mutex mutex_;
+    std::unordered_set<WSTRING> exact_instantiations_;
+    std::unordered_set<WSTRING> canonical_instantiations_;
+    unsigned long long call_sites_ = 0;
+
+public:
+    // Add records a call emitted by the rewriter, it returns true if the JIT compiles a new instantiation for it.
+    bool Add(const WSTRING& method_name, const std::vector<CallTargetGenericArgument>& generic_arguments);
+
+    size_t ExactCount();
+    size_t CanonicalCount();
+    unsigned long long CallSites();
+
+    std::string ToString();
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_INSTANTIATIONS_H_
@@ -0,0 +1,100 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_outline.h"
+
+#include "il_rewriter_wrapper.h"
+
+namespace trace
+{
+
+bool CanOutlineMethod(const FunctionInfo& caller)
+{
+    // The outlined method is called through its methodDef, the generic ones would need their instantiation.
+    const auto calling_convention = caller.method_signature.CallingConvention();
+    bool       is_generic =
+        caller.type.type_spec != mdTypeSpecNil || (calling_convention & IMAGE_CEE_CS_CALLCONV_GENERIC) != 0;
+    for (const TypeInfo* type = &caller.type; type != nullptr; type = type->parent_type.get())
+    {
+        is_generic |= type->isGeneric;
+    }
+    return !is_generic && (calling_convention & IMAGE_CEE_CS_CALLCONV_MASK) != IMAGE_CEE_CS_CALLCONV_VARARG;
+}
+
+HRESULT DefineOutlinedMethod(ICorProfilerInfo* info, ModuleID module_id, ModuleMetadata* module_metadata,
+                             const FunctionInfo& caller, mdMethodDef* outlined_method_def)
+{
+    const auto& metadata_import = module_metadata->metadata_import;
+
+    DWORD           attributes       = 0;
+    DWORD           impl_flags       = 0;
+    PCCOR_SIGNATURE signature        = nullptr;
+    ULONG           signature_length = 0;
+    ULONG           rva              = 0;
+    auto hr = metadata_import->GetMethodProps(caller.id, nullptr, nullptr, 0, nullptr, &attributes, &signature,
+                                              &signature_length, &rva, &impl_flags);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (IsMdAbstract(attributes) || IsMdPinvokeImpl(attributes) || !IsMiIL(impl_flags) || rva == 0)
+    {
+        return S_FALSE;
+    }
+
+    const auto name = OutlinedMethodNamePrefix + caller.name;
+    if (SUCCEEDED(metadata_import->FindMethod(caller.type.id, name.c_str(), signature, signature_length,
+                                              outlined_method_def)))
+    {
+        return S_OK;
+    }
+
+    LPCBYTE body = nullptr;
+    hr           = info->GetILFunctionBody(module_id, caller.id, &body, nullptr);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // The instrumented method keeps the synchronization, the other implementation flags, e.g. the aggressive
+    // optimization, apply to the original body.
+    hr = module_metadata->metadata_emit->DefineMethod(caller.type.id, name.c_str(),
+                                                      mdPrivate | mdHideBySig | (attributes & mdStatic), signature,
+                                                      signature_length, 0, impl_flags & ~miSynchronized,
+                                                      outlined_method_def);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ILRewriter rewriter(info, nullptr, module_id, *outlined_method_def);
+    hr = rewriter.Import(body);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    return rewriter.Export();
+}
+
+HRESULT WriteOutlinedMethodCall(ILRewriter* rewriter, const FunctionInfo& caller, mdMethodDef outlined_method_def)
+{
+    rewriter->InitializeTiny();
+
+    ILRewriterWrapper reWriterWrapper(rewriter);
+    reWriterWrapper.SetILPosition(rewriter->GetILList());
+
+    const bool has_this       = (caller.method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS) != 0;
+    const auto argument_count = caller.method_signature.NumberOfArguments() + (has_this ? 1 : 0);
+    for (UINT16 i = 0; i < argument_count; i++)
+    {
+        reWriterWrapper.LoadArgument(i);
+    }
+    reWriterWrapper.CallMember(outlined_method_def, false);
+    reWriterWrapper.Return();
+    return S_OK;
+}
+
+} // namespace trace
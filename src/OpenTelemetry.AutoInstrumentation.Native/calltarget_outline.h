@@ -0,0 +1,39 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_OUTLINE_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_OUTLINE_H_
+
+#include <corhlpr.h>
+#include <corprof.h>
+
+#include "clr_helpers.h"
+#include "il_rewriter.h"
+#include "module_metadata.h"
+
+namespace trace
+{
+
+// Prefix of the name of the methods defined with the original body of the instrumented methods.
+const auto OutlinedMethodNamePrefix = WStr("<>otel__");
+
+// CanOutlineMethod returns true if the original body of the method can be moved to a new method of its type. The
+// generic methods, the methods of generic types and the vararg methods keep their body.
+bool CanOutlineMethod(const FunctionInfo& caller);
+
+// DefineOutlinedMethod adds a private method with the signature and a copy of the original body of the method to its
+// type. Methods can only be added to types that are not loaded yet, so this must be called while the module is
+// loading.
+HRESULT DefineOutlinedMethod(ICorProfilerInfo* info, ModuleID module_id, ModuleMetadata* module_metadata,
+                             const FunctionInfo& caller, mdMethodDef* outlined_method_def);
+
+// WriteOutlinedMethodCall writes a body that calls the outlined method with the arguments of the method, the
+// CallTarget rewrite then wraps this call instead of the original body, which keeps the JIT optimizations of a
+// method without exception handling.
+HRESULT WriteOutlinedMethodCall(ILRewriter* rewriter, const FunctionInfo& caller, mdMethodDef outlined_method_def);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_OUTLINE_H_
@@ -0,0 +1,549 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_planner.h"
+
+#include <filesystem>
+
+#include "calltarget_tokens.h"
+#include "calltarget_weaver.h"
+#include "cost_attribution.h"
+#include "il_rewriter.h"
+#include "logger.h"
+#include "otel_profiler_constants.h"
+#include "pal.h"
+
+namespace trace
+{
+
+namespace
+{
+    // Adds the methods of a type with the given name whose arguments match the integration target.
+    // Returns false if the type has no method with that name.
+    bool MatchTypeMethods(ComPtr<IMetaDataImport2> import, const IntegrationMethod& integration,
+                          mdTypeDef typeDef, const WSTRING& methodName, bool skipMethodsWithoutBody,
+                          std::vector<CallTargetMethodMatch>& matches,
+                          std::vector<CallTargetMethodRejection>* rejections)
+    {
+        auto reject = [rejections](const IntegrationMethod& integration, mdMethodDef methodDef,
+                                   const WSTRING& reason) {
+            if (rejections != nullptr)
+            {
+                rejections->push_back({&integration, methodDef, reason});
+            }
+        };
+
+        // Now we enumerate all methods with the same target method name. (All overloads of the method)
+        auto enumMethods = Enumerator<mdMethodDef>(
+            [import, methodName, typeDef](HCORENUM* ptr, mdMethodDef arr[], ULONG max, ULONG* cnt) -> HRESULT {
+                return import->EnumMethodsWithName(ptr, typeDef, methodName.c_str(), arr, max, cnt);
+            },
+            [import](HCORENUM ptr) -> void { import->CloseEnum(ptr); });
+
+        bool foundMethod  = false;
+        auto enumIterator = enumMethods.begin();
+        while (enumIterator != enumMethods.end())
+        {
+            auto methodDef = *enumIterator;
+            foundMethod    = true;
+
+            // The abstract methods of the subtypes, e.g. of a derived interface, have nothing to rewrite.
+            if (skipMethodsWithoutBody)
+            {
+                ULONG codeRva = 0;
+                if (FAILED(import->GetMethodProps(methodDef, nullptr, nullptr, 0, nullptr, nullptr, nullptr, nullptr,
+                                                  &codeRva, nullptr)) ||
+                    codeRva == 0)
+                {
+                    enumIterator = ++enumIterator;
+                    continue;
+                }
+            }
+
+            // Extract the function info from the mdMethodDef
+            const auto caller = GetFunctionInfo(import, methodDef);
+            if (!caller.IsValid())
+            {
+                Logger::Warn("The caller for the methoddef: ", TokenStr(&methodDef), " is not valid!");
+                reject(integration, methodDef, WStr("Invalid method definition."));
+                enumIterator = ++enumIterator;
+                continue;
+            }
+
+            // We create a new function info into the heap from the caller functionInfo in the stack, to be used later
+            // in the ReJIT process
+            auto functionInfo = FunctionInfo(caller);
+            auto hr           = functionInfo.method_signature.TryParse();
+            if (FAILED(hr))
+            {
+                Logger::Warn("The method signature: ", functionInfo.method_signature.str(), " cannot be parsed.");
+                reject(integration, methodDef, WStr("Method signature cannot be parsed."));
+                enumIterator = ++enumIterator;
+                continue;
+            }
+
+            // Compare the mdMethodDef arguments to the instrumentation target
+            const auto argumentsRejection =
+                CallTarget_GetArgumentsRejection(import, integration.replacement.target_method, functionInfo);
+            if (!argumentsRejection.empty())
+            {
+                Logger::Debug("The caller for the methoddef: ", integration.replacement.target_method.method_name,
+                              " doesn't have the right arguments.");
+                reject(integration, methodDef, argumentsRejection);
+                enumIterator = ++enumIterator;
+                continue;
+            }
+
+            matches.push_back({&integration, methodDef, functionInfo});
+            enumIterator = ++enumIterator;
+        }
+
+        return foundMethod;
+    }
+} // namespace
+
+/// <summary>
+/// Describe a matched or rejected method in a plan or a weaving report.
+/// </summary>
+/// <param name="integration">Integration matching the method</param>
+/// <param name="method_def">Method definition, or nil when the whole target type is rejected</param>
+/// <returns>The method description</returns>
+nlohmann::json CallTarget_MethodToJson(const IntegrationMethod* integration, mdMethodDef method_def)
+{
+    nlohmann::json method;
+    method["integration"] = ToString(integration->integration_name);
+    method["type"]        = ToString(integration->replacement.target_method.type_name);
+    method["method"]      = ToString(integration->replacement.target_method.method_name);
+    method["token"]       = method_def == mdMethodDefNil ? "" : ToString(TokenStr(&method_def));
+    return method;
+}
+
+/// <summary>
+/// Compare the arguments of a method to the ones of an integration target.
+/// </summary>
+/// <param name="metadata_import">Metadata import of the module that defines or references the method</param>
+/// <param name="target_method">Integration target</param>
+/// <param name="function_info">Function info of the method, with the signature already parsed</param>
+/// <returns>The rejection reason or an empty string if the arguments match</returns>
+WSTRING CallTarget_GetArgumentsRejection(const ComPtr<IMetaDataImport2>& metadata_import,
+                                         const MethodReference& target_method, const FunctionInfo& function_info)
+{
+    auto import = metadata_import;
+
+    // Compare if the method contains the same number of arguments as the instrumentation target
+    const auto numOfArgs = function_info.method_signature.NumberOfArguments();
+    if (numOfArgs != target_method.signature_types.size() - 1)
+    {
+        return WStr("Method has ") + ToWSTRING(numOfArgs) + WStr(" arguments, the integration expects ") +
+               ToWSTRING(target_method.signature_types.size() - 1) + WStr(".");
+    }
+
+    // Compare each method argument type to the instrumentation target
+    const auto methodArguments = function_info.method_signature.GetMethodArguments();
+    Logger::Debug("Comparing signature for method: ", target_method.type_name, ".", target_method.method_name);
+    for (unsigned int i = 0; i < numOfArgs; i++)
+    {
+        const auto argumentTypeName            = methodArguments[i].GetTypeTokName(import);
+        const auto integrationArgumentTypeName = target_method.signature_types[i + 1];
+        Logger::Debug("  -> ", argumentTypeName, " = ", integrationArgumentTypeName);
+        if (argumentTypeName != integrationArgumentTypeName && integrationArgumentTypeName != WStr("_"))
+        {
+            return WStr("Argument ") + ToWSTRING(i) + WStr(" is ") + argumentTypeName +
+                   WStr(", the integration expects ") + integrationArgumentTypeName + WStr(".");
+        }
+    }
+
+    return EmptyWStr;
+}
+
+bool CallTarget_IsTargetAllowed(const WSTRING& assembly_name, const WSTRING& type_name, const WSTRING& method_name)
+{
+    if (assembly_name != mscorlib_assemblyName && assembly_name != system_private_corelib_assemblyName)
+    {
+        return true;
+    }
+
+    const auto full_name = type_name + WStr(".") + method_name;
+    for (const auto& allowed_method : corlib_methods_allow_list)
+    {
+        if (full_name == allowed_method)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Search for the methods of a module that match the integrations target methods.
+/// </summary>
+/// <param name="metadata_import">Metadata import of the module</param>
+/// <param name="assembly_name">Name of the module assembly</param>
+/// <param name="assembly_version">Version of the module assembly</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <param name="matches">Matched methods</param>
+/// <param name="rejections">Methods, or types, that didn't match the integration target (optional)</param>
+/// <param name="durations">Time spent matching each integration targeting the assembly (optional)</param>
+void CallTarget_MatchModuleMethods(const ComPtr<IMetaDataImport2>& metadata_import, const WSTRING& assembly_name,
+                                   const Version& assembly_version,
+                                   const std::vector<IntegrationMethod>& integrations,
+                                   std::vector<CallTargetMethodMatch>& matches,
+                                   std::vector<CallTargetMethodRejection>* rejections,
+                                   std::vector<CallTargetMatchDuration>* durations)
+{
+    auto import = metadata_import;
+
+    auto reject = [rejections](const IntegrationMethod& integration, mdMethodDef methodDef, const WSTRING& reason) {
+        if (rejections != nullptr)
+        {
+            rejections->push_back({&integration, methodDef, reason});
+        }
+    };
+
+    for (const IntegrationMethod& integration : integrations)
+    {
+        // If the integration is not for the current assembly we skip.
+        // The subtypes of the derived and interface targets are matched by CallTarget_MatchSubtypeMethods, and the
+        // callers of the call-site targets by MatchCallSiteCallers.
+        if (integration.replacement.target_method.assembly.name != assembly_name ||
+            integration.replacement.target_method.IsHierarchyTarget() ||
+            integration.replacement.integration_kind == IntegrationKind::CallSite)
+        {
+            continue;
+        }
+
+        // Reports the time spent on the integration when leaving the iteration.
+        struct MatchDurationScope
+        {
+            std::vector<CallTargetMatchDuration>* durations;
+            const IntegrationMethod* integration;
+            CostStopwatch stopwatch;
+
+            ~MatchDurationScope()
+            {
+                if (durations != nullptr)
+                {
+                    durations->push_back({integration, stopwatch.ElapsedNs()});
+                }
+            }
+        } match_duration{durations, &integration};
+
+        // Check min version
+        if (integration.replacement.target_method.min_version > assembly_version)
+        {
+            reject(integration, mdMethodDefNil,
+                   WStr("Assembly version ") + assembly_version.str() + WStr(" is lower than the minimum version."));
+            continue;
+        }
+
+        // Check max version
+        if (integration.replacement.target_method.max_version < assembly_version)
+        {
+            reject(integration, mdMethodDefNil,
+                   WStr("Assembly version ") + assembly_version.str() + WStr(" is greater than the maximum version."));
+            continue;
+        }
+
+        if (!CallTarget_IsTargetAllowed(assembly_name, integration.replacement.target_method.type_name,
+                                        integration.replacement.target_method.method_name))
+        {
+            reject(integration, mdMethodDefNil, WStr("Method is not in the CoreLib allow-list."));
+            continue;
+        }
+
+        // We are in the right module, so we try to load the mdTypeDef from the integration target type name.
+        mdTypeDef typeDef   = mdTypeDefNil;
+        auto      foundType = FindTypeDefByName(integration.replacement.target_method.type_name, assembly_name,
+                                           import, typeDef);
+
+        if (!foundType)
+        {
+            reject(integration, mdMethodDefNil, WStr("Target type not found."));
+            continue;
+        }
+
+        const bool foundMethod = MatchTypeMethods(import, integration, typeDef,
+                                                  integration.replacement.target_method.method_name, false, matches,
+                                                  rejections);
+
+        if (!foundMethod)
+        {
+            reject(integration, mdMethodDefNil, WStr("Target method not found."));
+        }
+    }
+}
+
+/// <summary>
+/// Search for the methods of a subtype of a derived or interface integration target type.
+/// </summary>
+/// <param name="metadata_import">Metadata import of the module that defines the subtype</param>
+/// <param name="assembly_name">Name of the module assembly</param>
+/// <param name="type_def">Subtype found by the type hierarchy index</param>
+/// <param name="integration">Derived or interface integration</param>
+/// <param name="matches">Matched methods</param>
+void CallTarget_MatchSubtypeMethods(const ComPtr<IMetaDataImport2>& metadata_import, const WSTRING& assembly_name,
+                                    mdTypeDef type_def, const IntegrationMethod& integration,
+                                    std::vector<CallTargetMethodMatch>& matches)
+{
+    const auto& target_method = integration.replacement.target_method;
+
+    std::vector<CallTargetMethodMatch> type_matches;
+    MatchTypeMethods(metadata_import, integration, type_def, target_method.method_name, true, type_matches, nullptr);
+
+    // The explicit implementations of an interface method are named after the interface.
+    if (target_method.kind == TargetMethodKind::Interface)
+    {
+        MatchTypeMethods(metadata_import, integration, type_def,
+                         target_method.type_name + WStr(".") + target_method.method_name, true, type_matches, nullptr);
+    }
+
+    for (auto& match : type_matches)
+    {
+        if (CallTarget_IsTargetAllowed(assembly_name, match.function_info.type.name, match.function_info.name))
+        {
+            matches.push_back(std::move(match));
+        }
+    }
+}
+
+/// <summary>
+/// Get the reason why CallTarget_RewriteMethodBody refuses to rewrite a method.
+/// </summary>
+/// <param name="caller">Function info of the matched method, with the signature already parsed</param>
+/// <returns>The rejection reason or an empty string if the method can be rewritten</returns>
+WSTRING CallTarget_GetRewriteRejection(const FunctionInfo& caller)
+{
+    if (caller.type.valueType && caller.type.type_spec == mdTypeSpecNil && caller.type.isGeneric)
+    {
+        return WStr("Methods of a generic ValueType cannot be instrumented.");
+    }
+
+    return EmptyWStr;
+}
+
+/// <summary>
+/// Compare a method body with its CallTarget rewrite.
+/// </summary>
+/// <param name="original_body">Original method body including the header</param>
+/// <param name="rewritten_body">Method body exported after the CallTarget rewrite</param>
+/// <returns>The sizes of the rewrite, without the metadata tokens</returns>
+CallTargetRewriteSize CallTarget_MeasureRewrite(LPCBYTE original_body, const std::vector<BYTE>& rewritten_body)
+{
+    CallTargetRewriteSize size;
+
+    ILRewriter original(mdTokenNil);
+    if (SUCCEEDED(original.Import(original_body)))
+    {
+        COR_ILMETHOD_DECODER decoder(reinterpret_cast<const COR_ILMETHOD*>(original_body));
+        size.original_code_size = decoder.GetCodeSize();
+        for (ILInstr* pInstr = original.GetILList()->m_pNext; pInstr != original.GetILList(); pInstr = pInstr->m_pNext)
+        {
+            if (pInstr->m_opcode == CEE_RET)
+            {
+                size.return_count++;
+            }
+        }
+    }
+
+    COR_ILMETHOD_DECODER rewritten(reinterpret_cast<const COR_ILMETHOD*>(rewritten_body.data()));
+    size.rewritten_code_size = rewritten.GetCodeSize();
+    size.rewritten_body_size = static_cast<unsigned>(rewritten_body.size());
+    size.exception_clauses   = rewritten.EH == nullptr ? 0 : rewritten.EH->EHCount();
+    return size;
+}
+
+/// <summary>
+/// Open the metadata of an assembly file and compute the plan of the CallTarget rewrite for it. The matched
+/// methods are rewritten as the weaver does, the metadata changes are discarded: the sizes and the metadata tokens
+/// of the plan are the ones of the actual rewrite.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scope</param>
+/// <param name="assembly_path">Path of the assembly file</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <returns>The assembly plan</returns>
+nlohmann::json CallTarget_PlanAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& assembly_path,
+                                           const std::vector<IntegrationMethod>& integrations)
+{
+    nlohmann::json plan;
+    plan["path"]            = ToString(assembly_path);
+    plan["methods"]         = nlohmann::json::array();
+    plan["rejections"]      = nlohmann::json::array();
+    plan["not_planned"]     = nlohmann::json::array();
+    plan["metadata_tokens"] = 0;
+
+    if (CallTarget_SkipAssemblyFile(dispenser, assembly_path, integrations, plan))
+    {
+        return plan;
+    }
+
+    CallTargetAssemblyFile file;
+    const auto             error = CallTarget_OpenAssemblyFile(dispenser, assembly_path, file);
+    if (!error.empty())
+    {
+        plan["error"] = ToString(error);
+        return plan;
+    }
+
+    std::vector<CallTargetMethodMatch>     matches;
+    std::vector<CallTargetMethodRejection> rejections;
+    CallTarget_MatchModuleMethods(file.module_metadata->metadata_import, file.assembly->name, file.assembly->version,
+                                  integrations, matches, &rejections);
+
+    // The subtypes of the derived and interface targets, and the calls made by the call-site callers, are only found
+    // by the profiler at runtime: these integrations are listed without their methods.
+    auto not_planned = nlohmann::json::array();
+    for (const auto& integration : integrations)
+    {
+        const auto& replacement = integration.replacement;
+        if (replacement.InstrumentedAssemblyName() != file.assembly->name)
+        {
+            continue;
+        }
+
+        if (replacement.integration_kind == IntegrationKind::CallSite)
+        {
+            auto method      = CallTarget_MethodToJson(&integration, mdMethodDefNil);
+            method["reason"] = "The calls made by " + ToString(replacement.caller_method.type_name) + "." +
+                               ToString(replacement.caller_method.method_name) +
+                               "() are replaced by the profiler at runtime.";
+            not_planned.push_back(method);
+        }
+        else if (replacement.target_method.IsHierarchyTarget())
+        {
+            auto method      = CallTarget_MethodToJson(&integration, mdMethodDefNil);
+            method["reason"] = "The methods of the subtypes of the target type are matched by the profiler at "
+                               "runtime, in the assemblies loaded by the application.";
+            not_planned.push_back(method);
+        }
+    }
+    plan["not_planned"] = not_planned;
+
+    // The first rewritten method also defines the tokens shared by the module, they are only counted once.
+    const auto metadata_tables = file.module_metadata->metadata_import.As<IMetaDataTables>(IID_IMetaDataTables);
+    auto       count_tokens    = [&metadata_tables]() {
+        ULONG count = 0;
+        for (const auto token_type : {mdtTypeRef, mdtMemberRef, mdtSignature, mdtTypeSpec, mdtAssemblyRef,
+                                      mdtMethodSpec})
+        {
+            ULONG row_size = 0, rows = 0, columns = 0, key = 0;
+            const char* name = nullptr;
+            if (SUCCEEDED(metadata_tables->GetTableInfo(token_type >> 24, &row_size, &rows, &columns, &key, &name)))
+            {
+                count += rows;
+            }
+        }
+        return count;
+    };
+    const ULONG initial_tokens = metadata_tables.IsNull() ? 0 : count_tokens();
+
+    auto methods = nlohmann::json::array();
+    for (const auto& match : matches)
+    {
+        auto method            = CallTarget_MethodToJson(match.integration, match.method_def);
+        method["signature"]    = ToString(match.function_info.signature.str());
+        method["wrapper_type"] = ToString(match.integration->replacement.wrapper_method.type_name);
+
+        // The MethodMetrics methods are rewritten by the profiler at runtime, without the CallTarget handlers.
+        if (match.integration->replacement.integration_kind == IntegrationKind::MethodMetrics)
+        {
+            methods.push_back(method);
+            continue;
+        }
+
+        const ULONG       tokens_before = metadata_tables.IsNull() ? 0 : count_tokens();
+        std::vector<BYTE> body;
+        const auto        rejection = CallTarget_RewriteFileMethod(file, match, body);
+        if (!rejection.empty())
+        {
+            rejections.push_back({match.integration, match.method_def, rejection});
+            continue;
+        }
+
+        ULONG rva = 0;
+        file.module_metadata->metadata_import->GetMethodProps(match.method_def, nullptr, nullptr, 0, nullptr, nullptr,
+                                                              nullptr, nullptr, &rva, nullptr);
+        const auto size = CallTarget_MeasureRewrite(CallTarget_GetMethodBodyFromImage(file.image, rva), body);
+
+        method["original_il_size"]    = size.original_code_size;
+        method["predicted_il_size"]   = size.rewritten_code_size;
+        method["predicted_body_size"] = size.rewritten_body_size;
+        method["returns"]             = size.return_count;
+        method["exception_clauses"]   = size.exception_clauses;
+        method["metadata_tokens"]     = metadata_tables.IsNull() ? 0 : count_tokens() - tokens_before;
+        methods.push_back(method);
+    }
+
+    auto rejected = nlohmann::json::array();
+    for (const auto& rejection : rejections)
+    {
+        auto method      = CallTarget_MethodToJson(rejection.integration, rejection.method_def);
+        method["reason"] = ToString(rejection.reason);
+        rejected.push_back(method);
+    }
+
+    plan["methods"]         = methods;
+    plan["rejections"]      = rejected;
+    plan["metadata_tokens"] = metadata_tables.IsNull() ? 0 : count_tokens() - initial_tokens;
+    return plan;
+}
+
+/// <summary>
+/// Compute the plan of the CallTarget rewrite for all the assemblies (*.dll, *.exe) of a directory. The native
+/// libraries and the assemblies that no integration targets are only counted as skipped.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scopes</param>
+/// <param name="directory">Application directory, it is scanned recursively</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <returns>The plan with the assemblies that have at least one match, rejection or integration not planned, or that
+/// cannot be read</returns>
+nlohmann::json CallTarget_PlanDirectory(IMetaDataDispenser* dispenser, const WSTRING& directory,
+                                        const std::vector<IntegrationMethod>& integrations)
+{
+    nlohmann::json plan;
+    auto           assemblies = nlohmann::json::array();
+    size_t         scanned    = 0;
+    size_t         skipped    = 0;
+    size_t         failed     = 0;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(ToString(directory), ec))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        if (!CallTarget_HasAssemblyExtension(entry.path().string()))
+        {
+            continue;
+        }
+
+        scanned++;
+        auto assembly_plan = CallTarget_PlanAssemblyFile(dispenser, ToWSTRING(entry.path().string()), integrations);
+        if (assembly_plan.contains("skipped"))
+        {
+            skipped++;
+            continue;
+        }
+        if (assembly_plan.contains("error"))
+        {
+            failed++;
+        }
+        if (!assembly_plan["methods"].empty() || !assembly_plan["rejections"].empty() ||
+            !assembly_plan["not_planned"].empty() || assembly_plan.contains("error"))
+        {
+            assemblies.push_back(assembly_plan);
+        }
+    }
+
+    plan["directory"]  = ToString(directory);
+    plan["scanned"]    = scanned;
+    plan["skipped"]    = skipped;
+    plan["failed"]     = failed;
+    plan["assemblies"] = assemblies;
+    return plan;
+}
+
+} // namespace trace
@@ -0,0 +1,100 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_PLANNER_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_PLANNER_H_
+
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "clr_helpers.h"
+#include "com_ptr.h"
+#include "integration.h"
+
+namespace trace
+{
+
+// A method of a module that is going to be rewritten by an integration.
+struct CallTargetMethodMatch
+{
+    const IntegrationMethod* integration;
+    mdMethodDef method_def;
+    FunctionInfo function_info;
+};
+
+// A method (or the whole target type) that was considered for an integration but is not going to be rewritten.
+struct CallTargetMethodRejection
+{
+    const IntegrationMethod* integration;
+    mdMethodDef method_def;
+    WSTRING reason;
+};
+
+// Time spent matching the target methods of an integration in a module.
+struct CallTargetMatchDuration
+{
+    const IntegrationMethod* integration;
+    unsigned long long duration_ns;
+};
+
+// Sizes of the CallTarget rewrite of a method body.
+struct CallTargetRewriteSize
+{
+    unsigned original_code_size = 0;
+    unsigned rewritten_code_size = 0;
+    unsigned rewritten_body_size = 0;
+    unsigned return_count = 0;
+    unsigned exception_clauses = 0;
+};
+
+// CallTarget_MatchModuleMethods finds the methods of a module that match the integrations target methods.
+// This is the matching used by the profiler before requesting a ReJIT, it only relies on the module metadata
+// so it can also run against a metadata scope opened from a file.
+// Rejections and durations are only reported for integrations targeting the module assembly and are skipped
+// if null.
+void CallTarget_MatchModuleMethods(const ComPtr<IMetaDataImport2>& metadata_import, const WSTRING& assembly_name,
+                                   const Version& assembly_version,
+                                   const std::vector<IntegrationMethod>& integrations,
+                                   std::vector<CallTargetMethodMatch>& matches,
+                                   std::vector<CallTargetMethodRejection>* rejections,
+                                   std::vector<CallTargetMatchDuration>* durations = nullptr);
+
+// CallTarget_MatchSubtypeMethods finds the methods of a subtype of a derived or interface integration target,
+// found by the TypeHierarchyIndex, that match the target method. Methods without a body are skipped.
+void CallTarget_MatchSubtypeMethods(const ComPtr<IMetaDataImport2>& metadata_import, const WSTRING& assembly_name,
+                                    mdTypeDef type_def, const IntegrationMethod& integration,
+                                    std::vector<CallTargetMethodMatch>& matches);
+
+// CallTarget_GetArgumentsRejection returns the reason why the arguments of a method, with the signature already
+// parsed, don't match the ones of an integration target, or an empty string if they match.
+WSTRING CallTarget_GetArgumentsRejection(const ComPtr<IMetaDataImport2>& metadata_import,
+                                         const MethodReference& target_method, const FunctionInfo& function_info);
+
+// CallTarget_IsTargetAllowed returns false for the CoreLib methods that are not in the vetted allow-list.
+bool CallTarget_IsTargetAllowed(const WSTRING& assembly_name, const WSTRING& type_name, const WSTRING& method_name);
+
+// CallTarget_GetRewriteRejection returns the reason why CallTarget_RewriteMethodBody is going to refuse
+// to rewrite a matched method, or an empty string if the method can be rewritten.
+WSTRING CallTarget_GetRewriteRejection(const FunctionInfo& caller);
+
+// CallTarget_MeasureRewrite compares a method body with the body exported after its CallTarget rewrite.
+CallTargetRewriteSize CallTarget_MeasureRewrite(LPCBYTE original_body, const std::vector<BYTE>& rewritten_body);
+
+// CallTarget_MethodToJson describes a matched or rejected method in a plan or a weaving report.
+nlohmann::json CallTarget_MethodToJson(const IntegrationMethod* integration, mdMethodDef method_def);
+
+// CallTarget_PlanAssemblyFile applies the rewrite to the metadata of an assembly file opened in memory and returns
+// the rewrite plan for it. The assembly file is not modified.
+nlohmann::json CallTarget_PlanAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& assembly_path,
+                                           const std::vector<IntegrationMethod>& integrations);
+
+// CallTarget_PlanDirectory returns the rewrite plan for all the assemblies found in an application directory,
+// including the assemblies that cannot be read.
+nlohmann::json CallTarget_PlanDirectory(IMetaDataDispenser* dispenser, const WSTRING& directory,
+                                        const std::vector<IntegrationMethod>& integrations);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_PLANNER_H_
@@ -0,0 +1,909 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "calltarget_rewriter.h"
+
+#include "il_rewriter_wrapper.h"
+#include "logger.h"
+
+namespace trace
+{
+
+namespace
+{
+    const WSTRING callTargetRefStructTypeName = WStr("OpenTelemetry.AutoInstrumentation.CallTarget.CallTargetRefStruct");
+
+    // GetGenericArgument returns the generic argument of the CallTargetInvoker calls for a method argument or return
+    // value, the by-ref arguments are passed with the referenced type.
+    CallTargetGenericArgument GetGenericArgument(ModuleMetadata* module_metadata, const FunctionMethodArgument& argument)
+    {
+        auto     metadataImport = module_metadata->metadata_import;
+        unsigned elementType;
+        auto     typeFlags = argument.GetTypeFlags(elementType);
+        auto     typeName  = argument.GetTypeTokName(metadataImport);
+        if ((typeFlags & TypeFlagByRef) && !typeName.empty() && typeName.back() == '&')
+        {
+            typeName.pop_back();
+        }
+        return {typeName, (typeFlags & TypeFlagBoxedType) != 0};
+    }
+
+    // AddEHClause appends an exception handling clause to the method.
+    void AddEHClause(ILRewriter* rewriter, const EHClause& clause)
+    {
+        auto ehCount      = rewriter->GetEHCount();
+        auto ehPointer    = rewriter->GetEHPointer();
+        auto newEHClauses = new EHClause[ehCount + 1];
+        for (unsigned i = 0; i < ehCount; i++)
+        {
+            newEHClauses[i] = ehPointer[i];
+        }
+        newEHClauses[ehCount] = clause;
+        rewriter->SetEHClause(newEHClauses, ehCount + 1);
+    }
+
+    // StoreAsyncState stores the CallTarget state, and the instance, in the state machine before the builder starts
+    // it. The address of the state machine is on the stack for the Start<TStateMachine>(ref TStateMachine) call.
+    // Once started, AsyncMethodStarted restores the activity of the caller.
+    HRESULT StoreAsyncState(ILRewriter* rewriter, ModuleMetadata* module_metadata, FunctionInfo* caller,
+                            mdTypeRef wrapper_type_ref, const CallTargetAsyncStateMachine& state_machine,
+                            ULONG callTargetStateIndex)
+    {
+        ILInstr* startInstr = nullptr;
+        for (ILInstr* pInstr = rewriter->GetILList()->m_pNext; pInstr != rewriter->GetILList();
+             pInstr          = pInstr->m_pNext)
+        {
+            if (pInstr->m_opcode == CEE_CALL &&
+                IsAsyncBuilderMember(module_metadata->metadata_import, state_machine, pInstr->m_Arg32, WStr("Start")))
+            {
+                if (startInstr != nullptr)
+                {
+                    return S_FALSE;
+                }
+                startInstr = pInstr;
+            }
+        }
+
+        if (startInstr == nullptr)
+        {
+            return S_FALSE;
+        }
+
+        ILRewriterWrapper reWriterWrapper(rewriter);
+        reWriterWrapper.SetILPosition(startInstr);
+
+        auto loadStateMachine = [&reWriterWrapper, &state_machine]() {
+            reWriterWrapper.Duplicate();
+            if (!state_machine.value_type)
+            {
+                reWriterWrapper.CreateInstr(CEE_LDIND_REF);
+            }
+        };
+
+        loadStateMachine();
+        reWriterWrapper.LoadLocal(callTargetStateIndex);
+        reWriterWrapper.StoreField(state_machine.state_field_def);
+
+        if (state_machine.instance_field_def != mdFieldDefNil)
+        {
+            loadStateMachine();
+            reWriterWrapper.LoadArgument(0);
+            reWriterWrapper.StoreField(state_machine.instance_field_def);
+        }
+
+        reWriterWrapper.SetILPosition(startInstr->m_pNext);
+        reWriterWrapper.LoadLocal(callTargetStateIndex);
+        ILInstr* asyncMethodStartedInstr;
+        return module_metadata->GetCallTargetTokens()->WriteAsyncMethodStarted(&reWriterWrapper, wrapper_type_ref,
+                                                                               &caller->type, &asyncMethodStartedInstr);
+    }
+
+    // AddBeginMethodInstantiation accounts the instantiation of the BeginMethod overload called by the method.
+    void AddBeginMethodInstantiation(ModuleMetadata* module_metadata, FunctionInfo* caller,
+                                     const CallTargetGenericArgument&           integrationArgument,
+                                     const std::vector<FunctionMethodArgument>& methodArguments,
+                                     const std::vector<bool>&                   refStructArguments,
+                                     const std::vector<bool>& canonicalArguments, bool byRefArguments)
+    {
+        const int numArgs = static_cast<int>(methodArguments.size());
+
+        std::vector<CallTargetGenericArgument> beginArguments{integrationArgument,
+                                                              {caller->type.name, caller->type.valueType}};
+        WSTRING                                beginMethodName = WStr("BeginMethod");
+        if (numArgs >= FASTPATH_COUNT)
+        {
+            beginMethodName += WStr("(object[])");
+        }
+        else
+        {
+            if (byRefArguments)
+            {
+                beginMethodName += WStr("(ref)");
+            }
+            for (int i = 0; i < numArgs; i++)
+            {
+                if (refStructArguments[i])
+                {
+                    beginArguments.push_back({callTargetRefStructTypeName, true});
+                }
+                else if (canonicalArguments[i])
+                {
+                    beginArguments.push_back({SystemObject, false});
+                }
+                else
+                {
+                    beginArguments.push_back(GetGenericArgument(module_metadata, methodArguments[i]));
+                }
+            }
+        }
+        CallTargetInstantiations::Instance()->Add(beginMethodName, beginArguments);
+    }
+} // namespace
+
+/// <summary>
+/// Rewrite the imported method body with the calltarget implementation. The rewriter is not exported, this is left
+/// to the caller, so the same rewrite can be applied to a method being ReJITed or to a method body read from disk.
+/// Resulting code structure:
+///
+/// - Add locals for TReturn (if non-void method), CallTargetState, CallTargetReturn/CallTargetReturn<TReturn>,
+/// Exception
+/// - Initialize locals
+///
+/// try
+/// {
+///   try
+///   {
+///     try
+///     {
+///       - Invoke BeginMethod with object instance (or null if static method) and original method arguments
+///       - Store result into CallTargetState local
+///     }
+///     catch
+///     {
+///       - Invoke LogException(Exception)
+///     }
+///
+///     - Execute original method instructions
+///       * All RET instructions are replaced with a LEAVE_S. If non-void method, the value on the stack is first stored
+///       in the TReturn local.
+///   }
+///   catch (Exception)
+///   {
+///     - Store exception into Exception local
+///     - throw
+///   }
+/// }
+/// finally
+/// {
+///   try
+///   {
+///     - Invoke EndMethod with object instance (or null if static method), TReturn local (if non-void method),
+///     CallTargetState local, and Exception local
+///     - Store result into CallTargetReturn/CallTargetReturn<TReturn> local
+///     - If non-void method, store CallTargetReturn<TReturn>.GetReturnValue() into TReturn local
+///   }
+///   catch
+///   {
+///     - Invoke LogException(Exception)
+///   }
+/// }
+///
+/// - If non-void method, load TReturn local
+/// - RET
+/// </summary>
+/// <param name="rewriter">Rewriter with the imported original method body</param>
+/// <param name="module_metadata">Metadata of the module that defines the method</param>
+/// <param name="caller">Function info of the method being rewritten</param>
+/// <param name="wrapper_type_ref">TypeRef of the integration type in the module</param>
+/// <param name="argument_positions">Positions of the arguments passed to BeginMethod, the ones declared by the
+/// integration, or null to pass all the arguments. The declared arguments are always passed on the FastPath.</param>
+/// <param name="canonical_argument_uses">How the integration consumes each argument passed to BeginMethod, with the
+/// canonical instantiation policy. Empty with the typed policy.</param>
+/// <param name="async_state_machine">State machine of an async method instrumented through it, or null. The method
+/// only calls BeginMethod and stores the CallTarget state in the state machine, the EndMethod part is replaced by
+/// the calls written by CallTarget_RewriteAsyncMoveNext.</param>
+/// <returns>S_OK if the IL was rewritten, S_FALSE if the method cannot be instrumented</returns>
+HRESULT CallTarget_RewriteMethodBody(ILRewriter*     rewriter,
+                                     ModuleMetadata* module_metadata,
+                                     FunctionInfo*   caller,
+                                     mdTypeRef       wrapper_type_ref,
+                                     const std::vector<ULONG>*                 argument_positions,
+                                     const std::vector<CallTargetArgumentUse>& canonical_argument_uses,
+                                     const CallTargetAsyncStateMachine*        async_state_machine)
+{
+    CallTargetTokens*      callTargetTokens = module_metadata->GetCallTargetTokens();
+    FunctionMethodArgument retFuncArg       = caller->method_signature.GetRet();
+    unsigned int           retFuncElementType;
+    int                    retTypeFlags = retFuncArg.GetTypeFlags(retFuncElementType);
+    bool                   isVoid       = (retTypeFlags & TypeFlagVoid) > 0;
+    bool                   isStatic = !(caller->method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS);
+    std::vector<FunctionMethodArgument> methodArguments = caller->method_signature.GetMethodArguments();
+    auto                                metaEmit        = module_metadata->metadata_emit;
+    HRESULT                             hr              = S_OK;
+
+    // *** Select the arguments passed to BeginMethod, the integration may only consume some of them. The other
+    // arguments are neither copied nor part of the BeginMethod instantiation.
+    std::vector<ULONG> argumentPositions;
+    if (argument_positions != nullptr)
+    {
+        std::vector<FunctionMethodArgument> selectedArguments;
+        for (const auto position : *argument_positions)
+        {
+            selectedArguments.push_back(methodArguments[position]);
+        }
+        methodArguments   = selectedArguments;
+        argumentPositions = *argument_positions;
+    }
+    else
+    {
+        for (ULONG i = 0; i < methodArguments.size(); i++)
+        {
+            argumentPositions.push_back(i);
+        }
+    }
+    int numArgs = static_cast<int>(methodArguments.size());
+
+    // *** Create the rewriter wrapper helper
+    ILRewriterWrapper reWriterWrapper(rewriter);
+    reWriterWrapper.SetILPosition(rewriter->GetILList()->m_pNext);
+
+    // *** Find the ref struct arguments, they are passed to BeginMethod through CallTargetRefStruct locals
+    std::vector<bool> refStructArguments(numArgs, false);
+    ULONG             refStructLocalsCount = 0;
+    for (int i = 0; i < numArgs; i++)
+    {
+        if (callTargetTokens->IsRefStructArgument(methodArguments[i]))
+        {
+            if (numArgs >= FASTPATH_COUNT)
+            {
+                Logger::Warn("*** CallTarget_RewriteMethodBody(): Methods with ref struct parameters and more than ",
+                             FASTPATH_COUNT - 1, " parameters cannot be instrumented. ");
+                return S_FALSE;
+            }
+            refStructArguments[i] = true;
+            refStructLocalsCount++;
+        }
+    }
+
+    // *** Modify the Local Var Signature of the method and initialize the new local vars
+    ULONG    refStructFirstIndex   = static_cast<ULONG>(ULONG_MAX);
+    ULONG    callTargetStateIndex  = static_cast<ULONG>(ULONG_MAX);
+    ULONG    exceptionIndex        = static_cast<ULONG>(ULONG_MAX);
+    ULONG    callTargetReturnIndex = static_cast<ULONG>(ULONG_MAX);
+    ULONG    returnValueIndex      = static_cast<ULONG>(ULONG_MAX);
+    mdToken  callTargetStateToken  = mdTokenNil;
+    mdToken  exceptionToken        = mdTokenNil;
+    mdToken  callTargetReturnToken = mdTokenNil;
+    ILInstr* firstInstruction;
+    callTargetTokens->ModifyLocalSigAndInitialize(&reWriterWrapper, caller, refStructLocalsCount, &refStructFirstIndex,
+                                                  &callTargetStateIndex, &exceptionIndex, &callTargetReturnIndex,
+                                                  &returnValueIndex, &callTargetStateToken, &exceptionToken,
+                                                  &callTargetReturnToken, &firstInstruction);
+
+    // ***
+    // BEGIN METHOD PART
+    // ***
+
+    // *** Load instance into the stack (if not static)
+    // The instance of a ValueType is passed by reference, `this` is already a managed pointer so the struct is
+    // neither copied nor boxed. The static methods of a ValueType pass a null reference.
+    bool isGenericValueType = false;
+    if (caller->type.valueType && caller->type.type_spec == mdTypeSpecNil)
+    {
+        // A struct nested in a generic type is generic too.
+        for (const TypeInfo* type = &caller->type; type != nullptr; type = type->parent_type.get())
+        {
+            isGenericValueType |= type->isGeneric;
+        }
+    }
+    if (isGenericValueType)
+    {
+        // Generic struct instrumentation is not supported
+        // IMetaDataImport::GetMemberProps and IMetaDataImport::GetMemberRefProps returns
+        // The parent token as mdTypeDef and not as a mdTypeSpec
+        // that's because the method definition is stored in the mdTypeDef
+        // The problem is that we don't have the exact Spec of that generic
+        // so the TTarget generic argument of the CallTarget methods can't be written.
+        // This problem doesn't occur on a class type because we can always relay in the
+        // object type.
+        return S_FALSE;
+    }
+
+    // The methods with by-ref or ref struct arguments (FastPath) pass the instance and all the arguments by reference.
+    unsigned elementType;
+    bool     byRefArguments = refStructLocalsCount > 0;
+    if (numArgs < FASTPATH_COUNT)
+    {
+        for (int i = 0; i < numArgs; i++)
+        {
+            byRefArguments |= (methodArguments[i].GetTypeFlags(elementType) & TypeFlagByRef) > 0;
+        }
+    }
+
+    // *** Find the value-type arguments passed as System.Object, the integration doesn't need them typed and the call
+    // shares the canonical instantiation of the CallTarget handlers. The overload taking the arguments by reference
+    // keeps their types.
+    std::vector<bool> canonicalArguments(numArgs, false);
+    if (!canonical_argument_uses.empty() && numArgs < FASTPATH_COUNT && !byRefArguments)
+    {
+        for (int i = 0; i < numArgs; i++)
+        {
+            canonicalArguments[i] = canonical_argument_uses[i] != CallTargetArgumentUse::Typed &&
+                                    (methodArguments[i].GetTypeFlags(elementType) & TypeFlagBoxedType);
+        }
+    }
+
+    if (!isStatic)
+    {
+        if (byRefArguments && !caller->type.valueType)
+        {
+            reWriterWrapper.LoadArgumentAddress(0);
+        }
+        else
+        {
+            reWriterWrapper.LoadArgument(0);
+        }
+    }
+    else if (caller->type.valueType || byRefArguments)
+    {
+        reWriterWrapper.CreateInstr(CEE_LDC_I4_0);
+        reWriterWrapper.CreateInstr(CEE_CONV_U);
+    }
+    else
+    {
+        reWriterWrapper.LoadNull();
+    }
+
+    // *** Load the method arguments to the stack
+    if (numArgs < FASTPATH_COUNT)
+    {
+        // Load the arguments directly (FastPath)
+        ULONG refStructIndex = refStructFirstIndex;
+        for (int i = 0; i < numArgs; i++)
+        {
+            const UINT16 argIndex     = static_cast<UINT16>(argumentPositions[i] + (isStatic ? 0 : 1));
+            auto         argTypeFlags = methodArguments[i].GetTypeFlags(elementType);
+            if (canonicalArguments[i])
+            {
+                // An argument the integration never reads is not boxed.
+                if (canonical_argument_uses[i] == CallTargetArgumentUse::Unused)
+                {
+                    reWriterWrapper.LoadNull();
+                    continue;
+                }
+
+                auto tok = methodArguments[i].GetTypeTok(metaEmit, callTargetTokens->GetCorLibAssemblyRef());
+                if (tok == mdTokenNil)
+                {
+                    return S_FALSE;
+                }
+                reWriterWrapper.LoadArgument(argIndex);
+                reWriterWrapper.Box(tok);
+            }
+            else if (!byRefArguments || (argTypeFlags & TypeFlagByRef))
+            {
+                reWriterWrapper.LoadArgument(argIndex);
+            }
+            else
+            {
+                reWriterWrapper.LoadArgumentAddress(argIndex);
+            }
+
+            if (refStructArguments[i])
+            {
+                ILInstr* refStructInstr;
+                hr = callTargetTokens->WriteRefStructArgument(&reWriterWrapper, methodArguments[i], refStructIndex++,
+                                                              &refStructInstr);
+                if (FAILED(hr))
+                {
+                    return S_FALSE;
+                }
+            }
+        }
+    }
+    else
+    {
+        // Load the arguments inside an object array (SlowPath)
+        reWriterWrapper.CreateArray(callTargetTokens->GetObjectTypeRef(), numArgs);
+        for (int i = 0; i < numArgs; i++)
+        {
+            reWriterWrapper.BeginLoadValueIntoArray(i);
+            reWriterWrapper.LoadArgument(argumentPositions[i] + (isStatic ? 0 : 1));
+            auto argTypeFlags = methodArguments[i].GetTypeFlags(elementType);
+            if (argTypeFlags & (TypeFlagByRef | TypeFlagBoxedType))
+            {
+                auto tok = methodArguments[i].GetTypeTok(metaEmit, callTargetTokens->GetCorLibAssemblyRef());
+                if (tok == mdTokenNil)
+                {
+                    return S_FALSE;
+                }
+                // The array holds a copy of the value referenced by a by-ref argument.
+                if (argTypeFlags & TypeFlagByRef)
+                {
+                    reWriterWrapper.LoadObj(tok);
+                }
+                if (argTypeFlags & TypeFlagBoxedType)
+                {
+                    reWriterWrapper.Box(tok);
+                }
+            }
+            reWriterWrapper.EndLoadValueIntoArray();
+        }
+    }
+
+    // *** Emit BeginMethod call
+    if (Logger::IsDebugEnabled())
+    {
+        Logger::Debug("Caller Type.Id: ", HexStr(&caller->type.id, sizeof(mdToken)));
+        Logger::Debug("Caller Type.IsGeneric: ", caller->type.isGeneric);
+        Logger::Debug("Caller Type.IsValid: ", caller->type.IsValid());
+        Logger::Debug("Caller Type.Name: ", caller->type.name);
+        Logger::Debug("Caller Type.TokenType: ", caller->type.token_type);
+        Logger::Debug("Caller Type.Spec: ", HexStr(&caller->type.type_spec, sizeof(mdTypeSpec)));
+        Logger::Debug("Caller Type.ValueType: ", caller->type.valueType);
+        //
+        if (caller->type.extend_from != nullptr)
+        {
+            Logger::Debug("Caller Type Extend From.Id: ", HexStr(&caller->type.extend_from->id, sizeof(mdToken)));
+            Logger::Debug("Caller Type Extend From.IsGeneric: ", caller->type.extend_from->isGeneric);
+            Logger::Debug("Caller Type Extend From.IsValid: ", caller->type.extend_from->IsValid());
+            Logger::Debug("Caller Type Extend From.Name: ", caller->type.extend_from->name);
+            Logger::Debug("Caller Type Extend From.TokenType: ", caller->type.extend_from->token_type);
+            Logger::Debug("Caller Type Extend From.Spec: ",
+                          HexStr(&caller->type.extend_from->type_spec, sizeof(mdTypeSpec)));
+            Logger::Debug("Caller Type Extend From.ValueType: ", caller->type.extend_from->valueType);
+        }
+        //
+        if (caller->type.parent_type != nullptr)
+        {
+            Logger::Debug("Caller ParentType.Id: ", HexStr(&caller->type.parent_type->id, sizeof(mdToken)));
+            Logger::Debug("Caller ParentType.IsGeneric: ", caller->type.parent_type->isGeneric);
+            Logger::Debug("Caller ParentType.IsValid: ", caller->type.parent_type->IsValid());
+            Logger::Debug("Caller ParentType.Name: ", caller->type.parent_type->name);
+            Logger::Debug("Caller ParentType.TokenType: ", caller->type.parent_type->token_type);
+            Logger::Debug("Caller ParentType.Spec: ", HexStr(&caller->type.parent_type->type_spec, sizeof(mdTypeSpec)));
+            Logger::Debug("Caller ParentType.ValueType: ", caller->type.parent_type->valueType);
+        }
+    }
+
+    ILInstr* beginCallInstruction;
+    hr = callTargetTokens->WriteBeginMethod(&reWriterWrapper, wrapper_type_ref, &caller->type, methodArguments,
+                                            refStructArguments, canonicalArguments, &beginCallInstruction);
+    if (FAILED(hr))
+    {
+        // Error message is written to the log in WriteBeginMethod.
+        return S_FALSE;
+    }
+    reWriterWrapper.StLocal(callTargetStateIndex);
+    ILInstr* pStateLeaveToBeginOriginalMethodInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
+
+    // *** BeginMethod call catch
+    ILInstr* beginMethodCatchFirstInstr = nullptr;
+    callTargetTokens->WriteLogException(&reWriterWrapper, wrapper_type_ref, &caller->type, &beginMethodCatchFirstInstr);
+    ILInstr* beginMethodCatchLeaveInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
+
+    // *** BeginMethod exception handling clause
+    EHClause beginMethodExClause{};
+    beginMethodExClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
+    beginMethodExClause.m_pTryBegin     = firstInstruction;
+    beginMethodExClause.m_pTryEnd       = beginMethodCatchFirstInstr;
+    beginMethodExClause.m_pHandlerBegin = beginMethodCatchFirstInstr;
+    beginMethodExClause.m_pHandlerEnd   = beginMethodCatchLeaveInstr;
+    beginMethodExClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
+
+    // ***
+    // METHOD EXECUTION
+    // ***
+    ILInstr* beginOriginalMethodInstr                = reWriterWrapper.GetCurrentILInstr();
+    pStateLeaveToBeginOriginalMethodInstr->m_pTarget = beginOriginalMethodInstr;
+    beginMethodCatchLeaveInstr->m_pTarget            = beginOriginalMethodInstr;
+
+    const CallTargetGenericArgument integrationArgument{GetTypeInfo(module_metadata->metadata_import,
+                                                                    wrapper_type_ref).name,
+                                                        false};
+
+    // *** The async state machine completes the instrumentation, without a continuation on the returned task
+    if (async_state_machine != nullptr)
+    {
+        hr = StoreAsyncState(rewriter, module_metadata, caller, wrapper_type_ref, *async_state_machine,
+                             callTargetStateIndex);
+        if (hr != S_OK)
+        {
+            Logger::Warn("*** CallTarget_RewriteMethodBody(): The start of the async state machine could not be rewritten in ",
+                         caller->type.name, ".", caller->name, "()");
+            return S_FALSE;
+        }
+
+        AddEHClause(rewriter, beginMethodExClause);
+        AddBeginMethodInstantiation(module_metadata, caller, integrationArgument, methodArguments,
+                                    refStructArguments, canonicalArguments, byRefArguments);
+        return S_OK;
+    }
+
+    // ***
+    // ENDING OF THE METHOD EXECUTION
+    // ***
+
+    // *** Create return instruction and insert it at the end
+    ILInstr* methodReturnInstr  = rewriter->NewILInstr();
+    methodReturnInstr->m_opcode = CEE_RET;
+    rewriter->InsertAfter(rewriter->GetILList()->m_pPrev, methodReturnInstr);
+    reWriterWrapper.SetILPosition(methodReturnInstr);
+
+    // ***
+    // EXCEPTION CATCH
+    // ***
+    ILInstr* startExceptionCatch = reWriterWrapper.StLocal(exceptionIndex);
+    reWriterWrapper.SetILPosition(methodReturnInstr);
+    ILInstr* rethrowInstr = reWriterWrapper.Rethrow();
+
+    // ***
+    // EXCEPTION FINALLY / END METHOD PART
+    // ***
+    ILInstr* endMethodTryStartInstr;
+
+    // *** Load instance into the stack (if not static)
+    if (!isStatic)
+    {
+        endMethodTryStartInstr = reWriterWrapper.LoadArgument(0);
+    }
+    else if (caller->type.valueType)
+    {
+        endMethodTryStartInstr = reWriterWrapper.CreateInstr(CEE_LDC_I4_0);
+        reWriterWrapper.CreateInstr(CEE_CONV_U);
+    }
+    else
+    {
+        endMethodTryStartInstr = reWriterWrapper.LoadNull();
+    }
+
+    // *** Load the return value is is not void
+    if (!isVoid)
+    {
+        reWriterWrapper.LoadLocal(returnValueIndex);
+    }
+
+    reWriterWrapper.LoadLocal(exceptionIndex);
+    reWriterWrapper.LoadLocal(callTargetStateIndex);
+
+    ILInstr* endMethodCallInstr;
+    if (isVoid)
+    {
+        callTargetTokens->WriteEndVoidReturnMemberRef(&reWriterWrapper, wrapper_type_ref, &caller->type,
+                                                      &endMethodCallInstr);
+    }
+    else
+    {
+        callTargetTokens->WriteEndReturnMemberRef(&reWriterWrapper, wrapper_type_ref, &caller->type, &retFuncArg,
+                                                  &endMethodCallInstr);
+    }
+    reWriterWrapper.StLocal(callTargetReturnIndex);
+
+    if (!isVoid)
+    {
+        ILInstr* callTargetReturnGetReturnInstr;
+        reWriterWrapper.LoadLocalAddress(callTargetReturnIndex);
+        callTargetTokens->WriteCallTargetReturnGetReturnValue(&reWriterWrapper, callTargetReturnToken,
+                                                              &callTargetReturnGetReturnInstr);
+        reWriterWrapper.StLocal(returnValueIndex);
+    }
+
+    ILInstr* endMethodTryLeave = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
+
+    // *** EndMethod call catch
+    ILInstr* endMethodCatchFirstInstr = nullptr;
+    callTargetTokens->WriteLogException(&reWriterWrapper, wrapper_type_ref, &caller->type, &endMethodCatchFirstInstr);
+    ILInstr* endMethodCatchLeaveInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
+
+    // *** EndMethod exception handling clause
+    EHClause endMethodExClause{};
+    endMethodExClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
+    endMethodExClause.m_pTryBegin     = endMethodTryStartInstr;
+    endMethodExClause.m_pTryEnd       = endMethodCatchFirstInstr;
+    endMethodExClause.m_pHandlerBegin = endMethodCatchFirstInstr;
+    endMethodExClause.m_pHandlerEnd   = endMethodCatchLeaveInstr;
+    endMethodExClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
+
+    // *** EndMethod leave to finally
+    ILInstr* endFinallyInstr            = reWriterWrapper.EndFinally();
+    endMethodTryLeave->m_pTarget        = endFinallyInstr;
+    endMethodCatchLeaveInstr->m_pTarget = endFinallyInstr;
+
+    // ***
+    // METHOD RETURN
+    // ***
+
+    // Load the current return value from the local var
+    if (!isVoid)
+    {
+        reWriterWrapper.LoadLocal(returnValueIndex);
+    }
+
+    // Changes all returns to a LEAVE.S
+    for (ILInstr* pInstr = rewriter->GetILList()->m_pNext; pInstr != rewriter->GetILList(); pInstr = pInstr->m_pNext)
+    {
+        switch (pInstr->m_opcode)
+        {
+            case CEE_RET:
+            {
+                if (pInstr != methodReturnInstr)
+                {
+                    if (!isVoid)
+                    {
+                        reWriterWrapper.SetILPosition(pInstr);
+                        reWriterWrapper.StLocal(returnValueIndex);
+                    }
+                    pInstr->m_opcode  = CEE_LEAVE_S;
+                    pInstr->m_pTarget = endFinallyInstr->m_pNext;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Exception handling clauses
+    EHClause exClause{};
+    exClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
+    exClause.m_pTryBegin     = firstInstruction;
+    exClause.m_pTryEnd       = startExceptionCatch;
+    exClause.m_pHandlerBegin = startExceptionCatch;
+    exClause.m_pHandlerEnd   = rethrowInstr;
+    exClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
+
+    EHClause finallyClause{};
+    finallyClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_FINALLY;
+    finallyClause.m_pTryBegin     = firstInstruction;
+    finallyClause.m_pTryEnd       = rethrowInstr->m_pNext;
+    finallyClause.m_pHandlerBegin = rethrowInstr->m_pNext;
+    finallyClause.m_pHandlerEnd   = endFinallyInstr;
+
+    // ***
+    // Update and Add exception clauses
+    // ***
+    auto ehCount      = rewriter->GetEHCount();
+    auto ehPointer    = rewriter->GetEHPointer();
+    auto newEHClauses = new EHClause[ehCount + 4];
+    for (unsigned i = 0; i < ehCount; i++)
+    {
+        newEHClauses[i] = ehPointer[i];
+    }
+
+    // *** Add the new EH clauses
+    ehCount += 4;
+    newEHClauses[ehCount - 4] = beginMethodExClause;
+    newEHClauses[ehCount - 3] = endMethodExClause;
+    newEHClauses[ehCount - 2] = exClause;
+    newEHClauses[ehCount - 1] = finallyClause;
+    rewriter->SetEHClause(newEHClauses, ehCount);
+
+    // ***
+    // Account the instantiations of the CallTargetInvoker methods
+    // ***
+    AddBeginMethodInstantiation(module_metadata, caller, integrationArgument, methodArguments, refStructArguments,
+                                canonicalArguments, byRefArguments);
+
+    std::vector<CallTargetGenericArgument> endArguments{integrationArgument,
+                                                        {caller->type.name, caller->type.valueType}};
+    if (!isVoid)
+    {
+        endArguments.push_back(GetGenericArgument(module_metadata, retFuncArg));
+    }
+    CallTargetInstantiations::Instance()->Add(WStr("EndMethod"), endArguments);
+
+    return S_OK;
+}
+
+/// <summary>
+/// Rewrite the MoveNext method of the state machine of an async method whose kickoff method was rewritten with
+/// CallTarget_RewriteMethodBody. Before each call completing the builder of the state machine, the result or the
+/// exception on the stack is passed to EndAsyncMethod with the instance and the CallTarget state stored in the state
+/// machine, and the value it returns is passed to the builder:
+///
+/// - SetResult(TResult): EndAsyncMethod(result, instance, state)
+/// - SetResult(): EndAsyncMethod(null, instance, state), the result is dropped
+/// - SetException(Exception): EndAsyncMethodWithException(exception, instance, state)
+///
+/// EndAsyncMethod handles the exceptions of the integration, the calls are not wrapped in an exception handler.
+/// </summary>
+/// <param name="rewriter">Rewriter with the imported MoveNext body</param>
+/// <param name="module_metadata">Metadata of the module that defines the method</param>
+/// <param name="kickoff">Function info of the async method</param>
+/// <param name="wrapper_type_ref">TypeRef of the integration type in the module</param>
+/// <param name="state_machine">State machine of the async method, with the fields defined by the profiler</param>
+/// <returns>S_OK if the IL was rewritten, S_FALSE if the method cannot be instrumented</returns>
+HRESULT CallTarget_RewriteAsyncMoveNext(ILRewriter*                        rewriter,
+                                        ModuleMetadata*                    module_metadata,
+                                        FunctionInfo*                      kickoff,
+                                        mdTypeRef                          wrapper_type_ref,
+                                        const CallTargetAsyncStateMachine& state_machine)
+{
+    CallTargetTokens* callTargetTokens = module_metadata->GetCallTargetTokens();
+    ILRewriterWrapper reWriterWrapper(rewriter);
+
+    int completions = 0;
+    for (ILInstr* pInstr = rewriter->GetILList()->m_pNext; pInstr != rewriter->GetILList(); pInstr = pInstr->m_pNext)
+    {
+        if (pInstr->m_opcode != CEE_CALL && pInstr->m_opcode != CEE_CALLVIRT)
+        {
+            continue;
+        }
+
+        const bool setResult =
+            IsAsyncBuilderMember(module_metadata->metadata_import, state_machine, pInstr->m_Arg32, WStr("SetResult"));
+        const bool setException =
+            !setResult && IsAsyncBuilderMember(module_metadata->metadata_import, state_machine, pInstr->m_Arg32,
+                                               WStr("SetException"));
+        if (!setResult && !setException)
+        {
+            continue;
+        }
+
+        reWriterWrapper.SetILPosition(pInstr);
+
+        const bool withoutResult = setResult && state_machine.result_signature == nullptr;
+        if (withoutResult)
+        {
+            reWriterWrapper.LoadNull();
+        }
+
+        if (state_machine.instance_field_def != mdFieldDefNil)
+        {
+            reWriterWrapper.LoadArgument(0);
+            reWriterWrapper.LoadField(state_machine.instance_field_def);
+        }
+        else
+        {
+            reWriterWrapper.LoadNull();
+        }
+
+        reWriterWrapper.LoadArgument(0);
+        reWriterWrapper.LoadField(state_machine.state_field_def);
+
+        ILInstr* endAsyncMethodInstr;
+        auto     hr = callTargetTokens->WriteEndAsyncMethod(&reWriterWrapper, wrapper_type_ref, &kickoff->type,
+                                                            state_machine.result_signature,
+                                                            state_machine.result_signature_length, setException,
+                                                            &endAsyncMethodInstr);
+        if (FAILED(hr))
+        {
+            // Error message is written to the log in WriteEndAsyncMethod.
+            return S_FALSE;
+        }
+
+        if (withoutResult)
+        {
+            reWriterWrapper.Pop();
+        }
+        completions++;
+    }
+
+    if (completions == 0)
+    {
+        Logger::Warn("*** CallTarget_RewriteAsyncMoveNext(): The completion of the async state machine was not found "
+                     "for ",
+                     kickoff->type.name, ".", kickoff->name, "()");
+        return S_FALSE;
+    }
+
+    // ***
+    // Account the instantiations of the CallTargetInvoker methods
+    // ***
+    const CallTargetGenericArgument integrationArgument{GetTypeInfo(module_metadata->metadata_import,
+                                                                    wrapper_type_ref).name,
+                                                        false};
+    std::vector<CallTargetGenericArgument> endArguments{integrationArgument, {kickoff->type.name, false}};
+    if (state_machine.result_signature != nullptr)
+    {
+        auto                   metadataImport = module_metadata->metadata_import;
+        FunctionMethodArgument resultArgument{0, state_machine.result_signature_length,
+                                              state_machine.result_signature};
+        unsigned               elementType;
+        endArguments.push_back({resultArgument.GetTypeTokName(metadataImport),
+                                (resultArgument.GetTypeFlags(elementType) & TypeFlagBoxedType) != 0});
+    }
+    else
+    {
+        endArguments.push_back({SystemObject, false});
+    }
+    CallTargetInstantiations::Instance()->Add(WStr("EndAsyncMethod"), endArguments);
+
+    Logger::Debug("*** CallTarget_RewriteAsyncMoveNext(): Rewrote MoveNext of the async state machine of ",
+                  kickoff->type.name, ".", kickoff->name, "() [Builder=<>t__builder, Completions=", completions, "]");
+    return S_OK;
+}
+
+/// <summary>
+/// Rewrite the method body of a target of a MethodMetrics integration. The original body is wrapped in a try/finally
+/// recording its duration, no integration code is called:
+///
+///     long start = MethodMetrics.Begin();
+///     try { original body } finally { MethodMetrics.End(method_id, start); }
+/// </summary>
+/// <param name="rewriter">Rewriter with the imported method body</param>
+/// <param name="module_metadata">Metadata of the module that defines the method</param>
+/// <param name="caller">Function info of the method</param>
+/// <param name="method_id">Id of the method in the native method metrics</param>
+/// <returns>S_OK if the IL was rewritten, S_FALSE if the method cannot be instrumented</returns>
+HRESULT CallTarget_RewriteMethodMetrics(ILRewriter*     rewriter,
+                                        ModuleMetadata* module_metadata,
+                                        FunctionInfo*   caller,
+                                        int32_t         method_id)
+{
+    CallTargetTokens*      callTargetTokens = module_metadata->GetCallTargetTokens();
+    FunctionMethodArgument retFuncArg       = caller->method_signature.GetRet();
+    ILRewriterWrapper      reWriterWrapper(rewriter);
+    ILInstr*               firstOriginalInstr = rewriter->GetILList()->m_pNext;
+    reWriterWrapper.SetILPosition(firstOriginalInstr);
+
+    // *** Modify the Local Var Signature of the method
+    ULONG startTimestampIndex = static_cast<ULONG>(ULONG_MAX);
+    ULONG returnValueIndex    = static_cast<ULONG>(ULONG_MAX);
+    auto  hr = callTargetTokens->ModifyLocalSigForMethodMetrics(rewriter, &retFuncArg, &startTimestampIndex,
+                                                                &returnValueIndex);
+    if (FAILED(hr))
+    {
+        return S_FALSE;
+    }
+    const bool isVoid = returnValueIndex == static_cast<ULONG>(ULONG_MAX);
+
+    // *** Read the start timestamp before the original body
+    ILInstr* beginCallInstr;
+    hr = callTargetTokens->WriteMethodMetricsBegin(&reWriterWrapper, &beginCallInstr);
+    if (FAILED(hr))
+    {
+        return S_FALSE;
+    }
+    reWriterWrapper.StLocal(startTimestampIndex);
+
+    // *** Create return instruction and insert it at the end
+    ILInstr* methodReturnInstr  = rewriter->NewILInstr();
+    methodReturnInstr->m_opcode = CEE_RET;
+    rewriter->InsertAfter(rewriter->GetILList()->m_pPrev, methodReturnInstr);
+    reWriterWrapper.SetILPosition(methodReturnInstr);
+
+    // *** Record the duration in the finally block
+    ILInstr* finallyFirstInstr = reWriterWrapper.LoadInt32(method_id);
+    reWriterWrapper.LoadLocal(startTimestampIndex);
+    ILInstr* endCallInstr;
+    hr = callTargetTokens->WriteMethodMetricsEnd(&reWriterWrapper, &endCallInstr);
+    if (FAILED(hr))
+    {
+        return S_FALSE;
+    }
+    ILInstr* endFinallyInstr = reWriterWrapper.EndFinally();
+
+    // Load the current return value from the local var
+    if (!isVoid)
+    {
+        reWriterWrapper.LoadLocal(returnValueIndex);
+    }
+
+    // Changes all returns to a LEAVE.S
+    for (ILInstr* pInstr = rewriter->GetILList()->m_pNext; pInstr != finallyFirstInstr; pInstr = pInstr->m_pNext)
+    {
+        if (pInstr->m_opcode == CEE_RET)
+        {
+            if (!isVoid)
+            {
+                reWriterWrapper.SetILPosition(pInstr);
+                reWriterWrapper.StLocal(returnValueIndex);
+            }
+            pInstr->m_opcode  = CEE_LEAVE_S;
+            pInstr->m_pTarget = endFinallyInstr->m_pNext;
+        }
+    }
+
+    EHClause finallyClause{};
+    finallyClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_FINALLY;
+    finallyClause.m_pTryBegin     = firstOriginalInstr;
+    finallyClause.m_pTryEnd       = finallyFirstInstr;
+    finallyClause.m_pHandlerBegin = finallyFirstInstr;
+    finallyClause.m_pHandlerEnd   = endFinallyInstr;
+    AddEHClause(rewriter, finallyClause);
+
+    return S_OK;
+}
+
+} // namespace trace
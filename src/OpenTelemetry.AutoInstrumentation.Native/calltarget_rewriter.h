@@ -0,0 +1,31 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_REWRITER_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_REWRITER_H_
+
+#include "calltarget_async.h"
+#include "calltarget_instantiations.h"
+#include "clr_helpers.h"
+#include "il_rewriter.h"
+#include "module_metadata.h"
+
+namespace trace
+{
+
+HRESULT CallTarget_RewriteMethodBody(ILRewriter* rewriter, ModuleMetadata* module_metadata, FunctionInfo* caller,
+                                     mdTypeRef wrapper_type_ref, const std::vector<ULONG>* argument_positions = nullptr,
+                                     const std::vector<CallTargetArgumentUse>& canonical_argument_uses = {},
+                                     const CallTargetAsyncStateMachine* async_state_machine = nullptr);
+
+HRESULT CallTarget_RewriteAsyncMoveNext(ILRewriter* rewriter, ModuleMetadata* module_metadata, FunctionInfo* kickoff,
+                                        mdTypeRef wrapper_type_ref, const CallTargetAsyncStateMachine& state_machine);
+
+HRESULT CallTarget_RewriteMethodMetrics(ILRewriter* rewriter, ModuleMetadata* module_metadata, FunctionInfo* caller,
+                                        int32_t method_id);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_REWRITER_H_
@@ -3,6 +3,8 @@
 
 #include "calltarget_tokens.h"
 
+#include <algorithm>
+
 #include "cor_profiler.h"
 #include "il_rewriter_wrapper.h"
 #include "logger.h"
@@ -26,7 +28,11 @@ static const WSTRING managed_profiler_calltarget_type =
     WStr("OpenTelemetry.AutoInstrumentation.CallTarget.CallTargetInvoker");
 static const WSTRING managed_profiler_calltarget_beginmethod_name     = WStr("BeginMethod");
 static const WSTRING managed_profiler_calltarget_endmethod_name       = WStr("EndMethod");
-static const WSTRING managed_profiler_calltarget_logexception_name    = WStr("LogException");
+static const WSTRING managed_profiler_calltarget_asyncmethodstarted_name = WStr("AsyncMethodStarted");
+static const WSTRING managed_profiler_calltarget_endasyncmethod_name     = WStr("EndAsyncMethod");
+static const WSTRING managed_profiler_calltarget_endasyncmethodwithexception_name =
+    WStr("EndAsyncMethodWithException");
+static const WSTRING managed_profiler_calltarget_logexception_name = WStr("LogException");
 static const WSTRING managed_profiler_calltarget_getdefaultvalue_name = WStr("GetDefaultValue");
 
 static const WSTRING managed_profiler_calltarget_statetype =
@@ -41,6 +47,28 @@ static const WSTRING managed_profiler_calltarget_returntype_generics =
     WStr("OpenTelemetry.AutoInstrumentation.CallTarget.CallTargetReturn`1");
 static const WSTRING managed_profiler_calltarget_returntype_getreturnvalue_name = WStr("GetReturnValue");
 
+static const WSTRING managed_profiler_calltarget_refstructtype =
+    WStr("OpenTelemetry.AutoInstrumentation.CallTarget.CallTargetRefStruct");
+static const WSTRING managed_profiler_calltarget_refstructtype_create_name = WStr("Create");
+
+static const WSTRING managed_profiler_methodmetrics_type =
+    WStr("OpenTelemetry.AutoInstrumentation.CallTarget.MethodMetrics");
+static const WSTRING managed_profiler_methodmetrics_begin_name = WStr("Begin");
+static const WSTRING managed_profiler_methodmetrics_end_name   = WStr("End");
+
+WSTRING CallTarget_GetBytecodeInstrumentationAssembly(const ModuleMetadata* module_metadata)
+{
+    if (trace::profiler != nullptr)
+    {
+        return trace::profiler->GetBytecodeInstrumentationAssembly();
+    }
+
+    // The .NET Framework assemblies reference the strong named profiler assembly.
+    return module_metadata->corAssemblyProperty->szName == mscorlib_assemblyName
+               ? managed_profiler_full_assembly_version_strong_name
+               : managed_profiler_full_assembly_version;
+}
+
 /**
  * PRIVATE
  **/
@@ -56,6 +84,17 @@ HRESULT CallTargetTokens::EnsureCorLibTokens()
     AssemblyProperty corAssemblyProperty = *module_metadata->corAssemblyProperty;
 
     // *** Ensure corlib assembly ref
+    if (corLibAssemblyRef == mdAssemblyRefNil && module_metadata->assemblyName == corAssemblyProperty.szName)
+    {
+        // When instrumenting CoreLib itself its types are referenced with the module as resolution scope.
+        auto hr = module_metadata->metadata_import->GetModuleFromScope(&corLibAssemblyRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper corlib module token could not be found.");
+            return hr;
+        }
+    }
+
     if (corLibAssemblyRef == mdAssemblyRefNil)
     {
         auto hr =
@@ -176,7 +215,7 @@ HRESULT CallTargetTokens::EnsureBaseCalltargetTokens()
     // *** Ensure profiler assembly ref
     if (profilerAssemblyRef == mdAssemblyRefNil)
     {
-        const auto bytecode_instrumentation_name = trace::profiler->GetBytecodeInstrumentationAssembly();
+        const auto bytecode_instrumentation_name = CallTarget_GetBytecodeInstrumentationAssembly(module_metadata);
         Logger::Debug("CallTargetTokens::EnsureBaseCalltargetTokens() Bytecode "
                       "Instrumentation Assembly: ",
                       bytecode_instrumentation_name);
@@ -273,6 +312,125 @@ HRESULT CallTargetTokens::EnsureBaseCalltargetTokens()
     return S_OK;
 }
 
+HRESULT CallTargetTokens::EnsureMethodMetricsTokens()
+{
+    auto hr = EnsureBaseCalltargetTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ModuleMetadata* module_metadata = GetMetadata();
+
+    // *** Ensure method metrics type ref
+    if (methodMetricsTypeRef == mdTypeRefNil)
+    {
+        hr = module_metadata->metadata_emit->DefineTypeRefByName(profilerAssemblyRef,
+                                                                 managed_profiler_methodmetrics_type.data(),
+                                                                 &methodMetricsTypeRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper methodMetricsTypeRef could not be defined.");
+            return hr;
+        }
+    }
+
+    // *** Ensure MethodMetrics.Begin() member ref
+    if (methodMetricsBeginRef == mdMemberRefNil)
+    {
+        COR_SIGNATURE signature[] = {IMAGE_CEE_CS_CALLCONV_DEFAULT, 0x00, ELEMENT_TYPE_I8};
+
+        hr = module_metadata->metadata_emit->DefineMemberRef(methodMetricsTypeRef,
+                                                             managed_profiler_methodmetrics_begin_name.data(),
+                                                             signature, sizeof(signature), &methodMetricsBeginRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper methodMetricsBeginRef could not be defined.");
+            return hr;
+        }
+    }
+
+    // *** Ensure MethodMetrics.End(int, long) member ref
+    if (methodMetricsEndRef == mdMemberRefNil)
+    {
+        COR_SIGNATURE signature[] = {IMAGE_CEE_CS_CALLCONV_DEFAULT, 0x02, ELEMENT_TYPE_VOID, ELEMENT_TYPE_I4,
+                                     ELEMENT_TYPE_I8};
+
+        hr = module_metadata->metadata_emit->DefineMemberRef(methodMetricsTypeRef,
+                                                             managed_profiler_methodmetrics_end_name.data(), signature,
+                                                             sizeof(signature), &methodMetricsEndRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper methodMetricsEndRef could not be defined.");
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+HRESULT CallTargetTokens::EnsureCallTargetRefStructTokens()
+{
+    auto hr = EnsureBaseCalltargetTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ModuleMetadata* module_metadata = GetMetadata();
+
+    // *** Ensure CallTargetRefStruct type ref
+    if (callTargetRefStructTypeRef == mdTypeRefNil)
+    {
+        hr = module_metadata->metadata_emit->DefineTypeRefByName(profilerAssemblyRef,
+                                                                 managed_profiler_calltarget_refstructtype.data(),
+                                                                 &callTargetRefStructTypeRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper callTargetRefStructTypeRef could not be defined.");
+            return hr;
+        }
+    }
+
+    // *** Ensure CallTargetRefStruct.Create(void*, RuntimeTypeHandle) member ref
+    if (callTargetRefStructCreateRef == mdMemberRefNil)
+    {
+        unsigned callTargetRefStructTypeBuffer;
+        auto callTargetRefStructTypeSize = CorSigCompressToken(callTargetRefStructTypeRef, &callTargetRefStructTypeBuffer);
+
+        unsigned runtimeTypeHandleBuffer;
+        auto     runtimeTypeHandleSize = CorSigCompressToken(runtimeTypeHandleRef, &runtimeTypeHandleBuffer);
+
+        COR_SIGNATURE signature[signatureBufferSize];
+        unsigned      offset = 0;
+
+        signature[offset++] = IMAGE_CEE_CS_CALLCONV_DEFAULT;
+        signature[offset++] = 0x02;
+
+        signature[offset++] = ELEMENT_TYPE_VALUETYPE;
+        memcpy(&signature[offset], &callTargetRefStructTypeBuffer, callTargetRefStructTypeSize);
+        offset += callTargetRefStructTypeSize;
+
+        signature[offset++] = ELEMENT_TYPE_PTR;
+        signature[offset++] = ELEMENT_TYPE_VOID;
+
+        signature[offset++] = ELEMENT_TYPE_VALUETYPE;
+        memcpy(&signature[offset], &runtimeTypeHandleBuffer, runtimeTypeHandleSize);
+        offset += runtimeTypeHandleSize;
+
+        hr = module_metadata->metadata_emit->DefineMemberRef(callTargetRefStructTypeRef,
+                                                             managed_profiler_calltarget_refstructtype_create_name.data(),
+                                                             signature, offset, &callTargetRefStructCreateRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper callTargetRefStructCreateRef could not be defined.");
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
 mdTypeRef CallTargetTokens::GetTargetStateTypeRef()
 {
     auto hr = EnsureBaseCalltargetTokens();
@@ -551,6 +709,8 @@ mdToken CallTargetTokens::GetCurrentTypeRef(const TypeInfo* currentType, bool& i
 
 HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
                                          FunctionMethodArgument* methodReturnValue,
+                                         ULONG                   refStructLocalsCount,
+                                         ULONG*                  refStructFirstIndex,
                                          ULONG*                  callTargetStateIndex,
                                          ULONG*                  exceptionIndex,
                                          ULONG*                  callTargetReturnIndex,
@@ -559,7 +719,7 @@ HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
                                          mdToken*                exceptionToken,
                                          mdToken*                callTargetReturnToken)
 {
-    auto hr = EnsureBaseCalltargetTokens();
+    auto hr = refStructLocalsCount > 0 ? EnsureCallTargetRefStructTokens() : EnsureBaseCalltargetTokens();
     if (FAILED(hr))
     {
         return hr;
@@ -593,7 +753,16 @@ HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
         }
     }
 
-    ULONG newLocalsCount = 3;
+    ULONG newLocalsCount = 3 + refStructLocalsCount;
+
+    // Gets the calltarget ref struct type buffer and size
+    unsigned callTargetRefStructTypeRefBuffer = 0;
+    ULONG    callTargetRefStructTypeRefSize   = 0;
+    if (refStructLocalsCount > 0)
+    {
+        callTargetRefStructTypeRefSize =
+            CorSigCompressToken(callTargetRefStructTypeRef, &callTargetRefStructTypeRefBuffer);
+    }
 
     // Gets the calltarget state type buffer and size
     unsigned callTargetStateTypeRefBuffer;
@@ -641,8 +810,9 @@ HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
     }
 
     // New signature size
-    ULONG newSignatureSize = originalSignatureSize + returnSignatureTypeSize + (1 + exTypeRefSize) +
-                             callTargetReturnSizeForNewSignature + (1 + callTargetStateTypeRefSize);
+    ULONG newSignatureSize = originalSignatureSize + (refStructLocalsCount * (1 + callTargetRefStructTypeRefSize)) +
+                             returnSignatureTypeSize + (1 + exTypeRefSize) + callTargetReturnSizeForNewSignature +
+                             (1 + callTargetStateTypeRefSize);
     ULONG newSignatureOffset = 0;
 
     ULONG    oldLocalsBuffer;
@@ -682,6 +852,15 @@ HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
 
     // Add new locals
 
+    // Ref struct arguments locals
+    for (ULONG i = 0; i < refStructLocalsCount; i++)
+    {
+        newSignatureBuffer[newSignatureOffset++] = ELEMENT_TYPE_VALUETYPE;
+        memcpy(&newSignatureBuffer[newSignatureOffset], &callTargetRefStructTypeRefBuffer,
+               callTargetRefStructTypeRefSize);
+        newSignatureOffset += callTargetRefStructTypeRefSize;
+    }
+
     // Return value local
     if (returnSignatureType != nullptr)
     {
@@ -736,6 +915,7 @@ HRESULT CallTargetTokens::ModifyLocalSig(ILRewriter*             reWriter,
     *exceptionIndex        = newLocalsCount - 3;
     *callTargetReturnIndex = newLocalsCount - 2;
     *callTargetStateIndex  = newLocalsCount - 1;
+    *refStructFirstIndex   = newLocalsCount - 3 - (returnSignatureType != nullptr ? 1 : 0) - refStructLocalsCount;
     return hr;
 }
 
@@ -753,12 +933,14 @@ HRESULT CallTargetTokens::WriteBeginMethodWithArgumentsArray(void*           rew
     ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
     ModuleMetadata*    module_metadata = GetMetadata();
 
+    bool         byRefInstance       = currentType->valueType;
+    mdMemberRef& beginArrayMemberRef = byRefInstance ? this->beginArrayByRefMemberRef : this->beginArrayMemberRef;
     if (beginArrayMemberRef == mdMemberRefNil)
     {
         unsigned callTargetStateBuffer;
         auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
 
-        auto          signatureLength = 8 + callTargetStateSize;
+        auto          signatureLength = 8 + (byRefInstance ? 1 : 0) + callTargetStateSize;
         COR_SIGNATURE signature[signatureBufferSize];
         unsigned      offset = 0;
 
@@ -770,6 +952,10 @@ HRESULT CallTargetTokens::WriteBeginMethodWithArgumentsArray(void*           rew
         memcpy(&signature[offset], &callTargetStateBuffer, callTargetStateSize);
         offset += callTargetStateSize;
 
+        if (byRefInstance)
+        {
+            signature[offset++] = ELEMENT_TYPE_BYREF;
+        }
         signature[offset++] = ELEMENT_TYPE_MVAR;
         signature[offset++] = 0x01;
 
@@ -839,7 +1025,9 @@ CallTargetTokens::CallTargetTokens(ModuleMetadata* module_metadata_ptr)
     this->module_metadata_ptr = module_metadata_ptr;
     for (int i = 0; i < FASTPATH_COUNT; i++)
     {
-        beginMethodFastPathRefs[i] = mdMemberRefNil;
+        beginMethodFastPathRefs[i]               = mdMemberRefNil;
+        beginMethodFastPathByRefRefs[i]          = mdMemberRefNil;
+        beginMethodFastPathByRefArgumentsRefs[i] = mdMemberRefNil;
     }
 }
 
@@ -856,8 +1044,45 @@ mdAssemblyRef CallTargetTokens::GetCorLibAssemblyRef()
     return corLibAssemblyRef;
 }
 
+bool CallTargetTokens::IsRefStructArgument(const FunctionMethodArgument& argument)
+{
+    PCCOR_SIGNATURE signature     = nullptr;
+    const ULONG     signatureSize = argument.GetSignature(signature);
+
+    ULONG offset = 0;
+    if (offset < signatureSize && signature[offset] == ELEMENT_TYPE_BYREF)
+    {
+        offset++;
+    }
+    if (offset < signatureSize && signature[offset] == ELEMENT_TYPE_GENERICINST)
+    {
+        offset++;
+    }
+    if (offset + 1 >= signatureSize || signature[offset] != ELEMENT_TYPE_VALUETYPE)
+    {
+        return false;
+    }
+
+    mdToken typeToken = mdTokenNil;
+    CorSigUncompressToken(&signature[offset + 1], &typeToken);
+
+    const auto& metadata_import = GetMetadata()->metadata_import;
+    if (TypeFromToken(typeToken) == mdtTypeDef)
+    {
+        return metadata_import->GetCustomAttributeByName(typeToken, IsByRefLikeAttributeTypeName, nullptr, nullptr) ==
+               S_OK;
+    }
+
+    // The type references can't be resolved to their definitions here, only the span types are known to be ref
+    // structs.
+    const auto typeName = GetTypeInfo(metadata_import, typeToken).name;
+    return typeName == SystemSpanTypeName || typeName == SystemReadOnlySpanTypeName;
+}
+
 HRESULT CallTargetTokens::ModifyLocalSigAndInitialize(void*         rewriterWrapperPtr,
                                                       FunctionInfo* functionInfo,
+                                                      ULONG         refStructLocalsCount,
+                                                      ULONG*        refStructFirstIndex,
                                                       ULONG*        callTargetStateIndex,
                                                       ULONG*        exceptionIndex,
                                                       ULONG*        callTargetReturnIndex,
@@ -872,9 +1097,9 @@ HRESULT CallTargetTokens::ModifyLocalSigAndInitialize(void*         rewriterWrap
     // Modify the Local Var Signature of the method
     auto returnFunctionMethod = functionInfo->method_signature.GetRet();
 
-    auto hr = ModifyLocalSig(rewriterWrapper->GetILRewriter(), &returnFunctionMethod, callTargetStateIndex,
-                             exceptionIndex, callTargetReturnIndex, returnValueIndex, callTargetStateToken,
-                             exceptionToken, callTargetReturnToken);
+    auto hr = ModifyLocalSig(rewriterWrapper->GetILRewriter(), &returnFunctionMethod, refStructLocalsCount,
+                             refStructFirstIndex, callTargetStateIndex, exceptionIndex, callTargetReturnIndex,
+                             returnValueIndex, callTargetStateToken, exceptionToken, callTargetReturnToken);
 
     if (FAILED(hr))
     {
@@ -911,9 +1136,13 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
                                            mdTypeRef                            integrationTypeRef,
                                            const TypeInfo*                      currentType,
                                            std::vector<FunctionMethodArgument>& methodArguments,
+                                           const std::vector<bool>&             refStructArguments,
+                                           const std::vector<bool>&             canonicalArguments,
                                            ILInstr**                            instruction)
 {
-    auto hr = EnsureBaseCalltargetTokens();
+    const bool hasRefStructArguments =
+        std::find(refStructArguments.begin(), refStructArguments.end(), true) != refStructArguments.end();
+    auto hr = hasRefStructArguments ? EnsureCallTargetRefStructTokens() : EnsureBaseCalltargetTokens();
     if (FAILED(hr))
     {
         return hr;
@@ -932,12 +1161,26 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
     // FastPath
     //
 
-    if (beginMethodFastPathRefs[numArguments] == mdMemberRefNil)
+    // A method with by-ref or ref struct arguments passes all its arguments by reference, the by-ref arguments are
+    // forwarded and the ref structs are wrapped in a CallTargetRefStruct local.
+    bool     byRefArguments = hasRefStructArguments;
+    unsigned elementType;
+    for (auto i = 0; i < numArguments; i++)
+    {
+        byRefArguments |= (methodArguments[i].GetTypeFlags(elementType) & TypeFlagByRef) > 0;
+    }
+
+    bool         byRefInstance          = currentType->valueType || byRefArguments;
+    mdMemberRef& beginMethodFastPathRef = byRefArguments ? beginMethodFastPathByRefArgumentsRefs[numArguments]
+                                          : byRefInstance ? beginMethodFastPathByRefRefs[numArguments]
+                                                          : beginMethodFastPathRefs[numArguments];
+    if (beginMethodFastPathRef == mdMemberRefNil)
     {
         unsigned callTargetStateBuffer;
         auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
 
-        auto          signatureLength = 6 + (numArguments * 2) + callTargetStateSize;
+        auto signatureLength =
+            6 + (byRefInstance ? 1 : 0) + (numArguments * (byRefArguments ? 3 : 2)) + callTargetStateSize;
         COR_SIGNATURE signature[signatureBufferSize];
         unsigned      offset = 0;
 
@@ -949,11 +1192,19 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
         memcpy(&signature[offset], &callTargetStateBuffer, callTargetStateSize);
         offset += callTargetStateSize;
 
+        if (byRefInstance)
+        {
+            signature[offset++] = ELEMENT_TYPE_BYREF;
+        }
         signature[offset++] = ELEMENT_TYPE_MVAR;
         signature[offset++] = 0x01;
 
         for (auto i = 0; i < numArguments; i++)
         {
+            if (byRefArguments)
+            {
+                signature[offset++] = ELEMENT_TYPE_BYREF;
+            }
             signature[offset++] = ELEMENT_TYPE_MVAR;
             signature[offset++] = 0x01 + (i + 1);
         }
@@ -961,7 +1212,7 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
         auto hr = module_metadata->metadata_emit->DefineMemberRef(callTargetTypeRef,
                                                                   managed_profiler_calltarget_beginmethod_name.data(),
                                                                   signature, signatureLength,
-                                                                  &beginMethodFastPathRefs[numArguments]);
+                                                                  &beginMethodFastPathRef);
         if (FAILED(hr))
         {
             Logger::Warn("Wrapper beginMethod for ", numArguments, " arguments could not be defined.");
@@ -982,13 +1233,40 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
 
     auto signatureLength = 4 + integrationTypeSize + currentTypeSize;
 
-    PCCOR_SIGNATURE argumentsSignatureBuffer[FASTPATH_COUNT];
-    ULONG           argumentsSignatureSize[FASTPATH_COUNT];
+    unsigned callTargetRefStructTypeBuffer = 0;
+    ULONG    callTargetRefStructTypeSize   = 0;
+    if (hasRefStructArguments)
+    {
+        callTargetRefStructTypeSize = CorSigCompressToken(callTargetRefStructTypeRef, &callTargetRefStructTypeBuffer);
+    }
+
+    // The generic arguments are the types of the arguments without the by-ref, the ref structs use CallTargetRefStruct
+    // and the canonical arguments use System.Object.
+    static const COR_SIGNATURE objectSignature = ELEMENT_TYPE_OBJECT;
+    PCCOR_SIGNATURE            argumentsSignatureBuffer[FASTPATH_COUNT];
+    ULONG                      argumentsSignatureSize[FASTPATH_COUNT];
     for (auto i = 0; i < numArguments; i++)
     {
-        auto signatureSize        = methodArguments[i].GetSignature(argumentsSignatureBuffer[i]);
-        argumentsSignatureSize[i] = signatureSize;
-        signatureLength += signatureSize;
+        if (canonicalArguments[i])
+        {
+            argumentsSignatureBuffer[i] = &objectSignature;
+            argumentsSignatureSize[i]   = 1;
+        }
+        else if (refStructArguments[i])
+        {
+            argumentsSignatureBuffer[i] = nullptr;
+            argumentsSignatureSize[i]   = 1 + callTargetRefStructTypeSize;
+        }
+        else
+        {
+            argumentsSignatureSize[i] = methodArguments[i].GetSignature(argumentsSignatureBuffer[i]);
+            if (argumentsSignatureBuffer[i][0] == ELEMENT_TYPE_BYREF)
+            {
+                argumentsSignatureBuffer[i]++;
+                argumentsSignatureSize[i]--;
+            }
+        }
+        signatureLength += argumentsSignatureSize[i];
     }
 
     COR_SIGNATURE signature[signatureBufferSize];
@@ -1014,12 +1292,21 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
 
     for (auto i = 0; i < numArguments; i++)
     {
-        memcpy(&signature[offset], argumentsSignatureBuffer[i], argumentsSignatureSize[i]);
-        offset += argumentsSignatureSize[i];
+        if (argumentsSignatureBuffer[i] == nullptr)
+        {
+            signature[offset++] = ELEMENT_TYPE_VALUETYPE;
+            memcpy(&signature[offset], &callTargetRefStructTypeBuffer, callTargetRefStructTypeSize);
+            offset += callTargetRefStructTypeSize;
+        }
+        else
+        {
+            memcpy(&signature[offset], argumentsSignatureBuffer[i], argumentsSignatureSize[i]);
+            offset += argumentsSignatureSize[i];
+        }
     }
 
-    hr = module_metadata->metadata_emit->DefineMethodSpec(beginMethodFastPathRefs[numArguments], signature,
-                                                          signatureLength, &beginMethodSpec);
+    hr = module_metadata->metadata_emit->DefineMethodSpec(beginMethodFastPathRef, signature, signatureLength,
+                                                          &beginMethodSpec);
     if (FAILED(hr))
     {
         Logger::Warn("Error creating begin method spec.");
@@ -1030,6 +1317,36 @@ HRESULT CallTargetTokens::WriteBeginMethod(void*
     return S_OK;
 }
 
+HRESULT CallTargetTokens::WriteRefStructArgument(void*                         rewriterWrapperPtr,
+                                                 const FunctionMethodArgument& argument,
+                                                 ULONG                         refStructIndex,
+                                                 ILInstr**                     instruction)
+{
+    auto hr = EnsureCallTargetRefStructTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
+    auto               metadata_emit   = GetMetadata()->metadata_emit;
+
+    mdToken argumentTypeToken = argument.GetTypeTok(metadata_emit, corLibAssemblyRef);
+    if (argumentTypeToken == mdTokenNil)
+    {
+        Logger::Warn("Wrapper ref struct argument type could not be defined.");
+        return E_FAIL;
+    }
+
+    // The address of the argument is on the stack, ref structs live in the stack so it can be passed as a pointer.
+    *instruction = rewriterWrapper->CreateInstr(CEE_CONV_U);
+    rewriterWrapper->LoadToken(argumentTypeToken);
+    rewriterWrapper->CallMember(callTargetRefStructCreateRef, false);
+    rewriterWrapper->StLocal(refStructIndex);
+    rewriterWrapper->LoadLocalAddress(refStructIndex);
+    return S_OK;
+}
+
 // endmethod with void return
 HRESULT CallTargetTokens::WriteEndVoidReturnMemberRef(void*           rewriterWrapperPtr,
                                                       mdTypeRef       integrationTypeRef,
@@ -1044,6 +1361,8 @@ HRESULT CallTargetTokens::WriteEndVoidReturnMemberRef(void*           rewriterWr
     ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
     ModuleMetadata*    module_metadata = GetMetadata();
 
+    bool         byRefInstance    = currentType->valueType;
+    mdMemberRef& endVoidMemberRef = byRefInstance ? this->endVoidByRefMemberRef : this->endVoidMemberRef;
     if (endVoidMemberRef == mdMemberRefNil)
     {
         unsigned callTargetReturnVoidBuffer;
@@ -1055,7 +1374,8 @@ HRESULT CallTargetTokens::WriteEndVoidReturnMemberRef(void*           rewriterWr
         unsigned callTargetStateBuffer;
         auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
 
-        auto          signatureLength = 8 + callTargetReturnVoidSize + exTypeRefSize + callTargetStateSize;
+        auto signatureLength =
+            8 + (byRefInstance ? 1 : 0) + callTargetReturnVoidSize + exTypeRefSize + callTargetStateSize;
         COR_SIGNATURE signature[signatureBufferSize];
         unsigned      offset = 0;
 
@@ -1067,6 +1387,10 @@ HRESULT CallTargetTokens::WriteEndVoidReturnMemberRef(void*           rewriterWr
         memcpy(&signature[offset], &callTargetReturnVoidBuffer, callTargetReturnVoidSize);
         offset += callTargetReturnVoidSize;
 
+        if (byRefInstance)
+        {
+            signature[offset++] = ELEMENT_TYPE_BYREF;
+        }
         signature[offset++] = ELEMENT_TYPE_MVAR;
         signature[offset++] = 0x01;
 
@@ -1151,6 +1475,7 @@ HRESULT CallTargetTokens::WriteEndReturnMemberRef(void*                   rewrit
     // *** Define base MethodMemberRef for the type
 
     mdMemberRef endMethodMemberRef = mdMemberRefNil;
+    bool        byRefInstance      = currentType->valueType;
 
     unsigned callTargetReturnTypeRefBuffer;
     auto     callTargetReturnTypeRefSize = CorSigCompressToken(callTargetReturnTypeRef, &callTargetReturnTypeRefBuffer);
@@ -1161,7 +1486,8 @@ HRESULT CallTargetTokens::WriteEndReturnMemberRef(void*                   rewrit
     unsigned callTargetStateBuffer;
     auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
 
-    auto          signatureLength = 14 + callTargetReturnTypeRefSize + exTypeRefSize + callTargetStateSize;
+    auto signatureLength =
+        14 + (byRefInstance ? 1 : 0) + callTargetReturnTypeRefSize + exTypeRefSize + callTargetStateSize;
     COR_SIGNATURE signature[signatureBufferSize];
     unsigned      offset = 0;
 
@@ -1177,6 +1503,10 @@ HRESULT CallTargetTokens::WriteEndReturnMemberRef(void*                   rewrit
     signature[offset++] = ELEMENT_TYPE_MVAR;
     signature[offset++] = 0x02;
 
+    if (byRefInstance)
+    {
+        signature[offset++] = ELEMENT_TYPE_BYREF;
+    }
     signature[offset++] = ELEMENT_TYPE_MVAR;
     signature[offset++] = 0x01;
 
@@ -1252,6 +1582,204 @@ HRESULT CallTargetTokens::WriteEndReturnMemberRef(void*                   rewrit
     return S_OK;
 }
 
+HRESULT CallTargetTokens::WriteAsyncMethodStarted(void*           rewriterWrapperPtr,
+                                                  mdTypeRef       integrationTypeRef,
+                                                  const TypeInfo* currentType,
+                                                  ILInstr**       instruction)
+{
+    auto hr = EnsureBaseCalltargetTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
+    ModuleMetadata*    module_metadata = GetMetadata();
+
+    if (asyncMethodStartedMemberRef == mdMemberRefNil)
+    {
+        unsigned callTargetStateBuffer;
+        auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
+
+        auto          signatureLength = 5 + callTargetStateSize;
+        COR_SIGNATURE signature[signatureBufferSize];
+        unsigned      offset = 0;
+
+        signature[offset++] = IMAGE_CEE_CS_CALLCONV_GENERIC;
+        signature[offset++] = 0x02;
+        signature[offset++] = 0x01;
+
+        signature[offset++] = ELEMENT_TYPE_VOID;
+        signature[offset++] = ELEMENT_TYPE_VALUETYPE;
+        memcpy(&signature[offset], &callTargetStateBuffer, callTargetStateSize);
+        offset += callTargetStateSize;
+
+        hr = module_metadata->metadata_emit->DefineMemberRef(callTargetTypeRef,
+                                                             managed_profiler_calltarget_asyncmethodstarted_name.data(),
+                                                             signature, signatureLength,
+                                                             &asyncMethodStartedMemberRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper asyncMethodStartedMemberRef could not be defined.");
+            return hr;
+        }
+    }
+
+    mdMethodSpec asyncMethodStartedMethodSpec = mdMethodSpecNil;
+
+    unsigned integrationTypeBuffer;
+    ULONG    integrationTypeSize = CorSigCompressToken(integrationTypeRef, &integrationTypeBuffer);
+
+    bool    isValueType    = currentType->valueType;
+    mdToken currentTypeRef = GetCurrentTypeRef(currentType, isValueType);
+
+    unsigned currentTypeBuffer;
+    ULONG    currentTypeSize = CorSigCompressToken(currentTypeRef, &currentTypeBuffer);
+
+    auto          signatureLength = 4 + integrationTypeSize + currentTypeSize;
+    COR_SIGNATURE signature[signatureBufferSize];
+    unsigned      offset = 0;
+    signature[offset++]  = IMAGE_CEE_CS_CALLCONV_GENERICINST;
+    signature[offset++]  = 0x02;
+
+    signature[offset++] = ELEMENT_TYPE_CLASS;
+    memcpy(&signature[offset], &integrationTypeBuffer, integrationTypeSize);
+    offset += integrationTypeSize;
+
+    signature[offset++] = isValueType ? ELEMENT_TYPE_VALUETYPE : ELEMENT_TYPE_CLASS;
+    memcpy(&signature[offset], &currentTypeBuffer, currentTypeSize);
+    offset += currentTypeSize;
+
+    hr = module_metadata->metadata_emit->DefineMethodSpec(asyncMethodStartedMemberRef, signature, signatureLength,
+                                                          &asyncMethodStartedMethodSpec);
+    if (FAILED(hr))
+    {
+        Logger::Warn("Error creating async method started method spec.");
+        return hr;
+    }
+
+    *instruction = rewriterWrapper->CallMember(asyncMethodStartedMethodSpec, false);
+    return S_OK;
+}
+
+HRESULT CallTargetTokens::WriteEndAsyncMethod(void*           rewriterWrapperPtr,
+                                              mdTypeRef       integrationTypeRef,
+                                              const TypeInfo* currentType,
+                                              PCCOR_SIGNATURE resultSignature,
+                                              ULONG           resultSignatureLength,
+                                              bool            withException,
+                                              ILInstr**       instruction)
+{
+    auto hr = EnsureBaseCalltargetTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
+    ModuleMetadata*    module_metadata = GetMetadata();
+
+    // *** Define base MethodMemberRef, the value passed to the builder is returned by the call
+    mdMemberRef& endAsyncMethodRef = withException ? endAsyncMethodWithExceptionMemberRef : endAsyncMethodMemberRef;
+    if (endAsyncMethodRef == mdMemberRefNil)
+    {
+        unsigned exTypeRefBuffer;
+        auto     exTypeRefSize = CorSigCompressToken(exTypeRef, &exTypeRefBuffer);
+
+        unsigned callTargetStateBuffer;
+        auto     callTargetStateSize = CorSigCompressToken(callTargetStateTypeRef, &callTargetStateBuffer);
+
+        COR_SIGNATURE signature[signatureBufferSize];
+        unsigned      offset = 0;
+
+        signature[offset++] = IMAGE_CEE_CS_CALLCONV_GENERIC;
+        signature[offset++] = 0x03;
+        signature[offset++] = 0x03;
+
+        // The return value and the first parameter have the same type.
+        for (int i = 0; i < 2; i++)
+        {
+            if (withException)
+            {
+                signature[offset++] = ELEMENT_TYPE_CLASS;
+                memcpy(&signature[offset], &exTypeRefBuffer, exTypeRefSize);
+                offset += exTypeRefSize;
+            }
+            else
+            {
+                signature[offset++] = ELEMENT_TYPE_MVAR;
+                signature[offset++] = 0x02;
+            }
+        }
+
+        signature[offset++] = ELEMENT_TYPE_MVAR;
+        signature[offset++] = 0x01;
+
+        signature[offset++] = ELEMENT_TYPE_VALUETYPE;
+        memcpy(&signature[offset], &callTargetStateBuffer, callTargetStateSize);
+        offset += callTargetStateSize;
+
+        const auto& methodName = withException ? managed_profiler_calltarget_endasyncmethodwithexception_name
+                                               : managed_profiler_calltarget_endasyncmethod_name;
+        hr = module_metadata->metadata_emit->DefineMemberRef(callTargetTypeRef, methodName.data(), signature, offset,
+                                                             &endAsyncMethodRef);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Wrapper endAsyncMethodMemberRef could not be defined.");
+            return hr;
+        }
+    }
+
+    // *** Define Method Spec
+    mdMethodSpec endAsyncMethodSpec = mdMethodSpecNil;
+
+    unsigned integrationTypeBuffer;
+    ULONG    integrationTypeSize = CorSigCompressToken(integrationTypeRef, &integrationTypeBuffer);
+
+    bool    isValueType    = currentType->valueType;
+    mdToken currentTypeRef = GetCurrentTypeRef(currentType, isValueType);
+
+    unsigned currentTypeBuffer;
+    ULONG    currentTypeSize = CorSigCompressToken(currentTypeRef, &currentTypeBuffer);
+
+    COR_SIGNATURE signature[signatureBufferSize];
+    unsigned      offset = 0;
+
+    signature[offset++] = IMAGE_CEE_CS_CALLCONV_GENERICINST;
+    signature[offset++] = 0x03;
+
+    signature[offset++] = ELEMENT_TYPE_CLASS;
+    memcpy(&signature[offset], &integrationTypeBuffer, integrationTypeSize);
+    offset += integrationTypeSize;
+
+    signature[offset++] = isValueType ? ELEMENT_TYPE_VALUETYPE : ELEMENT_TYPE_CLASS;
+    memcpy(&signature[offset], &currentTypeBuffer, currentTypeSize);
+    offset += currentTypeSize;
+
+    if (resultSignature == nullptr)
+    {
+        signature[offset++] = ELEMENT_TYPE_OBJECT;
+    }
+    else
+    {
+        if (offset + resultSignatureLength > signatureBufferSize)
+        {
+            Logger::Warn("The result type signature of the async method is too long.");
+            return E_FAIL;
+        }
+        memcpy(&signature[offset], resultSignature, resultSignatureLength);
+        offset += resultSignatureLength;
+    }
+
+    hr = module_metadata->metadata_emit->DefineMethodSpec(endAsyncMethodRef, signature, offset, &endAsyncMethodSpec);
+    if (FAILED(hr))
+    {
+        Logger::Warn("Error creating end async method member spec.");
+        return hr;
+    }
+
+    *instruction = rewriterWrapper->CallMember(endAsyncMethodSpec, false);
+    return S_OK;
+}
+
 // write log exception
 HRESULT CallTargetTokens::WriteLogException(void*           rewriterWrapperPtr,
                                             mdTypeRef       integrationTypeRef,
@@ -1375,4 +1903,133 @@ HRESULT CallTargetTokens::WriteCallTargetReturnGetReturnValue(void*      rewrite
     return S_OK;
 }
 
+HRESULT CallTargetTokens::ModifyLocalSigForMethodMetrics(ILRewriter*             reWriter,
+                                                         FunctionMethodArgument* methodReturnValue,
+                                                         ULONG*                  startTimestampIndex,
+                                                         ULONG*                  returnValueIndex)
+{
+    auto hr = EnsureMethodMetricsTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ModuleMetadata* module_metadata = GetMetadata();
+
+    PCCOR_SIGNATURE originalSignature     = nullptr;
+    ULONG           originalSignatureSize = 0;
+    mdToken         localVarSig           = reWriter->GetTkLocalVarSig();
+    if (localVarSig != mdTokenNil)
+    {
+        IfFailRet(
+            module_metadata->metadata_import->GetSigFromToken(localVarSig, &originalSignature, &originalSignatureSize));
+    }
+
+    // Gets the Return type signature
+    PCCOR_SIGNATURE returnSignatureType     = nullptr;
+    ULONG           returnSignatureTypeSize = 0;
+    unsigned        retTypeElementType;
+    ULONG           newLocalsCount = 1;
+    if (methodReturnValue->GetTypeFlags(retTypeElementType) != TypeFlagVoid)
+    {
+        returnSignatureTypeSize = methodReturnValue->GetSignature(returnSignatureType);
+        newLocalsCount++;
+    }
+
+    // New signature size
+    ULONG newSignatureSize   = originalSignatureSize + returnSignatureTypeSize + 1;
+    ULONG newSignatureOffset = 0;
+
+    ULONG    oldLocalsBuffer;
+    ULONG    oldLocalsLen = 0;
+    unsigned newLocalsBuffer;
+    ULONG    newLocalsLen;
+
+    // Calculate the new locals count
+    if (originalSignatureSize == 0)
+    {
+        newSignatureSize += 2;
+        newLocalsLen = CorSigCompressData(newLocalsCount, &newLocalsBuffer);
+    }
+    else
+    {
+        oldLocalsLen = CorSigUncompressData(originalSignature + 1, &oldLocalsBuffer);
+        newLocalsCount += oldLocalsBuffer;
+        newLocalsLen = CorSigCompressData(newLocalsCount, &newLocalsBuffer);
+        newSignatureSize += newLocalsLen - oldLocalsLen;
+    }
+
+    if (newSignatureSize > signatureBufferSize)
+    {
+        Logger::Warn("The locals var signature is too large to add the method metrics locals.");
+        return E_FAIL;
+    }
+
+    // New signature declaration
+    COR_SIGNATURE newSignatureBuffer[signatureBufferSize];
+    newSignatureBuffer[newSignatureOffset++] = IMAGE_CEE_CS_CALLCONV_LOCAL_SIG;
+
+    // Set the locals count
+    memcpy(&newSignatureBuffer[newSignatureOffset], &newLocalsBuffer, newLocalsLen);
+    newSignatureOffset += newLocalsLen;
+
+    // Copy previous locals to the signature
+    if (originalSignatureSize > 0)
+    {
+        const auto copyLength = originalSignatureSize - 1 - oldLocalsLen;
+        memcpy(&newSignatureBuffer[newSignatureOffset], originalSignature + 1 + oldLocalsLen, copyLength);
+        newSignatureOffset += copyLength;
+    }
+
+    // Return value local
+    if (returnSignatureType != nullptr)
+    {
+        memcpy(&newSignatureBuffer[newSignatureOffset], returnSignatureType, returnSignatureTypeSize);
+        newSignatureOffset += returnSignatureTypeSize;
+    }
+
+    // Start timestamp local
+    newSignatureBuffer[newSignatureOffset++] = ELEMENT_TYPE_I8;
+
+    // Get new locals token
+    mdToken newLocalVarSig;
+    hr = module_metadata->metadata_emit->GetTokenFromSig(newSignatureBuffer, newSignatureSize, &newLocalVarSig);
+    if (FAILED(hr))
+    {
+        Logger::Warn("Error creating new locals var signature.");
+        return hr;
+    }
+
+    reWriter->SetTkLocalVarSig(newLocalVarSig);
+    *returnValueIndex    = returnSignatureType != nullptr ? newLocalsCount - 2 : static_cast<ULONG>(ULONG_MAX);
+    *startTimestampIndex = newLocalsCount - 1;
+    return S_OK;
+}
+
+HRESULT CallTargetTokens::WriteMethodMetricsBegin(void* rewriterWrapperPtr, ILInstr** instruction)
+{
+    auto hr = EnsureMethodMetricsTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
+    *instruction                       = rewriterWrapper->CallMember(methodMetricsBeginRef, false);
+    return S_OK;
+}
+
+HRESULT CallTargetTokens::WriteMethodMetricsEnd(void* rewriterWrapperPtr, ILInstr** instruction)
+{
+    auto hr = EnsureMethodMetricsTokens();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ILRewriterWrapper* rewriterWrapper = (ILRewriterWrapper*)rewriterWrapperPtr;
+    *instruction                       = rewriterWrapper->CallMember(methodMetricsEndRef, false);
+    return S_OK;
+}
+
 } // namespace trace
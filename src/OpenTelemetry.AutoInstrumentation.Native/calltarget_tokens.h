@@ -47,13 +47,34 @@ private:
     mdTypeRef callTargetStateTypeRef = mdTypeRefNil;
     mdTypeRef callTargetReturnVoidTypeRef = mdTypeRefNil;
     mdTypeRef callTargetReturnTypeRef = mdTypeRefNil;
+    mdTypeRef callTargetRefStructTypeRef = mdTypeRefNil;
+    mdMemberRef callTargetRefStructCreateRef = mdMemberRefNil;
 
     mdMemberRef beginArrayMemberRef = mdMemberRefNil;
     mdMemberRef beginMethodFastPathRefs[FASTPATH_COUNT];
     mdMemberRef endVoidMemberRef = mdMemberRefNil;
 
+    // Overloads taking the instance by reference, used for the methods of the ValueTypes.
+    mdMemberRef beginArrayByRefMemberRef = mdMemberRefNil;
+    mdMemberRef beginMethodFastPathByRefRefs[FASTPATH_COUNT];
+    mdMemberRef endVoidByRefMemberRef = mdMemberRefNil;
+
+    // Overloads taking the instance and the arguments by reference, used for the methods with by-ref or ref struct
+    // arguments.
+    mdMemberRef beginMethodFastPathByRefArgumentsRefs[FASTPATH_COUNT];
+
+    // Start and completion calls of the async state machines.
+    mdMemberRef asyncMethodStartedMemberRef = mdMemberRefNil;
+    mdMemberRef endAsyncMethodMemberRef = mdMemberRefNil;
+    mdMemberRef endAsyncMethodWithExceptionMemberRef = mdMemberRefNil;
+
     mdMemberRef logExceptionRef = mdMemberRefNil;
 
+    // Calls of the methods rewritten by the MethodMetrics integrations.
+    mdTypeRef methodMetricsTypeRef = mdTypeRefNil;
+    mdMemberRef methodMetricsBeginRef = mdMemberRefNil;
+    mdMemberRef methodMetricsEndRef = mdMemberRefNil;
+
     mdMemberRef callTargetStateTypeGetDefault = mdMemberRefNil;
     mdMemberRef callTargetReturnVoidTypeGetDefault = mdMemberRefNil;
     mdMemberRef getDefaultMemberRef = mdMemberRefNil;
@@ -61,7 +82,8 @@ private:
     ModuleMetadata* GetMetadata();
     HRESULT EnsureCorLibTokens();
     HRESULT EnsureBaseCalltargetTokens();
-    mdTypeRef GetTargetStateTypeRef();
+    HRESULT EnsureCallTargetRefStructTokens();
+    HRESULT EnsureMethodMetricsTokens();
     mdTypeRef GetTargetVoidReturnTypeRef();
     mdTypeSpec GetTargetReturnValueTypeRef(FunctionMethodArgument* returnArgument);
     mdMemberRef GetCallTargetStateDefaultMemberRef();
@@ -70,9 +92,10 @@ private:
     mdMethodSpec GetCallTargetDefaultValueMethodSpec(FunctionMethodArgument* methodArgument);
     mdToken GetCurrentTypeRef(const TypeInfo* currentType, bool& isValueType);
 
-    HRESULT ModifyLocalSig(ILRewriter* reWriter, FunctionMethodArgument* methodReturnValue, ULONG* callTargetStateIndex,
-                           ULONG* exceptionIndex, ULONG* callTargetReturnIndex, ULONG* returnValueIndex,
-                           mdToken* callTargetStateToken, mdToken* exceptionToken, mdToken* callTargetReturnToken);
+    HRESULT ModifyLocalSig(ILRewriter* reWriter, FunctionMethodArgument* methodReturnValue, ULONG refStructLocalsCount,
+                           ULONG* refStructFirstIndex, ULONG* callTargetStateIndex, ULONG* exceptionIndex,
+                           ULONG* callTargetReturnIndex, ULONG* returnValueIndex, mdToken* callTargetStateToken,
+                           mdToken* exceptionToken, mdToken* callTargetReturnToken);
 
     HRESULT WriteBeginMethodWithArgumentsArray(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef,
                                                const TypeInfo* currentType, ILInstr** instruction);
@@ -83,15 +106,25 @@ public:
     mdTypeRef GetObjectTypeRef();
     mdTypeRef GetExceptionTypeRef();
     mdAssemblyRef GetCorLibAssemblyRef();
+    mdTypeRef GetTargetStateTypeRef();
+
+    // IsRefStructArgument returns true if the argument, or the referenced value of a by-ref argument, is a ref struct.
+    bool IsRefStructArgument(const FunctionMethodArgument& argument);
 
     HRESULT ModifyLocalSigAndInitialize(void* rewriterWrapperPtr, FunctionInfo* functionInfo,
+                                        ULONG refStructLocalsCount, ULONG* refStructFirstIndex,
                                         ULONG* callTargetStateIndex, ULONG* exceptionIndex,
                                         ULONG* callTargetReturnIndex, ULONG* returnValueIndex,
                                         mdToken* callTargetStateToken, mdToken* exceptionToken,
                                         mdToken* callTargetReturnToken, ILInstr** firstInstruction);
 
     HRESULT WriteBeginMethod(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef, const TypeInfo* currentType,
-                             std::vector<FunctionMethodArgument>& methodArguments, ILInstr** instruction);
+                             std::vector<FunctionMethodArgument>& methodArguments,
+                             const std::vector<bool>& refStructArguments, const std::vector<bool>& canonicalArguments,
+                             ILInstr** instruction);
+
+    HRESULT WriteRefStructArgument(void* rewriterWrapperPtr, const FunctionMethodArgument& argument,
+                                   ULONG refStructIndex, ILInstr** instruction);
 
     HRESULT WriteEndVoidReturnMemberRef(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef,
                                         const TypeInfo* currentType, ILInstr** instruction);
@@ -99,13 +132,42 @@ public:
     HRESULT WriteEndReturnMemberRef(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef, const TypeInfo* currentType,
                                     FunctionMethodArgument* returnArgument, ILInstr** instruction);
 
+    // WriteAsyncMethodStarted writes the call made once the async state machine is started, with the CallTarget state
+    // on the stack.
+    HRESULT WriteAsyncMethodStarted(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef, const TypeInfo* currentType,
+                                    ILInstr** instruction);
+
+    // WriteEndAsyncMethod writes the call made before the builder of an async state machine completes the task, with
+    // the result (or the exception) on the stack followed by the instance and the CallTarget state. A null
+    // resultSignature is a Task or ValueTask without result, passed as System.Object.
+    HRESULT WriteEndAsyncMethod(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef, const TypeInfo* currentType,
+                                PCCOR_SIGNATURE resultSignature, ULONG resultSignatureLength, bool withException,
+                                ILInstr** instruction);
+
     HRESULT WriteLogException(void* rewriterWrapperPtr, mdTypeRef integrationTypeRef, const TypeInfo* currentType,
                               ILInstr** instruction);
 
     HRESULT WriteCallTargetReturnGetReturnValue(void* rewriterWrapperPtr, mdTypeSpec callTargetReturnTypeSpec,
                                                 ILInstr** instruction);
+
+    // ModifyLocalSigForMethodMetrics adds the locals of the start timestamp and, for a non-void method, of the
+    // return value.
+    HRESULT ModifyLocalSigForMethodMetrics(ILRewriter* reWriter, FunctionMethodArgument* methodReturnValue,
+                                           ULONG* startTimestampIndex, ULONG* returnValueIndex);
+
+    // WriteMethodMetricsBegin writes the call reading the start timestamp of the method.
+    HRESULT WriteMethodMetricsBegin(void* rewriterWrapperPtr, ILInstr** instruction);
+
+    // WriteMethodMetricsEnd writes the call recording the duration of the method, with the method id and the start
+    // timestamp on the stack.
+    HRESULT WriteMethodMetricsEnd(void* rewriterWrapperPtr, ILInstr** instruction);
 };
 
+// CallTarget_GetBytecodeInstrumentationAssembly returns the full name of the profiler assembly referenced by a
+// rewritten module. Without a profiler, e.g. when weaving an assembly file, the target runtime is the one of the
+// CoreLib referenced by the module.
+WSTRING CallTarget_GetBytecodeInstrumentationAssembly(const ModuleMetadata* module_metadata);
+
 } // namespace trace
 
 #endif // OTEL_CLR_PROFILER_CALLTARGET_TOKENS_H_
\ No newline at end of file
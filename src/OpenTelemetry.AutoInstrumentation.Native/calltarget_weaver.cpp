@@ -0,0 +1,970 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "calltarget_weaver.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+#include "calltarget_instantiations.h"
+#include "calltarget_rewriter.h"
+#include "calltarget_tokens.h"
+#include "il_rewriter.h"
+#include "logger.h"
+#include "macros.h"
+#include "metadata_builder.h"
+#include "otel_profiler_constants.h"
+#include "pal.h"
+
+namespace trace
+{
+
+namespace
+{
+    // The woven method bodies and the saved metadata are appended to the image in a new section.
+    const char  kWovenSectionName[]          = ".otel";
+    const DWORD kWovenSectionCharacteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+
+    // The woven assemblies reference this marker type of the managed profiler assembly. The type doesn't exist and
+    // its name can't be written in C#, no other assembly references it.
+    const WSTRING wovenMarkerTypeName = WStr("OpenTelemetry.AutoInstrumentation.CallTarget.<Woven>");
+
+    // Each woven method is recorded by a field reference of the marker type, named after the token of the method. The
+    // references are never resolved: no IL uses them.
+    const COR_SIGNATURE wovenMethodSignature[] = {IMAGE_CEE_CS_CALLCONV_FIELD, ELEMENT_TYPE_OBJECT};
+
+    // The references to CoreLib that can resolve the CallTarget tokens, in order of preference.
+    const WSTRING corlib_reference_names[] = {system_private_corelib_assemblyName, mscorlib_assemblyName,
+                                              WStr("System.Runtime"), WStr("netstandard")};
+
+    DWORD Align(DWORD value, DWORD alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // The headers of a PE image read and updated by the weaver.
+    struct ImageHeaders
+    {
+        IMAGE_FILE_HEADER*    file_header            = nullptr;
+        BYTE*                 optional_header        = nullptr;
+        bool                  pe32_plus              = false;
+        IMAGE_DATA_DIRECTORY* data_directories       = nullptr;
+        DWORD                 data_directories_count = 0;
+        IMAGE_SECTION_HEADER* sections               = nullptr;
+        size_t                sections_offset        = 0;
+        DWORD                 section_alignment      = 0;
+        DWORD                 file_alignment         = 0;
+        DWORD                 size_of_headers        = 0;
+    };
+
+    template <typename TOptionalHeader>
+    void ReadOptionalHeader(BYTE* optional_header, ImageHeaders& headers)
+    {
+        const auto header              = reinterpret_cast<TOptionalHeader*>(optional_header);
+        headers.section_alignment      = header->SectionAlignment;
+        headers.file_alignment         = header->FileAlignment;
+        headers.size_of_headers        = header->SizeOfHeaders;
+        headers.data_directories       = header->DataDirectory;
+        headers.data_directories_count = header->NumberOfRvaAndSizes;
+    }
+
+    template <typename TOptionalHeader>
+    void UpdateOptionalHeader(BYTE* optional_header, DWORD size_of_image, DWORD added_initialized_data)
+    {
+        const auto header = reinterpret_cast<TOptionalHeader*>(optional_header);
+        header->SizeOfImage = size_of_image;
+        header->SizeOfInitializedData += added_initialized_data;
+        // The checksum is only validated for drivers and boot loaded images.
+        header->CheckSum = 0;
+    }
+
+    template <typename TOptionalHeader>
+    void UpdateSizeOfHeaders(BYTE* optional_header, DWORD size_of_headers)
+    {
+        reinterpret_cast<TOptionalHeader*>(optional_header)->SizeOfHeaders = size_of_headers;
+    }
+
+    bool TryReadHeaders(std::vector<BYTE>& image, ImageHeaders& headers)
+    {
+        if (image.size() < sizeof(IMAGE_DOS_HEADER))
+        {
+            return false;
+        }
+
+        const auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(image.data());
+        const size_t fileHeaderOffset = static_cast<size_t>(dosHeader->e_lfanew) + sizeof(DWORD);
+        if (dosHeader->e_magic != IMAGE_DOS_SIGNATURE || fileHeaderOffset + sizeof(IMAGE_FILE_HEADER) > image.size() ||
+            *reinterpret_cast<const DWORD*>(image.data() + dosHeader->e_lfanew) != IMAGE_NT_SIGNATURE)
+        {
+            return false;
+        }
+
+        headers.file_header     = reinterpret_cast<IMAGE_FILE_HEADER*>(image.data() + fileHeaderOffset);
+        headers.optional_header = image.data() + fileHeaderOffset + sizeof(IMAGE_FILE_HEADER);
+        headers.sections_offset = fileHeaderOffset + sizeof(IMAGE_FILE_HEADER) + headers.file_header->SizeOfOptionalHeader;
+        if (headers.sections_offset + headers.file_header->NumberOfSections * sizeof(IMAGE_SECTION_HEADER) >
+            image.size())
+        {
+            return false;
+        }
+
+        const auto magic  = *reinterpret_cast<const WORD*>(headers.optional_header);
+        headers.pe32_plus = magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+        if (headers.pe32_plus)
+        {
+            ReadOptionalHeader<IMAGE_OPTIONAL_HEADER64>(headers.optional_header, headers);
+        }
+        else if (magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC)
+        {
+            ReadOptionalHeader<IMAGE_OPTIONAL_HEADER32>(headers.optional_header, headers);
+        }
+        else
+        {
+            return false;
+        }
+
+        headers.sections = reinterpret_cast<IMAGE_SECTION_HEADER*>(image.data() + headers.sections_offset);
+        return headers.data_directories_count > IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR &&
+               headers.section_alignment != 0 && headers.file_alignment != 0;
+    }
+
+    size_t RvaToOffset(const std::vector<BYTE>& image, const ImageHeaders& headers, ULONG rva, size_t size)
+    {
+        for (WORD i = 0; i < headers.file_header->NumberOfSections; i++)
+        {
+            const auto& section = headers.sections[i];
+            if (rva >= section.VirtualAddress && rva + size <= section.VirtualAddress + section.SizeOfRawData)
+            {
+                const size_t offset = section.PointerToRawData + (rva - section.VirtualAddress);
+                return offset + size <= image.size() ? offset : 0;
+            }
+        }
+        return 0;
+    }
+
+    // GetMethodBodySize returns the size of the method body at an RVA, with its header, code and extra sections, or 0
+    // if the body is malformed or doesn't fit in its section.
+    size_t GetMethodBodySize(const std::vector<BYTE>& image, const ImageHeaders& headers, ULONG rva)
+    {
+        const auto offset = RvaToOffset(image, headers, rva, sizeof(IMAGE_COR_ILMETHOD_TINY));
+        if (offset == 0)
+        {
+            return 0;
+        }
+
+        const BYTE format = image[offset] & CorILMethod_FormatMask;
+        if (format == CorILMethod_TinyFormat)
+        {
+            const size_t size = sizeof(IMAGE_COR_ILMETHOD_TINY) + (image[offset] >> 2);
+            return RvaToOffset(image, headers, rva, size) != 0 ? size : 0;
+        }
+        if (format != CorILMethod_FatFormat || RvaToOffset(image, headers, rva, sizeof(IMAGE_COR_ILMETHOD_FAT)) == 0)
+        {
+            return 0;
+        }
+
+        IMAGE_COR_ILMETHOD_FAT fat;
+        memcpy(&fat, image.data() + offset, sizeof(fat));
+        size_t size = fat.Size * sizeof(DWORD);
+        if (size < sizeof(IMAGE_COR_ILMETHOD_FAT))
+        {
+            return 0;
+        }
+        size += fat.CodeSize;
+        if (RvaToOffset(image, headers, rva, size) == 0)
+        {
+            return 0;
+        }
+
+        // The extra sections, e.g. the exception handling clauses, follow the code aligned on 4 bytes.
+        bool more_sections = (fat.Flags & CorILMethod_MoreSects) != 0;
+        while (more_sections)
+        {
+            size = (size + 3) & ~static_cast<size_t>(3);
+            if (RvaToOffset(image, headers, rva, size + sizeof(IMAGE_COR_ILMETHOD_SECT_FAT)) == 0)
+            {
+                return 0;
+            }
+
+            const BYTE*  section   = image.data() + offset + size;
+            const size_t data_size = (section[0] & CorILMethod_Sect_FatFormat) != 0
+                                         ? section[1] | (section[2] << 8) | (section[3] << 16)
+                                         : section[1];
+            if (data_size < sizeof(IMAGE_COR_ILMETHOD_SECT_SMALL))
+            {
+                return 0;
+            }
+            size += data_size;
+            if (RvaToOffset(image, headers, rva, size) == 0)
+            {
+                return 0;
+            }
+            more_sections = (section[0] & CorILMethod_Sect_MoreSects) != 0;
+        }
+        return size;
+    }
+
+    IMAGE_COR20_HEADER* GetCorHeader(std::vector<BYTE>& image, const ImageHeaders& headers)
+    {
+        const auto& directory = headers.data_directories[IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR];
+        const auto  offset    = RvaToOffset(image, headers, directory.VirtualAddress, sizeof(IMAGE_COR20_HEADER));
+        return offset == 0 ? nullptr : reinterpret_cast<IMAGE_COR20_HEADER*>(image.data() + offset);
+    }
+
+    // Makes room for one more section header: the compilers usually leave none, the raw data of the sections
+    // is moved down by a file alignment unit. The headers must still fit before the first section in memory, the
+    // RVAs don't change. The debug directory is the only data directory pointing to file offsets, besides the
+    // security one which is dropped anyway.
+    bool TryGrowHeaders(std::vector<BYTE>& image, ImageHeaders& headers, DWORD first_raw_data)
+    {
+        const size_t required = headers.sections_offset +
+                                (headers.file_header->NumberOfSections + 1) * sizeof(IMAGE_SECTION_HEADER);
+        if (required <= first_raw_data)
+        {
+            return true;
+        }
+
+        const DWORD shift = Align(static_cast<DWORD>(required - first_raw_data), headers.file_alignment);
+        for (WORD i = 0; i < headers.file_header->NumberOfSections; i++)
+        {
+            if (headers.size_of_headers + shift > headers.sections[i].VirtualAddress)
+            {
+                return false;
+            }
+        }
+
+        image.insert(image.begin() + first_raw_data, shift, 0);
+        TryReadHeaders(image, headers);
+        for (WORD i = 0; i < headers.file_header->NumberOfSections; i++)
+        {
+            auto& section = headers.sections[i];
+            if (section.PointerToRawData >= first_raw_data)
+            {
+                section.PointerToRawData += shift;
+            }
+        }
+
+        const auto& debug_directory = headers.data_directories[IMAGE_DIRECTORY_ENTRY_DEBUG];
+        if (headers.data_directories_count > IMAGE_DIRECTORY_ENTRY_DEBUG && debug_directory.Size != 0)
+        {
+            const auto offset = RvaToOffset(image, headers, debug_directory.VirtualAddress, debug_directory.Size);
+            if (offset == 0)
+            {
+                return false;
+            }
+            const auto entries = reinterpret_cast<IMAGE_DEBUG_DIRECTORY*>(image.data() + offset);
+            for (DWORD i = 0; i < debug_directory.Size / sizeof(IMAGE_DEBUG_DIRECTORY); i++)
+            {
+                if (entries[i].PointerToRawData >= first_raw_data)
+                {
+                    entries[i].PointerToRawData += shift;
+                }
+            }
+        }
+
+        headers.size_of_headers += shift;
+        if (headers.pe32_plus)
+        {
+            UpdateSizeOfHeaders<IMAGE_OPTIONAL_HEADER64>(headers.optional_header, headers.size_of_headers);
+        }
+        else
+        {
+            UpdateSizeOfHeaders<IMAGE_OPTIONAL_HEADER32>(headers.optional_header, headers.size_of_headers);
+        }
+        return true;
+    }
+
+    // Defines the references to the integration type, once per module like the profiler does.
+    HRESULT GetWrapperTypeRef(ModuleMetadata* module_metadata, const MethodReplacement& method_replacement,
+                              mdTypeRef& wrapper_type_ref)
+    {
+        const auto& wrapper_type_key = method_replacement.wrapper_method.get_type_cache_key();
+        if (module_metadata->TryGetWrapperParentTypeRef(wrapper_type_key, wrapper_type_ref))
+        {
+            return S_OK;
+        }
+
+        HRESULT  hr;
+        mdModule module = mdModuleNil;
+        RETURN_IF_FAILED(module_metadata->metadata_import->GetModuleFromScope(&module));
+
+        const MetadataBuilder metadata_builder(*module_metadata, module, module_metadata->metadata_import,
+                                               module_metadata->metadata_emit, module_metadata->assembly_import,
+                                               module_metadata->assembly_emit);
+
+        const AssemblyReference* wrapper_assembly = &method_replacement.wrapper_method.assembly;
+        if (wrapper_assembly->name == managed_profiler_name)
+        {
+            wrapper_assembly =
+                AssemblyReference::GetFromCache(CallTarget_GetBytecodeInstrumentationAssembly(module_metadata));
+        }
+
+        RETURN_IF_FAILED(metadata_builder.EmitAssemblyRef(*wrapper_assembly));
+        RETURN_IF_FAILED(metadata_builder.StoreWrapperMethodRef(method_replacement));
+        return module_metadata->TryGetWrapperParentTypeRef(wrapper_type_key, wrapper_type_ref) ? S_OK : E_FAIL;
+    }
+
+    // A method body woven in the image.
+    struct WovenMethod
+    {
+        const IntegrationMethod* integration;
+        mdMethodDef              method_def;
+        std::vector<BYTE>        body;
+        ULONG                    rva;
+    };
+
+    // Defines the marker reference of the woven assemblies, scoped to the reference to the managed profiler assembly
+    // the woven methods call, and the references recording the woven methods.
+    HRESULT DefineWovenMarker(const CallTargetAssemblyFile& file, const std::vector<WovenMethod>& methods)
+    {
+        const auto& module_metadata = *file.module_metadata;
+        for (mdAssemblyRef assembly_ref : EnumAssemblyRefs(module_metadata.assembly_import))
+        {
+            if (GetReferencedAssemblyMetadata(module_metadata.assembly_import, assembly_ref).name != managed_profiler_name)
+            {
+                continue;
+            }
+
+            HRESULT   hr;
+            mdTypeRef marker_ref = mdTypeRefNil;
+            RETURN_IF_FAILED(module_metadata.metadata_emit->DefineTypeRefByName(assembly_ref,
+                                                                                wovenMarkerTypeName.c_str(),
+                                                                                &marker_ref));
+            for (const auto& method : methods)
+            {
+                mdMemberRef method_ref = mdMemberRefNil;
+                RETURN_IF_FAILED(module_metadata.metadata_emit->DefineMemberRef(marker_ref,
+                                                                                TokenStr(&method.method_def).c_str(),
+                                                                                wovenMethodSignature,
+                                                                                sizeof(wovenMethodSignature),
+                                                                                &method_ref));
+            }
+            return S_OK;
+        }
+        return E_FAIL;
+    }
+
+    // Appends a section with the woven method bodies and the saved metadata, and points the methods and the CLI
+    // header to them. The image must be IL only: the precompiled code of a ReadyToRun image would ignore the woven
+    // bodies.
+    WSTRING WriteWovenImage(CallTargetAssemblyFile& file, std::vector<WovenMethod>& methods,
+                            std::vector<BYTE>& output, bool& strong_name_signed)
+    {
+        output = file.image;
+
+        ImageHeaders headers;
+        if (!TryReadHeaders(output, headers))
+        {
+            return WStr("The PE headers cannot be read.");
+        }
+
+        const auto corHeader = GetCorHeader(output, headers);
+        if (corHeader == nullptr)
+        {
+            return WStr("The CLI header cannot be read.");
+        }
+
+        if ((corHeader->Flags & COMIMAGE_FLAGS_ILONLY) == 0 || corHeader->ManagedNativeHeader.Size != 0)
+        {
+            return WStr("ReadyToRun and mixed-mode images cannot be woven, weave the IL assembly before precompiling "
+                        "it.");
+        }
+        strong_name_signed = (corHeader->Flags & COMIMAGE_FLAGS_STRONGNAMESIGNED) != 0;
+
+        // The new section header must fit before the raw data of the first section.
+        const WORD sectionsCount = headers.file_header->NumberOfSections;
+        DWORD      firstRawData  = static_cast<DWORD>(output.size());
+        for (WORD i = 0; i < sectionsCount; i++)
+        {
+            if (headers.sections[i].SizeOfRawData != 0)
+            {
+                firstRawData = std::min(firstRawData, static_cast<DWORD>(headers.sections[i].PointerToRawData));
+            }
+        }
+        if (!TryGrowHeaders(output, headers, firstRawData))
+        {
+            return WStr("The PE headers have no room for the woven section.");
+        }
+
+        DWORD endOfRawData     = headers.size_of_headers;
+        DWORD endOfVirtualData = 0;
+        for (WORD i = 0; i < sectionsCount; i++)
+        {
+            const auto& section = headers.sections[i];
+            if (section.SizeOfRawData != 0)
+            {
+                endOfRawData = std::max(endOfRawData, section.PointerToRawData + section.SizeOfRawData);
+            }
+            endOfVirtualData = std::max(endOfVirtualData, section.VirtualAddress +
+                                                              std::max(section.Misc.VirtualSize, section.SizeOfRawData));
+        }
+
+        const DWORD sectionRva       = Align(endOfVirtualData, headers.section_alignment);
+        const DWORD sectionRawOffset = Align(endOfRawData, headers.file_alignment);
+
+        // The fat method headers must be aligned on 4 bytes.
+        std::vector<BYTE> content;
+        HRESULT           hr;
+        for (auto& method : methods)
+        {
+            content.resize(Align(static_cast<DWORD>(content.size()), sizeof(DWORD)));
+            method.rva = sectionRva + static_cast<DWORD>(content.size());
+            content.insert(content.end(), method.body.begin(), method.body.end());
+
+            hr = file.module_metadata->metadata_emit->SetRVA(method.method_def, method.rva);
+            if (FAILED(hr))
+            {
+                return WStr("The RVA of ") + TokenStr(&method.method_def) + WStr(" cannot be updated.");
+            }
+        }
+
+        if (FAILED(DefineWovenMarker(file, methods)))
+        {
+            return WStr("The woven assembly marker cannot be defined.");
+        }
+
+        ULONG metadataSize = 0;
+        hr                 = file.module_metadata->metadata_emit->GetSaveSize(cssAccurate, &metadataSize);
+        if (FAILED(hr) || metadataSize == 0)
+        {
+            return WStr("The size of the woven metadata cannot be computed.");
+        }
+        content.resize(Align(static_cast<DWORD>(content.size()), sizeof(DWORD)));
+        const DWORD metadataOffset = static_cast<DWORD>(content.size());
+        content.resize(metadataOffset + metadataSize);
+        hr = file.module_metadata->metadata_emit->SaveToMemory(content.data() + metadataOffset, metadataSize);
+        if (FAILED(hr))
+        {
+            return WStr("The woven metadata cannot be saved.");
+        }
+
+        // The data past the sections, the Authenticode signature, is dropped: it doesn't match the woven image.
+        const DWORD sectionRawSize = Align(static_cast<DWORD>(content.size()), headers.file_alignment);
+        output.resize(sectionRawOffset, 0);
+        output.insert(output.end(), content.begin(), content.end());
+        output.resize(sectionRawOffset + sectionRawSize, 0);
+
+        // The headers are read again, the image buffer was reallocated.
+        TryReadHeaders(output, headers);
+        IMAGE_SECTION_HEADER section{};
+        memcpy(section.Name, kWovenSectionName, sizeof(kWovenSectionName) - 1);
+        section.Misc.VirtualSize = static_cast<DWORD>(content.size());
+        section.VirtualAddress   = sectionRva;
+        section.SizeOfRawData    = sectionRawSize;
+        section.PointerToRawData = sectionRawOffset;
+        section.Characteristics  = kWovenSectionCharacteristics;
+        memcpy(output.data() + headers.sections_offset + sectionsCount * sizeof(IMAGE_SECTION_HEADER), &section,
+               sizeof(section));
+        headers.file_header->NumberOfSections = sectionsCount + 1;
+
+        const DWORD sizeOfImage = Align(sectionRva + section.Misc.VirtualSize, headers.section_alignment);
+        if (headers.pe32_plus)
+        {
+            UpdateOptionalHeader<IMAGE_OPTIONAL_HEADER64>(headers.optional_header, sizeOfImage, sectionRawSize);
+        }
+        else
+        {
+            UpdateOptionalHeader<IMAGE_OPTIONAL_HEADER32>(headers.optional_header, sizeOfImage, sectionRawSize);
+        }
+        if (headers.data_directories_count > IMAGE_DIRECTORY_ENTRY_SECURITY)
+        {
+            headers.data_directories[IMAGE_DIRECTORY_ENTRY_SECURITY] = {0, 0};
+        }
+
+        const auto wovenCorHeader = GetCorHeader(output, headers);
+        wovenCorHeader->MetaData.VirtualAddress = sectionRva + metadataOffset;
+        wovenCorHeader->MetaData.Size           = metadataSize;
+        return EmptyWStr;
+    }
+
+    bool TryWriteFile(const WSTRING& path, const std::vector<BYTE>& image)
+    {
+        std::ofstream stream(ToString(path), std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        return stream.good();
+    }
+} // namespace
+
+/// <summary>
+/// Find the marker reference defined by the weaver. Referencing the CallTarget invoker isn't enough, any assembly
+/// can reference it, e.g. with typeof(CallTargetInvoker). Like the profiler, the weaver defines its own references to
+/// the managed profiler assembly: all of them are checked.
+/// </summary>
+/// <param name="metadata_import">Metadata import of the module</param>
+/// <param name="assembly_import">Assembly import of the module</param>
+/// <param name="woven_method_defs">Receives the woven methods, recorded by the field references of the marker</param>
+/// <returns>True if the module was woven</returns>
+bool CallTarget_IsWovenModule(const ComPtr<IMetaDataImport2>&         metadata_import,
+                              const ComPtr<IMetaDataAssemblyImport>& assembly_import,
+                              std::unordered_set<mdMethodDef>*       woven_method_defs)
+{
+    for (mdAssemblyRef assembly_ref : EnumAssemblyRefs(assembly_import))
+    {
+        mdTypeRef marker_ref = mdTypeRefNil;
+        if (GetReferencedAssemblyMetadata(assembly_import, assembly_ref).name != managed_profiler_name ||
+            metadata_import->FindTypeRef(assembly_ref, wovenMarkerTypeName.c_str(), &marker_ref) != S_OK)
+        {
+            continue;
+        }
+
+        if (woven_method_defs != nullptr)
+        {
+            for (mdMemberRef method_ref : EnumMemberRefs(metadata_import, marker_ref))
+            {
+                WCHAR name[kNameMaxSize]{};
+                ULONG name_length = 0;
+                if (SUCCEEDED(metadata_import->GetMemberRefProps(method_ref, nullptr, name, kNameMaxSize,
+                                                                 &name_length, nullptr, nullptr)))
+                {
+                    const auto method_def = static_cast<mdMethodDef>(std::strtoul(ToString(name).c_str(), nullptr, 16));
+                    if (TypeFromToken(method_def) == mdtMethodDef)
+                    {
+                        woven_method_defs->insert(method_def);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool CallTarget_ReadImage(const WSTRING& path, std::vector<BYTE>& image)
+{
+    std::ifstream stream(ToString(path), std::ios::binary);
+    if (!stream.good())
+    {
+        return false;
+    }
+    image.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return !image.empty();
+}
+
+LPCBYTE CallTarget_GetMethodBodyFromImage(const std::vector<BYTE>& image, ULONG rva)
+{
+    if (rva == 0)
+    {
+        return nullptr;
+    }
+
+    // The headers are only read, the image is not modified.
+    auto&        mutable_image = const_cast<std::vector<BYTE>&>(image);
+    ImageHeaders headers;
+    if (!TryReadHeaders(mutable_image, headers))
+    {
+        return nullptr;
+    }
+
+    // The body is decoded from the returned pointer, all of it must be inside the image.
+    if (GetMethodBodySize(image, headers, rva) == 0)
+    {
+        return nullptr;
+    }
+    return image.data() + RvaToOffset(image, headers, rva, 1);
+}
+
+bool CallTarget_HasAssemblyExtension(const std::string& path)
+{
+    auto extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".dll" || extension == ".exe";
+}
+
+/// <summary>
+/// Read the assembly name of a file from its metadata opened read-only. The image is not loaded: the files that are
+/// not .NET assemblies, or that no integration targets, are skipped before the image and the writable metadata scope
+/// are loaded.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scope</param>
+/// <param name="path">Path of the file</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <param name="report">Receives the assembly name, and the reason why the file is skipped</param>
+/// <returns>True if the file is skipped</returns>
+bool CallTarget_SkipAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& path,
+                                 const std::vector<IntegrationMethod>& integrations, nlohmann::json& report)
+{
+    ComPtr<IUnknown> metadata_interfaces;
+    auto             hr = dispenser->OpenScope(path.c_str(), ofRead, IID_IMetaDataAssemblyImport,
+                                               metadata_interfaces.GetAddressOf());
+    if (FAILED(hr))
+    {
+        // A native library has no metadata, unlike a missing or unreadable file.
+        const std::ifstream stream(ToString(path), std::ios::binary);
+        if (stream.good())
+        {
+            report["skipped"] = "The file is not a .NET assembly.";
+        }
+        else
+        {
+            report["error"] = "The assembly file cannot be read.";
+        }
+        return true;
+    }
+
+    const auto assembly_import = metadata_interfaces.As<IMetaDataAssemblyImport>(IID_IMetaDataAssemblyImport);
+    if (assembly_import.IsNull())
+    {
+        report["error"] = "The assembly metadata cannot be opened.";
+        return true;
+    }
+
+    // A module without an assembly manifest, e.g. a netmodule, is not loaded on its own.
+    const auto assembly = GetAssemblyImportMetadata(assembly_import);
+    if (assembly.assembly_token == mdTokenNil)
+    {
+        report["skipped"] = "The module has no assembly manifest.";
+        return true;
+    }
+
+    report["assembly"] = ToString(assembly.name);
+    report["version"]  = ToString(assembly.version.str());
+    const bool targeted =
+        std::any_of(integrations.begin(), integrations.end(), [&assembly](const IntegrationMethod& integration) {
+            return integration.replacement.InstrumentedAssemblyName() == assembly.name;
+        });
+    if (!targeted)
+    {
+        report["skipped"] = "No integration targets the assembly.";
+        return true;
+    }
+    return false;
+}
+
+/// <summary>
+/// Read an assembly file and open its metadata, with the changes kept in memory, for the CallTarget rewrite.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scope</param>
+/// <param name="path">Path of the assembly file</param>
+/// <param name="file">Opened assembly file, it must not be moved while its metadata is in use</param>
+/// <returns>An empty string on success, otherwise the reason why the assembly cannot be rewritten</returns>
+WSTRING CallTarget_OpenAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& path,
+                                    CallTargetAssemblyFile& file)
+{
+    file.path = path;
+    if (!CallTarget_ReadImage(path, file.image))
+    {
+        return WStr("The assembly file cannot be read.");
+    }
+
+    ComPtr<IUnknown> metadata_interfaces;
+    auto hr = dispenser->OpenScope(path.c_str(), ofWrite, IID_IMetaDataImport2, metadata_interfaces.GetAddressOf());
+    if (FAILED(hr))
+    {
+        return WStr("The assembly metadata cannot be opened.");
+    }
+
+    const auto metadata_import = metadata_interfaces.As<IMetaDataImport2>(IID_IMetaDataImport2);
+    const auto metadata_emit   = metadata_interfaces.As<IMetaDataEmit2>(IID_IMetaDataEmit2);
+    const auto assembly_import = metadata_interfaces.As<IMetaDataAssemblyImport>(IID_IMetaDataAssemblyImport);
+    const auto assembly_emit   = metadata_interfaces.As<IMetaDataAssemblyEmit>(IID_IMetaDataAssemblyEmit);
+    if (metadata_import.IsNull() || metadata_emit.IsNull() || assembly_import.IsNull() || assembly_emit.IsNull())
+    {
+        return WStr("The assembly metadata cannot be opened for writing.");
+    }
+
+    file.assembly = std::make_unique<AssemblyMetadata>(GetAssemblyImportMetadata(assembly_import));
+    if (file.assembly->assembly_token == mdTokenNil)
+    {
+        return WStr("The module has no assembly manifest.");
+    }
+
+    // The CallTarget tokens reference the CoreLib types through the module reference to CoreLib, the reference
+    // assemblies forward them.
+    mdAssemblyRef corlib_ref = mdAssemblyRefNil;
+    for (const auto& corlib_name : corlib_reference_names)
+    {
+        corlib_ref = FindAssemblyRef(assembly_import, corlib_name);
+        if (corlib_ref != mdAssemblyRefNil)
+        {
+            file.corlib.szName = corlib_name;
+            break;
+        }
+    }
+    if (corlib_ref == mdAssemblyRefNil)
+    {
+        return WStr("The assembly doesn't reference CoreLib.");
+    }
+
+    const void* public_key = nullptr;
+    ULONG       public_key_size = 0;
+    hr = assembly_import->GetAssemblyRefProps(corlib_ref, &public_key, &public_key_size, nullptr, 0, nullptr,
+                                              &file.corlib.pMetaData, nullptr, nullptr, &file.corlib.assemblyFlags);
+    if (FAILED(hr))
+    {
+        return WStr("The CoreLib reference cannot be read.");
+    }
+
+    // The public key, or its token, is copied: the blob heap grows with the rewrite.
+    const auto public_key_bytes = static_cast<const BYTE*>(public_key);
+    file.corlib_public_key.assign(public_key_bytes, public_key_bytes + public_key_size);
+    file.corlib.ppbPublicKey = file.corlib_public_key.data();
+    file.corlib.pcbPublicKey = public_key_size;
+
+    file.module_metadata =
+        std::make_unique<ModuleMetadata>(metadata_import, metadata_emit, assembly_import, assembly_emit,
+                                         file.assembly->name, 0, &file.corlib);
+    return EmptyWStr;
+}
+
+/// <summary>
+/// Apply the CallTarget rewrite to a matched method of an assembly file, as CallTarget_RewriterCallback does on a
+/// ReJIT. The async methods are rewritten as methods returning a task, and the original body is never outlined.
+/// </summary>
+/// <param name="file">Opened assembly file</param>
+/// <param name="match">Method matched by an integration</param>
+/// <param name="body">Receives the rewritten method body</param>
+/// <returns>An empty string on success, otherwise the reason why the method is not rewritten</returns>
+WSTRING CallTarget_RewriteFileMethod(CallTargetAssemblyFile& file, const CallTargetMethodMatch& match,
+                                     std::vector<BYTE>& body)
+{
+    const auto& method_replacement = match.integration->replacement;
+
+    // The woven assembly records the woven methods: the profiler only skips their CallTarget rewrite, and still
+    // applies the other integrations at runtime.
+    if (method_replacement.integration_kind != IntegrationKind::CallTarget)
+    {
+        return WStr("Only the CallTarget integrations are applied to assembly files, the profiler applies the other "
+                    "integrations at runtime.");
+    }
+
+    auto rejection = CallTarget_GetRewriteRejection(match.function_info);
+    if (!rejection.empty())
+    {
+        return rejection;
+    }
+
+    ModuleMetadata* module_metadata = file.module_metadata.get();
+    ULONG           rva             = 0;
+    module_metadata->metadata_import->GetMethodProps(match.method_def, nullptr, nullptr, 0, nullptr, nullptr, nullptr,
+                                                     nullptr, &rva, nullptr);
+    const auto pMethodBytes = CallTarget_GetMethodBodyFromImage(file.image, rva);
+    if (pMethodBytes == nullptr)
+    {
+        return WStr("Method body not found in the image.");
+    }
+
+    FunctionInfo       caller = match.function_info;
+    std::vector<ULONG> argument_positions;
+    const bool         selects_arguments =
+        method_replacement.declares_arguments &&
+        SelectCallTargetArguments(method_replacement.argument_indices, caller.method_signature.NumberOfArguments(),
+                                  FASTPATH_COUNT - 1, argument_positions);
+
+    mdTypeRef wrapper_type_ref = mdTypeRefNil;
+    auto      hr               = GetWrapperTypeRef(module_metadata, method_replacement, wrapper_type_ref);
+    if (FAILED(hr))
+    {
+        return WStr("The integration type cannot be referenced.");
+    }
+
+    ILRewriter rewriter(match.method_def);
+    hr = rewriter.Import(pMethodBytes);
+    if (FAILED(hr))
+    {
+        return WStr("The method body cannot be read.");
+    }
+
+    hr = CallTarget_RewriteMethodBody(&rewriter, module_metadata, &caller, wrapper_type_ref,
+                                      selects_arguments ? &argument_positions : nullptr);
+    if (hr != S_OK)
+    {
+        return WStr("The CallTarget rewrite failed.");
+    }
+
+    hr = rewriter.Export();
+    if (FAILED(hr))
+    {
+        return WStr("The rewritten method body cannot be written.");
+    }
+
+    body = rewriter.GetExportedBody();
+    return EmptyWStr;
+}
+
+/// <summary>
+/// Write a copy of an assembly file with the CallTarget rewrite applied to the methods matched by the
+/// integrations. Nothing is written if no method is woven.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scope</param>
+/// <param name="assembly_path">Path of the assembly file</param>
+/// <param name="output_path">Path of the woven assembly file</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <returns>The weaving report of the assembly</returns>
+nlohmann::json CallTarget_WeaveAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& assembly_path,
+                                            const WSTRING& output_path,
+                                            const std::vector<IntegrationMethod>& integrations)
+{
+    nlohmann::json report;
+    report["path"]    = ToString(assembly_path);
+    report["methods"] = nlohmann::json::array();
+
+    report["rejections"] = nlohmann::json::array();
+    if (CallTarget_SkipAssemblyFile(dispenser, assembly_path, integrations, report))
+    {
+        return report;
+    }
+
+    CallTargetAssemblyFile file;
+    const auto             error = CallTarget_OpenAssemblyFile(dispenser, assembly_path, file);
+    if (!error.empty())
+    {
+        report["error"] = ToString(error);
+        return report;
+    }
+
+    if (CallTarget_IsWovenModule(file.module_metadata->metadata_import, file.module_metadata->assembly_import))
+    {
+        report["error"] = "The assembly is already woven.";
+        return report;
+    }
+
+    std::vector<CallTargetMethodMatch>     matches;
+    std::vector<CallTargetMethodRejection> rejections;
+    CallTarget_MatchModuleMethods(file.module_metadata->metadata_import, file.assembly->name, file.assembly->version,
+                                  integrations, matches, &rejections);
+
+    // A method is rewritten once, by the first integration matching it.
+    std::vector<WovenMethod>        methods;
+    std::unordered_set<mdMethodDef> woven_method_defs;
+    for (const auto& match : matches)
+    {
+        if (!woven_method_defs.insert(match.method_def).second)
+        {
+            rejections.push_back({match.integration, match.method_def, WStr("Method is already woven.")});
+            continue;
+        }
+
+        std::vector<BYTE> body;
+        const auto        rejection = CallTarget_RewriteFileMethod(file, match, body);
+        if (!rejection.empty())
+        {
+            rejections.push_back({match.integration, match.method_def, rejection});
+            continue;
+        }
+
+        methods.push_back({match.integration, match.method_def, std::move(body), 0});
+    }
+
+    auto rejected = nlohmann::json::array();
+    for (const auto& rejection : rejections)
+    {
+        auto method      = CallTarget_MethodToJson(rejection.integration, rejection.method_def);
+        method["reason"] = ToString(rejection.reason);
+        rejected.push_back(method);
+    }
+    report["rejections"] = rejected;
+
+    if (methods.empty())
+    {
+        return report;
+    }
+
+    std::vector<BYTE> output;
+    bool              strong_name_signed = false;
+    const auto        write_error        = WriteWovenImage(file, methods, output, strong_name_signed);
+    if (!write_error.empty())
+    {
+        report["error"] = ToString(write_error);
+        return report;
+    }
+
+    if (!TryWriteFile(output_path, output))
+    {
+        report["error"] = "The woven assembly cannot be written.";
+        return report;
+    }
+
+    auto woven = nlohmann::json::array();
+    for (const auto& method : methods)
+    {
+        auto woven_method         = CallTarget_MethodToJson(method.integration, method.method_def);
+        woven_method["body_size"] = method.body.size();
+        woven_method["rva"]       = method.rva;
+        woven.push_back(woven_method);
+    }
+    report["output"]  = ToString(output_path);
+    report["methods"] = woven;
+
+    // The signature covers the original image, a strong named assembly must be signed again once woven.
+    report["resign_required"] = strong_name_signed;
+    return report;
+}
+
+/// <summary>
+/// Copy an application directory, weaving the assemblies (*.dll, *.exe) matched by the integrations. The other
+/// files, and the assemblies without any woven method, are copied unchanged.
+/// </summary>
+/// <param name="dispenser">Metadata dispenser used to open the assembly scopes</param>
+/// <param name="directory">Application directory, it is copied recursively</param>
+/// <param name="output_directory">Directory receiving the woven application</param>
+/// <param name="integrations">Integrations to be applied</param>
+/// <returns>The weaving report with the assemblies that have at least one woven method, rejection or error</returns>
+nlohmann::json CallTarget_WeaveDirectory(IMetaDataDispenser* dispenser, const WSTRING& directory,
+                                         const WSTRING& output_directory,
+                                         const std::vector<IntegrationMethod>& integrations)
+{
+    nlohmann::json report;
+    auto           assemblies = nlohmann::json::array();
+    size_t         scanned    = 0;
+    size_t         skipped    = 0;
+    size_t         woven      = 0;
+
+    const std::filesystem::path source_root(ToString(directory));
+    const std::filesystem::path output_root(ToString(output_directory));
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(source_root, ec))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        const auto output_path = output_root / std::filesystem::relative(entry.path(), source_root, ec);
+        std::filesystem::create_directories(output_path.parent_path(), ec);
+
+        if (CallTarget_HasAssemblyExtension(entry.path().string()))
+        {
+            scanned++;
+            auto assembly_report = CallTarget_WeaveAssemblyFile(dispenser, ToWSTRING(entry.path().string()),
+                                                                ToWSTRING(output_path.string()), integrations);
+            const bool is_woven = assembly_report.contains("output");
+            woven += is_woven ? 1 : 0;
+            skipped += assembly_report.contains("skipped") ? 1 : 0;
+            if (is_woven || assembly_report.contains("error") || !assembly_report["rejections"].empty())
+            {
+                assemblies.push_back(assembly_report);
+            }
+            if (is_woven)
+            {
+                continue;
+            }
+        }
+
+        std::filesystem::copy_file(entry.path(), output_path, std::filesystem::copy_options::overwrite_existing,
+                                   ec);
+        if (ec)
+        {
+            Logger::Warn("CallTarget_WeaveDirectory: ", entry.path().string(), " cannot be copied: ", ec.message());
+        }
+    }
+
+    report["directory"]        = ToString(directory);
+    report["output_directory"] = ToString(output_directory);
+    report["scanned"]          = scanned;
+    report["skipped"]          = skipped;
+    report["woven"]            = woven;
+    report["assemblies"]       = assemblies;
+    return report;
+}
+
+} // namespace trace
@@ -0,0 +1,84 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_CALLTARGET_WEAVER_H_
+#define OTEL_CLR_PROFILER_CALLTARGET_WEAVER_H_
+
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+#include <unordered_set>
+#include <vector>
+
+#include "calltarget_planner.h"
+#include "clr_helpers.h"
+#include "com_ptr.h"
+#include "integration.h"
+#include "module_metadata.h"
+
+namespace trace
+{
+
+// An assembly file opened with a writable metadata scope. The metadata changes are only kept in memory, the
+// weaver saves them in the woven image.
+struct CallTargetAssemblyFile
+{
+    WSTRING path;
+    std::vector<BYTE> image;
+    std::unique_ptr<AssemblyMetadata> assembly;
+    // The module reference to CoreLib, the CallTarget tokens reference the CoreLib types through it.
+    AssemblyProperty corlib;
+    std::vector<BYTE> corlib_public_key;
+    std::unique_ptr<ModuleMetadata> module_metadata;
+};
+
+// CallTarget_ReadImage reads the raw PE image of an assembly file.
+bool CallTarget_ReadImage(const WSTRING& path, std::vector<BYTE>& image);
+
+// CallTarget_GetMethodBodyFromImage maps a method RVA to the method body in a raw PE image. It returns nullptr if the
+// body, with its header, code and extra sections, is malformed or doesn't fit in the image.
+LPCBYTE CallTarget_GetMethodBodyFromImage(const std::vector<BYTE>& image, ULONG rva);
+
+// CallTarget_IsWovenModule returns true if methods of a module were woven with the CallTarget rewrite, and adds them
+// to woven_method_defs: the profiler must not apply the CallTarget integrations to them again, the other
+// integrations still apply to the module.
+bool CallTarget_IsWovenModule(const ComPtr<IMetaDataImport2>&         metadata_import,
+                              const ComPtr<IMetaDataAssemblyImport>& assembly_import,
+                              std::unordered_set<mdMethodDef>*       woven_method_defs = nullptr);
+
+// CallTarget_HasAssemblyExtension returns true for the *.dll and *.exe files, whatever the case of the extension.
+bool CallTarget_HasAssemblyExtension(const std::string& path);
+
+// CallTarget_SkipAssemblyFile reads the assembly name of a file from its metadata opened read-only, without loading
+// the image, and returns true if the file is not rewritten: the file is not a .NET assembly, no integration targets
+// the assembly, or the file cannot be read. The "skipped" reason, or the "error", is set in the report.
+bool CallTarget_SkipAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& path,
+                                 const std::vector<IntegrationMethod>& integrations, nlohmann::json& report);
+
+// CallTarget_OpenAssemblyFile reads an assembly file and opens its metadata for the CallTarget rewrite.
+// Returns an empty string on success, otherwise the reason why the assembly cannot be rewritten.
+WSTRING CallTarget_OpenAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& path,
+                                    CallTargetAssemblyFile& file);
+
+// CallTarget_RewriteFileMethod applies the CallTarget rewrite of a matched method of an assembly file, the same
+// rewrite the profiler applies on a ReJIT. Returns an empty string and the rewritten body on success, otherwise
+// the reason why the method is not rewritten.
+WSTRING CallTarget_RewriteFileMethod(CallTargetAssemblyFile& file, const CallTargetMethodMatch& match,
+                                     std::vector<BYTE>& body);
+
+// CallTarget_WeaveAssemblyFile writes a copy of an assembly file with the CallTarget rewrite applied to the
+// methods matched by the integrations, and returns the weaving report for it.
+nlohmann::json CallTarget_WeaveAssemblyFile(IMetaDataDispenser* dispenser, const WSTRING& assembly_path,
+                                            const WSTRING& output_path,
+                                            const std::vector<IntegrationMethod>& integrations);
+
+// CallTarget_WeaveDirectory copies an application directory, weaving all the assemblies found in it.
+nlohmann::json CallTarget_WeaveDirectory(IMetaDataDispenser* dispenser, const WSTRING& directory,
+                                         const WSTRING& output_directory,
+                                         const std::vector<IntegrationMethod>& integrations);
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_CALLTARGET_WEAVER_H_
@@ -941,29 +941,22 @@ bool FindTypeDefByName(const trace::WSTRING            instrumentationTargetMeth
 {
     mdTypeDef parentTypeDef              = mdTypeDefNil;
     auto      nameParts                  = Split(instrumentationTargetMethodTypeName, '+');
-    auto      instrumentedMethodTypeName = instrumentationTargetMethodTypeName;
+    auto      instrumentedMethodTypeName = nameParts.empty() ? instrumentationTargetMethodTypeName : nameParts.back();
 
-    if (nameParts.size() == 2)
+    // We're instrumenting a nested class, find the enclosing classes first
+    for (size_t i = 0; i + 1 < nameParts.size(); i++)
     {
-        // We're instrumenting a nested class, find the parent first
-        auto hr = metadata_import->FindTypeDefByName(nameParts[0].c_str(), mdTokenNil, &parentTypeDef);
+        auto hr = metadata_import->FindTypeDefByName(nameParts[i].c_str(), parentTypeDef, &parentTypeDef);
 
         if (FAILED(hr))
         {
             // This can happen between .NET framework and .NET core, not all apis are
             // available in both. Eg: WinHttpHandler, CurlHandler, and some methods in
             // System.Data
-            Logger::Debug("Can't load the parent TypeDef: ", nameParts[0], " for nested class: ",
+            Logger::Debug("Can't load the parent TypeDef: ", nameParts[i], " for nested class: ",
                           instrumentationTargetMethodTypeName, ", Module: ", assemblyName);
             return false;
         }
-        instrumentedMethodTypeName = nameParts[1];
-    }
-    else if (nameParts.size() > 2)
-    {
-        Logger::Warn("Invalid TypeDef-only one layer of nested classes are supported: ",
-                     instrumentationTargetMethodTypeName, ", Module: ", assemblyName);
-        return false;
     }
 
     // Find the type we're instrumenting
@@ -44,6 +44,9 @@ const auto SystemTypeName = WStr("System.Type");
 const auto GetTypeFromHandleMethodName = WStr("GetTypeFromHandle");
 const auto RuntimeTypeHandleTypeName = WStr("System.RuntimeTypeHandle");
 const auto RuntimeMethodHandleTypeName = WStr("System.RuntimeMethodHandle");
+const auto SystemSpanTypeName = WStr("System.Span`1");
+const auto SystemReadOnlySpanTypeName = WStr("System.ReadOnlySpan`1");
+const auto IsByRefLikeAttributeTypeName = WStr("System.Runtime.CompilerServices.IsByRefLikeAttribute");
 
 template <typename T>
 class EnumeratorIterator;
@@ -152,6 +155,16 @@ static Enumerator<mdTypeDef> EnumTypeDefs(const ComPtr<IMetaDataImport2>& metada
         [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
 }
 
+static Enumerator<mdInterfaceImpl> EnumInterfaceImpls(const ComPtr<IMetaDataImport2>& metadata_import,
+                                                      const mdTypeDef                 type_def)
+{
+    return Enumerator<mdInterfaceImpl>(
+        [metadata_import, type_def](HCORENUM* ptr, mdInterfaceImpl arr[], ULONG max, ULONG* cnt) -> HRESULT {
+            return metadata_import->EnumInterfaceImpls(ptr, type_def, arr, max, cnt);
+        },
+        [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
+}
+
 static Enumerator<mdTypeRef> EnumTypeRefs(const ComPtr<IMetaDataImport2>& metadata_import)
 {
     return Enumerator<mdTypeRef>(
@@ -170,6 +183,15 @@ static Enumerator<mdModuleRef> EnumModuleRefs(const ComPtr<IMetaDataImport2>& me
         [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
 }
 
+static Enumerator<mdMemberRef> EnumMemberRefs(const ComPtr<IMetaDataImport2>& metadata_import, const mdToken parent)
+{
+    return Enumerator<mdMemberRef>(
+        [metadata_import, parent](HCORENUM* ptr, mdMemberRef arr[], ULONG max, ULONG* cnt) -> HRESULT {
+            return metadata_import->EnumMemberRefs(ptr, parent, arr, max, cnt);
+        },
+        [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
+}
+
 static Enumerator<mdAssemblyRef> EnumAssemblyRefs(const ComPtr<IMetaDataAssemblyImport>& assembly_import)
 {
     return Enumerator<mdAssemblyRef>(
@@ -4,11 +4,19 @@
 #include "cor_profiler.h"
 
 #include "corhlpr.h"
+#include <algorithm>
 #include <corprof.h>
 #include <string>
+#include <thread>
 
 #include "bytecode_instrumentations.h"
+#include "calltarget_callsite.h"
+#include "calltarget_outline.h"
+#include "calltarget_planner.h"
+#include "calltarget_rewriter.h"
+#include "calltarget_weaver.h"
 #include "clr_helpers.h"
+#include "cost_attribution.h"
 #include "dllmain.h"
 #include "environment_variables.h"
 #include "environment_variables_util.h"
@@ -17,12 +25,14 @@
 #include "integration_loader.h"
 #include "logger.h"
 #include "metadata_builder.h"
+#include "method_metrics.h"
 #include "module_metadata.h"
 #include "otel_profiler_constants.h"
 #include "pal.h"
 #include "resource.h"
 #include "startup_hook.h"
 #include "stats.h"
+#include "telemetry_region.h"
 #include "util.h"
 #include "version.h"
 
@@ -40,6 +50,62 @@ namespace trace
 
 CorProfiler* profiler = nullptr;
 
+LoadIntegrationConfiguration GetLoadIntegrationConfiguration()
+{
+    const bool instrumentation_enabled_by_default = AreInstrumentationsEnabledByDefault();
+
+    return LoadIntegrationConfiguration(
+        AreTracesEnabled(),
+        GetEnabledEnvironmentValues(AreTracesInstrumentationsEnabledByDefault(instrumentation_enabled_by_default),
+                                    trace_integration_names),
+        AreMetricsEnabled(),
+        GetEnabledEnvironmentValues(AreMetricsInstrumentationsEnabledByDefault(instrumentation_enabled_by_default),
+                                    metric_integration_names),
+        AreLogsEnabled(),
+        GetEnabledEnvironmentValues(AreLogsInstrumentationsEnabledByDefault(instrumentation_enabled_by_default),
+                                    log_integration_names));
+}
+
+// JoinNames returns the names separated by a comma, for the log messages
+static WSTRING JoinNames(const std::vector<WSTRING>& names)
+{
+    WSTRING result;
+    for (const auto& name : names)
+    {
+        if (!result.empty())
+        {
+            result += WStr(",");
+        }
+        result += name;
+    }
+    return result;
+}
+
+// RunOnNativeThread runs the work on a new native thread and waits for it. The runtime refuses the ReJIT and the
+// revert requests made on a managed thread outside of the profiler callbacks, e.g. on the threads calling the exported
+// functions, with CORPROF_E_UNSUPPORTED_CALL_SEQUENCE.
+template <typename Work>
+static void RunOnNativeThread(Work&& work)
+{
+    std::thread(std::forward<Work>(work)).join();
+}
+
+// GetTypeHierarchyTargets returns the assembly and the type names of the derived and interface targets
+static std::vector<std::pair<WSTRING, WSTRING>> GetTypeHierarchyTargets(
+    const std::vector<IntegrationMethod>& integrations)
+{
+    std::vector<std::pair<WSTRING, WSTRING>> targets;
+    for (const auto& integration : integrations)
+    {
+        const auto& target_method = integration.replacement.target_method;
+        if (target_method.IsHierarchyTarget())
+        {
+            targets.emplace_back(target_method.assembly.name, target_method.type_name);
+        }
+    }
+    return targets;
+}
+
 //
 // ICorProfilerCallback methods
 //
@@ -49,6 +115,72 @@ HRESULT STDMETHODCALLTYPE CorProfiler::Initialize(IUnknown* cor_profiler_info_un
 
     CorProfilerBase::Initialize(cor_profiler_info_unknown);
 
+    return InitializeProfiler(cor_profiler_info_unknown, false);
+}
+
+HRESULT STDMETHODCALLTYPE CorProfiler::InitializeForAttach(IUnknown* cor_profiler_info_unknown,
+                                                           void*     pvClientData,
+                                                           UINT      cbClientData)
+{
+    auto _ = trace::Stats::Instance()->InitializeMeasure();
+
+    CorProfilerBase::InitializeForAttach(cor_profiler_info_unknown, pvClientData, cbClientData);
+
+    Logger::Info("Profiler attach requested.");
+    return InitializeProfiler(cor_profiler_info_unknown, true);
+}
+
+HRESULT STDMETHODCALLTYPE CorProfiler::ProfilerAttachComplete()
+{
+    CorProfilerBase::ProfilerAttachComplete();
+
+    if (!is_attached_)
+    {
+        return S_OK;
+    }
+
+    // The modules loaded before the attach didn't raise ModuleLoadFinished, so they are enumerated here and
+    // analyzed as if they were just loaded. Modules loading concurrently can show up in both paths, the analysis
+    // of a module is only done once.
+    ICorProfilerModuleEnum* module_enum = nullptr;
+    HRESULT                 hr          = this->info_->EnumModules(&module_enum);
+    if (FAILED(hr))
+    {
+        Logger::Warn("ProfilerAttachComplete: Failed to enumerate the loaded modules, HR=", HResultStr(hr));
+        return S_OK;
+    }
+
+    std::vector<ModuleID> module_ids;
+    ModuleID              module_id;
+    while (module_enum->Next(1, &module_id, nullptr) == S_OK)
+    {
+        module_ids.push_back(module_id);
+    }
+    module_enum->Release();
+
+    // The assemblies are replayed first: AssemblyLoadFinished marks the AppDomains where the managed profiler is
+    // loaded, the rewrites requested by the modules analysis are skipped in the other AppDomains.
+    std::unordered_set<AssemblyID> assembly_ids;
+    for (const auto& loaded_module_id : module_ids)
+    {
+        const auto module_info = GetModuleInfo(this->info_, loaded_module_id);
+        if (module_info.IsValid() && assembly_ids.insert(module_info.assembly.id).second)
+        {
+            AssemblyLoadFinished(module_info.assembly.id, S_OK);
+        }
+    }
+
+    for (const auto& loaded_module_id : module_ids)
+    {
+        ModuleLoadFinished(loaded_module_id, S_OK);
+    }
+
+    Logger::Info("ProfilerAttachComplete: ", module_ids.size(), " loaded modules analyzed.");
+    return S_OK;
+}
+
+HRESULT CorProfiler::InitializeProfiler(IUnknown* cor_profiler_info_unknown, bool attaching)
+{
     if (Logger::IsDebugEnabled())
     {
         const auto env_variables = GetEnvironmentVariables(env_vars_prefixes_to_display);
@@ -157,29 +289,131 @@ HRESULT STDMETHODCALLTYPE CorProfiler::Initialize(IUnknown* cor_profiler_info_un
     }
 
     // Initialize ReJIT handler and define the Rewriter Callback
-    auto callback = [this](RejitHandlerModule* mod, RejitHandlerModuleMethod* method) {
-        return this->CallTarget_RewriterCallback(mod, method);
+    auto callback = [this](RejitHandlerModule* mod, const RejitHandlerModuleMethod& method,
+                           ICorProfilerFunctionControl* pFunctionControl) {
+        const auto cost_attribution = CostAttribution::Instance();
+        if (!cost_attribution->IsEnabled())
+        {
+            return this->CallTarget_RewriterCallback(mod, method, pFunctionControl);
+        }
+
+        const CostStopwatch stopwatch;
+        const auto          hr          = this->CallTarget_RewriterCallback(mod, method, pFunctionControl);
+        const auto          duration_ns = stopwatch.ElapsedNs();
+        cost_attribution->AddAssemblyCost(mod->GetModuleMetadata()->assemblyName, CostPhase::Rewrite, duration_ns, 1);
+        if (method.methodReplacement != nullptr)
+        {
+            cost_attribution->AddWrapperCost(method.methodReplacement->wrapper_method.type_name, CostPhase::Rewrite,
+                                             duration_ns, 1);
+        }
+        return hr;
     };
 
     rejit_handler = new RejitHandler(this->info_, callback);
 
-    const bool instrumentation_enabled_by_default = AreInstrumentationsEnabledByDefault();
+    if (attaching)
+    {
+        // Methods of a running process can be already inlined into their callers and inlining can't be disabled
+        // after the attach, so the ReJIT requests must include the inliners.
+        ICorProfilerInfo10* info10 = nullptr;
+        hr = cor_profiler_info_unknown->QueryInterface(__uuidof(ICorProfilerInfo10), (void**)&info10);
+        if (FAILED(hr))
+        {
+            Logger::Warn("Failed to attach profiler: ReJIT with inliners is not supported by the runtime.");
+            delete rejit_handler;
+            rejit_handler = nullptr;
+            return E_FAIL;
+        }
+        rejit_handler->EnableRequestRejitWithInliners(info10);
+    }
 
     // load all integrations from JSON files
-    const LoadIntegrationConfiguration
-        configuration(AreTracesEnabled(), GetEnabledEnvironmentValues(AreTracesInstrumentationsEnabledByDefault(
-                                                                          instrumentation_enabled_by_default),
-                                                                      trace_integration_names),
-                      AreMetricsEnabled(), GetEnabledEnvironmentValues(AreMetricsInstrumentationsEnabledByDefault(
-                                                                           instrumentation_enabled_by_default),
-                                                                       metric_integration_names),
-                      AreLogsEnabled(), GetEnabledEnvironmentValues(AreLogsInstrumentationsEnabledByDefault(
-                                                                        instrumentation_enabled_by_default),
-                                                                    log_integration_names));
-    LoadIntegrationsFromEnvironment(integration_methods_, configuration);
+    LoadIntegrationsFromEnvironment(integration_methods_, GetLoadIntegrationConfiguration());
 
     Logger::Debug("Number of Integrations loaded: ", integration_methods_.size());
 
+    type_hierarchy_index_.SetTargets(GetTypeHierarchyTargets(integration_methods_));
+
+    const auto startup_overhead_budget_ms = GetConfiguredSize(environment::startup_overhead_budget, 0);
+    if (startup_overhead_budget_ms > 0)
+    {
+        auto degradation_step_names = GetEnvironmentValues(environment::startup_overhead_degradation_steps);
+        if (degradation_step_names.empty())
+        {
+            degradation_step_names = {GetStartupDegradationStepName(StartupDegradationStep::LowPriorityInstrumentations),
+                                      GetStartupDegradationStepName(StartupDegradationStep::NGenInliners),
+                                      GetStartupDegradationStepName(StartupDegradationStep::AllInstrumentations)};
+        }
+
+        const auto startup_overhead_window_ms = GetConfiguredSize(environment::startup_overhead_window, 60000);
+        startup_overhead_budget_ =
+            StartupOverheadBudget(static_cast<unsigned long long>(startup_overhead_budget_ms) * 1000000,
+                                  ParseStartupDegradationSteps(degradation_step_names),
+                                  static_cast<unsigned long long>(startup_overhead_window_ms) * 1000000);
+        startup_stopwatch_              = CostStopwatch();
+        low_priority_integration_names_ = GetEnvironmentValues(environment::startup_overhead_low_priority_instrumentations);
+
+        Logger::Info("Startup overhead budget: ", startup_overhead_budget_ms, "ms during the first ",
+                     startup_overhead_window_ms, "ms, degradation steps: ", JoinNames(degradation_step_names));
+    }
+
+    calltarget_instantiation_policy_ =
+        ParseCallTargetInstantiationPolicy(GetEnvironmentValue(environment::calltarget_instantiation_policy));
+    if (calltarget_instantiation_policy_ == CallTargetInstantiationPolicy::Canonical)
+    {
+        Logger::Info("CallTarget instantiation policy: canonical.");
+    }
+
+    calltarget_async_state_machines_ = IsCallTargetAsyncStateMachinesEnabled();
+    if (calltarget_async_state_machines_)
+    {
+        Logger::Info("CallTarget async state machines instrumentation is enabled.");
+    }
+
+    calltarget_outlining_ = IsCallTargetOutliningEnabled();
+    if (calltarget_outlining_)
+    {
+        Logger::Info("CallTarget outlining is enabled.");
+    }
+
+    const auto module_analysis_threads = GetConfiguredSize(environment::module_analysis_threads, 0);
+    if (module_analysis_threads > 0)
+    {
+        if (calltarget_async_state_machines_)
+        {
+            // The state machines fields are only defined while their module loads.
+            Logger::Warn("Module analysis threads are ignored, the async state machines instrumentation analyzes "
+                         "the modules while they load.");
+        }
+        else if (calltarget_outlining_)
+        {
+            // The outlined methods can only be defined while their module loads.
+            Logger::Warn("Module analysis threads are ignored, the CallTarget outlining analyzes the modules while "
+                         "they load.");
+        }
+        else
+        {
+            module_analysis_pool_ = std::make_unique<ModuleAnalysisPool>(module_analysis_threads);
+            Logger::Info("Module analysis threads: ", module_analysis_pool_->ThreadCount());
+        }
+    }
+
+    dump_il_rewrite_enabled_.store(IsDumpILRewriteEnabled(), std::memory_order_relaxed);
+
+    if (IsTelemetryRegionEnabled())
+    {
+        TelemetryRegion::Instance()->Open(GetTelemetryRegionFilePath());
+    }
+
+    if (IsCostAttributionEnabled())
+    {
+        CostAttribution::Instance()->Enable();
+        cost_attribution_report_delay_ns_ =
+            static_cast<unsigned long long>(GetConfiguredSize(environment::cost_attribution_report_delay, 0)) * 1000000;
+        StartCostAttributionReport();
+        Logger::Info("Cost attribution is enabled.");
+    }
+
     DWORD event_mask = COR_PRF_DISABLE_TRANSPARENCY_CHECKS_UNDER_FULL_TRUST | COR_PRF_MONITOR_MODULE_LOADS |
                        COR_PRF_MONITOR_ASSEMBLY_LOADS | COR_PRF_MONITOR_APPDOMAIN_LOADS;
 
@@ -221,8 +455,25 @@ HRESULT STDMETHODCALLTYPE CorProfiler::Initialize(IUnknown* cor_profiler_info_un
         event_mask |= COR_PRF_DISABLE_ALL_NGEN_IMAGES;
     }
 
+    DWORD event_mask_high = COR_PRF_HIGH_ADD_ASSEMBLY_REFERENCES;
+
+    if (attaching)
+    {
+        // Only a subset of the flags can be set after the attach, the rest are ignored with a log entry.
+        const DWORD ignored_event_mask      = event_mask & ~COR_PRF_ALLOWABLE_AFTER_ATTACH;
+        const DWORD ignored_event_mask_high = event_mask_high & ~COR_PRF_HIGH_ALLOWABLE_AFTER_ATTACH;
+        if (ignored_event_mask != 0 || ignored_event_mask_high != 0)
+        {
+            Logger::Info("Event mask flags not allowed after attach are ignored: ",
+                         HexStr(&ignored_event_mask, sizeof(DWORD)), " ",
+                         HexStr(&ignored_event_mask_high, sizeof(DWORD)));
+        }
+        event_mask &= COR_PRF_ALLOWABLE_AFTER_ATTACH;
+        event_mask_high &= COR_PRF_HIGH_ALLOWABLE_AFTER_ATTACH;
+    }
+
     // set event mask to subscribe to events and disable NGEN images
-    hr = this->info_->SetEventMask2(event_mask, COR_PRF_HIGH_ADD_ASSEMBLY_REFERENCES);
+    hr = this->info_->SetEventMask2(event_mask, event_mask_high);
     if (FAILED(hr))
     {
         Logger::Warn("Failed to attach profiler: unable to set event mask.");
@@ -563,12 +814,22 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleLoadFinished(ModuleID module_id, HR
         return S_OK;
     }
 
+    // when attaching to a running process the module can be reported by both ModuleLoadFinished and
+    // ProfilerAttachComplete. The skipped and NGEN modules have no metadata stored, so all the reported modules
+    // are tracked.
+    if (!loaded_module_ids_.insert(module_id).second)
+    {
+        return S_OK;
+    }
+
     const auto module_info = GetModuleInfo(this->info_, module_id);
     if (!module_info.IsValid())
     {
         return S_OK;
     }
 
+    CheckStartupOverheadBudget();
+
     if (Logger::IsDebugEnabled())
     {
         Logger::Debug("ModuleLoadFinished: ", module_id, " ", module_info.assembly.name, " AppDomain ",
@@ -577,11 +838,36 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleLoadFinished(ModuleID module_id, HR
                       " | IsResource = ", module_info.IsResource(), std::noboolalpha);
     }
 
-    if (module_info.IsNGEN())
+    // The subtypes defined by the already loaded modules are instrumented right away, the ones defined
+    // by this module once its metadata is stored.
+    std::vector<TypeHierarchyMatch> module_subtypes;
+    if (type_hierarchy_index_.HasTargets() && !module_info.IsDynamic() && !module_info.IsResource() &&
+        !module_info.IsWindowsRuntime())
+    {
+        ComPtr<IUnknown> hierarchy_metadata_interfaces;
+        if (SUCCEEDED(this->info_->GetModuleMetaData(module_id, ofRead, IID_IMetaDataImport2,
+                                                     hierarchy_metadata_interfaces.GetAddressOf())))
+        {
+            std::vector<TypeHierarchyMatch> loaded_subtypes;
+            for (auto& subtype : IndexModuleTypeHierarchy(
+                     module_id, module_info.assembly.name,
+                     hierarchy_metadata_interfaces.As<IMetaDataImport2>(IID_IMetaDataImport)))
+            {
+                (subtype.module_id == module_id ? module_subtypes : loaded_subtypes).push_back(std::move(subtype));
+            }
+            CallTarget_RequestRejitForSubtypes(loaded_subtypes);
+        }
+    }
+
+    if (module_info.IsNGEN() && !ngen_inliners_shed_)
     {
         // We check if the Module contains NGEN images and added to the
         // rejit handler list to verify the inlines.
+        // CoreLib must be added too, before it is handled below: its ReadyToRun code inlines some of the
+        // allow-listed methods, e.g. DispatchWorkItem into Dispatch.
+        const CostStopwatch stopwatch;
         rejit_handler->AddNGenModule(module_id);
+        CostAttribution::Instance()->AddNGenInlinersCost(stopwatch.ElapsedNs(), 1);
     }
 
     AppDomainID app_domain_id = module_info.assembly.app_domain_id;
@@ -619,6 +905,27 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleLoadFinished(ModuleID module_id, HR
                      ".", corAssemblyProperty.pMetaData.usMinorVersion, ".",
                      corAssemblyProperty.pMetaData.usRevisionNumber);
 
+        // On .NET Framework mscorlib is domain-neutral and can't reference the instrumentation assembly,
+        // so only the CoreLib of .NET can be instrumented.
+        if (SUCCEEDED(hr) && !runtime_information_.is_desktop())
+        {
+            const auto metadata_import = metadata_interfaces.As<IMetaDataImport2>(IID_IMetaDataImport);
+            const auto metadata_emit   = metadata_interfaces.As<IMetaDataEmit2>(IID_IMetaDataEmit);
+            const auto assembly_emit   = metadata_interfaces.As<IMetaDataAssemblyEmit>(IID_IMetaDataAssemblyEmit);
+
+            corlib_module_id_ = module_id;
+            module_id_to_info_map_[module_id] =
+                new ModuleMetadata(metadata_import, metadata_emit, assembly_import, assembly_emit,
+                                   module_info.assembly.name, app_domain_id, &corAssemblyProperty);
+
+            // The rewritten CoreLib methods reference the instrumentation assembly, so their ReJIT is
+            // requested once it is loaded.
+            if (managed_profiler_module_id_ != 0)
+            {
+                CallTarget_RequestRejitForModule(module_id, module_id_to_info_map_[module_id], integration_methods_);
+            }
+        }
+
         return S_OK;
     }
 
@@ -714,17 +1021,32 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleLoadFinished(ModuleID module_id, HR
                                          module_info.assembly.name, app_domain_id, &corAssemblyProperty);
     module_id_to_info_map_[module_id] = module_metadata;
 
+    if (CallTarget_IsWovenModule(metadata_import, assembly_import, &module_metadata->woven_method_defs))
+    {
+        // The CallTarget rewrite of the woven methods was applied ahead of time by the weaver, the other integrations
+        // are still matched.
+        Logger::Info("ModuleLoadFinished woven module: ", module_id, " ", module_info.assembly.name,
+                     " [WovenMethods=", module_metadata->woven_method_defs.size(), "]");
+    }
+
     if (module_info.assembly.name == managed_profiler_name)
     {
         // If we want to rewrite metadata tokens on the instrumentation assembly it will be
         // necessary to ReJIT it. However, since that is not done at this moment it is not
         // necessary to scan for targets to be instrumented on it.
         managed_profiler_module_id_ = module_id;
+
+        if (corlib_module_id_ != 0)
+        {
+            CallTarget_RequestRejitForModule(corlib_module_id_, module_id_to_info_map_[corlib_module_id_],
+                                             integration_methods_);
+        }
     }
-    else
+    else if (!EnqueueModuleAnalysis(module_id, module_subtypes))
     {
         // We call the function to analyze the module and request the ReJIT of integrations defined in this module.
-        CallTarget_RequestRejitForModule(module_id, module_metadata, integration_methods_);
+        CallTarget_RequestRejitForModule(module_id, module_metadata, integration_methods_, true);
+        CallTarget_RequestRejitForSubtypes(module_subtypes);
     }
 
     Logger::Debug("ModuleLoadFinished stored metadata for ", module_id, " ", module_info.assembly.name, " AppDomain ",
@@ -768,7 +1090,13 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleUnloadStarted(ModuleID module_id)
 
     // take this lock so we block until the
     // module metadata is not longer being used
-    std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+    std::unique_lock<std::mutex> guard(module_id_to_info_map_lock_);
+    loaded_module_ids_.erase(module_id);
+
+    // The module analysis pool matches the integrations without the lock, so the metadata of a module being
+    // analyzed can only be released once its analysis completes. A queued analysis is skipped.
+    modules_queued_for_analysis_.erase(module_id);
+    module_analysis_completed_.wait(guard, [this, module_id]() { return modules_in_analysis_.count(module_id) == 0; });
 
     // double check if is_attached_ has changed to avoid possible race condition with shutdown function
     if (!is_attached_)
@@ -776,28 +1104,37 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ModuleUnloadStarted(ModuleID module_id)
         return S_OK;
     }
 
+    type_hierarchy_index_.RemoveModule(module_id);
+
+    // The NGEN modules are tracked by the ReJIT handler even when their metadata is not stored.
+    if (rejit_handler != nullptr)
+    {
+        rejit_handler->RemoveModule(module_id);
+    }
+
     // remove module metadata from map
     auto findRes = module_id_to_info_map_.find(module_id);
     if (findRes != module_id_to_info_map_.end())
     {
         ModuleMetadata* metadata = findRes->second;
 
-        // remove appdomain id from managed_profiler_loaded_app_domains set
-        if (managed_profiler_loaded_app_domains.find(metadata->app_domain_id) !=
-            managed_profiler_loaded_app_domains.end())
+        // remove appdomain id from managed_profiler_loaded_app_domains set, only the unload of the
+        // instrumentation assembly itself, e.g. when its AppDomain is unloaded, invalidates it. The unload of a
+        // collectible AssemblyLoadContext must not disable the instrumentation of the AppDomain.
+        if (metadata->assemblyName == managed_profiler_name)
         {
             managed_profiler_loaded_app_domains.erase(metadata->app_domain_id);
         }
 
         module_id_to_info_map_.erase(module_id);
-
-        if (rejit_handler != nullptr)
-        {
-            rejit_handler->RemoveModule(module_id);
-        }
         delete metadata;
     }
 
+    if (module_id == managed_profiler_module_id_)
+    {
+        managed_profiler_module_id_ = 0;
+    }
+
     return S_OK;
 }
 
@@ -805,6 +1142,10 @@ HRESULT STDMETHODCALLTYPE CorProfiler::Shutdown()
 {
     CorProfilerBase::Shutdown();
 
+    // The running analyses take the lock, the pool is stopped before taking it.
+    StopModuleAnalysis();
+    StopCostAttributionReport();
+
     // keep this lock until we are done using the module,
     // to prevent it from unloading while in use
     std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
@@ -815,7 +1156,11 @@ HRESULT STDMETHODCALLTYPE CorProfiler::Shutdown()
         delete rejit_handler;
         rejit_handler = nullptr;
     }
-    Logger::Info("Exiting. Stats: ", Stats::Instance()->ToString());
+    Logger::Info("Exiting. Stats: ", Stats::Instance()->ToString(),
+                 ", CallTarget instantiations: ", CallTargetInstantiations::Instance()->ToString());
+    LogCostAttributionReport("Exiting.");
+    Logger::LogSuppressedMessages();
+    TelemetryRegion::Instance()->Close();
     is_attached_.store(false);
     Logger::Shutdown();
     return S_OK;
@@ -840,9 +1185,39 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ProfilerDetachSucceeded()
     }
 
     Logger::Info("Detaching profiler.");
+
+    // No thread is running profiler code at this point, so the state kept for the instrumentation is released.
+    ReleaseInstrumentationState("Profiler detached.");
+    profiler = nullptr;
+    return S_OK;
+}
+
+void CorProfiler::ReleaseInstrumentationState(const std::string& reason)
+{
+    if (rejit_handler != nullptr)
+    {
+        rejit_handler->Shutdown();
+        delete rejit_handler;
+        rejit_handler = nullptr;
+    }
+
+    for (const auto& module_metadata : module_id_to_info_map_)
+    {
+        delete module_metadata.second;
+    }
+    module_id_to_info_map_.clear();
+    loaded_module_ids_.clear();
+    managed_profiler_module_id_ = 0;
+    corlib_module_id_           = 0;
+    type_hierarchy_index_.Clear();
+
+    Logger::Info(reason, " Stats: ", Stats::Instance()->ToString(),
+                 ", CallTarget instantiations: ", CallTargetInstantiations::Instance()->ToString());
+    LogCostAttributionReport(reason);
+    Logger::LogSuppressedMessages();
+    TelemetryRegion::Instance()->Close();
     Logger::Flush();
     is_attached_.store(false);
-    return S_OK;
 }
 
 #ifdef _WIN32
@@ -1004,77 +1379,537 @@ HRESULT STDMETHODCALLTYPE CorProfiler::JITCompilationStartedOnNetFramework(Funct
     auto valid_loader_callsite = true;
     if (is_desktop_iis)
     {
-        valid_loader_callsite = module_metadata->assemblyName == WStr("System.Web") &&
-                                caller.type.name == WStr("System.Web.Compilation.BuildManager") &&
-                                caller.name == WStr("InvokePreStartInitMethods");
+        valid_loader_callsite = module_metadata->assemblyName == WStr("System.Web") &&
+                                caller.type.name == WStr("System.Web.Compilation.BuildManager") &&
+                                caller.name == WStr("InvokePreStartInitMethods");
+    }
+    else if (module_metadata->assemblyName == WStr("System") ||
+             module_metadata->assemblyName == WStr("System.Net.Http"))
+    {
+        valid_loader_callsite = false;
+    }
+
+    // The first time a method is JIT compiled in an AppDomain, insert our Loader,
+    // which, at a minimum, must add an AssemblyResolve event so we can find
+    // OpenTelemetry.AutoInstrumentation.dll and its dependencies on disk.
+    if (valid_loader_callsite && !has_loader_injected_in_appdomain)
+    {
+        bool domain_neutral_assembly = runtime_information_.is_desktop() && corlib_module_loaded &&
+                                       module_metadata->app_domain_id == corlib_app_domain_id;
+        Logger::Info("JITCompilationStarted: Loader registered in function_id=", function_id, " token=", function_token,
+                     " name=", caller.type.name, ".", caller.name, "(), assembly_name=", module_metadata->assemblyName,
+                     " app_domain_id=", module_metadata->app_domain_id, " domain_neutral=", domain_neutral_assembly);
+
+        first_jit_compilation_app_domains.insert(module_metadata->app_domain_id);
+
+        hr = RunAutoInstrumentationLoader(module_metadata->metadata_emit, module_id, function_token);
+        if (FAILED(hr))
+        {
+            Logger::Warn("JITCompilationStarted: Call to RunAutoInstrumentationLoader() failed for ", module_id, " ",
+                         function_token);
+            return S_OK;
+        }
+
+        if (is_desktop_iis)
+        {
+            hr = AddIISPreStartInitFlags(module_id, function_token);
+            if (FAILED(hr))
+            {
+                Logger::Warn("JITCompilationStarted: Call to AddIISPreStartInitFlags() failed for ", module_id, " ",
+                             function_token);
+                return S_OK;
+            }
+        }
+    }
+
+    return S_OK;
+}
+#endif
+
+bool CorProfiler::IsAttached() const
+{
+    return is_attached_;
+}
+
+HRESULT CorProfiler::ReloadIntegrations()
+{
+    HRESULT hr = S_FALSE;
+    RunOnNativeThread([this, &hr]() { hr = ReloadIntegrationsOnNativeThread(); });
+    return hr;
+}
+
+HRESULT CorProfiler::ReloadIntegrationsOnNativeThread()
+{
+    std::vector<IntegrationMethod> integrations;
+    LoadIntegrationsFromEnvironment(integrations, GetLoadIntegrationConfiguration());
+
+    // keep this lock until we are done using the modules,
+    // to prevent them from unloading while in use
+    std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+
+    if (!is_attached_ || rejit_handler == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    // Integrations shed by the startup overhead budget stay disabled.
+    RemoveShedIntegrations(integrations);
+
+    std::vector<MethodReplacement> removed_replacements;
+    for (const auto& integration : integration_methods_)
+    {
+        if (std::find(integrations.begin(), integrations.end(), integration) == integrations.end())
+        {
+            removed_replacements.push_back(integration.replacement);
+        }
+    }
+
+    std::vector<IntegrationMethod> added_integrations;
+    for (const auto& integration : integrations)
+    {
+        if (std::find(integration_methods_.begin(), integration_methods_.end(), integration) ==
+            integration_methods_.end())
+        {
+            added_integrations.push_back(integration);
+        }
+    }
+
+    Logger::Info("ReloadIntegrations: ", integrations.size(), " integrations loaded, ", added_integrations.size(),
+                 " added, ", removed_replacements.size(), " removed.");
+
+    // Restore the original IL of the methods instrumented by the integrations that are gone.
+    if (!removed_replacements.empty())
+    {
+        std::vector<ModuleID>    modules;
+        std::vector<mdMethodDef> methods;
+        rejit_handler->RemoveMethodsWithReplacements(removed_replacements, modules, methods);
+        rejit_handler->RequestRevert(modules, methods);
+    }
+
+    integration_methods_ = std::move(integrations);
+
+    // The modules loaded while there was no derived or interface target were not indexed.
+    const bool index_loaded_modules = !type_hierarchy_index_.HasTargets();
+    auto       subtypes = type_hierarchy_index_.SetTargets(GetTypeHierarchyTargets(integration_methods_));
+    if (index_loaded_modules && type_hierarchy_index_.HasTargets())
+    {
+        for (const auto& module : module_id_to_info_map_)
+        {
+            for (auto& subtype :
+                 IndexModuleTypeHierarchy(module.first, module.second->assemblyName, module.second->metadata_import))
+            {
+                subtypes.push_back(std::move(subtype));
+            }
+        }
+    }
+
+    // Instrument the methods of the already loaded modules that match the new integrations.
+    if (!added_integrations.empty())
+    {
+        size_t rejit_count = 0;
+        for (const auto& module : module_id_to_info_map_)
+        {
+            // CoreLib can only reference the instrumentation assembly once it is loaded.
+            if (module.first != managed_profiler_module_id_ &&
+                (module.first != corlib_module_id_ || managed_profiler_module_id_ != 0))
+            {
+                rejit_count += CallTarget_RequestRejitForModule(module.first, module.second, added_integrations);
+            }
+        }
+        rejit_count += CallTarget_RequestRejitForSubtypes(subtypes);
+        Logger::Info("ReloadIntegrations: ", rejit_count, " methods requested for ReJIT.");
+    }
+
+    return S_OK;
+}
+
+HRESULT CorProfiler::DetachProfiler()
+{
+    // The pool threads run profiler code, they must be stopped before the detach, and no ReJIT must be
+    // requested once the methods are reverted.
+    StopModuleAnalysis();
+    StopCostAttributionReport();
+
+    // Restore the original IL of all instrumented methods, including the inliners that were ReJITed. The lock is kept
+    // while reverting: a concurrent Shutdown or detach can release the ReJIT handler.
+    bool attached = false;
+    auto revert   = [this, &attached]() {
+        std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+        if (!is_attached_ || rejit_handler == nullptr)
+        {
+            return;
+        }
+
+        std::vector<ModuleID>    modules;
+        std::vector<mdMethodDef> methods;
+        rejit_handler->GetMethods(modules, methods);
+        Logger::Info("DetachProfiler: Reverting ", methods.size(), " methods.");
+        rejit_handler->RequestRevert(modules, methods);
+        attached = true;
+    };
+    RunOnNativeThread(revert);
+    if (!attached)
+    {
+        return S_FALSE;
+    }
+
+    // Stop the callbacks, only the flags that can't be changed after the initialization are kept.
+    DWORD event_mask      = 0;
+    DWORD event_mask_high = 0;
+    HRESULT hr            = this->info_->GetEventMask2(&event_mask, &event_mask_high);
+    if (SUCCEEDED(hr))
+    {
+        hr = this->info_->SetEventMask2(event_mask & (COR_PRF_MONITOR_IMMUTABLE | COR_PRF_ENABLE_REJIT),
+                                        event_mask_high & COR_PRF_HIGH_MONITOR_IMMUTABLE);
+    }
+    if (FAILED(hr))
+    {
+        Logger::Warn("DetachProfiler: Failed to clear the event mask, HR=", HResultStr(hr));
+    }
+
+    hr = this->info_->RequestProfilerDetach(detach_expected_completion_milliseconds);
+    if (FAILED(hr))
+    {
+        // The runtime never unloads a profiler that requested a ReJIT, which the CallTarget instrumentation always
+        // does, nor one that set immutable flags at startup. The methods are reverted and the callbacks are stopped,
+        // so the profiler stays loaded but inactive, and the state kept for the instrumentation is released as if it
+        // was unloaded.
+        Logger::Warn("DetachProfiler: The profiler cannot be unloaded, HR=", HResultStr(hr),
+                     ". Instrumentation is disabled.");
+        std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+        if (is_attached_)
+        {
+            ReleaseInstrumentationState("Instrumentation disabled.");
+        }
+        return hr;
+    }
+
+    Logger::Info("DetachProfiler: Detach requested.");
+    return S_OK;
+}
+
+void CorProfiler::SetDumpILRewriteEnabled(bool enabled)
+{
+    dump_il_rewrite_enabled_.store(enabled, std::memory_order_relaxed);
+    Logger::Info("IL rewrite dump ", enabled ? "enabled." : "disabled.");
+}
+
+static_assert(sizeof(InstrumentedMethod::selected_arguments) / sizeof(INT32) == FASTPATH_COUNT - 1,
+              "BeginMethod takes up to FASTPATH_COUNT - 1 selected arguments.");
+
+void CorProfiler::GetInstrumentedMethods(std::vector<InstrumentedMethod>& instrumented_methods)
+{
+    // keep this lock until we are done using the modules,
+    // to prevent them from unloading while in use
+    std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+
+    if (!is_attached_ || rejit_handler == nullptr)
+    {
+        return;
+    }
+
+    // The integration types are resolved in the instrumentation assembly, so the managed code can find
+    // the CallTarget handlers, or the call-site wrapper, used by each method.
+    const auto managed_profiler_module = module_id_to_info_map_.find(managed_profiler_module_id_);
+    std::unordered_map<WSTRING, mdTypeDef> integration_type_defs;
+
+    std::vector<ModuleID>          modules;
+    std::vector<mdMethodDef>       methods;
+    std::vector<MethodReplacement> replacements;
+    rejit_handler->GetMethodReplacements(modules, methods, replacements);
+
+    for (size_t i = 0; i < methods.size(); i++)
+    {
+        const auto module = module_id_to_info_map_.find(modules[i]);
+        if (module == module_id_to_info_map_.end())
+        {
+            continue;
+        }
+
+        InstrumentedMethod instrumented_method{};
+        auto hr = module->second->metadata_import->GetScopeProps(nullptr, 0, nullptr,
+                                                                 &instrumented_method.module_version_id);
+        if (FAILED(hr))
+        {
+            continue;
+        }
+        instrumented_method.method_def              = methods[i];
+        instrumented_method.integration_type_def    = mdTypeDefNil;
+        instrumented_method.wrapper_method_def      = mdMethodDefNil;
+        instrumented_method.selected_argument_count = -1;
+
+        // The same selection as CallTarget_RewriterCallback, the CallTarget handlers are instantiated for it.
+        if (replacements[i].integration_kind == IntegrationKind::CallTarget && replacements[i].declares_arguments)
+        {
+            auto               caller = GetFunctionInfo(module->second->metadata_import, methods[i]);
+            std::vector<ULONG> positions;
+            if (caller.IsValid() && SUCCEEDED(caller.method_signature.TryParse()) &&
+                SelectCallTargetArguments(replacements[i].argument_indices,
+                                          caller.method_signature.NumberOfArguments(), FASTPATH_COUNT - 1, positions))
+            {
+                instrumented_method.selected_argument_count = static_cast<INT32>(positions.size());
+                std::copy(positions.begin(), positions.end(), instrumented_method.selected_arguments);
+            }
+        }
+
+        // The targets of the MethodMetrics integrations do not use CallTarget handlers. The callers rewritten by
+        // the call-site integrations call a wrapper method instead.
+        if (managed_profiler_module != module_id_to_info_map_.end() &&
+            replacements[i].integration_kind != IntegrationKind::MethodMetrics)
+        {
+            const auto& wrapper_type_name = replacements[i].wrapper_method.type_name;
+            auto        wrapper_type_def  = integration_type_defs.find(wrapper_type_name);
+            if (wrapper_type_def == integration_type_defs.end())
+            {
+                mdTypeDef type_def = mdTypeDefNil;
+                FindTypeDefByName(wrapper_type_name, managed_profiler_name,
+                                  managed_profiler_module->second->metadata_import, type_def);
+                wrapper_type_def = integration_type_defs.emplace(wrapper_type_name, type_def).first;
+            }
+
+            if (replacements[i].integration_kind == IntegrationKind::CallTarget)
+            {
+                instrumented_method.integration_type_def = wrapper_type_def->second;
+            }
+            else if (wrapper_type_def->second != mdTypeDefNil)
+            {
+                // The wrapper is looked up by name, the wrapper methods are not overloaded.
+                hr = managed_profiler_module->second->metadata_import->FindMethod(
+                    wrapper_type_def->second, replacements[i].wrapper_method.method_name.c_str(), nullptr, 0,
+                    &instrumented_method.wrapper_method_def);
+                if (FAILED(hr))
+                {
+                    instrumented_method.wrapper_method_def = mdMethodDefNil;
+                }
+            }
+        }
+
+        instrumented_methods.push_back(instrumented_method);
+    }
+}
+
+WSTRING CorProfiler::GetBytecodeInstrumentationAssembly() const
+{
+    WSTRING bytecodeInstrumentationAssembly = managed_profiler_full_assembly_version;
+    if (!runtime_information_.runtime_type)
+    {
+        Logger::Error("GetBytecodeInstrumentationAssembly: called before runtime_information was initialized.");
+    }
+    else if (runtime_information_.is_desktop())
+    {
+        // When on .NET Framework use the signature with the public key so strong name works.
+        bytecodeInstrumentationAssembly = managed_profiler_full_assembly_version_strong_name;
+    }
+
+    return bytecodeInstrumentationAssembly;
+}
+
+//
+// Helper methods
+//
+void CorProfiler::CheckStartupOverheadBudget()
+{
+    if (!startup_overhead_budget_.IsEnabled())
+    {
+        return;
+    }
+
+    const auto overhead = Stats::Instance()->StartupOverhead();
+    for (const auto step : startup_overhead_budget_.Consume(overhead, startup_stopwatch_.ElapsedNs()))
+    {
+        WSTRING shed;
+        switch (step)
+        {
+            case StartupDegradationStep::LowPriorityInstrumentations:
+                low_priority_integrations_shed_ = true;
+                shed = WStr("low priority instrumentations [") +
+                       JoinNames(RemoveShedIntegrations(integration_methods_)) + WStr("]");
+                break;
+            case StartupDegradationStep::NGenInliners:
+                ngen_inliners_shed_ = true;
+                shed = WStr("NGEN inliners scanning");
+                break;
+            case StartupDegradationStep::AllInstrumentations:
+                all_integrations_shed_ = true;
+                shed = WStr("all instrumentations [") + JoinNames(RemoveShedIntegrations(integration_methods_)) +
+                       WStr("]");
+                break;
+        }
+        type_hierarchy_index_.SetTargets(GetTypeHierarchyTargets(integration_methods_));
+
+        // The methods already rewritten keep their instrumentation, only the modules loaded from now on are affected.
+        Logger::Warn("Startup overhead budget exceeded after ", overhead / 1000000, "ms, stopped ", shed,
+                     ". Stats: ", Stats::Instance()->ToString());
+    }
+}
+
+void CorProfiler::StartCostAttributionReport()
+{
+    if (cost_attribution_report_delay_ns_ == 0)
+    {
+        return;
+    }
+
+    // The report doesn't depend on the modules being loaded, a native thread logs it when the delay elapsed.
+    cost_attribution_report_thread_ = std::thread([this]() {
+        const auto                   delay = std::chrono::nanoseconds(cost_attribution_report_delay_ns_);
+        std::unique_lock<std::mutex> lock(cost_attribution_report_lock_);
+        if (!cost_attribution_report_stopped_.wait_for(lock, delay, [this]() { return cost_attribution_report_stop_; }))
+        {
+            LogCostAttributionReport("Startup.");
+        }
+    });
+}
+
+void CorProfiler::StopCostAttributionReport()
+{
+    if (!cost_attribution_report_thread_.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(cost_attribution_report_lock_);
+        cost_attribution_report_stop_ = true;
+    }
+    cost_attribution_report_stopped_.notify_all();
+    cost_attribution_report_thread_.join();
+}
+
+void CorProfiler::LogCostAttributionReport(const std::string& reason) const
+{
+    const auto cost_attribution = CostAttribution::Instance();
+    if (!cost_attribution->IsEnabled())
+    {
+        return;
+    }
+
+    Logger::Info(reason, " Cost attribution: ", cost_attribution->ToString(CostAttributionReportEntries));
+    TelemetryRegion::Instance()->PublishCosts(cost_attribution->GetIntegrations(), cost_attribution->GetAssemblies(),
+                                              cost_attribution->GetNGenInliners());
+}
+
+std::vector<WSTRING> CorProfiler::RemoveShedIntegrations(std::vector<IntegrationMethod>& integrations) const
+{
+    std::vector<WSTRING>           removed_names;
+    std::vector<IntegrationMethod> kept_integrations;
+    for (const auto& integration : integrations)
+    {
+        const bool shed = all_integrations_shed_ ||
+                          (low_priority_integrations_shed_ &&
+                           std::find(low_priority_integration_names_.begin(), low_priority_integration_names_.end(),
+                                     integration.integration_name) != low_priority_integration_names_.end());
+        if (!shed)
+        {
+            kept_integrations.push_back(integration);
+        }
+        else if (std::find(removed_names.begin(), removed_names.end(), integration.integration_name) ==
+                 removed_names.end())
+        {
+            removed_names.push_back(integration.integration_name);
+        }
+    }
+
+    // IntegrationMethod is not assignable, so the vector is replaced instead of erasing from it.
+    integrations = std::move(kept_integrations);
+    return removed_names;
+}
+
+std::vector<TypeHierarchyMatch> CorProfiler::IndexModuleTypeHierarchy(ModuleID module_id, const WSTRING& assembly_name,
+                                                                      const ComPtr<IMetaDataImport2>& metadata_import)
+{
+    const auto types    = GetTypeHierarchyEntries(metadata_import);
+    auto       subtypes = type_hierarchy_index_.AddModule(module_id, assembly_name, types);
+    if (!subtypes.empty())
+    {
+        Logger::Debug("IndexModuleTypeHierarchy: ", module_id, " ", assembly_name, " indexed ", types.size(),
+                      " types, ", subtypes.size(), " subtypes of the derived and interface targets found.");
     }
-    else if (module_metadata->assemblyName == WStr("System") ||
-             module_metadata->assemblyName == WStr("System.Net.Http"))
+    return subtypes;
+}
+
+bool CorProfiler::EnqueueModuleAnalysis(ModuleID module_id, const std::vector<TypeHierarchyMatch>& module_subtypes)
+{
+    if (module_analysis_pool_ == nullptr)
     {
-        valid_loader_callsite = false;
+        return false;
     }
 
-    // The first time a method is JIT compiled in an AppDomain, insert our Loader,
-    // which, at a minimum, must add an AssemblyResolve event so we can find
-    // OpenTelemetry.AutoInstrumentation.dll and its dependencies on disk.
-    if (valid_loader_callsite && !has_loader_injected_in_appdomain)
+    modules_queued_for_analysis_.insert(module_id);
+    if (!module_analysis_pool_->Enqueue(static_cast<size_t>(module_id), [this, module_id, module_subtypes]() {
+            AnalyzeModule(module_id, module_subtypes);
+        }))
     {
-        bool domain_neutral_assembly = runtime_information_.is_desktop() && corlib_module_loaded &&
-                                       module_metadata->app_domain_id == corlib_app_domain_id;
-        Logger::Info("JITCompilationStarted: Loader registered in function_id=", function_id, " token=", function_token,
-                     " name=", caller.type.name, ".", caller.name, "(), assembly_name=", module_metadata->assemblyName,
-                     " app_domain_id=", module_metadata->app_domain_id, " domain_neutral=", domain_neutral_assembly);
+        modules_queued_for_analysis_.erase(module_id);
+        return false;
+    }
 
-        first_jit_compilation_app_domains.insert(module_metadata->app_domain_id);
+    return true;
+}
 
-        hr = RunAutoInstrumentationLoader(module_metadata->metadata_emit, module_id, function_token);
-        if (FAILED(hr))
+void CorProfiler::AnalyzeModule(ModuleID module_id, const std::vector<TypeHierarchyMatch>& module_subtypes)
+{
+    auto _ = trace::Stats::Instance()->ModuleAnalysisMeasure();
+
+    ModuleMetadata*                module_metadata = nullptr;
+    std::vector<IntegrationMethod> integrations;
+    {
+        std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+
+        // The module was unloaded, or its id reused by a module with its own analysis, since it was queued.
+        if (!is_attached_ || rejit_handler == nullptr || modules_queued_for_analysis_.erase(module_id) == 0)
         {
-            Logger::Warn("JITCompilationStarted: Call to RunAutoInstrumentationLoader() failed for ", module_id, " ",
-                         function_token);
-            return S_OK;
+            return;
         }
 
-        if (is_desktop_iis)
+        const auto module = module_id_to_info_map_.find(module_id);
+        if (module == module_id_to_info_map_.end())
         {
-            hr = AddIISPreStartInitFlags(module_id, function_token);
-            if (FAILED(hr))
+            return;
+        }
+        module_metadata = module->second;
+
+        // Only the integrations rewriting the module are copied, the matching skips the other ones.
+        for (const auto& integration : integration_methods_)
+        {
+            if (integration.replacement.InstrumentedAssemblyName() == module_metadata->assemblyName)
             {
-                Logger::Warn("JITCompilationStarted: Call to AddIISPreStartInitFlags() failed for ", module_id, " ",
-                             function_token);
-                return S_OK;
+                integrations.push_back(integration);
             }
         }
+        modules_in_analysis_.insert(module_id);
     }
 
-    return S_OK;
-}
-#endif
+    // The matching only reads the module metadata, ModuleUnloadStarted waits for it to complete.
+    std::vector<CallTargetMethodMatch> matches;
+    CallTarget_MatchModule(module_id, module_metadata, integrations, matches);
 
-bool CorProfiler::IsAttached() const
-{
-    return is_attached_;
+    {
+        std::lock_guard<std::mutex> guard(module_id_to_info_map_lock_);
+        modules_in_analysis_.erase(module_id);
+
+        // The types of the module may be loaded now, the ReJIT is requested as for an already loaded module.
+        if (is_attached_ && rejit_handler != nullptr)
+        {
+            CallTarget_RequestRejitForMatches(module_id, module_metadata, matches);
+            CallTarget_RequestRejitForSubtypes(module_subtypes);
+        }
+    }
+    module_analysis_completed_.notify_all();
 }
 
-WSTRING CorProfiler::GetBytecodeInstrumentationAssembly() const
+void CorProfiler::StopModuleAnalysis()
 {
-    WSTRING bytecodeInstrumentationAssembly = managed_profiler_full_assembly_version;
-    if (!runtime_information_.runtime_type)
+    if (module_analysis_pool_ == nullptr)
     {
-        Logger::Error("GetBytecodeInstrumentationAssembly: called before runtime_information was initialized.");
-    }
-    else if (runtime_information_.is_desktop())
-    {
-        // When on .NET Framework use the signature with the public key so strong name works.
-        bytecodeInstrumentationAssembly = managed_profiler_full_assembly_version_strong_name;
+        return;
     }
 
-    return bytecodeInstrumentationAssembly;
+    const auto pending = module_analysis_pool_->PendingCount();
+    module_analysis_pool_->Stop();
+    Logger::Debug("StopModuleAnalysis: ", pending, " modules were queued for analysis.");
 }
 
-//
-// Helper methods
-//
 WSTRING CorProfiler::GetCoreCLRProfilerPath()
 {
     WSTRING native_profiler_file;
@@ -2284,8 +3119,8 @@ HRESULT STDMETHODCALLTYPE CorProfiler::ReJITError(ModuleID    moduleId,
 {
     if (is_attached_)
     {
-        Logger::Warn("ReJITError: [functionId: ", functionId, ", moduleId: ", moduleId, ", methodId: ", methodId,
-                     ", hrStatus: ", HResultStr(hrStatus), "]");
+        Logger::WarnRateLimited("ReJITError", "ReJITError: [functionId: ", functionId, ", moduleId: ", moduleId,
+                                ", methodId: ", methodId, ", hrStatus: ", HResultStr(hrStatus), "]");
     }
 
     return S_OK;
@@ -2330,6 +3165,7 @@ HRESULT STDMETHODCALLTYPE CorProfiler::JITCachedFunctionSearchStarted(FunctionID
         // we haven't stored a ModuleMetadata for this module,
         // so there's nothing to do here, we accept the NGEN image.
         *pbUseCachedFunction = true;
+        TelemetryRegion::Instance()->Add(TelemetryCounter::NGenFunctionsUsed);
         return S_OK;
     }
 
@@ -2342,10 +3178,12 @@ HRESULT STDMETHODCALLTYPE CorProfiler::JITCachedFunctionSearchStarted(FunctionID
         Logger::Debug("Disabling NGEN due to missing loader.");
         // The loader is missing in this AppDomain, we skip the NGEN image to allow the JITCompilationStart inject it.
         *pbUseCachedFunction = false;
+        TelemetryRegion::Instance()->Add(TelemetryCounter::NGenFunctionsRejected);
         return S_OK;
     }
 
     *pbUseCachedFunction = true;
+    TelemetryRegion::Instance()->Add(TelemetryCounter::NGenFunctionsUsed);
     return S_OK;
 }
 
@@ -2359,146 +3197,261 @@ HRESULT STDMETHODCALLTYPE CorProfiler::JITCachedFunctionSearchStarted(FunctionID
 /// <param name="module_id">Module id</param>
 /// <param name="module_metadata">Module metadata for the module</param>
 /// <param name="integrations">Filtered vector of integrations to be applied</param>
+/// <param name="module_loading">True if the module is being loaded, none of its types is loaded yet</param>
 /// <returns>Number of ReJIT requests made</returns>
 size_t CorProfiler::CallTarget_RequestRejitForModule(ModuleID                              module_id,
                                                      ModuleMetadata*                       module_metadata,
-                                                     const std::vector<IntegrationMethod>& integrations)
+                                                     const std::vector<IntegrationMethod>& integrations,
+                                                     bool                                  module_loading)
 {
     auto _ = trace::Stats::Instance()->CallTargetRequestRejitMeasure();
 
-    auto       metadata_import   = module_metadata->metadata_import;
+    std::vector<CallTargetMethodMatch> matches;
+    CallTarget_MatchModule(module_id, module_metadata, integrations, matches);
+    return CallTarget_RequestRejitForMatches(module_id, module_metadata, matches, module_loading);
+}
+
+/// <summary>
+/// Search for methods to instrument in a module, only its metadata and the bodies of the call-site callers are read.
+/// </summary>
+/// <param name="module_id">Module id</param>
+/// <param name="module_metadata">Module metadata for the module</param>
+/// <param name="integrations">Filtered vector of integrations to be applied</param>
+/// <param name="matches">Receives the methods to instrument</param>
+void CorProfiler::CallTarget_MatchModule(ModuleID                              module_id,
+                                         ModuleMetadata*                       module_metadata,
+                                         const std::vector<IntegrationMethod>& integrations,
+                                         std::vector<CallTargetMethodMatch>&   matches)
+{
     const auto assembly_metadata = GetAssemblyImportMetadata(module_metadata->assembly_import);
 
-    std::vector<ModuleID>    vtModules;
-    std::vector<mdMethodDef> vtMethodDefs;
+    const auto                           cost_attribution = CostAttribution::Instance();
+    const CostStopwatch                  stopwatch;
+    std::vector<CallTargetMatchDuration> durations;
+    CallTarget_MatchModuleMethods(module_metadata->metadata_import, module_metadata->assemblyName,
+                                  assembly_metadata.version, integrations, matches, nullptr,
+                                  cost_attribution->IsEnabled() ? &durations : nullptr);
+    MatchCallSiteCallers(this->info_, module_id, module_metadata, integrations, matches);
 
-    for (const IntegrationMethod& integration : integrations)
+    if (cost_attribution->IsEnabled())
     {
-
-        // If the integration is not for the current assembly we skip.
-        if (integration.replacement.target_method.assembly.name != module_metadata->assemblyName)
+        cost_attribution->AddAssemblyCost(module_metadata->assemblyName, CostPhase::Match, stopwatch.ElapsedNs(),
+                                          matches.size());
+        for (const auto& duration : durations)
         {
-            continue;
+            const auto match_count =
+                std::count_if(matches.begin(), matches.end(),
+                              [&duration](const CallTargetMethodMatch& match) {
+                                  return match.integration == duration.integration;
+                              });
+            cost_attribution->AddIntegrationCost(duration.integration->integration_name, CostPhase::Match,
+                                                 duration.duration_ns, match_count);
         }
+    }
+}
+
+/// <summary>
+/// Request the ReJIT of the methods of the subtypes of the derived and interface integration targets.
+/// </summary>
+/// <param name="subtypes">Subtypes found by the type hierarchy index</param>
+/// <returns>Number of ReJIT requests made</returns>
+size_t CorProfiler::CallTarget_RequestRejitForSubtypes(const std::vector<TypeHierarchyMatch>& subtypes)
+{
+    if (subtypes.empty())
+    {
+        return 0;
+    }
 
-        // Check min version
-        if (integration.replacement.target_method.min_version > assembly_metadata.version)
+    auto _ = trace::Stats::Instance()->CallTargetRequestRejitMeasure();
+
+    // The version range of a derived or interface target applies to the assembly defining the target type,
+    // it is not checked if that assembly is not instrumented.
+    std::unordered_map<WSTRING, bool> version_checks;
+    auto target_version_in_range = [this, &version_checks](const MethodReference& target_method) {
+        const auto cache_key = target_method.get_type_cache_key();
+        const auto check     = version_checks.find(cache_key);
+        if (check != version_checks.end())
         {
-            continue;
+            return check->second;
         }
 
-        // Check max version
-        if (integration.replacement.target_method.max_version < assembly_metadata.version)
+        bool in_range = true;
+        for (const auto& module : module_id_to_info_map_)
         {
-            continue;
+            if (module.second->assemblyName == target_method.assembly.name)
+            {
+                const auto version = GetAssemblyImportMetadata(module.second->assembly_import).version;
+                in_range           = !(target_method.min_version > version) && !(target_method.max_version < version);
+                break;
+            }
         }
+        version_checks[cache_key] = in_range;
+        return in_range;
+    };
 
-        // We are in the right module, so we try to load the mdTypeDef from the integration target type name.
-        mdTypeDef typeDef   = mdTypeDefNil;
-        auto      foundType = FindTypeDefByName(integration.replacement.target_method.type_name,
-                                           module_metadata->assemblyName, metadata_import, typeDef);
-
-        if (!foundType)
+    std::unordered_map<ModuleID, std::vector<CallTargetMethodMatch>> module_matches;
+    for (const auto& subtype : subtypes)
+    {
+        // The skipped modules are only indexed, and CoreLib is only instrumented through its allow-list.
+        const auto module = module_id_to_info_map_.find(subtype.module_id);
+        if (module == module_id_to_info_map_.end() || subtype.module_id == managed_profiler_module_id_ ||
+            subtype.module_id == corlib_module_id_)
         {
             continue;
         }
 
-        // Now we enumerate all methods with the same target method name. (All overloads of the method)
-        auto enumMethods = Enumerator<mdMethodDef>(
-            [metadata_import, integration, typeDef](HCORENUM* ptr, mdMethodDef arr[], ULONG max,
-                                                    ULONG* cnt) -> HRESULT {
-                return metadata_import->EnumMethodsWithName(ptr, typeDef,
-                                                            integration.replacement.target_method.method_name.c_str(),
-                                                            arr, max, cnt);
-            },
-            [metadata_import](HCORENUM ptr) -> void { metadata_import->CloseEnum(ptr); });
-
-        auto enumIterator = enumMethods.begin();
-        while (enumIterator != enumMethods.end())
+        for (const auto& integration : integration_methods_)
         {
-            auto methodDef = *enumIterator;
-
-            // Extract the function info from the mdMethodDef
-            const auto caller = GetFunctionInfo(module_metadata->metadata_import, methodDef);
-            if (!caller.IsValid())
+            const auto& target_method = integration.replacement.target_method;
+            if (!target_method.IsHierarchyTarget() || target_method.type_name != subtype.target_type_name ||
+                !target_version_in_range(target_method))
             {
-                Logger::Warn("The caller for the methoddef: ", TokenStr(&methodDef), " is not valid!");
-                enumIterator = ++enumIterator;
                 continue;
             }
 
-            // We create a new function info into the heap from the caller functionInfo in the stack, to be used later
-            // in the ReJIT process
-            auto functionInfo = FunctionInfo(caller);
-            auto hr           = functionInfo.method_signature.TryParse();
-            if (FAILED(hr))
+            CallTarget_MatchSubtypeMethods(module->second->metadata_import, module->second->assemblyName,
+                                           subtype.type_def, integration, module_matches[subtype.module_id]);
+        }
+    }
+
+    size_t rejit_count = 0;
+    for (const auto& matches : module_matches)
+    {
+        rejit_count +=
+            CallTarget_RequestRejitForMatches(matches.first, module_id_to_info_map_[matches.first], matches.second);
+    }
+    return rejit_count;
+}
+
+/// <summary>
+/// Store the matched methods of a module in the ReJIT handler and request their ReJIT.
+/// </summary>
+/// <param name="module_id">Module id</param>
+/// <param name="module_metadata">Module metadata for the module</param>
+/// <param name="matches">Matched methods of the module</param>
+/// <param name="module_loading">True if the module is being loaded, the async state machines of the matched methods
+/// can get the fields used to instrument them</param>
+/// <returns>Number of ReJIT requests made</returns>
+size_t CorProfiler::CallTarget_RequestRejitForMatches(ModuleID                                  module_id,
+                                                      ModuleMetadata*                           module_metadata,
+                                                      const std::vector<CallTargetMethodMatch>& matches,
+                                                      bool                                      module_loading)
+{
+    std::vector<ModuleID>    vtModules;
+    std::vector<mdMethodDef> vtMethodDefs;
+
+    const auto          cost_attribution = CostAttribution::Instance();
+    const CostStopwatch stopwatch;
+
+    // The NGEN images of the .NET Framework contain the layout of their types, no method can be added to them.
+    const bool outline_methods = calltarget_outlining_ && module_loading &&
+                                 !(runtime_information_.is_desktop() && GetModuleInfo(this->info_, module_id).IsNGEN());
+
+    for (auto& match : matches)
+    {
+        const auto& caller    = match.function_info;
+        auto        methodDef = match.method_def;
+
+        if (match.integration->replacement.integration_kind == IntegrationKind::CallTarget &&
+            module_metadata->woven_method_defs.count(methodDef) > 0)
+        {
+            Logger::Debug("Skipping the woven method ", caller.type.name, ".", caller.name, "()");
+            continue;
+        }
+
+        const CostStopwatch match_stopwatch;
+        cost_attribution->SetWrapperIntegration(match.integration->replacement.wrapper_method.type_name,
+                                                match.integration->integration_name);
+
+        // As we are in the right method, we gather all information we need and stored it in to the ReJIT handler.
+        auto moduleHandler = rejit_handler->GetOrAddModule(module_id);
+        moduleHandler->SetModuleMetadata(module_metadata);
+        moduleHandler->SetMethod(methodDef, match.integration->replacement);
+
+        // Store module_id and methodDef to request the ReJIT after analyzing all integrations.
+        vtModules.push_back(module_id);
+        vtMethodDefs.push_back(methodDef);
+
+        // The async methods are completed by their state machine, whose MoveNext is rewritten too. The fields holding
+        // the CallTarget state can only be added before the state machine is loaded, and their type must resolve when
+        // it is loaded: the async methods found in other cases use a continuation on the returned task.
+        CallTargetAsyncStateMachine state_machine;
+        bool                        async_state_machine_defined = false;
+        if (calltarget_async_state_machines_ && module_loading &&
+            match.integration->replacement.integration_kind == IntegrationKind::CallTarget &&
+            ProfilerAssemblyIsLoadedIntoAppDomain(module_metadata->app_domain_id) &&
+            FindAsyncStateMachine(module_metadata, caller, &state_machine) == S_OK)
+        {
+            auto hr = DefineAsyncStateMachineFields(module_metadata, caller, &state_machine);
+            if (SUCCEEDED(hr))
             {
-                Logger::Warn("The method signature: ", functionInfo.method_signature.str(), " cannot be parsed.");
-                enumIterator = ++enumIterator;
-                continue;
-            }
+                const CallTargetAsyncMethod kickoff{CallTargetAsyncMethodPart::KickOff, caller, state_machine};
+                moduleHandler->SetMethod(methodDef, match.integration->replacement, &kickoff);
+
+                const CallTargetAsyncMethod move_next{CallTargetAsyncMethodPart::MoveNext, caller, state_machine};
+                moduleHandler->SetMethod(state_machine.move_next_def, match.integration->replacement, &move_next);
+
+                vtModules.push_back(module_id);
+                vtMethodDefs.push_back(state_machine.move_next_def);
+                async_state_machine_defined = true;
 
-            // Compare if the current mdMethodDef contains the same number of arguments as the instrumentation target
-            const auto numOfArgs = functionInfo.method_signature.NumberOfArguments();
-            if (numOfArgs != integration.replacement.target_method.signature_types.size() - 1)
+                Logger::Debug("Enqueue for ReJIT the async state machine of ", caller.type.name, ".", caller.name,
+                              "() [MoveNext=", TokenStr(&state_machine.move_next_def), "]");
+            }
+            else
             {
-                Logger::Debug("The caller for the methoddef: ", integration.replacement.target_method.method_name,
-                              " doesn't have the right number of arguments(", numOfArgs, " arguments).");
-                enumIterator = ++enumIterator;
-                continue;
+                Logger::Warn("The fields of the async state machine could not be defined for ", caller.type.name, ".",
+                             caller.name, "(), HR=", HResultStr(hr));
             }
+        }
 
-            // Compare each mdMethodDef argument type to the instrumentation target
-            bool       argumentsMismatch = false;
-            const auto methodArguments   = functionInfo.method_signature.GetMethodArguments();
-            Logger::Debug("Comparing signature for method: ", integration.replacement.target_method.type_name, ".",
-                          integration.replacement.target_method.method_name);
-            for (unsigned int i = 0; i < numOfArgs; i++)
+        // The original body is moved to a new method before the type is loaded, the rewrite of the instrumented
+        // method then wraps a call to it. The kickoff of an async method is already small, it keeps its body, and the
+        // calls made by a call-site caller are replaced in its own body.
+        if (outline_methods && !async_state_machine_defined &&
+            match.integration->replacement.integration_kind != IntegrationKind::CallSite && CanOutlineMethod(caller))
+        {
+            mdMethodDef outlined_method_def = mdMethodDefNil;
+            auto        hr =
+                DefineOutlinedMethod(this->info_, module_id, module_metadata, caller, &outlined_method_def);
+            if (hr == S_OK)
             {
-                const auto argumentTypeName            = methodArguments[i].GetTypeTokName(metadata_import);
-                const auto integrationArgumentTypeName = integration.replacement.target_method.signature_types[i + 1];
-                Logger::Debug("  -> ", argumentTypeName, " = ", integrationArgumentTypeName);
-                if (argumentTypeName != integrationArgumentTypeName && integrationArgumentTypeName != WStr("_"))
-                {
-                    argumentsMismatch = true;
-                    break;
-                }
+                moduleHandler->SetOutlinedMethod(methodDef, outlined_method_def);
+                Logger::Debug("Outlined the original body of ", caller.type.name, ".", caller.name, "() [MethodDef=",
+                              TokenStr(&outlined_method_def), "]");
             }
-            if (argumentsMismatch)
+            else if (FAILED(hr))
             {
-                Logger::Debug("The caller for the methoddef: ", integration.replacement.target_method.method_name,
-                              " doesn't have the right type of arguments.");
-                enumIterator = ++enumIterator;
-                continue;
+                Logger::WarnRateLimited("RequestRejitForMatches.DefineOutlinedMethod",
+                                        "The original body could not be outlined for ", caller.type.name, ".",
+                                        caller.name, "(), HR=", HResultStr(hr));
             }
+        }
 
-            // As we are in the right method, we gather all information we need and stored it in to the ReJIT handler.
-            auto moduleHandler = rejit_handler->GetOrAddModule(module_id);
-            moduleHandler->SetModuleMetadata(module_metadata);
-            auto methodHandler = moduleHandler->GetOrAddMethod(methodDef);
-            methodHandler->SetFunctionInfo(functionInfo);
-            methodHandler->SetMethodReplacement(integration.replacement);
-
-            // Store module_id and methodDef to request the ReJIT after analyzing all integrations.
-            vtModules.push_back(module_id);
-            vtMethodDefs.push_back(methodDef);
+        bool caller_assembly_is_domain_neutral = runtime_information_.is_desktop() && corlib_module_loaded &&
+                                                 module_metadata->app_domain_id == corlib_app_domain_id;
 
-            bool caller_assembly_is_domain_neutral = runtime_information_.is_desktop() && corlib_module_loaded &&
-                                                     module_metadata->app_domain_id == corlib_app_domain_id;
+        Logger::Debug("Enqueue for ReJIT [ModuleId=", module_id, ", MethodDef=", TokenStr(&methodDef),
+                      ", AppDomainId=", module_metadata->app_domain_id, ", IsDomainNeutral=",
+                      caller_assembly_is_domain_neutral, ", Assembly=", module_metadata->assemblyName, ", Type=",
+                      caller.type.name, ", Method=", caller.name, ", Signature=", caller.signature.str(), "]");
 
-            Logger::Debug("Enqueue for ReJIT [ModuleId=", module_id, ", MethodDef=", TokenStr(&methodDef),
-                          ", AppDomainId=", module_metadata->app_domain_id, ", IsDomainNeutral=",
-                          caller_assembly_is_domain_neutral, ", Assembly=", module_metadata->assemblyName, ", Type=",
-                          caller.type.name, ", Method=", caller.name, ", Signature=", caller.signature.str(), "]");
-            enumIterator = ++enumIterator;
-        }
+        cost_attribution->AddIntegrationCost(match.integration->integration_name, CostPhase::ReJit,
+                                             match_stopwatch.ElapsedNs(), 1);
     }
 
     // Request the ReJIT for all integrations found in the module.
     if (!vtMethodDefs.empty())
     {
         this->rejit_handler->RequestRejit(vtModules, vtMethodDefs);
-        this->rejit_handler->RequestRejitForNGenInliners();
+        cost_attribution->AddAssemblyCost(module_metadata->assemblyName, CostPhase::ReJit, stopwatch.ElapsedNs(),
+                                          vtMethodDefs.size());
+        if (!ngen_inliners_shed_)
+        {
+            const CostStopwatch ngen_inliners_stopwatch;
+            this->rejit_handler->RequestRejitForNGenInliners();
+            cost_attribution->AddNGenInlinersCost(ngen_inliners_stopwatch.ElapsedNs(), 1);
+        }
     }
 
     // We return the number of ReJIT requests
@@ -2507,74 +3460,60 @@ size_t CorProfiler::CallTarget_RequestRejitForModule(ModuleID
 
 /// <summary>
 /// Rewrite the target method body with the calltarget implementation. (This is function is triggered by the ReJIT
-/// handler) Resulting code structure:
-///
-/// - Add locals for TReturn (if non-void method), CallTargetState, CallTargetReturn/CallTargetReturn<TReturn>,
-/// Exception
-/// - Initialize locals
-///
-/// try
-/// {
-///   try
-///   {
-///     try
-///     {
-///       - Invoke BeginMethod with object instance (or null if static method) and original method arguments
-///       - Store result into CallTargetState local
-///     }
-///     catch
-///     {
-///       - Invoke LogException(Exception)
-///     }
-///
-///     - Execute original method instructions
-///       * All RET instructions are replaced with a LEAVE_S. If non-void method, the value on the stack is first stored
-///       in the TReturn local.
-///   }
-///   catch (Exception)
-///   {
-///     - Store exception into Exception local
-///     - throw
-///   }
-/// }
-/// finally
-/// {
-///   try
-///   {
-///     - Invoke EndMethod with object instance (or null if static method), TReturn local (if non-void method),
-///     CallTargetState local, and Exception local
-///     - Store result into CallTargetReturn/CallTargetReturn<TReturn> local
-///     - If non-void method, store CallTargetReturn<TReturn>.GetReturnValue() into TReturn local
-///   }
-///   catch
-///   {
-///     - Invoke LogException(Exception)
-///   }
-/// }
-///
-/// - If non-void method, load TReturn local
-/// - RET
+/// handler) The IL changes are applied by CallTarget_RewriteMethodBody.
 /// </summary>
 /// <param name="moduleHandler">Module ReJIT handler representation</param>
 /// <param name="methodHandler">Method ReJIT handler representation</param>
+/// <param name="pFunctionControl">Function control of the ReJIT of the method</param>
 /// <returns>Result of the rewriting</returns>
-HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       moduleHandler,
-                                                 RejitHandlerModuleMethod* methodHandler)
+HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*             moduleHandler,
+                                                 const RejitHandlerModuleMethod& methodHandler,
+                                                 ICorProfilerFunctionControl*    pFunctionControl)
 {
     auto _ = trace::Stats::Instance()->CallTargetRewriterCallbackMeasure();
 
-    FunctionInfo* caller = methodHandler->GetFunctionInfo();
+    // The ReJIT handler only keeps the methodDef, the function info is read again from the metadata.
+    ModuleMetadata* module_metadata = moduleHandler->GetModuleMetadata();
+    auto            caller_info     = GetFunctionInfo(module_metadata->metadata_import, methodHandler.methodDef);
+    if (!caller_info.IsValid() || FAILED(caller_info.method_signature.TryParse()))
+    {
+        Logger::WarnRateLimited("CallTarget_RewriterCallback.FunctionInfo",
+                                "*** CallTarget_RewriterCallback() The function info could not be read for: ",
+                                TokenStr(&methodHandler.methodDef));
+        return S_FALSE;
+    }
+    FunctionInfo* caller = &caller_info;
 
     // Ensure that the replacement is actually available and found.
     if (!managed_profiler_module_id_)
     {
-        Logger::Error("*** CallTarget_RewriterCallback() Error instrumenting: ", caller->type.name, ".", caller->name,
-                      "() ", "managed profiler module was not loaded yet.");
+        Logger::ErrorRateLimited("CallTarget_RewriterCallback.ManagedProfilerModule",
+                                 "*** CallTarget_RewriterCallback() Error instrumenting: ", caller->type.name, ".",
+                                 caller->name, "() ", "managed profiler module was not loaded yet.");
         return S_FALSE;
     }
 
-    HRESULT            hr                 = S_OK;
-    MethodReplacement* method_replacement = methodHandler->GetMethodReplacement();
+    HRESULT                            hr                 = S_OK;
+    const MethodReplacement*           method_replacement = methodHandler.methodReplacement;
+    std::vector<CallTargetArgumentUse> canonical_argument_uses;
+
+    // BeginMethod only receives the arguments declared by the integration, they are passed without an object array.
+    std::vector<ULONG> argument_positions;
+    const bool         selects_arguments =
+        method_replacement->declares_arguments &&
+        SelectCallTargetArguments(method_replacement->argument_indices, caller->method_signature.NumberOfArguments(),
+                                  FASTPATH_COUNT - 1, argument_positions);
+    if (method_replacement->declares_arguments && !selects_arguments)
+    {
+        Logger::WarnRateLimited("CallTarget_RewriterCallback.ArgumentIndices",
+                                "*** CallTarget_RewriterCallback(): The arguments declared by ",
+                                method_replacement->wrapper_method.type_name, " don't match ", caller->type.name, ".",
+                                caller->name, "(), all the arguments are passed to BeginMethod.");
+    }
+
+    // The parts of the async methods instrumented through their state machine.
+    const auto async_method =
+        methodHandler.isAsyncMethod ? moduleHandler->GetAsyncMethod(methodHandler.methodDef) : nullptr;
     {
         // keep this lock until we are done using the module,
         // to prevent it from unloading while in use
@@ -2589,8 +3528,9 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
 
         if (instrumentation_module_metadata == nullptr)
         {
-            Logger::Error("*** CallTarget_RewriterCallback() Error instrumenting: ", caller->type.name, ".",
-                          caller->name, "() managed profiler module metadata was not found.");
+            Logger::ErrorRateLimited("CallTarget_RewriterCallback.ManagedProfilerModuleMetadata",
+                                     "*** CallTarget_RewriterCallback() Error instrumenting: ", caller->type.name, ".",
+                                     caller->name, "() managed profiler module metadata was not found.");
             return S_FALSE;
         }
 
@@ -2602,9 +3542,11 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
                                                                                  &wrapper_type_def);
         if (FAILED(hr) || wrapper_type_def == mdTypeDefNil)
         {
-            Logger::Error("*** CallTarget_RewriterCallback() Failed for: ", caller->type.name, ".", caller->name,
-                          "() integration type not found on the managed profiler module HRESULT=", HResultStr(hr),
-                          " IntegrationType=", wrapper.type_name);
+            Logger::ErrorRateLimited("CallTarget_RewriterCallback.IntegrationType",
+                                     "*** CallTarget_RewriterCallback() Failed for: ", caller->type.name, ".",
+                                     caller->name,
+                                     "() integration type not found on the managed profiler module HRESULT=",
+                                     HResultStr(hr), " IntegrationType=", wrapper.type_name);
             return S_FALSE;
         }
 
@@ -2634,7 +3576,8 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
             }
         }
 
-        if (!found_wrapper_method)
+        // The type of a MethodMetrics integration only identifies it, its targets do not call it.
+        if (!found_wrapper_method && method_replacement->integration_kind == IntegrationKind::CallTarget)
         {
             Logger::Error(
                 "*** CallTarget_RewriterCallback() Failed for: ", caller->type.name, ".", caller->name,
@@ -2642,26 +3585,56 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
                 "IntegrationType=", wrapper.type_name);
             return S_FALSE;
         }
+
+        // The callers of a call-site integration call its wrapper method instead.
+        if (method_replacement->integration_kind == IntegrationKind::CallSite)
+        {
+            const auto& wrapper_method_name = wrapper.method_name.empty()
+                                                  ? method_replacement->target_method.method_name
+                                                  : wrapper.method_name;
+            mdMethodDef wrapper_method_def[1];
+            HCORENUM    phEnum  = NULL;
+            ULONG       cTokens = 0;
+            hr = instrumentation_module_metadata->metadata_import->EnumMethodsWithName(&phEnum, wrapper_type_def,
+                                                                                       wrapper_method_name.c_str(),
+                                                                                       wrapper_method_def, 1,
+                                                                                       &cTokens);
+            instrumentation_module_metadata->metadata_import->CloseEnum(phEnum);
+            if (hr != S_OK || cTokens == 0)
+            {
+                Logger::ErrorRateLimited("CallTarget_RewriterCallback.CallSiteWrapperMethod",
+                                         "*** CallTarget_RewriterCallback() Failed for: ", caller->type.name, ".",
+                                         caller->name, "() the call-site wrapper method was not found ",
+                                         "IntegrationType=", wrapper.type_name, ", Method=", wrapper_method_name);
+                return S_FALSE;
+            }
+        }
+
+        if (calltarget_instantiation_policy_ == CallTargetInstantiationPolicy::Canonical)
+        {
+            canonical_argument_uses =
+                GetCallTargetArgumentUses(instrumentation_module_metadata->metadata_import, wrapper_type_def,
+                                          selects_arguments ? static_cast<ULONG>(argument_positions.size())
+                                                            : caller->method_signature.NumberOfArguments());
+        }
     }
 
-    ModuleID               module_id        = moduleHandler->GetModuleId();
-    ModuleMetadata*        module_metadata  = moduleHandler->GetModuleMetadata();
-    CallTargetTokens*      callTargetTokens = module_metadata->GetCallTargetTokens();
-    mdToken                function_token   = caller->id;
-    FunctionMethodArgument retFuncArg       = caller->method_signature.GetRet();
+    ModuleID               module_id       = moduleHandler->GetModuleId();
+    mdToken                function_token  = caller->id;
+    FunctionMethodArgument retFuncArg      = caller->method_signature.GetRet();
     unsigned int           retFuncElementType;
     int                    retTypeFlags = retFuncArg.GetTypeFlags(retFuncElementType);
     bool                   isVoid       = (retTypeFlags & TypeFlagVoid) > 0;
-    bool                   isStatic = !(caller->method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS);
-    std::vector<FunctionMethodArgument> methodArguments = caller->method_signature.GetMethodArguments();
-    int                                 numArgs         = caller->method_signature.NumberOfArguments();
-    auto                                metaEmit        = module_metadata->metadata_emit;
-    auto                                metaImport      = module_metadata->metadata_import;
+    bool isStatic = !(caller->method_signature.CallingConvention() & IMAGE_CEE_CS_CALLCONV_HASTHIS);
+    int  numArgs  = caller->method_signature.NumberOfArguments();
 
     // *** Get all references to the wrapper type
     mdMemberRef wrapper_method_ref = mdMemberRefNil;
     mdTypeRef   wrapper_type_ref   = mdTypeRefNil;
-    GetWrapperMethodRef(module_metadata, module_id, *method_replacement, wrapper_method_ref, wrapper_type_ref);
+    if (method_replacement->integration_kind != IntegrationKind::MethodMetrics)
+    {
+        GetWrapperMethodRef(module_metadata, module_id, *method_replacement, wrapper_method_ref, wrapper_type_ref);
+    }
 
     if (Logger::IsDebugEnabled())
     {
@@ -2673,7 +3646,8 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
     // First we check if the managed profiler has not been loaded yet
     if (!ProfilerAssemblyIsLoadedIntoAppDomain(module_metadata->app_domain_id))
     {
-        Logger::Warn(
+        Logger::WarnRateLimited(
+            "CallTarget_RewriterCallback.ManagedProfilerAppDomain",
             "*** CallTarget_RewriterCallback() skipping method: Method replacement found but the managed profiler has "
             "not yet been loaded into AppDomain with id=",
             module_metadata->app_domain_id, " token=", function_token, " caller_name=", caller->type.name, ".",
@@ -2682,393 +3656,91 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
     }
 
     // *** Create rewriter
-    ILRewriter rewriter(this->info_, methodHandler->GetFunctionControl(), module_id, function_token);
-    bool       modified = false;
-    hr                  = rewriter.Import();
+    // The body of an outlined method only calls the method with its original body.
+    const auto outlined_method_def =
+        async_method == nullptr ? moduleHandler->GetOutlinedMethod(methodHandler.methodDef) : mdMethodDefNil;
+    ILRewriter rewriter(this->info_, pFunctionControl, module_id, function_token);
+    hr = outlined_method_def != mdMethodDefNil ? WriteOutlinedMethodCall(&rewriter, *caller, outlined_method_def)
+                                               : rewriter.Import();
     if (FAILED(hr))
     {
-        Logger::Warn("*** CallTarget_RewriterCallback(): Call to ILRewriter.Import() failed for ", module_id, " ",
-                     function_token);
+        Logger::WarnRateLimited("CallTarget_RewriterCallback.Import",
+                                "*** CallTarget_RewriterCallback(): Call to ILRewriter.Import() failed for ", module_id,
+                                " ", function_token);
         return S_FALSE;
     }
 
+    if (outlined_method_def != mdMethodDefNil)
+    {
+        Logger::Debug("*** CallTarget_RewriterCallback(): ", caller->type.name, ".", caller->name,
+                      "() forwards to its outlined body ", OutlinedMethodNamePrefix + caller->name, "() [MethodDef=",
+                      TokenStr(&outlined_method_def), "]");
+    }
+
     // *** Store the original il code text if the dump_il option is enabled.
+    // The option is read once, it can change while the method is rewritten.
+    const bool  dump_il_rewrite = dump_il_rewrite_enabled_.load(std::memory_order_relaxed);
     std::string original_code;
-    if (IsDumpILRewriteEnabled())
+    if (dump_il_rewrite)
     {
         original_code =
             GetILCodes("*** CallTarget_RewriterCallback(): Original Code: ", &rewriter, *caller, module_metadata);
     }
 
-    // *** Create the rewriter wrapper helper
-    ILRewriterWrapper reWriterWrapper(&rewriter);
-    reWriterWrapper.SetILPosition(rewriter.GetILList()->m_pNext);
-
-    // *** Modify the Local Var Signature of the method and initialize the new local vars
-    ULONG    callTargetStateIndex  = static_cast<ULONG>(ULONG_MAX);
-    ULONG    exceptionIndex        = static_cast<ULONG>(ULONG_MAX);
-    ULONG    callTargetReturnIndex = static_cast<ULONG>(ULONG_MAX);
-    ULONG    returnValueIndex      = static_cast<ULONG>(ULONG_MAX);
-    mdToken  callTargetStateToken  = mdTokenNil;
-    mdToken  exceptionToken        = mdTokenNil;
-    mdToken  callTargetReturnToken = mdTokenNil;
-    ILInstr* firstInstruction;
-    callTargetTokens->ModifyLocalSigAndInitialize(&reWriterWrapper, caller, &callTargetStateIndex, &exceptionIndex,
-                                                  &callTargetReturnIndex, &returnValueIndex, &callTargetStateToken,
-                                                  &exceptionToken, &callTargetReturnToken, &firstInstruction);
-
-    // ***
-    // BEGIN METHOD PART
-    // ***
-
-    // *** Load instance into the stack (if not static)
-    if (isStatic)
-    {
-        if (caller->type.valueType)
-        {
-            // Static methods in a ValueType can't be instrumented.
-            // In the future this can be supported by adding a local for the valuetype and initialize it to the default
-            // value. After the signature modification we need to emit the following IL to initialize and load into the
-            // stack.
-            //    ldloca.s [localIndex]
-            //    initobj [valueType]
-            //    ldloc.s [localIndex]
-            Logger::Warn("*** CallTarget_RewriterCallback(): Static methods in a ValueType cannot be instrumented. ");
-            return S_FALSE;
-        }
-        reWriterWrapper.LoadNull();
-    }
-    else
+    // *** Apply the CallTarget rewrite to the imported IL
+    if (method_replacement->integration_kind == IntegrationKind::MethodMetrics)
     {
-        reWriterWrapper.LoadArgument(0);
-        if (caller->type.valueType)
+        // The overloads are told apart by their parameter types.
+        auto       metadata_import = module_metadata->metadata_import;
+        auto       method_name     = caller->type.name + WStr(".") + caller->name + WStr("(");
+        const auto arguments       = caller->method_signature.GetMethodArguments();
+        for (size_t i = 0; i < arguments.size(); i++)
         {
-            if (caller->type.type_spec != mdTypeSpecNil)
-            {
-                reWriterWrapper.LoadObj(caller->type.type_spec);
-            }
-            else if (!caller->type.isGeneric)
-            {
-                reWriterWrapper.LoadObj(caller->type.id);
-            }
-            else
-            {
-                // Generic struct instrumentation is not supported
-                // IMetaDataImport::GetMemberProps and IMetaDataImport::GetMemberRefProps returns
-                // The parent token as mdTypeDef and not as a mdTypeSpec
-                // that's because the method definition is stored in the mdTypeDef
-                // The problem is that we don't have the exact Spec of that generic
-                // We can't emit LoadObj or Box because that would result in an invalid IL.
-                // This problem doesn't occur on a class type because we can always relay in the
-                // object type.
-                return S_FALSE;
-            }
+            method_name += (i == 0 ? EmptyWStr : WStr(", ")) + arguments[i].GetTypeTokName(metadata_import);
         }
-    }
+        method_name += WStr(")");
 
-    // *** Load the method arguments to the stack
-    unsigned elementType;
-    if (numArgs < FASTPATH_COUNT)
-    {
-        // Load the arguments directly (FastPath)
-        for (int i = 0; i < numArgs; i++)
-        {
-            reWriterWrapper.LoadArgument(i + (isStatic ? 0 : 1));
-            auto argTypeFlags = methodArguments[i].GetTypeFlags(elementType);
-            if (argTypeFlags & TypeFlagByRef)
-            {
-                Logger::Warn("*** CallTarget_RewriterCallback(): Methods with ref parameters "
-                             "cannot be instrumented. ");
-                return S_FALSE;
-            }
-        }
-    }
-    else
-    {
-        // Load the arguments inside an object array (SlowPath)
-        reWriterWrapper.CreateArray(callTargetTokens->GetObjectTypeRef(), numArgs);
-        for (int i = 0; i < numArgs; i++)
+        const auto method_id =
+            MethodMetrics::Instance()->Register(module_metadata->assemblyName, caller->id, method_name);
+        if (method_id < 0)
         {
-            reWriterWrapper.BeginLoadValueIntoArray(i);
-            reWriterWrapper.LoadArgument(i + (isStatic ? 0 : 1));
-            auto argTypeFlags = methodArguments[i].GetTypeFlags(elementType);
-            if (argTypeFlags & TypeFlagByRef)
-            {
-                Logger::Warn("*** CallTarget_RewriterCallback(): Methods with ref parameters "
-                             "cannot be instrumented. ");
-                return S_FALSE;
-            }
-            if (argTypeFlags & TypeFlagBoxedType)
-            {
-                auto tok = methodArguments[i].GetTypeTok(metaEmit, callTargetTokens->GetCorLibAssemblyRef());
-                if (tok == mdTokenNil)
-                {
-                    return S_FALSE;
-                }
-                reWriterWrapper.Box(tok);
-            }
-            reWriterWrapper.EndLoadValueIntoArray();
-        }
-    }
-
-    // *** Emit BeginMethod call
-    if (Logger::IsDebugEnabled())
-    {
-        Logger::Debug("Caller Type.Id: ", HexStr(&caller->type.id, sizeof(mdToken)));
-        Logger::Debug("Caller Type.IsGeneric: ", caller->type.isGeneric);
-        Logger::Debug("Caller Type.IsValid: ", caller->type.IsValid());
-        Logger::Debug("Caller Type.Name: ", caller->type.name);
-        Logger::Debug("Caller Type.TokenType: ", caller->type.token_type);
-        Logger::Debug("Caller Type.Spec: ", HexStr(&caller->type.type_spec, sizeof(mdTypeSpec)));
-        Logger::Debug("Caller Type.ValueType: ", caller->type.valueType);
-        //
-        if (caller->type.extend_from != nullptr)
-        {
-            Logger::Debug("Caller Type Extend From.Id: ", HexStr(&caller->type.extend_from->id, sizeof(mdToken)));
-            Logger::Debug("Caller Type Extend From.IsGeneric: ", caller->type.extend_from->isGeneric);
-            Logger::Debug("Caller Type Extend From.IsValid: ", caller->type.extend_from->IsValid());
-            Logger::Debug("Caller Type Extend From.Name: ", caller->type.extend_from->name);
-            Logger::Debug("Caller Type Extend From.TokenType: ", caller->type.extend_from->token_type);
-            Logger::Debug("Caller Type Extend From.Spec: ",
-                          HexStr(&caller->type.extend_from->type_spec, sizeof(mdTypeSpec)));
-            Logger::Debug("Caller Type Extend From.ValueType: ", caller->type.extend_from->valueType);
-        }
-        //
-        if (caller->type.parent_type != nullptr)
-        {
-            Logger::Debug("Caller ParentType.Id: ", HexStr(&caller->type.parent_type->id, sizeof(mdToken)));
-            Logger::Debug("Caller ParentType.IsGeneric: ", caller->type.parent_type->isGeneric);
-            Logger::Debug("Caller ParentType.IsValid: ", caller->type.parent_type->IsValid());
-            Logger::Debug("Caller ParentType.Name: ", caller->type.parent_type->name);
-            Logger::Debug("Caller ParentType.TokenType: ", caller->type.parent_type->token_type);
-            Logger::Debug("Caller ParentType.Spec: ", HexStr(&caller->type.parent_type->type_spec, sizeof(mdTypeSpec)));
-            Logger::Debug("Caller ParentType.ValueType: ", caller->type.parent_type->valueType);
-        }
-    }
-
-    ILInstr* beginCallInstruction;
-    hr = callTargetTokens->WriteBeginMethod(&reWriterWrapper, wrapper_type_ref, &caller->type, methodArguments,
-                                            &beginCallInstruction);
-    if (FAILED(hr))
-    {
-        // Error message is written to the log in WriteBeginMethod.
-        return S_FALSE;
-    }
-    reWriterWrapper.StLocal(callTargetStateIndex);
-    ILInstr* pStateLeaveToBeginOriginalMethodInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
-
-    // *** BeginMethod call catch
-    ILInstr* beginMethodCatchFirstInstr = nullptr;
-    callTargetTokens->WriteLogException(&reWriterWrapper, wrapper_type_ref, &caller->type, &beginMethodCatchFirstInstr);
-    ILInstr* beginMethodCatchLeaveInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
-
-    // *** BeginMethod exception handling clause
-    EHClause beginMethodExClause{};
-    beginMethodExClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
-    beginMethodExClause.m_pTryBegin     = firstInstruction;
-    beginMethodExClause.m_pTryEnd       = beginMethodCatchFirstInstr;
-    beginMethodExClause.m_pHandlerBegin = beginMethodCatchFirstInstr;
-    beginMethodExClause.m_pHandlerEnd   = beginMethodCatchLeaveInstr;
-    beginMethodExClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
-
-    // ***
-    // METHOD EXECUTION
-    // ***
-    ILInstr* beginOriginalMethodInstr                = reWriterWrapper.GetCurrentILInstr();
-    pStateLeaveToBeginOriginalMethodInstr->m_pTarget = beginOriginalMethodInstr;
-    beginMethodCatchLeaveInstr->m_pTarget            = beginOriginalMethodInstr;
-
-    // ***
-    // ENDING OF THE METHOD EXECUTION
-    // ***
-
-    // *** Create return instruction and insert it at the end
-    ILInstr* methodReturnInstr  = rewriter.NewILInstr();
-    methodReturnInstr->m_opcode = CEE_RET;
-    rewriter.InsertAfter(rewriter.GetILList()->m_pPrev, methodReturnInstr);
-    reWriterWrapper.SetILPosition(methodReturnInstr);
-
-    // ***
-    // EXCEPTION CATCH
-    // ***
-    ILInstr* startExceptionCatch = reWriterWrapper.StLocal(exceptionIndex);
-    reWriterWrapper.SetILPosition(methodReturnInstr);
-    ILInstr* rethrowInstr = reWriterWrapper.Rethrow();
-
-    // ***
-    // EXCEPTION FINALLY / END METHOD PART
-    // ***
-    ILInstr* endMethodTryStartInstr;
-
-    // *** Load instance into the stack (if not static)
-    if (isStatic)
-    {
-        if (caller->type.valueType)
-        {
-            // Static methods in a ValueType can't be instrumented.
-            // In the future this can be supported by adding a local for the valuetype
-            // and initialize it to the default value. After the signature
-            // modification we need to emit the following IL to initialize and load
-            // into the stack.
-            //    ldloca.s [localIndex]
-            //    initobj [valueType]
-            //    ldloc.s [localIndex]
-            Logger::Warn("CallTarget_RewriterCallback: Static methods in a ValueType cannot "
-                         "be instrumented. ");
+            Logger::WarnRateLimited("CallTarget_RewriterCallback.MethodMetrics",
+                                    "*** CallTarget_RewriterCallback(): The method metrics are full, ",
+                                    caller->type.name, ".", caller->name, "() is not instrumented.");
             return S_FALSE;
         }
-        endMethodTryStartInstr = reWriterWrapper.LoadNull();
+        hr = CallTarget_RewriteMethodMetrics(&rewriter, module_metadata, caller, method_id);
     }
-    else
+    else if (method_replacement->integration_kind == IntegrationKind::CallSite)
     {
-        endMethodTryStartInstr = reWriterWrapper.LoadArgument(0);
-        if (caller->type.valueType)
+        hr = RewriteCallSites(&rewriter, module_metadata, *method_replacement, wrapper_type_ref);
+        if (hr == S_FALSE)
         {
-            if (caller->type.type_spec != mdTypeSpecNil)
-            {
-                reWriterWrapper.LoadObj(caller->type.type_spec);
-            }
-            else if (!caller->type.isGeneric)
-            {
-                reWriterWrapper.LoadObj(caller->type.id);
-            }
-            else
-            {
-                // Generic struct instrumentation is not supported
-                // IMetaDataImport::GetMemberProps and IMetaDataImport::GetMemberRefProps returns
-                // The parent token as mdTypeDef and not as a mdTypeSpec
-                // that's because the method definition is stored in the mdTypeDef
-                // The problem is that we don't have the exact Spec of that generic
-                // We can't emit LoadObj or Box because that would result in an invalid IL.
-                // This problem doesn't occur on a class type because we can always relay in the
-                // object type.
-                return S_FALSE;
-            }
+            Logger::Debug("*** CallTarget_RewriterCallback(): No call of ",
+                          method_replacement->target_method.type_name, ".",
+                          method_replacement->target_method.method_name, "() found in ", caller->type.name, ".",
+                          caller->name, "()");
         }
     }
-
-    // *** Load the return value is is not void
-    if (!isVoid)
-    {
-        reWriterWrapper.LoadLocal(returnValueIndex);
-    }
-
-    reWriterWrapper.LoadLocal(exceptionIndex);
-    reWriterWrapper.LoadLocal(callTargetStateIndex);
-
-    ILInstr* endMethodCallInstr;
-    if (isVoid)
+    else if (async_method != nullptr && async_method->part == CallTargetAsyncMethodPart::MoveNext)
     {
-        callTargetTokens->WriteEndVoidReturnMemberRef(&reWriterWrapper, wrapper_type_ref, &caller->type,
-                                                      &endMethodCallInstr);
+        FunctionInfo kickoff(async_method->kickoff);
+        hr = CallTarget_RewriteAsyncMoveNext(&rewriter, module_metadata, &kickoff, wrapper_type_ref,
+                                             async_method->state_machine);
     }
     else
     {
-        callTargetTokens->WriteEndReturnMemberRef(&reWriterWrapper, wrapper_type_ref, &caller->type, &retFuncArg,
-                                                  &endMethodCallInstr);
-    }
-    reWriterWrapper.StLocal(callTargetReturnIndex);
-
-    if (!isVoid)
-    {
-        ILInstr* callTargetReturnGetReturnInstr;
-        reWriterWrapper.LoadLocalAddress(callTargetReturnIndex);
-        callTargetTokens->WriteCallTargetReturnGetReturnValue(&reWriterWrapper, callTargetReturnToken,
-                                                              &callTargetReturnGetReturnInstr);
-        reWriterWrapper.StLocal(returnValueIndex);
-    }
-
-    ILInstr* endMethodTryLeave = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
-
-    // *** EndMethod call catch
-    ILInstr* endMethodCatchFirstInstr = nullptr;
-    callTargetTokens->WriteLogException(&reWriterWrapper, wrapper_type_ref, &caller->type, &endMethodCatchFirstInstr);
-    ILInstr* endMethodCatchLeaveInstr = reWriterWrapper.CreateInstr(CEE_LEAVE_S);
-
-    // *** EndMethod exception handling clause
-    EHClause endMethodExClause{};
-    endMethodExClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
-    endMethodExClause.m_pTryBegin     = endMethodTryStartInstr;
-    endMethodExClause.m_pTryEnd       = endMethodCatchFirstInstr;
-    endMethodExClause.m_pHandlerBegin = endMethodCatchFirstInstr;
-    endMethodExClause.m_pHandlerEnd   = endMethodCatchLeaveInstr;
-    endMethodExClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
-
-    // *** EndMethod leave to finally
-    ILInstr* endFinallyInstr            = reWriterWrapper.EndFinally();
-    endMethodTryLeave->m_pTarget        = endFinallyInstr;
-    endMethodCatchLeaveInstr->m_pTarget = endFinallyInstr;
-
-    // ***
-    // METHOD RETURN
-    // ***
-
-    // Load the current return value from the local var
-    if (!isVoid)
-    {
-        reWriterWrapper.LoadLocal(returnValueIndex);
-    }
-
-    // Changes all returns to a LEAVE.S
-    for (ILInstr* pInstr = rewriter.GetILList()->m_pNext; pInstr != rewriter.GetILList(); pInstr = pInstr->m_pNext)
-    {
-        switch (pInstr->m_opcode)
-        {
-            case CEE_RET:
-            {
-                if (pInstr != methodReturnInstr)
-                {
-                    if (!isVoid)
-                    {
-                        reWriterWrapper.SetILPosition(pInstr);
-                        reWriterWrapper.StLocal(returnValueIndex);
-                    }
-                    pInstr->m_opcode  = CEE_LEAVE_S;
-                    pInstr->m_pTarget = endFinallyInstr->m_pNext;
-                }
-                break;
-            }
-            default:
-                break;
-        }
+        hr = CallTarget_RewriteMethodBody(&rewriter, module_metadata, caller, wrapper_type_ref,
+                                          selects_arguments ? &argument_positions : nullptr, canonical_argument_uses,
+                                          async_method != nullptr ? &async_method->state_machine : nullptr);
     }
-
-    // Exception handling clauses
-    EHClause exClause{};
-    exClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_NONE;
-    exClause.m_pTryBegin     = firstInstruction;
-    exClause.m_pTryEnd       = startExceptionCatch;
-    exClause.m_pHandlerBegin = startExceptionCatch;
-    exClause.m_pHandlerEnd   = rethrowInstr;
-    exClause.m_ClassToken    = callTargetTokens->GetExceptionTypeRef();
-
-    EHClause finallyClause{};
-    finallyClause.m_Flags         = COR_ILEXCEPTION_CLAUSE_FINALLY;
-    finallyClause.m_pTryBegin     = firstInstruction;
-    finallyClause.m_pTryEnd       = rethrowInstr->m_pNext;
-    finallyClause.m_pHandlerBegin = rethrowInstr->m_pNext;
-    finallyClause.m_pHandlerEnd   = endFinallyInstr;
-
-    // ***
-    // Update and Add exception clauses
-    // ***
-    auto ehCount      = rewriter.GetEHCount();
-    auto ehPointer    = rewriter.GetEHPointer();
-    auto newEHClauses = new EHClause[ehCount + 4];
-    for (unsigned i = 0; i < ehCount; i++)
+    if (hr != S_OK)
     {
-        newEHClauses[i] = ehPointer[i];
+        // Error message is written to the log in CallTarget_RewriteMethodBody.
+        return S_FALSE;
     }
 
-    // *** Add the new EH clauses
-    ehCount += 4;
-    newEHClauses[ehCount - 4] = beginMethodExClause;
-    newEHClauses[ehCount - 3] = endMethodExClause;
-    newEHClauses[ehCount - 2] = exClause;
-    newEHClauses[ehCount - 1] = finallyClause;
-    rewriter.SetEHClause(newEHClauses, ehCount);
-
-    if (IsDumpILRewriteEnabled())
+    if (dump_il_rewrite)
     {
         Logger::Info(original_code);
         Logger::Info(
@@ -3079,12 +3751,24 @@ HRESULT CorProfiler::CallTarget_RewriterCallback(RejitHandlerModule*       modul
 
     if (FAILED(hr))
     {
-        Logger::Warn("*** CallTarget_RewriterCallback(): Call to ILRewriter.Export() failed for "
-                     "ModuleID=",
-                     module_id, " ", function_token);
+        Logger::WarnRateLimited("CallTarget_RewriterCallback.Export",
+                                "*** CallTarget_RewriterCallback(): Call to ILRewriter.Export() failed for ModuleID=",
+                                module_id, " ", function_token);
         return S_FALSE;
     }
 
+    // The original instructions are shifted by the CallTarget prologue, the runtime needs the map to report the
+    // original offsets, and so the right source lines, in stack traces, debuggers and profilers. An outlined method
+    // has no original instruction left.
+    hr = outlined_method_def == mdMethodDefNil ? rewriter.SetILInstrumentedCodeMap() : S_OK;
+    if (FAILED(hr))
+    {
+        Logger::WarnRateLimited("CallTarget_RewriterCallback.SetILInstrumentedCodeMap",
+                                "*** CallTarget_RewriterCallback(): Call to ILRewriter.SetILInstrumentedCodeMap() "
+                                "failed for ModuleID=",
+                                module_id, " ", function_token, ", HR=", HResultStr(hr));
+    }
+
     Logger::Info("*** CallTarget_RewriterCallback() Finished: ", caller->type.name, ".", caller->name, "() [IsVoid=",
                  isVoid, ", IsStatic=", isStatic, ", IntegrationType=", method_replacement->wrapper_method.type_name,
                  ", Arguments=", numArgs, "]");
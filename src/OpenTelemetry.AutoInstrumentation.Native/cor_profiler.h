@@ -9,22 +9,49 @@
 #include "cor.h"
 #include "corprof.h"
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "calltarget_instantiations.h"
+#include "calltarget_planner.h"
 #include "cor_profiler_base.h"
+#include "cost_attribution.h"
 #include "environment_variables.h"
 #include "il_rewriter.h"
 #include "integration.h"
+#include "module_analysis_pool.h"
 #include "module_metadata.h"
 #include "pal.h"
 #include "rejit_handler.h"
+#include "startup_overhead_budget.h"
+#include "type_hierarchy_index.h"
 
 namespace trace
 {
 
+// Method requested for ReJIT, as returned to the managed code.
+// NOTE: Must keep this layout in sync with NativeMethods.InstrumentedMethod.
+struct InstrumentedMethod
+{
+    GUID module_version_id;
+    mdMethodDef method_def;
+    // TypeDef of the integration in the instrumentation assembly, or mdTypeDefNil if it was not found.
+    mdTypeDef integration_type_def;
+    // MethodDef of the wrapper called instead of the target by a call-site integration, in the instrumentation
+    // assembly, or mdMethodDefNil.
+    mdMethodDef wrapper_method_def;
+    // Number of arguments passed to BeginMethod when the integration selects them, or -1 when all the arguments are
+    // passed.
+    INT32 selected_argument_count;
+    // Indices of the selected arguments, in the order they are passed to BeginMethod, up to FASTPATH_COUNT - 1.
+    INT32 selected_arguments[8];
+};
+
 class CorProfiler : public CorProfilerBase
 {
 private:
@@ -61,7 +88,54 @@ private:
     //
     std::mutex module_id_to_info_map_lock_;
     std::unordered_map<ModuleID, ModuleMetadata*> module_id_to_info_map_;
+    // All the modules reported to ModuleLoadFinished, including the skipped and NGEN ones without metadata
+    std::unordered_set<ModuleID> loaded_module_ids_;
     ModuleID managed_profiler_module_id_ = 0;
+    ModuleID corlib_module_id_ = 0;
+
+    //
+    // Subtypes of the derived and interface integration targets, guarded by module_id_to_info_map_lock_
+    //
+    TypeHierarchyIndex type_hierarchy_index_;
+
+    //
+    // Startup overhead budget, guarded by module_id_to_info_map_lock_
+    //
+    StartupOverheadBudget startup_overhead_budget_{0, {}};
+    CostStopwatch startup_stopwatch_;
+    std::vector<WSTRING> low_priority_integration_names_;
+    bool low_priority_integrations_shed_ = false;
+    bool ngen_inliners_shed_ = false;
+    bool all_integrations_shed_ = false;
+
+    //
+    // Generic arguments of the CallTargetInvoker calls, read once at Initialize
+    //
+    CallTargetInstantiationPolicy calltarget_instantiation_policy_ = CallTargetInstantiationPolicy::Typed;
+    bool calltarget_async_state_machines_ = false;
+    bool calltarget_outlining_ = false;
+
+    //
+    // IL dump switch, read with relaxed loads because it can be changed while the methods are rewritten
+    //
+    std::atomic_bool dump_il_rewrite_enabled_{false};
+
+    //
+    // Cost attribution report thread, it logs the report once the delay elapsed
+    //
+    unsigned long long cost_attribution_report_delay_ns_ = 0;
+    std::thread cost_attribution_report_thread_;
+    std::mutex cost_attribution_report_lock_;
+    std::condition_variable cost_attribution_report_stopped_;
+    bool cost_attribution_report_stop_ = false;
+
+    //
+    // Module analysis pool, the sets are guarded by module_id_to_info_map_lock_
+    //
+    std::unique_ptr<ModuleAnalysisPool> module_analysis_pool_;
+    std::unordered_set<ModuleID> modules_queued_for_analysis_;
+    std::unordered_set<ModuleID> modules_in_analysis_;
+    std::condition_variable module_analysis_completed_;
 
     //
     // Methods only for .NET Framework
@@ -92,6 +166,7 @@ private:
     //
     // Helper methods
     //
+    HRESULT InitializeProfiler(IUnknown* cor_profiler_info_unknown, bool attaching);
     void RewritingPInvokeMaps(ComPtr<IUnknown> metadata_interfaces, ModuleMetadata* module_metadata, WSTRING nativemethods_type_name);
     WSTRING GetCoreCLRProfilerPath();
     bool GetWrapperMethodRef(ModuleMetadata* module_metadata, ModuleID module_id,
@@ -100,18 +175,50 @@ private:
     bool ProfilerAssemblyIsLoadedIntoAppDomain(AppDomainID app_domain_id);
     std::string GetILCodes(const std::string& title, ILRewriter* rewriter, const FunctionInfo& caller,
                            ModuleMetadata* module_metadata);
+    void CheckStartupOverheadBudget();
+    void StartCostAttributionReport();
+    void StopCostAttributionReport();
+    void LogCostAttributionReport(const std::string& reason) const;
+    std::vector<WSTRING> RemoveShedIntegrations(std::vector<IntegrationMethod>& integrations) const;
+    std::vector<TypeHierarchyMatch> IndexModuleTypeHierarchy(ModuleID module_id, const WSTRING& assembly_name,
+                                                             const ComPtr<IMetaDataImport2>& metadata_import);
+    bool EnqueueModuleAnalysis(ModuleID module_id, const std::vector<TypeHierarchyMatch>& module_subtypes);
+    void AnalyzeModule(ModuleID module_id, const std::vector<TypeHierarchyMatch>& module_subtypes);
+    void StopModuleAnalysis();
+    void ReleaseInstrumentationState(const std::string& reason);
+    HRESULT ReloadIntegrationsOnNativeThread();
     //
     // CallTarget Methods
     //
     size_t CallTarget_RequestRejitForModule(ModuleID module_id, ModuleMetadata* module_metadata,
-                                            const std::vector<IntegrationMethod>& integrations);
-    HRESULT CallTarget_RewriterCallback(RejitHandlerModule* moduleHandler, RejitHandlerModuleMethod* methodHandler);
+                                            const std::vector<IntegrationMethod>& integrations,
+                                            bool module_loading = false);
+    void CallTarget_MatchModule(ModuleID module_id, ModuleMetadata* module_metadata,
+                                const std::vector<IntegrationMethod>& integrations,
+                                std::vector<CallTargetMethodMatch>& matches);
+    size_t CallTarget_RequestRejitForSubtypes(const std::vector<TypeHierarchyMatch>& subtypes);
+    size_t CallTarget_RequestRejitForMatches(ModuleID module_id, ModuleMetadata* module_metadata,
+                                             const std::vector<CallTargetMethodMatch>& matches,
+                                             bool module_loading = false);
+    HRESULT CallTarget_RewriterCallback(RejitHandlerModule* moduleHandler, const RejitHandlerModuleMethod& methodHandler,
+                                        ICorProfilerFunctionControl* pFunctionControl);
 
 public:
     CorProfiler() = default;
 
     bool IsAttached() const;
 
+    HRESULT ReloadIntegrations();
+
+    // DetachProfiler reverts the instrumented methods and requests the runtime to unload the profiler. Returns S_OK
+    // if the unload was requested, S_FALSE if the profiler is not attached, otherwise the error of the unload
+    // request: the instrumentation is disabled but the profiler stays loaded.
+    HRESULT DetachProfiler();
+
+    void SetDumpILRewriteEnabled(bool enabled);
+
+    void GetInstrumentedMethods(std::vector<InstrumentedMethod>& instrumented_methods);
+
     WSTRING GetBytecodeInstrumentationAssembly() const;
 
 #ifdef _WIN32
@@ -125,6 +232,11 @@ public:
     //
     HRESULT STDMETHODCALLTYPE Initialize(IUnknown* cor_profiler_info_unknown) override;
 
+    HRESULT STDMETHODCALLTYPE InitializeForAttach(IUnknown* cor_profiler_info_unknown, void* pvClientData,
+                                                  UINT cbClientData) override;
+
+    HRESULT STDMETHODCALLTYPE ProfilerAttachComplete() override;
+
     HRESULT STDMETHODCALLTYPE AssemblyLoadFinished(AssemblyID assembly_id, HRESULT hr_status) override;
 
     HRESULT STDMETHODCALLTYPE ModuleLoadFinished(ModuleID module_id, HRESULT hr_status) override;
@@ -0,0 +1,206 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "cost_attribution.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace trace
+{
+
+void CostEntry::Add(CostPhase phase, unsigned long long duration_ns, unsigned long long count)
+{
+    switch (phase)
+    {
+        case CostPhase::Match:
+            match_ns += duration_ns;
+            match_count += count;
+            break;
+        case CostPhase::ReJit:
+            rejit_ns += duration_ns;
+            rejit_count += count;
+            break;
+        case CostPhase::Rewrite:
+            rewrite_ns += duration_ns;
+            rewrite_count += count;
+            break;
+    }
+}
+
+unsigned long long CostEntry::TotalNs() const
+{
+    return match_ns + rejit_ns + rewrite_ns;
+}
+
+CostEntry& CostAttribution::GetEntry(std::unordered_map<WSTRING, CostEntry>& costs, const WSTRING& name)
+{
+    const auto entry = costs.find(name);
+    if (entry != costs.end())
+    {
+        return entry->second;
+    }
+
+    // The other entry is the last one allowed, the map never exceeds CostAttributionMaxEntries entries.
+    if (costs.size() >= CostAttributionMaxEntries - 1)
+    {
+        return costs[CostAttributionOtherEntry];
+    }
+    return costs[name];
+}
+
+void CostAttribution::Enable()
+{
+    enabled_.store(true);
+}
+
+bool CostAttribution::IsEnabled() const
+{
+    return enabled_.load();
+}
+
+void CostAttribution::AddIntegrationCost(const WSTRING& integration_name, CostPhase phase,
+                                         unsigned long long duration_ns, unsigned long long count)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    GetEntry(integrations_, integration_name).Add(phase, duration_ns, count);
+}
+
+void CostAttribution::AddAssemblyCost(const WSTRING& assembly_name, CostPhase phase, unsigned long long duration_ns,
+                                      unsigned long long count)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    GetEntry(assemblies_, assembly_name).Add(phase, duration_ns, count);
+}
+
+void CostAttribution::AddNGenInlinersCost(unsigned long long duration_ns, unsigned long long count)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    ngen_inliners_.Add(CostPhase::ReJit, duration_ns, count);
+}
+
+void CostAttribution::SetWrapperIntegration(const WSTRING& wrapper_type_name, const WSTRING& integration_name)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (wrapper_integrations_.size() >= CostAttributionMaxEntries &&
+        wrapper_integrations_.find(wrapper_type_name) == wrapper_integrations_.end())
+    {
+        return;
+    }
+    wrapper_integrations_[wrapper_type_name] = integration_name;
+}
+
+void CostAttribution::AddWrapperCost(const WSTRING& wrapper_type_name, CostPhase phase,
+                                     unsigned long long duration_ns, unsigned long long count)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    const auto integration = wrapper_integrations_.find(wrapper_type_name);
+    const auto& integration_name =
+        integration != wrapper_integrations_.end() ? integration->second : wrapper_type_name;
+    GetEntry(integrations_, integration_name).Add(phase, duration_ns, count);
+}
+
+namespace
+{
+
+std::vector<std::pair<WSTRING, CostEntry>> SortByCost(const std::unordered_map<WSTRING, CostEntry>& costs)
+{
+    std::vector<std::pair<WSTRING, CostEntry>> sorted(costs.begin(), costs.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        const auto a_total = a.second.TotalNs();
+        const auto b_total = b.second.TotalNs();
+        return a_total != b_total ? a_total > b_total : a.first < b.first;
+    });
+    return sorted;
+}
+
+std::string DurationString(unsigned long long duration_ns)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << duration_ns / 1000000.0 << "ms";
+    return ss.str();
+}
+
+void WriteCosts(std::stringstream& ss, const std::vector<std::pair<WSTRING, CostEntry>>& costs, size_t max_entries)
+{
+    ss << "[";
+    for (size_t i = 0; i < costs.size() && i < max_entries; i++)
+    {
+        const auto& entry = costs[i].second;
+        ss << (i == 0 ? "" : ", ") << ToString(costs[i].first) << "=" << DurationString(entry.TotalNs());
+        ss << " (Match=" << DurationString(entry.match_ns) << "/" << entry.match_count;
+        ss << ", ReJit=" << DurationString(entry.rejit_ns) << "/" << entry.rejit_count;
+        ss << ", Rewrite=" << DurationString(entry.rewrite_ns) << "/" << entry.rewrite_count << ")";
+    }
+    if (costs.size() > max_entries)
+    {
+        ss << ", " << costs.size() - max_entries << " more";
+    }
+    ss << "]";
+}
+
+} // namespace
+
+std::vector<std::pair<WSTRING, CostEntry>> CostAttribution::GetIntegrations()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return SortByCost(integrations_);
+}
+
+std::vector<std::pair<WSTRING, CostEntry>> CostAttribution::GetAssemblies()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return SortByCost(assemblies_);
+}
+
+CostEntry CostAttribution::GetNGenInliners()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return ngen_inliners_;
+}
+
+std::string CostAttribution::ToString(size_t max_entries)
+{
+    const auto integrations  = GetIntegrations();
+    const auto assemblies    = GetAssemblies();
+    const auto ngen_inliners = GetNGenInliners();
+
+    std::stringstream ss;
+    ss << "[Integrations=";
+    WriteCosts(ss, integrations, max_entries);
+    ss << ", Assemblies=";
+    WriteCosts(ss, assemblies, max_entries);
+    ss << ", NGenInliners=" << DurationString(ngen_inliners.rejit_ns) << "/" << ngen_inliners.rejit_count;
+    ss << "]";
+    return ss.str();
+}
+
+} // namespace trace
@@ -0,0 +1,115 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_COST_ATTRIBUTION_H_
+#define OTEL_CLR_PROFILER_COST_ATTRIBUTION_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "string.h" // NOLINT
+#include "util.h"
+
+namespace trace
+{
+
+// Number of integrations and assemblies listed in the logged reports.
+const size_t CostAttributionReportEntries = 20;
+// Number of integrations, assemblies and wrapper types recorded, the costs of the next ones are attributed to the
+// CostAttributionOtherEntry entry. Collectible AssemblyLoadContexts can load an unbounded number of assemblies.
+const size_t CostAttributionMaxEntries = 1024;
+const WSTRING CostAttributionOtherEntry = WStr("(Other)");
+
+// The phases of the bytecode instrumentation whose cost is attributed.
+enum class CostPhase
+{
+    // Searching the integration target methods in a module.
+    Match,
+    // Requesting the ReJIT of the matched methods.
+    ReJit,
+    // Rewriting the body of a method.
+    Rewrite
+};
+
+// Time, in nanoseconds, and number of operations of each phase.
+struct CostEntry
+{
+    unsigned long long match_ns = 0;
+    unsigned long long match_count = 0;
+    unsigned long long rejit_ns = 0;
+    unsigned long long rejit_count = 0;
+    unsigned long long rewrite_ns = 0;
+    unsigned long long rewrite_count = 0;
+
+    void Add(CostPhase phase, unsigned long long duration_ns, unsigned long long count);
+    unsigned long long TotalNs() const;
+};
+
+// CostStopwatch measures the duration of a phase, it is only started when the cost attribution is enabled.
+class CostStopwatch
+{
+private:
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    CostStopwatch() : start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    unsigned long long ElapsedNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_)
+            .count();
+    }
+};
+
+// CostAttribution splits the time spent by the bytecode instrumentation between the integrations, the instrumented
+// assemblies and the NGEN inliners scanning, to find which one slows down the startup. Nothing is recorded until
+// it is enabled.
+class CostAttribution : public Singleton<CostAttribution>
+{
+private:
+    std::atomic_bool enabled_{false};
+    std::mutex mutex_;
+    std::unordered_map<WSTRING, CostEntry> integrations_;
+    std::unordered_map<WSTRING, CostEntry> assemblies_;
+    // The ReJIT handler only keeps the wrapper type of a method, it identifies the integration.
+    std::unordered_map<WSTRING, WSTRING> wrapper_integrations_;
+    CostEntry ngen_inliners_;
+
+    static CostEntry& GetEntry(std::unordered_map<WSTRING, CostEntry>& costs, const WSTRING& name);
+
+public:
+    void Enable();
+    bool IsEnabled() const;
+
+    void AddIntegrationCost(const WSTRING& integration_name, CostPhase phase, unsigned long long duration_ns,
+                            unsigned long long count);
+    void AddAssemblyCost(const WSTRING& assembly_name, CostPhase phase, unsigned long long duration_ns,
+                         unsigned long long count);
+    void AddNGenInlinersCost(unsigned long long duration_ns, unsigned long long count);
+
+    // SetWrapperIntegration records the integration of a wrapper type, so AddWrapperCost can attribute the
+    // rewrites to it. The costs of an unknown wrapper type are attributed to the wrapper type name.
+    void SetWrapperIntegration(const WSTRING& wrapper_type_name, const WSTRING& integration_name);
+    void AddWrapperCost(const WSTRING& wrapper_type_name, CostPhase phase, unsigned long long duration_ns,
+                        unsigned long long count);
+
+    // GetIntegrations and GetAssemblies return the costs sorted from the most to the least expensive.
+    std::vector<std::pair<WSTRING, CostEntry>> GetIntegrations();
+    std::vector<std::pair<WSTRING, CostEntry>> GetAssemblies();
+    CostEntry GetNGenInliners();
+
+    // ToString reports the max_entries most expensive integrations and assemblies.
+    std::string ToString(size_t max_entries);
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_COST_ATTRIBUTION_H_
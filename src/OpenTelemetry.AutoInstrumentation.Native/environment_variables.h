@@ -92,6 +92,52 @@ const WSTRING clr_enable_inlining = WStr("OTEL_DOTNET_AUTO_CLR_ENABLE_INLINING")
 // Sets whether to enable NGEN images.
 const WSTRING clr_enable_ngen = WStr("OTEL_DOTNET_AUTO_CLR_ENABLE_NGEN");
 
+// Sets the time, in milliseconds, that the profiler can spend analyzing modules and rewriting methods
+// before degrading the instrumentation. If not set, or set to 0, there is no budget.
+const WSTRING startup_overhead_budget = WStr("OTEL_DOTNET_AUTO_STARTUP_OVERHEAD_BUDGET");
+
+// Sets the time, in milliseconds since the profiler started, during which the startup overhead budget applies.
+// Default is 60000. If set to 0, the budget applies for the whole life of the process.
+const WSTRING startup_overhead_window = WStr("OTEL_DOTNET_AUTO_STARTUP_OVERHEAD_WINDOW");
+
+// Comma-separated list of the steps applied, in order, each time the startup overhead budget is exceeded.
+// Default is "low_priority_instrumentations,ngen_inliners,all_instrumentations".
+const WSTRING startup_overhead_degradation_steps = WStr("OTEL_DOTNET_AUTO_STARTUP_OVERHEAD_DEGRADATION_STEPS");
+
+// Comma-separated list of the integrations that are shed first when the startup overhead budget is exceeded.
+const WSTRING startup_overhead_low_priority_instrumentations =
+    WStr("OTEL_DOTNET_AUTO_STARTUP_OVERHEAD_LOW_PRIORITY_INSTRUMENTATIONS");
+
+// Sets how the value-type arguments are passed to the CallTarget handlers. Supported values are "typed" (default),
+// every argument keeps its type, and "canonical", the value-type arguments that the integration receives as
+// System.Object, or doesn't receive at all, are passed as System.Object to share the handlers instantiations.
+const WSTRING calltarget_instantiation_policy = WStr("OTEL_DOTNET_AUTO_CALLTARGET_INSTANTIATION_POLICY");
+
+// Enable the instrumentation of the async methods through their compiler-generated state machines: the CallTarget
+// state is kept in the state machine and the integration is called when the task completes, without a continuation.
+const WSTRING calltarget_async_state_machines_enabled =
+    WStr("OTEL_DOTNET_AUTO_CALLTARGET_ASYNC_STATE_MACHINES_ENABLED");
+
+// Enable the outlining of the instrumented methods: their original body is moved to a new method, called by the
+// instrumented method, so the JIT optimizes it as a method without the CallTarget exception handling.
+const WSTRING calltarget_outlining_enabled = WStr("OTEL_DOTNET_AUTO_CALLTARGET_OUTLINING_ENABLED");
+
+// Sets the number of threads analyzing the loaded modules, so the threads loading the assemblies don't wait for
+// the integrations matching. If not set, or set to 0, the modules are analyzed while they load.
+const WSTRING module_analysis_threads = WStr("OTEL_DOTNET_AUTO_MODULE_ANALYSIS_THREADS");
+
+// Publish the counters and histograms of the profiler in a memory-mapped file in the log directory, readable by
+// external tools while the process runs.
+const WSTRING telemetry_region_enabled = WStr("OTEL_DOTNET_AUTO_NATIVE_TELEMETRY_REGION_ENABLED");
+
+// Enable the attribution of the bytecode instrumentation time to the integrations and the instrumented assemblies.
+// The report is logged when the profiler exits.
+const WSTRING cost_attribution_enabled = WStr("OTEL_DOTNET_AUTO_COST_ATTRIBUTION_ENABLED");
+
+// Sets the time, in milliseconds, after the profiler initialization at which the cost attribution report is also
+// logged. If not set, or set to 0, the report is only logged when the profiler exits.
+const WSTRING cost_attribution_report_delay = WStr("OTEL_DOTNET_AUTO_COST_ATTRIBUTION_REPORT_DELAY");
+
 // Enable the assembly version redirection when running on the .NET Framework.
 const WSTRING netfx_assembly_redirection_enabled = WStr("OTEL_DOTNET_AUTO_NETFX_REDIRECT_ENABLED");
 
@@ -60,6 +60,22 @@ bool IsDumpILRewriteEnabled() {
   CheckIfTrue(GetEnvironmentValue(environment::dump_il_rewrite_enabled));
 }
 
+bool IsCallTargetAsyncStateMachinesEnabled() {
+  CheckIfTrue(GetEnvironmentValue(environment::calltarget_async_state_machines_enabled));
+}
+
+bool IsCallTargetOutliningEnabled() {
+  CheckIfTrue(GetEnvironmentValue(environment::calltarget_outlining_enabled));
+}
+
+bool IsTelemetryRegionEnabled() {
+  CheckIfTrue(GetEnvironmentValue(environment::telemetry_region_enabled));
+}
+
+bool IsCostAttributionEnabled() {
+  CheckIfTrue(GetEnvironmentValue(environment::cost_attribution_enabled));
+}
+
 bool IsAzureAppServices() {
   CheckIfTrue(GetEnvironmentValue(environment::azure_app_services));
 }
@@ -3,6 +3,7 @@
 // license information.
 
 #include "il_rewriter.h"
+#include <algorithm>
 #include <corhlpr.cpp>
 
 #undef IfFailRet
@@ -126,6 +127,10 @@ ILRewriter::ILRewriter(ICorProfilerInfo*            pICorProfilerInfo,
     m_nInstrs = 0;
 }
 
+ILRewriter::ILRewriter(mdToken tkMethod) : ILRewriter(nullptr, nullptr, 0, tkMethod)
+{
+}
+
 ILRewriter::~ILRewriter()
 {
     ILInstr* p = m_IL.m_pNext;
@@ -193,8 +198,24 @@ HRESULT ILRewriter::Import()
 {
     LPCBYTE pMethodBytes;
 
+    if (IsOffline())
+    {
+        // Offline rewriters don't have access to the runtime, the body must be provided by the caller.
+        return E_UNEXPECTED;
+    }
+
     IfFailRet(m_pICorProfilerInfo->GetILFunctionBody(m_moduleId, m_tkMethod, &pMethodBytes, nullptr));
 
+    return Import(pMethodBytes);
+}
+
+HRESULT ILRewriter::Import(LPCBYTE pMethodBytes)
+{
+    if (pMethodBytes == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
     COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)pMethodBytes);
 
     // Import the header flags
@@ -260,7 +281,8 @@ HRESULT ILRewriter::ImportIL(LPCBYTE pIL)
         ILInstr* pInstr = NewILInstr();
         IfNullRet(pInstr);
 
-        pInstr->m_opcode = opcode;
+        pInstr->m_opcode         = opcode;
+        pInstr->m_originalOffset = startOffset;
 
         InsertBefore(&m_IL, pInstr);
 
@@ -405,7 +427,9 @@ HRESULT ILRewriter::ImportEH(const COR_ILMETHOD_SECT_EH* pILEH, unsigned nEH)
 ILInstr* ILRewriter::NewILInstr()
 {
     m_nInstrs++;
-    return new ILInstr();
+    ILInstr* pInstr          = new ILInstr();
+    pInstr->m_originalOffset = kNoOriginalOffset;
+    return pInstr;
 }
 
 HRESULT ILRewriter::GetInstrFromOffset(unsigned offset, ILInstr** ppInstr)
@@ -608,6 +632,18 @@ again:
             goto again;
     }
 
+    // The inserted instructions are attributed by the runtime to the closest preceding original instruction.
+    m_instrumentedCodeMap.clear();
+    for (ILInstr* pInstr = m_IL.m_pNext; pInstr != &m_IL; pInstr = pInstr->m_pNext)
+    {
+        if (pInstr->m_originalOffset != kNoOriginalOffset)
+        {
+            m_instrumentedCodeMap.push_back({pInstr->m_originalOffset, pInstr->m_offset, TRUE});
+        }
+    }
+    std::stable_sort(m_instrumentedCodeMap.begin(), m_instrumentedCodeMap.end(),
+                     [](const COR_IL_MAP& a, const COR_IL_MAP& b) { return a.oldOffset < b.oldOffset; });
+
     unsigned codeSize = offset;
     unsigned totalSize;
     LPBYTE   pBody = NULL;
@@ -694,7 +730,12 @@ again:
 
 HRESULT ILRewriter::SetILFunctionBody(unsigned size, LPBYTE pBody)
 {
-    if (m_pICorProfilerFunctionControl != nullptr)
+    if (IsOffline())
+    {
+        // Keep a copy of the body, the caller is responsible for persisting it.
+        m_exportedBody.assign(pBody, pBody + size);
+    }
+    else if (m_pICorProfilerFunctionControl != nullptr)
     {
         // We're supplying IL for a rejit, so use the rejit mechanism
         IfFailRet(m_pICorProfilerFunctionControl->SetILFunctionBody(size, pBody));
@@ -710,7 +751,7 @@ HRESULT ILRewriter::SetILFunctionBody(unsigned size, LPBYTE pBody)
 
 LPBYTE ILRewriter::AllocateILMemory(unsigned size)
 {
-    if (m_pICorProfilerFunctionControl != nullptr)
+    if (m_pICorProfilerFunctionControl != nullptr || IsOffline())
     {
         // We're supplying IL for a rejit, so we can just allocate from
         // the heap
@@ -728,7 +769,7 @@ LPBYTE ILRewriter::AllocateILMemory(unsigned size)
 
 void ILRewriter::DeallocateILMemory(LPBYTE pBody)
 {
-    if (m_pICorProfilerFunctionControl == nullptr)
+    if (m_pICorProfilerFunctionControl == nullptr && !IsOffline())
     {
         // Old-style instrumentation does not provide a way to free up bytes
         return;
@@ -741,3 +782,31 @@ unsigned ILRewriter::GetMaxStackValue()
 {
     return m_maxStack;
 }
+
+bool ILRewriter::IsOffline() const
+{
+    return m_pICorProfilerInfo == nullptr && m_pICorProfilerFunctionControl == nullptr;
+}
+
+const std::vector<BYTE>& ILRewriter::GetExportedBody() const
+{
+    return m_exportedBody;
+}
+
+const std::vector<COR_IL_MAP>& ILRewriter::GetILInstrumentedCodeMap() const
+{
+    return m_instrumentedCodeMap;
+}
+
+HRESULT ILRewriter::SetILInstrumentedCodeMap()
+{
+    // The classic-style instrumentation needs the FunctionID of the method, it is only used for
+    // generated methods without an original body.
+    if (m_pICorProfilerFunctionControl == nullptr || m_instrumentedCodeMap.empty())
+    {
+        return S_FALSE;
+    }
+
+    return m_pICorProfilerFunctionControl->SetILInstrumentedCodeMap((ULONG)m_instrumentedCodeMap.size(),
+                                                                    m_instrumentedCodeMap.data());
+}
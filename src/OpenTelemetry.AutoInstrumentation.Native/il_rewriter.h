@@ -7,6 +7,7 @@
 
 #include <corhlpr.h>
 #include <corprof.h>
+#include <vector>
 
 typedef enum
 {
@@ -18,6 +19,8 @@ typedef enum
     // special internal instructions
 } OPCODE;
 
+const unsigned kNoOriginalOffset = static_cast<unsigned>(-1);
+
 struct ILInstr
 {
     ILInstr* m_pNext;
@@ -26,6 +29,9 @@ struct ILInstr
     unsigned m_opcode;
     unsigned m_offset;
 
+    // Offset of the instruction in the imported method body, or kNoOriginalOffset if it was inserted.
+    unsigned m_originalOffset;
+
     union
     {
         ILInstr* m_pTarget;
@@ -83,10 +89,22 @@ private:
 
     IMethodMalloc* m_pIMethodMalloc;
 
+    // Method body produced by Export() when the rewriter is not bound to a running
+    // runtime (no ICorProfilerInfo and no ICorProfilerFunctionControl).
+    std::vector<BYTE> m_exportedBody;
+
+    // Offsets of the imported instructions in the body produced by Export(), sorted by original offset.
+    std::vector<COR_IL_MAP> m_instrumentedCodeMap;
+
 public:
     ILRewriter(ICorProfilerInfo* pICorProfilerInfo, ICorProfilerFunctionControl* pICorProfilerFunctionControl,
                ModuleID moduleID, mdToken tkMethod);
 
+    // Creates a rewriter that is not bound to a running runtime. The method body must be
+    // supplied to Import(LPCBYTE) and the result of Export() is read with GetExportedBody().
+    // This allows the CallTarget rewrite to be applied to method bodies read from disk.
+    ILRewriter(mdToken tkMethod);
+
     ~ILRewriter();
 
     void InitializeTiny();
@@ -109,6 +127,8 @@ public:
 
     HRESULT Import();
 
+    HRESULT Import(LPCBYTE pMethodBytes);
+
     HRESULT ImportIL(LPCBYTE pIL);
 
     HRESULT ImportEH(const COR_ILMETHOD_SECT_EH* pILEH, unsigned nEH);
@@ -140,6 +160,16 @@ public:
     void DeallocateILMemory(LPBYTE pBody);
 
     unsigned GetMaxStackValue();
+
+    bool IsOffline() const;
+
+    const std::vector<BYTE>& GetExportedBody() const;
+
+    const std::vector<COR_IL_MAP>& GetILInstrumentedCodeMap() const;
+
+    // Publishes the map of the exported body to the runtime, so stack traces, debuggers and profilers
+    // report the offsets of the original method body. Returns S_FALSE if there is nothing to publish.
+    HRESULT SetILInstrumentedCodeMap();
 };
 
 #endif // OTEL_CLR_PROFILER_IL_REWRITER_H_
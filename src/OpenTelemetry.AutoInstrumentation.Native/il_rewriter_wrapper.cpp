@@ -41,7 +41,7 @@ void ILRewriterWrapper::LoadInt64(const INT64 value) const
     m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
 }
 
-void ILRewriterWrapper::LoadInt32(const INT32 value) const
+ILInstr* ILRewriterWrapper::LoadInt32(const INT32 value) const
 {
     static const std::vector<OPCODE> opcodes = {
         CEE_LDC_I4_0, CEE_LDC_I4_1, CEE_LDC_I4_2, CEE_LDC_I4_3, CEE_LDC_I4_4,
@@ -66,6 +66,7 @@ void ILRewriterWrapper::LoadInt32(const INT32 value) const
     }
 
     m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
+    return pNewInstr;
 }
 
 ILInstr* ILRewriterWrapper::LoadArgument(const UINT16 index) const
@@ -95,6 +96,25 @@ ILInstr* ILRewriterWrapper::LoadArgument(const UINT16 index) const
     return pNewInstr;
 }
 
+ILInstr* ILRewriterWrapper::LoadArgumentAddress(const UINT16 index) const
+{
+    ILInstr* pNewInstr = m_ILRewriter->NewILInstr();
+
+    if (index <= 255)
+    {
+        pNewInstr->m_opcode = CEE_LDARGA_S;
+        pNewInstr->m_Arg8   = static_cast<UINT8>(index);
+    }
+    else
+    {
+        pNewInstr->m_opcode = CEE_LDARGA;
+        pNewInstr->m_Arg16  = index;
+    }
+
+    m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
+    return pNewInstr;
+}
+
 void ILRewriterWrapper::Cast(const mdTypeRef type_ref) const
 {
     ILInstr* pNewInstr  = m_ILRewriter->NewILInstr();
@@ -163,15 +183,20 @@ void ILRewriterWrapper::EndLoadValueIntoArray() const
     m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
 }
 
-bool ILRewriterWrapper::ReplaceMethodCalls(const mdMemberRef old_method_ref, const mdMemberRef new_method_ref) const
+bool ILRewriterWrapper::ReplaceMethodCalls(const mdMemberRef old_method_ref, const mdMemberRef new_method_ref,
+                                           const bool callvirt_only) const
 {
     bool modified = false;
 
     for (ILInstr* pInstr = m_ILRewriter->GetILList()->m_pNext; pInstr != m_ILRewriter->GetILList();
          pInstr          = pInstr->m_pNext)
     {
-        if ((pInstr->m_opcode == CEE_CALL || pInstr->m_opcode == CEE_CALLVIRT) &&
-            pInstr->m_Arg32 == static_cast<INT32>(old_method_ref))
+        // The instance of a constrained call is a managed pointer, it can't be passed to the new method. The call of
+        // an instance method is either a base call or a call on a value type when callvirt is expected.
+        const bool constrained =
+            pInstr->m_pPrev != m_ILRewriter->GetILList() && pInstr->m_pPrev->m_opcode == CEE_CONSTRAINED;
+        if ((pInstr->m_opcode == CEE_CALLVIRT || (pInstr->m_opcode == CEE_CALL && !callvirt_only)) &&
+            pInstr->m_Arg32 == static_cast<INT32>(old_method_ref) && !constrained)
         {
             pInstr->m_opcode = CEE_CALL;
             pInstr->m_Arg32  = new_method_ref;
@@ -201,6 +226,24 @@ ILInstr* ILRewriterWrapper::LoadObj(mdToken token) const
     return pNewInstr;
 }
 
+ILInstr* ILRewriterWrapper::LoadField(mdToken field) const
+{
+    ILInstr* pNewInstr  = m_ILRewriter->NewILInstr();
+    pNewInstr->m_opcode = CEE_LDFLD;
+    pNewInstr->m_Arg32  = field;
+    m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
+    return pNewInstr;
+}
+
+ILInstr* ILRewriterWrapper::StoreField(mdToken field) const
+{
+    ILInstr* pNewInstr  = m_ILRewriter->NewILInstr();
+    pNewInstr->m_opcode = CEE_STFLD;
+    pNewInstr->m_Arg32  = field;
+    m_ILRewriter->InsertBefore(m_ILInstr, pNewInstr);
+    return pNewInstr;
+}
+
 ILInstr* ILRewriterWrapper::StLocal(unsigned index) const
 {
     static const std::vector<OPCODE> opcodes = {
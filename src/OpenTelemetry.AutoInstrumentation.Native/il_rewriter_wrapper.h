@@ -26,8 +26,9 @@ public:
     void Pop() const;
     ILInstr* LoadNull() const;
     void LoadInt64(INT64 value) const;
-    void LoadInt32(INT32 value) const;
+    ILInstr* LoadInt32(INT32 value) const;
     ILInstr* LoadArgument(UINT16 index) const;
+    ILInstr* LoadArgumentAddress(UINT16 index) const;
     void Cast(mdTypeRef type_ref) const;
     void Box(mdTypeRef type_ref) const;
     void UnboxAny(mdTypeRef type_ref) const;
@@ -36,9 +37,11 @@ public:
     void Duplicate() const;
     void BeginLoadValueIntoArray(INT32 arrayIndex) const;
     void EndLoadValueIntoArray() const;
-    bool ReplaceMethodCalls(mdMemberRef old_method_ref, mdMemberRef new_method_ref) const;
+    bool ReplaceMethodCalls(mdMemberRef old_method_ref, mdMemberRef new_method_ref, bool callvirt_only = false) const;
     ILInstr* LoadToken(mdToken token) const;
     ILInstr* LoadObj(mdToken token) const;
+    ILInstr* LoadField(mdToken field) const;
+    ILInstr* StoreField(mdToken field) const;
     ILInstr* StLocal(unsigned index) const;
     ILInstr* LoadLocal(unsigned index) const;
     ILInstr* LoadLocalAddress(unsigned index) const;
@@ -13,11 +13,14 @@
 #include <unordered_map>
 
 #include "logger.h"
+#include "telemetry_region.h"
 #include "util.h"
 
 namespace trace
 {
 
+// The cache is keyed by the assembly names of the integrations and of the instrumentation assembly, never by
+// the loaded modules, so its size doesn't grow with the modules loaded and unloaded by the application.
 std::mutex m_assemblyReferenceCacheMutex;
 std::unordered_map<WSTRING, std::unique_ptr<AssemblyReference>> m_assemblyReferenceCache;
 
@@ -35,8 +38,10 @@ AssemblyReference* AssemblyReference::GetFromCache(const WSTRING& str)
     auto                        findRes = m_assemblyReferenceCache.find(str);
     if (findRes != m_assemblyReferenceCache.end())
     {
+        TelemetryRegion::Instance()->Add(TelemetryCounter::AssemblyReferenceCacheHits);
         return findRes->second.get();
     }
+    TelemetryRegion::Instance()->Add(TelemetryCounter::AssemblyReferenceCacheMisses);
     AssemblyReference* aref       = new AssemblyReference(str);
     m_assemblyReferenceCache[str] = std::unique_ptr<AssemblyReference>(aref);
     return aref;
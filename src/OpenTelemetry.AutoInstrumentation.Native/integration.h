@@ -242,6 +242,30 @@ public:
     }
 };
 
+// TargetMethodKind tells which methods an integration target matches.
+enum class TargetMethodKind
+{
+    // The method of the target type.
+    Default,
+    // The overrides of the target virtual method in the types derived from the target type.
+    Derived,
+    // The implementations of the target interface method.
+    Interface
+};
+
+// IntegrationKind tells how an integration instruments its target methods.
+enum class IntegrationKind
+{
+    // The target methods call the integration type through CallTargetInvoker.
+    CallTarget,
+    // The target methods only record their calls and durations in the native method metrics, the integration type
+    // is not called.
+    MethodMetrics,
+    // The calls of the target method made by the selected callers call the wrapper method instead, the target
+    // method itself is not rewritten.
+    CallSite
+};
+
 struct MethodReference
 {
     const AssemblyReference assembly;
@@ -251,25 +275,35 @@ struct MethodReference
     const Version min_version;
     const Version max_version;
     const std::vector<WSTRING> signature_types;
+    const TargetMethodKind kind;
 
     MethodReference() :
-        min_version(Version(0, 0, 0, 0)), max_version(Version(USHRT_MAX, USHRT_MAX, USHRT_MAX, USHRT_MAX))
+        min_version(Version(0, 0, 0, 0)),
+        max_version(Version(USHRT_MAX, USHRT_MAX, USHRT_MAX, USHRT_MAX)),
+        kind(TargetMethodKind::Default)
     {
     }
 
     MethodReference(const WSTRING& assembly_name, WSTRING type_name, WSTRING method_name,
                     Version min_version, Version max_version, const std::vector<BYTE>& method_signature,
-                    const std::vector<WSTRING>& signature_types) :
+                    const std::vector<WSTRING>& signature_types, TargetMethodKind kind = TargetMethodKind::Default) :
         assembly(*AssemblyReference::GetFromCache(assembly_name)),
         type_name(type_name),
         method_name(method_name),
         method_signature(method_signature),
         min_version(min_version),
         max_version(max_version),
-        signature_types(signature_types)
+        signature_types(signature_types),
+        kind(kind)
     {
     }
 
+    // IsHierarchyTarget returns true if the target methods are searched in the subtypes of the target type.
+    inline bool IsHierarchyTarget() const
+    {
+        return kind != TargetMethodKind::Default;
+    }
+
     inline WSTRING get_type_cache_key() const
     {
         return WStr("[") + assembly.name + WStr("]") + type_name + WStr("_vMin_") + min_version.str() + WStr("_vMax_") +
@@ -286,7 +320,8 @@ struct MethodReference
     {
         return assembly == other.assembly && type_name == other.type_name && min_version == other.min_version &&
                max_version == other.max_version && method_name == other.method_name &&
-               method_signature == other.method_signature && signature_types == other.signature_types;
+               method_signature == other.method_signature && signature_types == other.signature_types &&
+               kind == other.kind;
     }
 };
 
@@ -295,20 +330,40 @@ struct MethodReplacement
     const MethodReference caller_method;
     const MethodReference target_method;
     const MethodReference wrapper_method;
+    const IntegrationKind integration_kind;
+    // The indices of the target method arguments passed to OnMethodBegin, when the integration declares them.
+    // Otherwise every argument is passed.
+    const bool                declares_arguments;
+    const std::vector<USHORT> argument_indices;
+
+    MethodReplacement() : integration_kind(IntegrationKind::CallTarget), declares_arguments(false)
+    {
+    }
 
-    MethodReplacement()
+    MethodReplacement(MethodReference caller_method, MethodReference target_method, MethodReference wrapper_method,
+                      IntegrationKind integration_kind = IntegrationKind::CallTarget, bool declares_arguments = false,
+                      std::vector<USHORT> argument_indices = {}) :
+        caller_method(caller_method),
+        target_method(target_method),
+        wrapper_method(wrapper_method),
+        integration_kind(integration_kind),
+        declares_arguments(declares_arguments),
+        argument_indices(argument_indices)
     {
     }
 
-    MethodReplacement(MethodReference caller_method, MethodReference target_method, MethodReference wrapper_method) :
-        caller_method(caller_method), target_method(target_method), wrapper_method(wrapper_method)
+    // InstrumentedAssemblyName returns the name of the assembly whose methods are rewritten.
+    inline const WSTRING& InstrumentedAssemblyName() const
     {
+        return integration_kind == IntegrationKind::CallSite ? caller_method.assembly.name
+                                                             : target_method.assembly.name;
     }
 
     inline bool operator==(const MethodReplacement& other) const
     {
         return caller_method == other.caller_method && target_method == other.target_method &&
-               wrapper_method == other.wrapper_method;
+               wrapper_method == other.wrapper_method && integration_kind == other.integration_kind &&
+               declares_arguments == other.declares_arguments && argument_indices == other.argument_indices;
     }
 };
 
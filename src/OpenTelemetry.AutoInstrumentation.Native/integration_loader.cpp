@@ -218,7 +218,72 @@ void MethodReplacementFromJson(const json::value_type&                src,
         const MethodReference wrapper = MethodReferenceFromJson(src.value("wrapper", json::object()), false, true);
         const MethodReference target  = MethodReferenceFromJson(src.value("target", json::object()), true, false);
 
-        integrationMethods.insert({integrationName, {{}, target, wrapper}});
+        IntegrationKind integration_kind      = IntegrationKind::CallTarget;
+        const auto      integration_kind_name = src.value("integration_kind", "CallTarget");
+        if (integration_kind_name == "MethodMetrics")
+        {
+            integration_kind = IntegrationKind::MethodMetrics;
+        }
+        else if (integration_kind_name == "CallSite")
+        {
+            integration_kind = IntegrationKind::CallSite;
+        }
+        else if (integration_kind_name != "CallTarget")
+        {
+            Logger::Warn("Unsupported integration kind: ", integration_kind_name,
+                         ", the method replacement is ignored: ", src.dump());
+            return;
+        }
+
+        if (integration_kind == IntegrationKind::CallTarget)
+        {
+            // The integration can declare the arguments its OnMethodBegin consumes, BeginMethod only receives those.
+            const auto          arguments          = src.find("argument_indices");
+            const bool          declares_arguments = arguments != src.end();
+            std::vector<USHORT> argument_indices;
+            if (declares_arguments)
+            {
+                if (!arguments->is_array())
+                {
+                    Logger::Warn("The argument indices must be an array, the method replacement is ignored: ",
+                                 src.dump());
+                    return;
+                }
+                for (const auto& el : *arguments)
+                {
+                    if (!el.is_number_unsigned() || el.get<unsigned>() > USHRT_MAX)
+                    {
+                        Logger::Warn("Invalid argument index: ", el.dump(), ", the method replacement is ignored: ",
+                                     src.dump());
+                        return;
+                    }
+                    argument_indices.push_back(el.get<USHORT>());
+                }
+            }
+
+            integrationMethods.insert(
+                {integrationName, {{}, target, wrapper, integration_kind, declares_arguments, argument_indices}});
+            return;
+        }
+
+        if (integration_kind != IntegrationKind::CallSite)
+        {
+            integrationMethods.insert({integrationName, {{}, target, wrapper, integration_kind}});
+            return;
+        }
+
+        // The caller selects the assembly, and optionally the type and the method, whose calls of the target method
+        // are replaced.
+        const MethodReference caller = MethodReferenceFromJson(src.value("caller", json::object()), false, false);
+        if (caller.assembly.name.empty() || target.IsHierarchyTarget())
+        {
+            Logger::Warn("A call-site integration needs a caller assembly and a default target, the method "
+                         "replacement is ignored: ",
+                         src.dump());
+            return;
+        }
+
+        integrationMethods.insert({integrationName, {caller, target, wrapper, integration_kind}});
     }
 }
 
@@ -244,6 +309,7 @@ MethodReference MethodReferenceFromJson(const json::value_type& src,
     USHORT               max_minor = USHRT_MAX;
     USHORT               max_patch = USHRT_MAX;
     std::vector<WSTRING> signature_type_array;
+    TargetMethodKind     kind = TargetMethodKind::Default;
 
     if (is_target_method)
     {
@@ -285,6 +351,21 @@ MethodReference MethodReferenceFromJson(const json::value_type& src,
                 signature_type_array[i] = ToWSTRING(sig_types[i]);
             }
         }
+
+        const auto kind_name = src.value("kind", "Default");
+        if (kind_name == "Derived")
+        {
+            kind = TargetMethodKind::Derived;
+        }
+        else if (kind_name == "Interface")
+        {
+            kind = TargetMethodKind::Interface;
+        }
+        else if (kind_name != "Default")
+        {
+            Logger::Warn("Unsupported target kind: ", kind_name, ", the target is used as a Default one: ",
+                         src.dump());
+        }
     }
 
     std::vector<BYTE> signature;
@@ -333,7 +414,8 @@ MethodReference MethodReferenceFromJson(const json::value_type& src,
         }
     }
     return MethodReference(assembly, type, method, Version(min_major, min_minor, min_patch, 0),
-                           Version(max_major, max_minor, max_patch, USHRT_MAX), signature, signature_type_array);
+                           Version(max_major, max_minor, max_patch, USHRT_MAX), signature, signature_type_array,
+                           kind);
 }
 
 } // namespace
@@ -45,6 +45,9 @@ public:
   const std::vector<WSTRING> enabledLogIntegrationNames;
 };
 
+// GetLoadIntegrationConfiguration reads the enabled signals and instrumentations from the environment
+LoadIntegrationConfiguration GetLoadIntegrationConfiguration();
+
 // LoadIntegrationsFromEnvironment loads integrations from any files specified
 // in the OTEL_DOTNET_AUTO_INTEGRATIONS_FILE environment variable
 void LoadIntegrationsFromEnvironment(
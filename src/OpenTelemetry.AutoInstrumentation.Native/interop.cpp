@@ -9,11 +9,18 @@
 // NativeMethods.cs!
 //---------------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <fstream>
+
+#include "calltarget_planner.h"
+#include "calltarget_weaver.h"
 #include "cor_profiler.h"
+#include "integration_loader.h"
+#include "logger.h"
+#include "method_metrics.h"
 
 #ifndef _WIN32
 #include <dlfcn.h>
-#include "logger.h"
 #endif
 
 EXTERN_C BOOL STDAPICALLTYPE IsProfilerAttached()
@@ -21,6 +28,146 @@ EXTERN_C BOOL STDAPICALLTYPE IsProfilerAttached()
     return trace::profiler != nullptr && trace::profiler->IsAttached();
 }
 
+EXTERN_C BOOL STDAPICALLTYPE ReloadIntegrations()
+{
+    return trace::profiler != nullptr && trace::profiler->ReloadIntegrations() == S_OK;
+}
+
+// DetachProfiler returns S_OK if the unload of the profiler was requested, S_FALSE if the profiler is not attached,
+// otherwise the error of the unload request: the instrumentation is disabled but the profiler stays loaded.
+EXTERN_C HRESULT STDAPICALLTYPE DetachProfiler()
+{
+    return trace::profiler != nullptr ? trace::profiler->DetachProfiler() : S_FALSE;
+}
+
+// SetNativeLogLevel changes the log level of the profiler, the supported levels are the OTEL_LOG_LEVEL values.
+EXTERN_C BOOL STDAPICALLTYPE SetNativeLogLevel(const WCHAR* level)
+{
+    return trace::profiler != nullptr && level != nullptr && trace::Logger::SetLogLevel(trace::WSTRING(level));
+}
+
+// SetDumpILRewriteEnabled changes whether the profiler logs the IL of the methods it rewrites.
+EXTERN_C BOOL STDAPICALLTYPE SetDumpILRewriteEnabled(BOOL enabled)
+{
+    if (trace::profiler == nullptr)
+    {
+        return FALSE;
+    }
+
+    trace::profiler->SetDumpILRewriteEnabled(enabled != FALSE);
+    return TRUE;
+}
+
+// GetInstrumentedMethods copies up to length methods requested for ReJIT and returns the total number of them.
+EXTERN_C int STDAPICALLTYPE GetInstrumentedMethods(trace::InstrumentedMethod* methods, int length)
+{
+    if (trace::profiler == nullptr)
+    {
+        return 0;
+    }
+
+    std::vector<trace::InstrumentedMethod> instrumented_methods;
+    trace::profiler->GetInstrumentedMethods(instrumented_methods);
+
+    const auto count = static_cast<int>(instrumented_methods.size());
+    for (int i = 0; methods != nullptr && i < count && i < length; i++)
+    {
+        methods[i] = instrumented_methods[i];
+    }
+    return count;
+}
+
+// RecordMethodDuration adds a call of a method rewritten by a MethodMetrics integration to the histograms of the
+// current thread.
+EXTERN_C VOID STDAPICALLTYPE RecordMethodDuration(int method_id, INT64 duration_ns)
+{
+    trace::MethodMetrics::Instance()->Record(method_id, duration_ns > 0 ? static_cast<uint64_t>(duration_ns) : 0);
+}
+
+// TryRecordMethodDuration is RecordMethodDuration without allocations nor locks, called without a GC transition by
+// the threads that already called RecordMethodDuration. It returns FALSE, without recording anything, when
+// RecordMethodDuration must be called instead.
+EXTERN_C int STDAPICALLTYPE TryRecordMethodDuration(int method_id, INT64 duration_ns)
+{
+    return trace::MethodMetrics::TryRecord(method_id, duration_ns > 0 ? static_cast<uint64_t>(duration_ns) : 0);
+}
+
+// GetMethodMetrics copies up to length methods with recorded calls and returns the total number of them. The values
+// are cumulative since the start of the process.
+EXTERN_C int STDAPICALLTYPE GetMethodMetrics(trace::MethodMetric* metrics, int length)
+{
+    std::vector<trace::MethodMetric> method_metrics;
+    trace::MethodMetrics::Instance()->Collect(method_metrics);
+
+    const auto count = static_cast<int>(method_metrics.size());
+    for (int i = 0; metrics != nullptr && i < count && i < length; i++)
+    {
+        metrics[i] = method_metrics[i];
+    }
+    return count;
+}
+
+// GetMethodMetricName copies the name of a method, NUL-terminated and truncated to length characters, and returns
+// the length of the name.
+EXTERN_C int STDAPICALLTYPE GetMethodMetricName(int method_id, WCHAR* name, int length)
+{
+    const auto method_name = trace::MethodMetrics::Instance()->GetMethodName(method_id);
+    if (name != nullptr && length > 0)
+    {
+        const auto copied = std::min(method_name.size(), static_cast<size_t>(length - 1));
+        std::copy_n(method_name.c_str(), copied, name);
+        name[copied] = 0;
+    }
+    return static_cast<int>(method_name.size());
+}
+
+// PlanAssemblies writes the JSON plan of the CallTarget rewrite of the assemblies of an application directory,
+// without modifying them. Like WeaveAssemblies, it runs without a profiler.
+EXTERN_C BOOL STDAPICALLTYPE PlanAssemblies(IMetaDataDispenser* dispenser,
+                                            const WCHAR*        integrations_path,
+                                            const WCHAR*        directory,
+                                            const WCHAR*        report_path)
+{
+    if (dispenser == nullptr || integrations_path == nullptr || directory == nullptr || report_path == nullptr)
+    {
+        return FALSE;
+    }
+
+    std::vector<trace::IntegrationMethod> integrations;
+    trace::LoadIntegrationsFromFile(integrations_path, integrations, trace::GetLoadIntegrationConfiguration());
+
+    const auto plan = trace::CallTarget_PlanDirectory(dispenser, directory, integrations);
+
+    std::ofstream stream(trace::ToString(trace::WSTRING(report_path)), std::ios::trunc);
+    stream << plan.dump(2);
+    return stream.good();
+}
+
+// WeaveAssemblies copies an application directory with the CallTarget integrations of a catalog woven into its
+// assemblies, and writes the JSON report. It runs without a profiler: the metadata dispenser is the one of the
+// runtime hosting the caller.
+EXTERN_C BOOL STDAPICALLTYPE WeaveAssemblies(IMetaDataDispenser* dispenser,
+                                             const WCHAR*        integrations_path,
+                                             const WCHAR*        directory,
+                                             const WCHAR*        output_directory,
+                                             const WCHAR*        report_path)
+{
+    if (dispenser == nullptr || integrations_path == nullptr || directory == nullptr || output_directory == nullptr ||
+        report_path == nullptr)
+    {
+        return FALSE;
+    }
+
+    std::vector<trace::IntegrationMethod> integrations;
+    trace::LoadIntegrationsFromFile(integrations_path, integrations, trace::GetLoadIntegrationConfiguration());
+
+    const auto report = trace::CallTarget_WeaveDirectory(dispenser, directory, output_directory, integrations);
+
+    std::ofstream stream(trace::ToString(trace::WSTRING(report_path)), std::ios::trunc);
+    stream << report.dump(2);
+    return stream.good();
+}
+
 #ifdef _WIN32
 // GetAssemblyAndSymbolsBytes is used when injecting the Loader into a .NET Framework application.
 EXTERN_C VOID STDAPICALLTYPE GetAssemblyAndSymbolsBytes(BYTE** pAssemblyArray,
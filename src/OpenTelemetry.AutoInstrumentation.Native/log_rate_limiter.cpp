@@ -0,0 +1,71 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "log_rate_limiter.h"
+
+#include <algorithm>
+
+namespace trace
+{
+
+LogRateLimiter::LogRateLimiter(unsigned burst, std::chrono::steady_clock::duration window) :
+    burst_(burst), window_(window)
+{
+}
+
+bool LogRateLimiter::Acquire(const std::string& key, unsigned long long* suppressed)
+{
+    return Acquire(key, std::chrono::steady_clock::now(), suppressed);
+}
+
+bool LogRateLimiter::Acquire(const std::string& key, std::chrono::steady_clock::time_point now,
+                             unsigned long long* suppressed)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    auto inserted = keys_.try_emplace(key);
+    auto& state   = inserted.first->second;
+    if (inserted.second || now - state.window_start >= window_)
+    {
+        state.window_start = now;
+        state.logged       = 0;
+    }
+
+    if (state.logged >= burst_)
+    {
+        state.suppressed++;
+        suppressed_count_++;
+        return false;
+    }
+
+    state.logged++;
+    *suppressed      = state.suppressed;
+    state.suppressed = 0;
+    return true;
+}
+
+std::vector<std::pair<std::string, unsigned long long>> LogRateLimiter::TakeSuppressed()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    std::vector<std::pair<std::string, unsigned long long>> suppressed;
+    for (auto& key : keys_)
+    {
+        if (key.second.suppressed > 0)
+        {
+            suppressed.emplace_back(key.first, key.second.suppressed);
+            key.second.suppressed = 0;
+        }
+    }
+    std::sort(suppressed.begin(), suppressed.end());
+    return suppressed;
+}
+
+unsigned long long LogRateLimiter::SuppressedCount() const
+{
+    return suppressed_count_.load();
+}
+
+} // namespace trace
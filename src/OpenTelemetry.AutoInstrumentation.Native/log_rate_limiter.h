@@ -0,0 +1,60 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_LOG_RATE_LIMITER_H_
+#define OTEL_CLR_PROFILER_LOG_RATE_LIMITER_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trace
+{
+
+// Number of messages logged with the same key in a window, the next ones are suppressed until the window ends.
+const unsigned LogRateLimitBurst = 5;
+const std::chrono::seconds LogRateLimitWindow{10};
+
+// LogRateLimiter limits the messages logged with the same key, usually the call site, so a step failing for every
+// method of a module doesn't format and write thousands of lines. The suppressed messages are only counted, the
+// next message logged with the key reports how many were suppressed.
+class LogRateLimiter
+{
+private:
+    struct KeyState
+    {
+        std::chrono::steady_clock::time_point window_start;
+        unsigned logged = 0;
+        unsigned long long suppressed = 0;
+    };
+
+    const unsigned burst_;
+    const std::chrono::steady_clock::duration window_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, KeyState> keys_;
+    std::atomic_ullong suppressed_count_{0};
+
+public:
+    LogRateLimiter(unsigned burst, std::chrono::steady_clock::duration window);
+
+    // Acquire returns true if a message with the key can be logged, suppressed receives the number of messages
+    // of the key suppressed since the last one logged.
+    bool Acquire(const std::string& key, unsigned long long* suppressed);
+    bool Acquire(const std::string& key, std::chrono::steady_clock::time_point now, unsigned long long* suppressed);
+
+    // TakeSuppressed returns the keys whose suppressed messages were not reported yet, and resets them.
+    std::vector<std::pair<std::string, unsigned long long>> TakeSuppressed();
+
+    // SuppressedCount returns the number of messages suppressed since the start.
+    unsigned long long SuppressedCount() const;
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_LOG_RATE_LIMITER_H_
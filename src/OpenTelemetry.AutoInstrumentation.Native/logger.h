@@ -64,11 +64,35 @@ public:
         LoggerImpl<TracerLoggerPolicy>::Instance()->Critical(args...);
     }
 
+    // WarnRateLimited logs at most a few messages with the same key in a time window, for the failures that can
+    // repeat for every method of a module. The key is usually the call site.
+    template <typename... Args>
+    static void WarnRateLimited(const std::string& key, const Args&... args)
+    {
+        LoggerImpl<TracerLoggerPolicy>::Instance()->WarnRateLimited(key, args...);
+    }
+
+    template <typename... Args>
+    static void ErrorRateLimited(const std::string& key, const Args&... args)
+    {
+        LoggerImpl<TracerLoggerPolicy>::Instance()->ErrorRateLimited(key, args...);
+    }
+
+    static void LogSuppressedMessages()
+    {
+        LoggerImpl<TracerLoggerPolicy>::Instance()->LogSuppressedMessages();
+    }
+
     static bool IsDebugEnabled()
     {
         return LoggerImpl<TracerLoggerPolicy>::Instance()->IsDebugEnabled();
     }
 
+    static bool SetLogLevel(const WSTRING& name)
+    {
+        return LoggerImpl<TracerLoggerPolicy>::Instance()->SetLogLevel(name);
+    }
+
     static void Shutdown()
     {
         LoggerImpl<TracerLoggerPolicy>::Shutdown();
@@ -8,7 +8,9 @@
 #include "util.h"
 #include "environment_variables.h"
 #include "string.h"
+#include "log_rate_limiter.h"
 #include "pal.h"
+#include "telemetry_region.h"
 
 #include "spdlog/sinks/null_sink.h"
 #include "spdlog/sinks/rotating_file_sink.h"
@@ -33,6 +35,9 @@ class LoggerImpl : public Singleton<LoggerImpl<TLoggerPolicy>>
 
 private:
     std::shared_ptr<spdlog::logger> m_fileout;
+    // False when nothing is written, the log file is not created with the "none" log level.
+    bool m_file_created = false;
+    LogRateLimiter m_rate_limiter{LogRateLimitBurst, LogRateLimitWindow};
     static std::string GetLogPath(const std::string& file_name_suffix);
     LoggerImpl();
     ~LoggerImpl();
@@ -47,6 +52,12 @@ private:
 
     bool ShouldLog(spdlog::level::level_enum log_level);
 
+    // TryParseLogLevel converts the name of a log level, "none" turns the logging off.
+    static bool TryParseLogLevel(const WSTRING& name, spdlog::level::level_enum* log_level);
+
+    template <typename... Args>
+    void LogRateLimited(spdlog::level::level_enum log_level, const std::string& key, const Args&... args);
+
 public:
     template <typename... Args>
     void Debug(const Args&... args);
@@ -63,10 +74,25 @@ public:
     template <typename... Args>
     void Critical(const Args&... args);
 
+    // WarnRateLimited and ErrorRateLimited log at most LogRateLimitBurst messages with the same key in
+    // LogRateLimitWindow, the other ones are counted, and reported by the next message logged with the key.
+    template <typename... Args>
+    void WarnRateLimited(const std::string& key, const Args&... args);
+
+    template <typename... Args>
+    void ErrorRateLimited(const std::string& key, const Args&... args);
+
+    // LogSuppressedMessages logs the number of messages suppressed for each key and not reported yet.
+    void LogSuppressedMessages();
+
     void Flush();
 
     bool IsDebugEnabled() const;
 
+    // SetLogLevel changes the log level while the profiler runs, the messages already being logged keep the
+    // previous one. The log level can't be raised if the profiler started with the "none" log level.
+    bool SetLogLevel(const WSTRING& name);
+
     static void Shutdown()
     {
         spdlog::shutdown();
@@ -101,6 +127,7 @@ LoggerImpl<TLoggerPolicy>::LoggerImpl()
         // There's not a good way to report errors when trying to create the log file.
         // But we never should be changing the normal behavior of an app.
         // std::cerr << "LoggerImpl Handler: " << msg << std::endl;
+        TelemetryRegion::Instance()->Add(TelemetryCounter::LoggerErrors);
     });
 
     static auto configured_log_level = GetEnvironmentValue(environment::log_level);
@@ -111,23 +138,7 @@ LoggerImpl<TLoggerPolicy>::LoggerImpl()
         return;
     }
     auto log_level = spdlog::level::info;
-
-    if (configured_log_level == log_level_error)
-    {
-        log_level = spdlog::level::err;
-    }
-    else if (configured_log_level == log_level_warn)
-    {
-        log_level = spdlog::level::warn;
-    }
-    else if (configured_log_level == log_level_info)
-    {
-        log_level = spdlog::level::info;
-    }
-    else if (configured_log_level == log_level_debug)
-    {
-        log_level = spdlog::level::debug;
-    }
+    TryParseLogLevel(configured_log_level, &log_level);
 
     spdlog::flush_every(std::chrono::seconds(3));
 
@@ -144,7 +155,8 @@ LoggerImpl<TLoggerPolicy>::LoggerImpl()
 
     try
     {
-        m_fileout = spdlog::rotating_logger_mt(logger_name, GetLogPath(file_name_suffix), file_size, 10);
+        m_fileout      = spdlog::rotating_logger_mt(logger_name, GetLogPath(file_name_suffix), file_size, 10);
+        m_file_created = true;
     }
     catch (...)
     {
@@ -247,6 +259,57 @@ void LoggerImpl<TLoggerPolicy>::Critical(const Args&... args)
     }
 }
 
+template <typename TLoggerPolicy>
+template <typename... Args>
+void LoggerImpl<TLoggerPolicy>::WarnRateLimited(const std::string& key, const Args&... args)
+{
+    LogRateLimited(spdlog::level::warn, key, args...);
+}
+
+template <typename TLoggerPolicy>
+template <typename... Args>
+void LoggerImpl<TLoggerPolicy>::ErrorRateLimited(const std::string& key, const Args&... args)
+{
+    LogRateLimited(spdlog::level::err, key, args...);
+}
+
+template <typename TLoggerPolicy>
+template <typename... Args>
+void LoggerImpl<TLoggerPolicy>::LogRateLimited(spdlog::level::level_enum log_level, const std::string& key,
+                                               const Args&... args)
+{
+    if (!ShouldLog(log_level))
+    {
+        return;
+    }
+
+    // Every message is logged while debugging.
+    unsigned long long suppressed = 0;
+    if (!IsDebugEnabled() && !m_rate_limiter.Acquire(key, &suppressed))
+    {
+        TelemetryRegion::Instance()->Add(TelemetryCounter::LoggerSuppressedMessages);
+        return;
+    }
+
+    if (suppressed > 0)
+    {
+        m_fileout->log(log_level, LogToString(args..., " (suppressed ", suppressed, " similar messages)"));
+    }
+    else
+    {
+        m_fileout->log(log_level, LogToString(args...));
+    }
+}
+
+template <typename TLoggerPolicy>
+void LoggerImpl<TLoggerPolicy>::LogSuppressedMessages()
+{
+    for (const auto& suppressed : m_rate_limiter.TakeSuppressed())
+    {
+        m_fileout->warn(LogToString("Suppressed ", suppressed.second, " similar messages: ", suppressed.first));
+    }
+}
+
 template <typename TLoggerPolicy>
 bool LoggerImpl<TLoggerPolicy>::ShouldLog(spdlog::level::level_enum log_level)
 {
@@ -266,6 +329,59 @@ bool LoggerImpl<TLoggerPolicy>::IsDebugEnabled() const
     return m_fileout->level() == spdlog::level::debug;
 }
 
+template <typename TLoggerPolicy>
+bool LoggerImpl<TLoggerPolicy>::TryParseLogLevel(const WSTRING& name, spdlog::level::level_enum* log_level)
+{
+    if (name == log_level_none)
+    {
+        *log_level = spdlog::level::off;
+    }
+    else if (name == log_level_error)
+    {
+        *log_level = spdlog::level::err;
+    }
+    else if (name == log_level_warn)
+    {
+        *log_level = spdlog::level::warn;
+    }
+    else if (name == log_level_info)
+    {
+        *log_level = spdlog::level::info;
+    }
+    else if (name == log_level_debug)
+    {
+        *log_level = spdlog::level::debug;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+template <typename TLoggerPolicy>
+bool LoggerImpl<TLoggerPolicy>::SetLogLevel(const WSTRING& name)
+{
+    auto log_level = spdlog::level::info;
+    if (!TryParseLogLevel(name, &log_level) || (!m_file_created && log_level != spdlog::level::off))
+    {
+        return false;
+    }
+
+    // The level is an atomic read by every call. The change is logged with the most verbose of the two levels.
+    const bool less_verbose = log_level > m_fileout->level();
+    if (less_verbose)
+    {
+        Info("Log level changed to ", name);
+    }
+    m_fileout->set_level(log_level);
+    if (!less_verbose)
+    {
+        Info("Log level changed to ", name);
+    }
+    return true;
+}
+
 } // namespace shared
 
 #endif // OTEL_CLR_PROFILER_LOGGER_IMPL_H_
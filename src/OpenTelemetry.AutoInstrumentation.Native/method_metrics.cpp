@@ -0,0 +1,227 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "method_metrics.h"
+
+#include <algorithm>
+
+namespace trace
+{
+
+namespace
+{
+    // Histograms of the current thread once registered, read by TryRecord without the lazy initialization of a
+    // thread_local with a destructor.
+    thread_local MethodMetrics::ThreadHistograms* current_thread_histograms = nullptr;
+
+    // ThreadRegistration adds the histograms of a thread to the collected ones on its first call, and merges them
+    // into the ones of the exited threads when it exits.
+    struct ThreadRegistration
+    {
+        MethodMetrics::ThreadHistograms histograms;
+
+        ThreadRegistration()
+        {
+            MethodMetrics::Instance()->ThreadStarted(&histograms);
+            current_thread_histograms = &histograms;
+        }
+
+        ~ThreadRegistration()
+        {
+            current_thread_histograms = nullptr;
+            MethodMetrics::Instance()->ThreadExited(&histograms);
+        }
+    };
+
+    void Increment(std::atomic<uint64_t>& value, uint64_t increment)
+    {
+        // Only the thread owning the histogram writes it, the collector only reads it.
+        value.store(value.load(std::memory_order_relaxed) + increment, std::memory_order_relaxed);
+    }
+
+    void AddDuration(TelemetryHistogramData& data, uint64_t duration_ns)
+    {
+        Increment(data.count, 1);
+        Increment(data.sum_ns, duration_ns);
+        Increment(data.buckets[GetTelemetryHistogramBucket(duration_ns)], 1);
+    }
+} // namespace
+
+MethodMetrics::ThreadHistograms::ThreadHistograms()
+{
+    for (auto& block : blocks)
+    {
+        block.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MethodMetrics::ThreadHistograms::~ThreadHistograms()
+{
+    for (auto& block : blocks)
+    {
+        delete block.load(std::memory_order_relaxed);
+    }
+}
+
+TelemetryHistogramData& MethodMetrics::ThreadHistograms::Get(int32_t method_id)
+{
+    auto& slot  = blocks[method_id / MethodMetricsBlockSize];
+    auto  block = slot.load(std::memory_order_acquire);
+    if (block == nullptr)
+    {
+        block = new Block();
+        slot.store(block, std::memory_order_release);
+    }
+    return block->histograms[method_id % MethodMetricsBlockSize];
+}
+
+MethodMetrics::ThreadHistograms* MethodMetrics::GetThreadHistograms()
+{
+    thread_local ThreadRegistration registration;
+    return &registration.histograms;
+}
+
+int32_t MethodMetrics::Register(const WSTRING& assembly_name, uint32_t method_def, const WSTRING& method_name)
+{
+    const auto method_key = assembly_name + WStr("!") + ToWSTRING(std::to_string(method_def));
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    const auto                  method_id = method_ids_.find(method_key);
+    if (method_id != method_ids_.end())
+    {
+        return method_id->second;
+    }
+
+    if (method_names_.size() >= MethodMetricsMaxMethods)
+    {
+        return -1;
+    }
+
+    const auto new_method_id = static_cast<int32_t>(method_names_.size());
+    method_names_.push_back(method_name);
+    method_ids_[method_key] = new_method_id;
+    return new_method_id;
+}
+
+WSTRING MethodMetrics::GetMethodName(int32_t method_id)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (method_id < 0 || method_id >= static_cast<int32_t>(method_names_.size()))
+    {
+        return EmptyWStr;
+    }
+    return method_names_[method_id];
+}
+
+void MethodMetrics::Record(int32_t method_id, uint64_t duration_ns)
+{
+    if (method_id < 0 || method_id >= MethodMetricsMaxMethods)
+    {
+        return;
+    }
+
+    AddDuration(GetThreadHistograms()->Get(method_id), duration_ns);
+}
+
+bool MethodMetrics::TryRecord(int32_t method_id, uint64_t duration_ns)
+{
+    const auto histograms = current_thread_histograms;
+    if (histograms == nullptr || method_id < 0 || method_id >= MethodMetricsMaxMethods)
+    {
+        return false;
+    }
+
+    const auto block = histograms->blocks[method_id / MethodMetricsBlockSize].load(std::memory_order_acquire);
+    if (block == nullptr)
+    {
+        return false;
+    }
+
+    AddDuration(block->histograms[method_id % MethodMetricsBlockSize], duration_ns);
+    return true;
+}
+
+void MethodMetrics::Add(const ThreadHistograms& histograms, std::vector<MethodMetric>& metrics)
+{
+    for (size_t i = 0; i < metrics.size(); i++)
+    {
+        const auto block = histograms.blocks[i / MethodMetricsBlockSize].load(std::memory_order_acquire);
+        if (block == nullptr)
+        {
+            i += MethodMetricsBlockSize - 1 - i % MethodMetricsBlockSize;
+            continue;
+        }
+
+        const auto& data = block->histograms[i % MethodMetricsBlockSize];
+        metrics[i].count += data.count.load(std::memory_order_relaxed);
+        metrics[i].sum_ns += data.sum_ns.load(std::memory_order_relaxed);
+        for (uint32_t bucket = 0; bucket < TelemetryHistogramBucketCount; bucket++)
+        {
+            metrics[i].buckets[bucket] += data.buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void MethodMetrics::Collect(std::vector<MethodMetric>& metrics)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    std::vector<MethodMetric> method_metrics(method_names_.size(), MethodMetric{});
+    Add(exited_threads_, method_metrics);
+    for (const auto thread : threads_)
+    {
+        Add(*thread, method_metrics);
+    }
+
+    for (size_t i = 0; i < method_metrics.size(); i++)
+    {
+        if (method_metrics[i].count > 0)
+        {
+            method_metrics[i].method_id    = static_cast<int32_t>(i);
+            method_metrics[i].bucket_count = TelemetryHistogramBucketCount;
+            metrics.push_back(method_metrics[i]);
+        }
+    }
+}
+
+void MethodMetrics::ThreadStarted(ThreadHistograms* histograms)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    threads_.push_back(histograms);
+}
+
+void MethodMetrics::ThreadExited(ThreadHistograms* histograms)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    threads_.erase(std::remove(threads_.begin(), threads_.end(), histograms), threads_.end());
+
+    for (int32_t block_index = 0; block_index < MethodMetricsBlockCount; block_index++)
+    {
+        const auto block = histograms->blocks[block_index].load(std::memory_order_acquire);
+        if (block == nullptr)
+        {
+            continue;
+        }
+
+        for (int32_t i = 0; i < MethodMetricsBlockSize; i++)
+        {
+            const auto& data = block->histograms[i];
+            if (data.count.load(std::memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+
+            auto& exited = exited_threads_.Get(block_index * MethodMetricsBlockSize + i);
+            Increment(exited.count, data.count.load(std::memory_order_relaxed));
+            Increment(exited.sum_ns, data.sum_ns.load(std::memory_order_relaxed));
+            for (uint32_t bucket = 0; bucket < TelemetryHistogramBucketCount; bucket++)
+            {
+                Increment(exited.buckets[bucket], data.buckets[bucket].load(std::memory_order_relaxed));
+            }
+        }
+    }
+}
+
+} // namespace trace
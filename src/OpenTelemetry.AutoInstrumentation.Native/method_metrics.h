@@ -0,0 +1,103 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_METHOD_METRICS_H_
+#define OTEL_CLR_PROFILER_METHOD_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "string.h"
+#include "telemetry_region.h"
+#include "util.h"
+
+namespace trace
+{
+
+// Number of methods whose calls can be recorded, the methods registered after it are not instrumented.
+const int32_t MethodMetricsMaxMethods = 4096;
+// The histograms of a thread are allocated by blocks of methods, on the first call of one of them.
+const int32_t MethodMetricsBlockSize  = 64;
+const int32_t MethodMetricsBlockCount = MethodMetricsMaxMethods / MethodMetricsBlockSize;
+
+// Calls and durations of a method, as returned to the managed code. The buckets are the ones of the telemetry
+// region histograms.
+// NOTE: Must keep this layout in sync with NativeMethods.MethodMetric.
+struct MethodMetric
+{
+    int32_t method_id;
+    uint32_t bucket_count;
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t buckets[TelemetryHistogramBucketCount];
+};
+
+// MethodMetrics records the calls of the methods rewritten by the MethodMetrics integrations. Each thread records
+// into its own histograms, without locks nor shared cache lines, and Collect sums the histograms of all the threads.
+class MethodMetrics : public Singleton<MethodMetrics>
+{
+    friend class Singleton<MethodMetrics>;
+
+public:
+    struct Block
+    {
+        TelemetryHistogramData histograms[MethodMetricsBlockSize];
+    };
+
+    // Histograms written by a single thread, the blocks are only freed with them.
+    struct ThreadHistograms : public UnCopyable
+    {
+        std::atomic<Block*> blocks[MethodMetricsBlockCount];
+
+        ThreadHistograms();
+        ~ThreadHistograms();
+
+        TelemetryHistogramData& Get(int32_t method_id);
+    };
+
+private:
+    std::mutex mutex_;
+    // Keyed by the assembly name and the methodDef token of the methods, so each overload gets its own id and a method
+    // of an assembly reloaded in a collectible AssemblyLoadContext keeps its id.
+    std::unordered_map<WSTRING, int32_t> method_ids_;
+    std::vector<WSTRING> method_names_;
+    std::vector<ThreadHistograms*> threads_;
+    // The values recorded by the threads that exited.
+    ThreadHistograms exited_threads_;
+
+    MethodMetrics() = default;
+
+    static ThreadHistograms* GetThreadHistograms();
+    static void Add(const ThreadHistograms& histograms, std::vector<MethodMetric>& metrics);
+
+public:
+    // Register returns the id of a method, the same method always gets the same id. It returns -1 once
+    // MethodMetricsMaxMethods methods are registered. The name is the one returned by GetMethodName.
+    int32_t Register(const WSTRING& assembly_name, uint32_t method_def, const WSTRING& method_name);
+    WSTRING GetMethodName(int32_t method_id);
+
+    // Record adds a call of a method to the histograms of the current thread.
+    void Record(int32_t method_id, uint64_t duration_ns);
+    // TryRecord adds a call of a method only if the histogram of the method is already allocated for the current
+    // thread. It neither allocates nor takes locks, so it can be called without a GC transition; Record must be
+    // called when it returns false. It must only be called by a thread that already called Record: the first access
+    // to a thread_local of the dlopen'd profiler goes through __tls_get_addr, which can allocate.
+    static bool TryRecord(int32_t method_id, uint64_t duration_ns);
+
+    // Collect returns the cumulative calls of the registered methods, the methods without calls are skipped.
+    void Collect(std::vector<MethodMetric>& metrics);
+
+    // ThreadStarted and ThreadExited track the histograms of the threads, the values of an exited thread are kept in
+    // the collected ones.
+    void ThreadStarted(ThreadHistograms* histograms);
+    void ThreadExited(ThreadHistograms* histograms);
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_METHOD_METRICS_H_
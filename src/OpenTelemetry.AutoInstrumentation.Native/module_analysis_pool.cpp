@@ -0,0 +1,98 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "module_analysis_pool.h"
+
+#include <algorithm>
+
+namespace trace
+{
+
+ModuleAnalysisPool::ModuleAnalysisPool(size_t thread_count)
+{
+    thread_count = std::min(thread_count, ModuleAnalysisMaxThreads);
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+
+    // The threads are started once all the workers exist, Run only uses its own.
+    for (auto& worker : workers_)
+    {
+        worker->thread = std::thread(&ModuleAnalysisPool::Run, this, worker.get());
+    }
+}
+
+ModuleAnalysisPool::~ModuleAnalysisPool()
+{
+    Stop();
+}
+
+void ModuleAnalysisPool::Run(Worker* worker)
+{
+    while (true)
+    {
+        auto work = worker->queue.pop();
+        if (!work)
+        {
+            return;
+        }
+
+        if (!stopping_.load())
+        {
+            work();
+        }
+        pending_--;
+    }
+}
+
+size_t ModuleAnalysisPool::ThreadCount() const
+{
+    return workers_.size();
+}
+
+bool ModuleAnalysisPool::Enqueue(size_t key, std::function<void()> work)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (stopping_.load() || workers_.empty())
+    {
+        return false;
+    }
+
+    pending_++;
+    workers_[key % workers_.size()]->queue.push(work);
+    return true;
+}
+
+unsigned long long ModuleAnalysisPool::PendingCount() const
+{
+    return pending_.load();
+}
+
+void ModuleAnalysisPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (stopping_.exchange(true))
+        {
+            return;
+        }
+
+        for (auto& worker : workers_)
+        {
+            worker->queue.push(nullptr);
+        }
+    }
+
+    for (auto& worker : workers_)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+} // namespace trace
@@ -0,0 +1,64 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_MODULE_ANALYSIS_POOL_H_
+#define OTEL_CLR_PROFILER_MODULE_ANALYSIS_POOL_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util.h"
+
+namespace trace
+{
+
+// Maximum number of threads of the module analysis pool.
+const size_t ModuleAnalysisMaxThreads = 16;
+
+// ModuleAnalysisPool runs the analysis of the loaded modules on its own threads, so the threads loading the
+// assemblies don't wait for the integrations matching. The work items of a module always run on the same thread,
+// in the order they were enqueued.
+class ModuleAnalysisPool : public UnCopyable
+{
+private:
+    struct Worker
+    {
+        // An empty work item stops the worker.
+        BlockingQueue<std::function<void()>> queue;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex mutex_;
+    std::atomic_bool stopping_{false};
+    std::atomic_ullong pending_{0};
+
+    void Run(Worker* worker);
+
+public:
+    explicit ModuleAnalysisPool(size_t thread_count);
+    ~ModuleAnalysisPool();
+
+    size_t ThreadCount() const;
+
+    // Enqueue queues the work item on the thread of the key, usually the module id. It returns false once the pool
+    // is stopped, the caller must then do the work itself.
+    bool Enqueue(size_t key, std::function<void()> work);
+
+    // PendingCount returns the number of work items enqueued and not completed yet.
+    unsigned long long PendingCount() const;
+
+    // Stop discards the pending work items and waits for the ones running to complete. It must not be called
+    // from a work item.
+    void Stop();
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_MODULE_ANALYSIS_POOL_H_
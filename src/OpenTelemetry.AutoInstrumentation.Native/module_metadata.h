@@ -39,6 +39,8 @@ public:
     const AppDomainID app_domain_id;
     const GUID module_version_id;
     const AssemblyProperty* corAssemblyProperty = nullptr;
+    // The methods woven with the CallTarget rewrite ahead of time, the CallTarget integrations are not applied to them.
+    std::unordered_set<mdMethodDef> woven_method_defs;
 
     ModuleMetadata(ComPtr<IMetaDataImport2> metadata_import, ComPtr<IMetaDataEmit2> metadata_emit,
                    ComPtr<IMetaDataAssemblyImport> assembly_import, ComPtr<IMetaDataAssemblyEmit> assembly_emit,
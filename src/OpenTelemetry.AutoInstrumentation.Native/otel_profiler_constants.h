@@ -64,6 +64,18 @@ const WSTRING skip_assemblies[]{WStr("mscorlib"),
 
 const WSTRING mscorlib_assemblyName = WStr("mscorlib");
 const WSTRING system_private_corelib_assemblyName = WStr("System.Private.CoreLib");
+
+// CoreLib methods that integrations can target, as "Type.Method". CoreLib is only instrumented on .NET, once the
+// instrumentation assembly is loaded. Each entry must be vetted: the method has an IL body, it is not called by
+// the CallTarget invoker or by the OpenTelemetry SDK while handling an instrumented call, which would recurse,
+// and its arguments can be used as generic arguments (no pointers).
+const WSTRING corlib_methods_allow_list[]{
+    // Execution of the thread pool work items.
+    WStr("System.Threading.ThreadPoolWorkQueue.DispatchWorkItem"),
+    // Execution of the timer callbacks.
+    WStr("System.Threading.TimerQueueTimer.CallCallback"),
+};
+
 const WSTRING opentelemetry_autoinstrumentation_loader_assemblyName = WStr("OpenTelemetry.AutoInstrumentation.Loader");
 
 const WSTRING managed_profiler_name = WStr("OpenTelemetry.AutoInstrumentation");
@@ -76,6 +88,9 @@ const WSTRING managed_profiler_full_assembly_version_strong_name =
 
 const WSTRING nonwindows_nativemethods_type = WStr("OpenTelemetry.AutoInstrumentation.NativeMethods+NonWindows");
 
+// Time that the runtime is expected to wait, after a detach request, for the threads to leave the profiler code.
+const DWORD detach_expected_completion_milliseconds = 5000;
+
 } // namespace trace
 
 #endif // OTEL_PROFILER_CONSTANTS_H
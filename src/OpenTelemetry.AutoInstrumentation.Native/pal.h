@@ -38,11 +38,10 @@
 namespace trace
 {
 
+// GetLogDirectoryFilePath returns the path of a file in the log directory.
 template <class TLoggerPolicy>
-inline WSTRING GetDatadogLogFilePath(const std::string& file_name_suffix)
+inline WSTRING GetLogDirectoryFilePath(const std::string& file_name)
 {
-    const auto file_name = TLoggerPolicy::file_name + file_name_suffix + ".log";
-
     WSTRING directory = GetEnvironmentValue(environment::log_directory);
 
     if (directory.length() > 0)
@@ -65,6 +64,12 @@ inline WSTRING GetDatadogLogFilePath(const std::string& file_name_suffix)
 #endif
 }
 
+template <class TLoggerPolicy>
+inline WSTRING GetDatadogLogFilePath(const std::string& file_name_suffix)
+{
+    return GetLogDirectoryFilePath<TLoggerPolicy>(TLoggerPolicy::file_name + file_name_suffix + ".log");
+}
+
 inline WSTRING GetCurrentProcessName()
 {
 #ifdef _WIN32
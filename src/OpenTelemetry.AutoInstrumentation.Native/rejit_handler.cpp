@@ -3,84 +3,24 @@
 
 #include "rejit_handler.h"
 
+#include <algorithm>
+
 #include "logger.h"
+#include "telemetry_region.h"
 
 namespace trace
 {
 
-//
-// RejitHandlerModuleMethod
-//
-
-RejitHandlerModuleMethod::RejitHandlerModuleMethod(mdMethodDef methodDef, RejitHandlerModule* module)
-{
-    m_methodDef         = methodDef;
-    m_pFunctionControl  = nullptr;
-    m_module            = module;
-    m_functionInfo      = nullptr;
-    m_methodReplacement = nullptr;
-}
-
-mdMethodDef RejitHandlerModuleMethod::GetMethodDef()
-{
-    return m_methodDef;
-}
-
-RejitHandlerModule* RejitHandlerModuleMethod::GetModule()
-{
-    return m_module;
-}
-
-ICorProfilerFunctionControl* RejitHandlerModuleMethod::GetFunctionControl()
-{
-    return m_pFunctionControl;
-}
-
-void RejitHandlerModuleMethod::SetFunctionControl(ICorProfilerFunctionControl* pFunctionControl)
-{
-    m_pFunctionControl = pFunctionControl;
-}
-
-FunctionInfo* RejitHandlerModuleMethod::GetFunctionInfo()
-{
-    return m_functionInfo.get();
-}
-
-void RejitHandlerModuleMethod::SetFunctionInfo(const FunctionInfo& functionInfo)
-{
-    m_functionInfo = std::make_unique<FunctionInfo>(functionInfo);
-}
-
-MethodReplacement* RejitHandlerModuleMethod::GetMethodReplacement()
-{
-    return m_methodReplacement.get();
-}
-
-void RejitHandlerModuleMethod::SetMethodReplacement(const MethodReplacement& methodReplacement)
-{
-    m_methodReplacement = std::make_unique<MethodReplacement>(methodReplacement);
-}
-
-void RejitHandlerModuleMethod::RequestRejitForInlinersInModule(ModuleID moduleId)
+namespace
 {
-    Logger::Debug("RejitHandlerModuleMethod::RequestRejitForInlinersInModule: ", moduleId);
-    std::lock_guard<std::mutex> guard(m_ngenModulesLock);
-
-    // We check first if we already processed this module to skip it.
-    auto find_res = m_ngenModules.find(moduleId);
-    if (find_res != m_ngenModules.end())
+    // EnumerateNGenInliners adds the methods of the NGEN module that inline the method to the ReJIT request, it
+    // returns false if their list may be incomplete.
+    bool EnumerateNGenInliners(ICorProfilerInfo7* pInfo, ModuleID moduleId, ModuleID currentModuleId,
+                               mdMethodDef currentMethodDef, std::vector<ModuleID>& modulesVector,
+                               std::vector<mdMethodDef>& modulesMethodDef)
     {
-        return;
-    }
-
-    // Enumerate all inliners and request rejit
-    ModuleID           currentModuleId  = m_module->GetModuleId();
-    mdMethodDef        currentMethodDef = m_methodDef;
-    RejitHandler*      handler          = m_module->GetHandler();
-    ICorProfilerInfo7* pInfo            = handler->GetCorProfilerInfo7();
+        Logger::Debug("RejitHandlerModule::GetInlinersInModule: ", moduleId);
 
-    if (pInfo != nullptr)
-    {
         // Now we enumerate all methods that inline the current methodDef
         BOOL                    incompleteData = false;
         ICorProfilerMethodEnum* methodEnum;
@@ -89,37 +29,32 @@ void RejitHandlerModuleMethod::RequestRejitForInlinersInModule(ModuleID moduleId
                                                                     &incompleteData, &methodEnum);
         if (SUCCEEDED(hr))
         {
-            COR_PRF_METHOD           method;
-            unsigned int             total = 0;
-            std::vector<ModuleID>    modules;
-            std::vector<mdMethodDef> methods;
+            COR_PRF_METHOD method;
+            unsigned int   total = 0;
             while (methodEnum->Next(1, &method, NULL) == S_OK)
             {
                 Logger::Debug("NGEN:: Asking rewrite for inliner [ModuleId=", method.moduleId, ",MethodDef=",
                               method.methodId, "]");
-                modules.push_back(method.moduleId);
-                methods.push_back(method.methodId);
+                modulesVector.push_back(method.moduleId);
+                modulesMethodDef.push_back(method.methodId);
                 total++;
             }
             methodEnum->Release();
             methodEnum = nullptr;
             if (total > 0)
             {
-                handler->RequestRejit(modules, methods);
                 Logger::Info("NGEN:: Processed with ", total, " inliners [ModuleId=", currentModuleId, ",MethodDef=",
                              currentMethodDef, "]");
             }
 
-            if (!incompleteData)
-            {
-                m_ngenModules[moduleId] = true;
-            }
-            else
+            if (incompleteData)
             {
                 Logger::Warn("NGen inliner data for module '", moduleId, "' is incomplete.");
             }
+            return !incompleteData;
         }
-        else if (hr == E_INVALIDARG)
+
+        if (hr == E_INVALIDARG)
         {
             Logger::Info("NGEN:: Error Invalid arguments in [ModuleId=", currentModuleId, ",MethodDef=",
                          currentMethodDef, ", HR=E_INVALIDARG]");
@@ -134,8 +69,14 @@ void RejitHandlerModuleMethod::RequestRejitForInlinersInModule(ModuleID moduleId
             Logger::Info("NGEN:: Error in [ModuleId=", currentModuleId, ",MethodDef=", currentMethodDef, ", HR=",
                          HResultStr(hr), "]");
         }
+        return false;
     }
-}
+
+    bool CompareMethodDef(const RejitHandlerModuleMethod& method, mdMethodDef methodDef)
+    {
+        return method.methodDef < methodDef;
+    }
+} // namespace
 
 //
 // RejitHandlerModule
@@ -168,63 +109,208 @@ void RejitHandlerModule::SetModuleMetadata(ModuleMetadata* metadata)
     m_metadata = metadata;
 }
 
-RejitHandlerModuleMethod* RejitHandlerModule::GetOrAddMethod(mdMethodDef methodDef)
+std::vector<RejitHandlerModuleMethod>::iterator RejitHandlerModule::FindMethod(mdMethodDef methodDef)
 {
-    std::lock_guard<std::mutex> guard(m_methods_lock);
+    auto it = std::lower_bound(m_methods.begin(), m_methods.end(), methodDef, CompareMethodDef);
+    return it != m_methods.end() && it->methodDef == methodDef ? it : m_methods.end();
+}
 
-    auto find_res = m_methods.find(methodDef);
-    if (find_res != m_methods.end())
+RejitHandlerModuleMethod& RejitHandlerModule::FindOrInsertMethod(mdMethodDef methodDef)
+{
+    auto it = std::lower_bound(m_methods.begin(), m_methods.end(), methodDef, CompareMethodDef);
+    if (it == m_methods.end() || it->methodDef != methodDef)
     {
-        return find_res->second.get();
+        RejitHandlerModuleMethod method;
+        method.methodDef = methodDef;
+        it               = m_methods.insert(it, method);
     }
+    return *it;
+}
 
-    RejitHandlerModuleMethod* methodHandler = new RejitHandlerModuleMethod(methodDef, this);
-    m_methods[methodDef]                    = std::unique_ptr<RejitHandlerModuleMethod>(methodHandler);
-    return methodHandler;
+void RejitHandlerModule::AddMethod(mdMethodDef methodDef)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+    FindOrInsertMethod(methodDef);
 }
 
-bool RejitHandlerModule::TryGetMethod(mdMethodDef methodDef, RejitHandlerModuleMethod** methodHandler)
+void RejitHandlerModule::SetMethod(mdMethodDef                  methodDef,
+                                   const MethodReplacement&     methodReplacement,
+                                   const CallTargetAsyncMethod* asyncMethod)
 {
+    const auto sharedMethodReplacement = m_handler->InternMethodReplacement(methodReplacement);
+
     std::lock_guard<std::mutex> guard(m_methods_lock);
+    auto&                       method = FindOrInsertMethod(methodDef);
+    method.methodReplacement           = sharedMethodReplacement;
+    method.isAsyncMethod               = asyncMethod != nullptr;
+    if (asyncMethod != nullptr)
+    {
+        m_asyncMethods[methodDef] = std::make_shared<const CallTargetAsyncMethod>(*asyncMethod);
+    }
+    else
+    {
+        m_asyncMethods.erase(methodDef);
+    }
+}
 
-    auto find_res = m_methods.find(methodDef);
+bool RejitHandlerModule::TryGetMethod(mdMethodDef methodDef, RejitHandlerModuleMethod* method)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+
+    auto find_res = FindMethod(methodDef);
     if (find_res != m_methods.end())
     {
-        *methodHandler = find_res->second.get();
+        *method = *find_res;
         return true;
     }
-    *methodHandler = nullptr;
     return false;
 }
 
+std::shared_ptr<const CallTargetAsyncMethod> RejitHandlerModule::GetAsyncMethod(mdMethodDef methodDef)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+
+    auto find_res = m_asyncMethods.find(methodDef);
+    return find_res != m_asyncMethods.end() ? find_res->second : nullptr;
+}
+
+void RejitHandlerModule::SetOutlinedMethod(mdMethodDef methodDef, mdMethodDef outlinedMethodDef)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+    m_outlinedMethods[methodDef] = outlinedMethodDef;
+}
+
+mdMethodDef RejitHandlerModule::GetOutlinedMethod(mdMethodDef methodDef)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+
+    auto find_res = m_outlinedMethods.find(methodDef);
+    return find_res != m_outlinedMethods.end() ? find_res->second : mdMethodDefNil;
+}
+
 bool RejitHandlerModule::ContainsMethod(mdMethodDef methodDef)
 {
     std::lock_guard<std::mutex> guard(m_methods_lock);
-    return m_methods.find(methodDef) != m_methods.end();
+    return FindMethod(methodDef) != m_methods.end();
 }
 
-void RejitHandlerModule::RequestRejitForInlinersInModule(ModuleID moduleId)
+void RejitHandlerModule::GetMethodDefs(std::vector<mdMethodDef>& methodDefs)
 {
     std::lock_guard<std::mutex> guard(m_methods_lock);
     for (const auto& method : m_methods)
     {
-        method.second.get()->RequestRejitForInlinersInModule(moduleId);
+        methodDefs.push_back(method.methodDef);
     }
 }
 
+void RejitHandlerModule::GetMethodReplacements(std::vector<mdMethodDef>&       methodDefs,
+                                               std::vector<MethodReplacement>& replacements)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+    for (const auto& method : m_methods)
+    {
+        if (method.methodReplacement != nullptr)
+        {
+            methodDefs.push_back(method.methodDef);
+            replacements.push_back(*method.methodReplacement);
+        }
+    }
+}
+
+void RejitHandlerModule::RemoveMethodsWithReplacements(const std::vector<MethodReplacement>& replacements,
+                                                       std::vector<mdMethodDef>&             methodDefs)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+    const auto                  removedBegin = methodDefs.size();
+    auto                        it           = std::remove_if(m_methods.begin(), m_methods.end(),
+                                         [&replacements, &methodDefs](const RejitHandlerModuleMethod& method) {
+                                             if (method.methodReplacement == nullptr ||
+                                                 std::find(replacements.begin(), replacements.end(),
+                                                           *method.methodReplacement) == replacements.end())
+                                             {
+                                                 return false;
+                                             }
+                                             methodDefs.push_back(method.methodDef);
+                                             return true;
+                                         });
+    m_methods.erase(it, m_methods.end());
+
+    // The methods instrumented again later must enumerate their inliners again.
+    for (auto removed = methodDefs.begin() + removedBegin; removed != methodDefs.end(); ++removed)
+    {
+        m_asyncMethods.erase(*removed);
+        for (auto& scanned : m_ngenScannedMethods)
+        {
+            auto scannedMethod = std::lower_bound(scanned.second.begin(), scanned.second.end(), *removed);
+            if (scannedMethod != scanned.second.end() && *scannedMethod == *removed)
+            {
+                scanned.second.erase(scannedMethod);
+            }
+        }
+    }
+}
+
+void RejitHandlerModule::GetInlinersInModule(ModuleID                  moduleId,
+                                             std::vector<ModuleID>&    modulesVector,
+                                             std::vector<mdMethodDef>& modulesMethodDef)
+{
+    ICorProfilerInfo7* pInfo = m_handler->GetCorProfilerInfo7();
+    if (pInfo == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+
+    // We check first if we already processed the methods in this module to skip them.
+    auto&      scanned      = m_ngenScannedMethods[moduleId];
+    const auto scannedCount = scanned.size();
+    for (const auto& method : m_methods)
+    {
+        if (std::binary_search(scanned.begin(), scanned.begin() + scannedCount, method.methodDef))
+        {
+            continue;
+        }
+
+        if (EnumerateNGenInliners(pInfo, moduleId, m_moduleId, method.methodDef, modulesVector, modulesMethodDef))
+        {
+            scanned.push_back(method.methodDef);
+        }
+    }
+    std::inplace_merge(scanned.begin(), scanned.begin() + scannedCount, scanned.end());
+}
+
+void RejitHandlerModule::RemoveNGenModule(ModuleID moduleId)
+{
+    std::lock_guard<std::mutex> guard(m_methods_lock);
+    m_ngenScannedMethods.erase(moduleId);
+}
+
 void RejitHandler::RequestRejitForInlinersInModule(ModuleID moduleId)
 {
-    std::lock_guard<std::mutex> guard(m_modules_lock);
-    for (const auto& mod : m_modules)
+    std::vector<ModuleID>    modules;
+    std::vector<mdMethodDef> methods;
+    {
+        std::lock_guard<std::mutex> guard(m_modules_lock);
+        for (const auto& mod : m_modules)
+        {
+            mod.second->GetInlinersInModule(moduleId, modules, methods);
+        }
+    }
+
+    // RequestRejit adds the inliners to the modules, it can't be called while they are locked.
+    if (!methods.empty())
     {
-        mod.second->RequestRejitForInlinersInModule(moduleId);
+        RequestRejit(modules, methods);
     }
 }
 
 RejitHandler::RejitHandler(ICorProfilerInfo7* pInfo,
-                           std::function<HRESULT(RejitHandlerModule*, RejitHandlerModuleMethod*)> rewriteCallback)
+                           std::function<HRESULT(RejitHandlerModule*, const RejitHandlerModuleMethod&,
+                                                 ICorProfilerFunctionControl*)> rewriteCallback)
 {
     m_profilerInfo7   = pInfo;
+    m_profilerInfo10  = nullptr;
     m_rewriteCallback = rewriteCallback;
 }
 
@@ -259,8 +345,36 @@ bool RejitHandler::TryGetModule(ModuleID moduleId, RejitHandlerModule** moduleHa
 
 void RejitHandler::RemoveModule(ModuleID moduleId)
 {
+    // Same lock order as AddNGenModule.
+    std::lock_guard<std::mutex> ngenGuard(m_ngenModules_lock);
+    m_ngenModules.erase(std::remove(m_ngenModules.begin(), m_ngenModules.end(), moduleId), m_ngenModules.end());
+
     std::lock_guard<std::mutex> guard(m_modules_lock);
     m_modules.erase(moduleId);
+
+    // The ModuleID of an unloaded module can be reused by a module loaded later, the methods must not
+    // consider its inliners as already processed.
+    for (const auto& mod : m_modules)
+    {
+        mod.second->RemoveNGenModule(moduleId);
+    }
+}
+
+const MethodReplacement* RejitHandler::InternMethodReplacement(const MethodReplacement& methodReplacement)
+{
+    std::lock_guard<std::mutex> guard(m_replacements_lock);
+
+    auto& replacements = m_replacements[methodReplacement.wrapper_method.type_name];
+    for (const auto& replacement : replacements)
+    {
+        if (*replacement == methodReplacement)
+        {
+            return replacement.get();
+        }
+    }
+
+    replacements.push_back(std::make_unique<MethodReplacement>(methodReplacement));
+    return replacements.back().get();
 }
 
 void RejitHandler::AddNGenModule(ModuleID moduleId)
@@ -270,6 +384,11 @@ void RejitHandler::AddNGenModule(ModuleID moduleId)
     RequestRejitForInlinersInModule(moduleId);
 }
 
+void RejitHandler::EnableRequestRejitWithInliners(ICorProfilerInfo10* pInfo10)
+{
+    m_profilerInfo10 = pInfo10;
+}
+
 void RejitHandler::RequestRejit(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef)
 {
     const size_t length = modulesMethodDef.size();
@@ -277,33 +396,106 @@ void RejitHandler::RequestRejit(std::vector<ModuleID>& modulesVector, std::vecto
     // Create module and methods metadata.
     for (size_t i = 0; i < length; i++)
     {
-        GetOrAddModule(modulesVector[i])->GetOrAddMethod(modulesMethodDef[i]);
+        GetOrAddModule(modulesVector[i])->AddMethod(modulesMethodDef[i]);
     }
 
-    // Even if ICorProfilerInfo10, or later, is available the code leverages the
-    // fact
-    // that this is a startup profiler so there is no need to handle an attach
-    // scenario.
-    // Instead of using RequestReJITWithInliners to handle inlined methods that
-    // are targeted
-    // for instrumentation the code uses the ICorProfilerCallback::JITInlining
-    // callback instead.
+    // When the profiler is loaded at startup, instead of using RequestReJITWithInliners
+    // to handle inlined methods that are targeted for instrumentation the code uses the
+    // ICorProfilerCallback::JITInlining callback instead.
     // On the callback the profiler blocks the inlining of any method targeted for
     // instrumentation.
-    HRESULT hr = m_profilerInfo7->RequestReJIT((ULONG)length, modulesVector.data(), modulesMethodDef.data());
+    // When the profiler is attached to a running process the methods may be already
+    // inlined, so RequestReJITWithInliners is used to also ReJIT their inliners.
+    HRESULT hr;
+    if (m_profilerInfo10 != nullptr)
+    {
+        hr = m_profilerInfo10->RequestReJITWithInliners(COR_PRF_REJIT_BLOCK_INLINING, (ULONG)length,
+                                                        modulesVector.data(), modulesMethodDef.data());
+    }
+    else
+    {
+        hr = m_profilerInfo7->RequestReJIT((ULONG)length, modulesVector.data(), modulesMethodDef.data());
+    }
     if (SUCCEEDED(hr))
     {
+        TelemetryRegion::Instance()->Add(TelemetryCounter::ReJitRequestedMethods, length);
         Logger::Info("Request ReJIT done for ", length, " methods");
     }
     else
     {
-        Logger::Warn("Error requesting ReJIT for ", length, " methods");
+        Logger::WarnRateLimited("RequestRejit", "Error requesting ReJIT for ", length, " methods");
+    }
+}
+
+void RejitHandler::RequestRevert(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef)
+{
+    const size_t length = modulesMethodDef.size();
+    if (length == 0)
+    {
+        return;
+    }
+
+    std::vector<HRESULT> status(length);
+    HRESULT              hr = m_profilerInfo7->RequestRevert((ULONG)length, modulesVector.data(),
+                                                modulesMethodDef.data(), status.data());
+    if (SUCCEEDED(hr))
+    {
+        TelemetryRegion::Instance()->Add(TelemetryCounter::ReJitRevertedMethods, length);
+        Logger::Info("Request Revert done for ", length, " methods");
+    }
+    else
+    {
+        Logger::WarnRateLimited("RequestRevert", "Error requesting Revert for ", length, " methods, HR=", HResultStr(hr),
+                                ", first method HR=", HResultStr(status[0]));
+    }
+}
+
+void RejitHandler::GetMethods(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef)
+{
+    std::lock_guard<std::mutex> guard(m_modules_lock);
+    for (const auto& mod : m_modules)
+    {
+        mod.second->GetMethodDefs(modulesMethodDef);
+        modulesVector.resize(modulesMethodDef.size(), mod.first);
+    }
+}
+
+void RejitHandler::GetMethodReplacements(std::vector<ModuleID>&          modulesVector,
+                                         std::vector<mdMethodDef>&       modulesMethodDef,
+                                         std::vector<MethodReplacement>& replacements)
+{
+    std::lock_guard<std::mutex> guard(m_modules_lock);
+    for (const auto& mod : m_modules)
+    {
+        mod.second->GetMethodReplacements(modulesMethodDef, replacements);
+        modulesVector.resize(modulesMethodDef.size(), mod.first);
+    }
+}
+
+void RejitHandler::RemoveMethodsWithReplacements(const std::vector<MethodReplacement>& replacements,
+                                                 std::vector<ModuleID>&                modulesVector,
+                                                 std::vector<mdMethodDef>&             modulesMethodDef)
+{
+    std::lock_guard<std::mutex> guard(m_modules_lock);
+    for (const auto& mod : m_modules)
+    {
+        mod.second->RemoveMethodsWithReplacements(replacements, modulesMethodDef);
+        modulesVector.resize(modulesMethodDef.size(), mod.first);
     }
 }
 
 void RejitHandler::Shutdown()
 {
     m_modules.clear();
+    {
+        std::lock_guard<std::mutex> guard(m_replacements_lock);
+        m_replacements.clear();
+    }
+    if (m_profilerInfo10 != nullptr)
+    {
+        m_profilerInfo10->Release();
+        m_profilerInfo10 = nullptr;
+    }
     m_profilerInfo7   = nullptr;
     m_rewriteCallback = nullptr;
 }
@@ -315,59 +507,58 @@ HRESULT RejitHandler::NotifyReJITParameters(ModuleID                     moduleI
 {
     auto moduleHandler = GetOrAddModule(moduleId);
     moduleHandler->SetModuleMetadata(metadata);
-    auto methodHandler = moduleHandler->GetOrAddMethod(methodId);
-    methodHandler->SetFunctionControl(pFunctionControl);
 
-    if (methodHandler->GetMethodDef() == mdMethodDefNil)
+    RejitHandlerModuleMethod methodHandler;
+    if (!moduleHandler->TryGetMethod(methodId, &methodHandler))
     {
-        Logger::Warn("NotifyReJITCompilationStarted: mdMethodDef is missing for "
-                     "MethodDef: ",
-                     methodId);
+        // The requested methods are always added first, the unknown ones were inlining them and are ReJITed by
+        // RequestReJITWithInliners with their original IL. They are recorded to be reverted with the instrumented
+        // methods.
+        moduleHandler->AddMethod(methodId);
+        Logger::Debug("NotifyReJITParameters: Inliner ReJITed [ModuleId=", moduleId, ", MethodDef=", methodId, "]");
         return S_FALSE;
     }
 
-    if (methodHandler->GetFunctionControl() == nullptr)
+    if (methodHandler.methodDef == mdMethodDefNil)
     {
-        Logger::Warn("NotifyReJITCompilationStarted: ICorProfilerFunctionControl is missing "
-                     "for "
-                     "MethodDef: ",
-                     methodId);
+        Logger::WarnRateLimited("NotifyReJITParameters.MethodDef",
+                                "NotifyReJITCompilationStarted: mdMethodDef is missing for MethodDef: ", methodId);
         return S_FALSE;
     }
 
-    if (methodHandler->GetFunctionInfo() == nullptr)
+    if (pFunctionControl == nullptr)
     {
-        Logger::Warn("NotifyReJITCompilationStarted: FunctionInfo is missing for "
-                     "MethodDef: ",
-                     methodId);
+        Logger::WarnRateLimited("NotifyReJITParameters.FunctionControl",
+                                "NotifyReJITCompilationStarted: ICorProfilerFunctionControl is missing for MethodDef: ",
+                                methodId);
         return S_FALSE;
     }
 
-    if (methodHandler->GetMethodReplacement() == nullptr)
+    if (methodHandler.methodReplacement == nullptr)
     {
-        Logger::Warn("NotifyReJITCompilationStarted: MethodReplacement is missing for "
-                     "MethodDef: ",
-                     methodId);
+        Logger::WarnRateLimited("NotifyReJITParameters.MethodReplacement",
+                                "NotifyReJITCompilationStarted: MethodReplacement is missing for MethodDef: ",
+                                methodId);
         return S_FALSE;
     }
 
     if (moduleHandler->GetModuleId() == 0)
     {
-        Logger::Warn("NotifyReJITCompilationStarted: ModuleID is missing for "
-                     "MethodDef: ",
-                     methodId);
+        Logger::WarnRateLimited("NotifyReJITParameters.ModuleID",
+                                "NotifyReJITCompilationStarted: ModuleID is missing for MethodDef: ", methodId);
         return S_FALSE;
     }
 
     if (moduleHandler->GetModuleMetadata() == nullptr)
     {
-        Logger::Warn("NotifyReJITCompilationStarted: ModuleMetadata is missing for "
-                     "MethodDef: ",
-                     methodId);
+        Logger::WarnRateLimited("NotifyReJITParameters.ModuleMetadata",
+                                "NotifyReJITCompilationStarted: ModuleMetadata is missing for MethodDef: ", methodId);
         return S_FALSE;
     }
 
-    return m_rewriteCallback(moduleHandler, methodHandler);
+    const auto hr = m_rewriteCallback(moduleHandler, methodHandler, pFunctionControl);
+    TelemetryRegion::Instance()->Add(hr == S_OK ? TelemetryCounter::RewriteSucceeded : TelemetryCounter::RewriteFailed);
+    return hr;
 }
 
 HRESULT RejitHandler::NotifyReJITCompilationStarted(FunctionID functionId, ReJITID rejitId)
@@ -7,11 +7,13 @@
 #define OTEL_CLR_PROFILER_REJIT_HANDLER_H_
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "calltarget_async.h"
 #include "cor.h"
 #include "corprof.h"
 #include "module_metadata.h"
@@ -20,40 +22,20 @@ namespace trace
 {
 
 // forward declarations...
-class RejitHandlerModule;
 class RejitHandler;
 
 /// <summary>
-/// Rejit handler representation of a method
+/// Rejit handler representation of a method, a compact record stored by value in the flat array of its module
 /// </summary>
-class RejitHandlerModuleMethod
+struct RejitHandlerModuleMethod
 {
-private:
-    mdMethodDef m_methodDef;
-    ICorProfilerFunctionControl* m_pFunctionControl;
-    std::unique_ptr<FunctionInfo> m_functionInfo;
-    std::unique_ptr<MethodReplacement> m_methodReplacement;
-
-    std::mutex m_ngenModulesLock;
-    std::unordered_map<ModuleID, bool> m_ngenModules;
-
-    RejitHandlerModule* m_module;
-
-public:
-    RejitHandlerModuleMethod(mdMethodDef methodDef, RejitHandlerModule* module);
-    mdMethodDef GetMethodDef();
-    RejitHandlerModule* GetModule();
-
-    ICorProfilerFunctionControl* GetFunctionControl();
-    void SetFunctionControl(ICorProfilerFunctionControl* pFunctionControl);
-
-    FunctionInfo* GetFunctionInfo();
-    void SetFunctionInfo(const FunctionInfo& functionInfo);
-
-    MethodReplacement* GetMethodReplacement();
-    void SetMethodReplacement(const MethodReplacement& methodReplacement);
-
-    void RequestRejitForInlinersInModule(ModuleID moduleId);
+    // Interned by the RejitHandler and shared by all the methods instrumented by the same integration, null for the
+    // inliners of the instrumented methods.
+    const MethodReplacement* methodReplacement = nullptr;
+    mdMethodDef methodDef = mdMethodDefNil;
+    // True for the parts of an async method instrumented through its state machine, see
+    // RejitHandlerModule::GetAsyncMethod.
+    bool isAsyncMethod = false;
 };
 
 /// <summary>
@@ -65,9 +47,20 @@ private:
     ModuleID m_moduleId;
     ModuleMetadata* m_metadata;
     std::mutex m_methods_lock;
-    std::unordered_map<mdMethodDef, std::unique_ptr<RejitHandlerModuleMethod>> m_methods;
+    // Sorted by methodDef.
+    std::vector<RejitHandlerModuleMethod> m_methods;
+    // The few async methods instrumented through their state machine, by kickoff and MoveNext methodDef.
+    std::unordered_map<mdMethodDef, std::shared_ptr<const CallTargetAsyncMethod>> m_asyncMethods;
+    // The methods whose original body was moved to a new method while the module was loading, the outlined method
+    // is kept when the instrumentation is removed.
+    std::unordered_map<mdMethodDef, mdMethodDef> m_outlinedMethods;
+    // Sorted methodDefs whose inliners were enumerated, by NGEN module.
+    std::unordered_map<ModuleID, std::vector<mdMethodDef>> m_ngenScannedMethods;
     RejitHandler* m_handler;
 
+    std::vector<RejitHandlerModuleMethod>::iterator FindMethod(mdMethodDef methodDef);
+    RejitHandlerModuleMethod& FindOrInsertMethod(mdMethodDef methodDef);
+
 public:
     RejitHandlerModule(ModuleID moduleId, RejitHandler* handler);
     ModuleID GetModuleId();
@@ -76,11 +69,26 @@ public:
     ModuleMetadata* GetModuleMetadata();
     void SetModuleMetadata(ModuleMetadata* metadata);
 
-    RejitHandlerModuleMethod* GetOrAddMethod(mdMethodDef methodDef);
-    bool TryGetMethod(mdMethodDef methodDef, RejitHandlerModuleMethod** methodHandler);
+    void AddMethod(mdMethodDef methodDef);
+    // SetMethod stores the integration instrumenting the method, and the part of the async method it is when
+    // asyncMethod is not null.
+    void SetMethod(mdMethodDef methodDef, const MethodReplacement& methodReplacement,
+                   const CallTargetAsyncMethod* asyncMethod = nullptr);
+    bool TryGetMethod(mdMethodDef methodDef, RejitHandlerModuleMethod* method);
+    std::shared_ptr<const CallTargetAsyncMethod> GetAsyncMethod(mdMethodDef methodDef);
+    // SetOutlinedMethod records the method defined with the original body of the method, see DefineOutlinedMethod.
+    void SetOutlinedMethod(mdMethodDef methodDef, mdMethodDef outlinedMethodDef);
+    // GetOutlinedMethod returns the method with the original body of the method, or mdMethodDefNil.
+    mdMethodDef GetOutlinedMethod(mdMethodDef methodDef);
     bool ContainsMethod(mdMethodDef methodDef);
-
-    void RequestRejitForInlinersInModule(ModuleID moduleId);
+    void GetMethodDefs(std::vector<mdMethodDef>& methodDefs);
+    void GetMethodReplacements(std::vector<mdMethodDef>& methodDefs, std::vector<MethodReplacement>& replacements);
+    void RemoveMethodsWithReplacements(const std::vector<MethodReplacement>& replacements,
+                                       std::vector<mdMethodDef>& methodDefs);
+
+    void GetInlinersInModule(ModuleID moduleId, std::vector<ModuleID>& modulesVector,
+                             std::vector<mdMethodDef>& modulesMethodDef);
+    void RemoveNGenModule(ModuleID moduleId);
 };
 
 /// <summary>
@@ -94,8 +102,14 @@ private:
     std::unordered_map<ModuleID, std::unique_ptr<RejitHandlerModule>> m_modules;
 
     ICorProfilerInfo7* m_profilerInfo7;
+    ICorProfilerInfo10* m_profilerInfo10;
+
+    // Method replacements shared by the instrumented methods, by wrapper type name.
+    std::mutex m_replacements_lock;
+    std::unordered_map<WSTRING, std::vector<std::unique_ptr<MethodReplacement>>> m_replacements;
 
-    std::function<HRESULT(RejitHandlerModule*, RejitHandlerModuleMethod*)> m_rewriteCallback;
+    std::function<HRESULT(RejitHandlerModule*, const RejitHandlerModuleMethod&, ICorProfilerFunctionControl*)>
+        m_rewriteCallback;
 
     std::mutex m_ngenModules_lock;
     std::vector<ModuleID> m_ngenModules;
@@ -104,19 +118,33 @@ private:
 
 public:
     RejitHandler(ICorProfilerInfo7* pInfo,
-                 std::function<HRESULT(RejitHandlerModule*, RejitHandlerModuleMethod*)> rewriteCallback);
+                 std::function<HRESULT(RejitHandlerModule*, const RejitHandlerModuleMethod&,
+                                       ICorProfilerFunctionControl*)> rewriteCallback);
 
     RejitHandlerModule* GetOrAddModule(ModuleID moduleId);
 
     bool TryGetModule(ModuleID moduleId, RejitHandlerModule** moduleHandler);
     void RemoveModule(ModuleID moduleId);
 
+    // InternMethodReplacement returns the shared copy of the method replacement, it lives until the shutdown.
+    const MethodReplacement* InternMethodReplacement(const MethodReplacement& methodReplacement);
+
     void AddNGenModule(ModuleID moduleId);
 
+    void EnableRequestRejitWithInliners(ICorProfilerInfo10* pInfo10);
+
     void RequestRejit(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef);
+    void RequestRevert(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef);
+    void GetMethods(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef);
+    void GetMethodReplacements(std::vector<ModuleID>& modulesVector, std::vector<mdMethodDef>& modulesMethodDef,
+                               std::vector<MethodReplacement>& replacements);
+    void RemoveMethodsWithReplacements(const std::vector<MethodReplacement>& replacements,
+                                       std::vector<ModuleID>& modulesVector,
+                                       std::vector<mdMethodDef>& modulesMethodDef);
 
     void Shutdown();
 
+    // NotifyReJITParameters rewrites the instrumented methods, and records the inliners ReJITed with them.
     HRESULT NotifyReJITParameters(ModuleID moduleId, mdMethodDef methodId,
                                   ICorProfilerFunctionControl* pFunctionControl, ModuleMetadata* metadata);
     HRESULT NotifyReJITCompilationStarted(FunctionID functionId, ReJITID rejitId);
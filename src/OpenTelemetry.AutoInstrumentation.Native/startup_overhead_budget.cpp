@@ -0,0 +1,93 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "startup_overhead_budget.h"
+
+#include "logger.h"
+
+namespace trace
+{
+
+const WSTRING low_priority_instrumentations_step_name = WStr("low_priority_instrumentations");
+const WSTRING ngen_inliners_step_name = WStr("ngen_inliners");
+const WSTRING all_instrumentations_step_name = WStr("all_instrumentations");
+
+std::vector<StartupDegradationStep> ParseStartupDegradationSteps(const std::vector<WSTRING>& names)
+{
+    std::vector<StartupDegradationStep> steps;
+    for (const auto& name : names)
+    {
+        if (name == low_priority_instrumentations_step_name)
+        {
+            steps.push_back(StartupDegradationStep::LowPriorityInstrumentations);
+        }
+        else if (name == ngen_inliners_step_name)
+        {
+            steps.push_back(StartupDegradationStep::NGenInliners);
+        }
+        else if (name == all_instrumentations_step_name)
+        {
+            steps.push_back(StartupDegradationStep::AllInstrumentations);
+        }
+        else
+        {
+            Logger::Warn("Unknown startup overhead degradation step: ", name);
+        }
+    }
+    return steps;
+}
+
+WSTRING GetStartupDegradationStepName(StartupDegradationStep step)
+{
+    switch (step)
+    {
+        case StartupDegradationStep::LowPriorityInstrumentations:
+            return low_priority_instrumentations_step_name;
+        case StartupDegradationStep::NGenInliners:
+            return ngen_inliners_step_name;
+        case StartupDegradationStep::AllInstrumentations:
+            return all_instrumentations_step_name;
+    }
+    return EmptyWStr;
+}
+
+StartupOverheadBudget::StartupOverheadBudget(unsigned long long budget_ns, std::vector<StartupDegradationStep> steps,
+                                             unsigned long long window_ns) :
+    budget_ns_(budget_ns), steps_(std::move(steps)), window_ns_(window_ns), next_threshold_ns_(budget_ns)
+{
+}
+
+bool StartupOverheadBudget::IsEnabled() const
+{
+    return budget_ns_ > 0 && !window_ended_ && applied_steps_ < steps_.size();
+}
+
+std::vector<StartupDegradationStep> StartupOverheadBudget::Consume(unsigned long long overhead_ns,
+                                                                   unsigned long long elapsed_ns)
+{
+    std::vector<StartupDegradationStep> steps;
+    if (!IsEnabled())
+    {
+        return steps;
+    }
+
+    if (window_ns_ > 0 && elapsed_ns > window_ns_)
+    {
+        window_ended_ = true;
+        Logger::Info("Startup overhead budget window ended after ", elapsed_ns / 1000000, "ms, with ",
+                     overhead_ns / 1000000, "ms of overhead.");
+        return steps;
+    }
+
+    // A single slow callback can exceed several thresholds at once, in that case all of them are applied.
+    while (applied_steps_ < steps_.size() && overhead_ns > next_threshold_ns_)
+    {
+        steps.push_back(steps_[applied_steps_++]);
+        next_threshold_ns_ += budget_ns_;
+    }
+    return steps;
+}
+
+} // namespace trace
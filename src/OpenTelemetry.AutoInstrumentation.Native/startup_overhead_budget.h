@@ -0,0 +1,64 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_STARTUP_OVERHEAD_BUDGET_H_
+#define OTEL_CLR_PROFILER_STARTUP_OVERHEAD_BUDGET_H_
+
+#include <vector>
+
+#include "string.h"
+
+namespace trace
+{
+
+// What the profiler stops doing when the startup overhead budget is exceeded.
+enum class StartupDegradationStep
+{
+    // Stop instrumenting the integrations configured as low priority.
+    LowPriorityInstrumentations,
+    // Stop scanning the NGEN images for the methods that inlined the instrumented ones.
+    NGenInliners,
+    // Stop instrumenting the modules loaded from now on.
+    AllInstrumentations
+};
+
+// ParseStartupDegradationSteps converts the configured step names, unknown names are logged and ignored.
+std::vector<StartupDegradationStep> ParseStartupDegradationSteps(const std::vector<WSTRING>& names);
+
+// GetStartupDegradationStepName returns the configuration name of a step.
+WSTRING GetStartupDegradationStepName(StartupDegradationStep step);
+
+// StartupOverheadBudget decides when the degradation steps have to be applied.
+// The first step is applied when the overhead exceeds the budget, every following step is applied each
+// time the overhead exceeds the budget again on top of the overhead at which the previous step was applied.
+// The budget only covers the startup window: once it is over, the overhead keeps growing with the modules loaded
+// by the application, and no step is applied anymore.
+class StartupOverheadBudget
+{
+private:
+    unsigned long long budget_ns_;
+    std::vector<StartupDegradationStep> steps_;
+    unsigned long long window_ns_;
+    size_t applied_steps_ = 0;
+    unsigned long long next_threshold_ns_;
+    bool window_ended_ = false;
+
+public:
+    // A window_ns of 0 makes the whole life of the process the startup window.
+    StartupOverheadBudget(unsigned long long budget_ns, std::vector<StartupDegradationStep> steps,
+                          unsigned long long window_ns = 0);
+
+    // IsEnabled returns false if there is no budget, the startup window is over or all the steps were already
+    // applied.
+    bool IsEnabled() const;
+
+    // Consume returns the steps that have to be applied for the given total overhead, measured elapsed_ns after
+    // the start of the process.
+    std::vector<StartupDegradationStep> Consume(unsigned long long overhead_ns, unsigned long long elapsed_ns);
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_STARTUP_OVERHEAD_BUDGET_H_
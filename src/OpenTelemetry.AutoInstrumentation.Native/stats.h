@@ -8,6 +8,7 @@
 
 #include <chrono>
 
+#include "telemetry_region.h"
 #include "util.h"
 
 namespace trace
@@ -16,18 +17,23 @@ namespace trace
 class SWStat
 {
     std::atomic_ullong* _value;
+    TelemetryHistogram _histogram;
     std::chrono::steady_clock::time_point _startTime;
 
 public:
-    SWStat(std::atomic_ullong* value)
+    SWStat(std::atomic_ullong* value, TelemetryHistogram histogram)
     {
         _value = value;
+        _histogram = histogram;
         _startTime = std::chrono::steady_clock::now();
     }
     ~SWStat()
     {
-        auto increment = (std::chrono::steady_clock::now() - _startTime).count();
+        auto increment = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                              _startTime)
+                             .count();
         _value->fetch_add(increment);
+        TelemetryRegion::Instance()->Record(_histogram, increment);
     }
 };
 
@@ -43,6 +49,7 @@ private:
     std::atomic_ullong jitCompilationStarted = {0};
     std::atomic_ullong moduleUnloadStarted = {0};
     std::atomic_ullong moduleLoadFinished = {0};
+    std::atomic_ullong moduleAnalysis = {0};
     std::atomic_ullong assemblyLoadFinished = {0};
     std::atomic_ullong initialize = {0};
 
@@ -54,6 +61,7 @@ private:
     std::atomic_uint jitCompilationStartedCount = {0};
     std::atomic_uint moduleUnloadStartedCount = {0};
     std::atomic_uint moduleLoadFinishedCount = {0};
+    std::atomic_uint moduleAnalysisCount = {0};
     std::atomic_uint assemblyLoadFinishedCount = {0};
 
 public:
@@ -65,6 +73,7 @@ public:
         jitCompilationStarted = 0;
         moduleUnloadStarted = 0;
         moduleLoadFinished = 0;
+        moduleAnalysis = 0;
         assemblyLoadFinished = 0;
         initialize = 0;
 
@@ -74,56 +83,70 @@ public:
         jitCompilationStartedCount = 0;
         moduleUnloadStartedCount = 0;
         moduleLoadFinishedCount = 0;
+        moduleAnalysisCount = 0;
         assemblyLoadFinishedCount = 0;
     }
     SWStat JITCachedFunctionSearchStartedMeasure()
     {
         jitCachedFunctionSearchStartedCount++;
-        return SWStat(&jitCachedFunctionSearchStarted);
+        return SWStat(&jitCachedFunctionSearchStarted, TelemetryHistogram::JitCachedFunctionSearchStarted);
     }
     SWStat CallTargetRequestRejitMeasure()
     {
         callTargetRequestRejitCount++;
-        return SWStat(&callTargetRequestRejit);
+        return SWStat(&callTargetRequestRejit, TelemetryHistogram::CallTargetRequestRejit);
     }
     SWStat CallTargetRewriterCallbackMeasure()
     {
         callTargetRewriterCount++;
-        return SWStat(&callTargetRewriter);
+        return SWStat(&callTargetRewriter, TelemetryHistogram::CallTargetRewriter);
     }
     SWStat JITInliningMeasure()
     {
         jitInliningCount++;
-        return SWStat(&jitInlining);
+        return SWStat(&jitInlining, TelemetryHistogram::JitInlining);
     }
     SWStat JITCompilationStartedMeasure()
     {
         jitCompilationStartedCount++;
-        return SWStat(&jitCompilationStarted);
+        return SWStat(&jitCompilationStarted, TelemetryHistogram::JitCompilationStarted);
     }
     SWStat ModuleUnloadStartedMeasure()
     {
         moduleUnloadStartedCount++;
-        return SWStat(&moduleUnloadStarted);
+        return SWStat(&moduleUnloadStarted, TelemetryHistogram::ModuleUnloadStarted);
     }
     SWStat ModuleLoadFinishedMeasure()
     {
         moduleLoadFinishedCount++;
-        return SWStat(&moduleLoadFinished);
+        return SWStat(&moduleLoadFinished, TelemetryHistogram::ModuleLoadFinished);
+    }
+    SWStat ModuleAnalysisMeasure()
+    {
+        moduleAnalysisCount++;
+        return SWStat(&moduleAnalysis, TelemetryHistogram::ModuleAnalysis);
     }
     SWStat AssemblyLoadFinishedMeasure()
     {
         assemblyLoadFinishedCount++;
-        return SWStat(&assemblyLoadFinished);
+        return SWStat(&assemblyLoadFinished, TelemetryHistogram::AssemblyLoadFinished);
     }
     SWStat InitializeMeasure()
     {
-        return SWStat(&initialize);
+        return SWStat(&initialize, TelemetryHistogram::Initialize);
+    }
+    // Time spent analyzing the modules and rewriting methods, the ReJIT requests made while loading
+    // a module are already accounted in ModuleLoadFinished, or in ModuleAnalysis when the module is
+    // analyzed by the module analysis pool.
+    unsigned long long StartupOverhead()
+    {
+        return moduleLoadFinished.load() + moduleAnalysis.load() + callTargetRewriter.load();
     }
     std::string ToString()
     {
         const auto ns_initialize = initialize.load();
         const auto ns_moduleLoadFinished = moduleLoadFinished.load();
+        const auto ns_moduleAnalysis = moduleAnalysis.load();
         const auto ns_callTargetRequestRejit = callTargetRequestRejit.load();
         const auto ns_callTargetRewriter = callTargetRewriter.load();
         const auto ns_assemblyLoadFinished = assemblyLoadFinished.load();
@@ -133,6 +156,7 @@ public:
         const auto ns_jitCachedFunctionSearchStarted = jitCachedFunctionSearchStarted.load();
 
         const auto count_moduleLoadFinishedCount = moduleLoadFinishedCount.load();
+        const auto count_moduleAnalysisCount = moduleAnalysisCount.load();
         const auto count_callTargetRequestRejitCount = callTargetRequestRejitCount.load();
         const auto count_callTargetRewriterCount = callTargetRewriterCount.load();
         const auto count_assemblyLoadFinishedCount = assemblyLoadFinishedCount.load();
@@ -141,9 +165,10 @@ public:
         const auto count_jitInliningCount = jitInliningCount.load();
         const auto count_jitCachedFunctionSearchStartedCount = jitCachedFunctionSearchStartedCount.load();
 
-        const auto ns_total = ns_initialize + ns_moduleLoadFinished + ns_callTargetRequestRejit +
-                              ns_callTargetRewriter + ns_assemblyLoadFinished + ns_moduleUnloadStarted +
-                              ns_jitCompilationStarted + ns_jitInlining + ns_jitCachedFunctionSearchStarted;
+        const auto ns_total = ns_initialize + ns_moduleLoadFinished + ns_moduleAnalysis +
+                              ns_callTargetRequestRejit + ns_callTargetRewriter + ns_assemblyLoadFinished +
+                              ns_moduleUnloadStarted + ns_jitCompilationStarted + ns_jitInlining +
+                              ns_jitCachedFunctionSearchStarted;
 
         std::stringstream ss;
         ss << "Total ";
@@ -153,6 +178,9 @@ public:
         ss << ", ModuleLoadFinished=";
         ss << ns_moduleLoadFinished / 1000000 << "ms"
            << "/" << count_moduleLoadFinishedCount;
+        ss << ", ModuleAnalysis=";
+        ss << ns_moduleAnalysis / 1000000 << "ms"
+           << "/" << count_moduleAnalysisCount;
         ss << ", CallTargetRequestRejit=";
         ss << ns_callTargetRequestRejit / 1000000 << "ms"
            << "/" << count_callTargetRequestRejitCount;
@@ -0,0 +1,277 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "telemetry_region.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "logger.h"
+#include "pal.h"
+
+namespace trace
+{
+
+const char* const telemetry_counter_names[TelemetryCounterCount] = {
+    "ReJitRequestedMethods",
+    "ReJitRevertedMethods",
+    "RewriteSucceeded",
+    "RewriteFailed",
+    "NGenFunctionsUsed",
+    "NGenFunctionsRejected",
+    "CallTargetInstantiations",
+    "CallTargetCompiledInstantiations",
+    "AssemblyReferenceCacheHits",
+    "AssemblyReferenceCacheMisses",
+    "LoggerErrors",
+    "LoggerSuppressedMessages",
+};
+
+const char* const telemetry_histogram_names[TelemetryHistogramCount] = {
+    "Initialize",
+    "ModuleLoadFinished",
+    "CallTargetRequestRejit",
+    "CallTargetRewriter",
+    "AssemblyLoadFinished",
+    "ModuleUnloadStarted",
+    "JitCompilationStarted",
+    "JitInlining",
+    "JitCachedFunctionSearchStarted",
+    "ModuleAnalysis",
+};
+
+uint32_t GetTelemetryHistogramBucket(uint64_t duration_ns)
+{
+    uint64_t duration_us = duration_ns / 1000;
+    uint32_t bucket      = 0;
+    while (duration_us > 0 && bucket < TelemetryHistogramBucketCount - 1)
+    {
+        duration_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+namespace
+{
+    void SetCostData(TelemetryCostData& data, const std::string& name, const CostEntry& entry)
+    {
+        memset(data.name, 0, TelemetryCostNameLength);
+        strncpy(data.name, name.c_str(), TelemetryCostNameLength - 1);
+        data.match_ns      = entry.match_ns;
+        data.match_count   = entry.match_count;
+        data.rejit_ns      = entry.rejit_ns;
+        data.rejit_count   = entry.rejit_count;
+        data.rewrite_ns    = entry.rewrite_ns;
+        data.rewrite_count = entry.rewrite_count;
+    }
+
+    void SetCostData(TelemetryCostData (&data)[TelemetryCostEntryCount],
+                     const std::vector<std::pair<WSTRING, CostEntry>>& costs)
+    {
+        for (uint32_t i = 0; i < TelemetryCostEntryCount; i++)
+        {
+            SetCostData(data[i], i < costs.size() ? ToString(costs[i].first) : std::string(),
+                        i < costs.size() ? costs[i].second : CostEntry());
+        }
+    }
+} // namespace
+
+WSTRING GetTelemetryRegionFilePath()
+{
+    const auto process_name = ToString(GetCurrentProcessName());
+    const auto file_name    = TracerLoggerPolicy::file_name + "-" +
+                           process_name.substr(0, process_name.find_last_of(".")) + "-" + std::to_string(GetPID()) +
+                           ".stats";
+    return GetLogDirectoryFilePath<TracerLoggerPolicy>(file_name);
+}
+
+TelemetryRegion::TelemetryRegion()
+{
+    layout_ = &local_;
+}
+
+TelemetryRegion::~TelemetryRegion()
+{
+    Close();
+}
+
+bool TelemetryRegion::Open(const WSTRING& path)
+{
+    // A closed region is not opened again, the profiler is shutting down.
+    if (mapped_ != nullptr)
+    {
+        return IsOpen();
+    }
+
+    try
+    {
+        const auto parent_path = std::filesystem::path(ToString(path)).parent_path();
+        if (!parent_path.empty() && !std::filesystem::exists(parent_path))
+        {
+            std::filesystem::create_directories(parent_path);
+        }
+    }
+    catch (...)
+    {
+        // The file can't be created without its directory, the error is logged below.
+    }
+
+    const auto size = sizeof(TelemetryRegionLayout);
+    void*      view = nullptr;
+#ifdef _WIN32
+    file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        Logger::Warn("The telemetry region file could not be created: ", path);
+        return false;
+    }
+
+    file_mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), nullptr);
+    if (file_mapping_ != nullptr)
+    {
+        view = MapViewOfFile(file_mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    }
+#else
+    file_ = open(ToString(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file_ < 0)
+    {
+        Logger::Warn("The telemetry region file could not be created: ", path);
+        return false;
+    }
+
+    if (ftruncate(file_, static_cast<off_t>(size)) == 0)
+    {
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+        if (view == MAP_FAILED)
+        {
+            view = nullptr;
+        }
+    }
+#endif
+
+    if (view == nullptr)
+    {
+        Logger::Warn("The telemetry region file could not be mapped: ", path);
+        Close();
+        return false;
+    }
+
+    // The file is new and zeroed: the values recorded so far are copied before the names and the header, which make
+    // the region readable.
+    mapped_ = static_cast<TelemetryRegionLayout*>(view);
+    for (uint32_t i = 0; i < TelemetryCounterCount; i++)
+    {
+        mapped_->counters[i].store(local_.counters[i].load());
+        strncpy(mapped_->counter_names[i], telemetry_counter_names[i], TelemetryNameLength - 1);
+    }
+    for (uint32_t i = 0; i < TelemetryHistogramCount; i++)
+    {
+        auto& histogram = mapped_->histograms[i];
+        histogram.count.store(local_.histograms[i].count.load());
+        histogram.sum_ns.store(local_.histograms[i].sum_ns.load());
+        for (uint32_t bucket = 0; bucket < TelemetryHistogramBucketCount; bucket++)
+        {
+            histogram.buckets[bucket].store(local_.histograms[i].buckets[bucket].load());
+        }
+        strncpy(mapped_->histogram_names[i], telemetry_histogram_names[i], TelemetryNameLength - 1);
+    }
+
+    auto& header            = mapped_->header;
+    header.version          = TelemetryRegionVersion;
+    header.size             = static_cast<uint32_t>(size);
+    header.counter_count    = TelemetryCounterCount;
+    header.histogram_count  = TelemetryHistogramCount;
+    header.bucket_count     = TelemetryHistogramBucketCount;
+    header.name_length      = TelemetryNameLength;
+    header.cost_entry_count = TelemetryCostEntryCount;
+    header.cost_name_length = TelemetryCostNameLength;
+    header.process_id       = static_cast<uint64_t>(GetPID());
+    header.start_time_ns    = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                      std::chrono::system_clock::now().time_since_epoch())
+                                                      .count());
+    header.state.store(static_cast<uint32_t>(TelemetryRegionState::Running));
+    std::atomic_thread_fence(std::memory_order_release);
+    header.magic = TelemetryRegionMagic;
+
+    // The increments made while the values were copied are lost, the region is opened during the initialization.
+    layout_.store(mapped_, std::memory_order_release);
+    Logger::Info("Telemetry region: ", path);
+    return true;
+}
+
+void TelemetryRegion::Close()
+{
+    if (mapped_ != nullptr)
+    {
+        mapped_->header.state.store(static_cast<uint32_t>(TelemetryRegionState::Exited));
+
+        // The values recorded from now on stay in the process, the mapped region is never released while the
+        // profiler callbacks may still use it.
+        layout_.store(&local_, std::memory_order_release);
+    }
+
+#ifdef _WIN32
+    if (file_mapping_ != nullptr)
+    {
+        CloseHandle(file_mapping_);
+        file_mapping_ = nullptr;
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(file_);
+        file_ = nullptr;
+    }
+#else
+    if (file_ >= 0)
+    {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+}
+
+bool TelemetryRegion::IsOpen() const
+{
+    return mapped_ != nullptr && layout_.load() == mapped_;
+}
+
+void TelemetryRegion::PublishCosts(const std::vector<std::pair<WSTRING, CostEntry>>& integrations,
+                                   const std::vector<std::pair<WSTRING, CostEntry>>& assemblies,
+                                   const CostEntry&                                  ngen_inliners)
+{
+    std::lock_guard<std::mutex> guard(cost_mutex_);
+    auto                        layout = layout_.load(std::memory_order_acquire);
+
+    layout->cost_sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    SetCostData(layout->cost_integrations, integrations);
+    SetCostData(layout->cost_assemblies, assemblies);
+    SetCostData(layout->cost_ngen_inliners, "NGenInliners", ngen_inliners);
+    layout->cost_sequence.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t TelemetryRegion::Get(TelemetryCounter counter) const
+{
+    return layout_.load(std::memory_order_acquire)->counters[static_cast<uint32_t>(counter)].load();
+}
+
+const TelemetryHistogramData& TelemetryRegion::Get(TelemetryHistogram histogram) const
+{
+    return layout_.load(std::memory_order_acquire)->histograms[static_cast<uint32_t>(histogram)];
+}
+
+} // namespace trace
@@ -0,0 +1,197 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_TELEMETRY_REGION_H_
+#define OTEL_CLR_PROFILER_TELEMETRY_REGION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cost_attribution.h"
+#include "string.h"
+#include "util.h"
+
+namespace trace
+{
+
+// "OTEL" read as a little-endian uint32.
+const uint32_t TelemetryRegionMagic = 0x4C45544F;
+// Incremented when the layout of the region changes, the readers must check it before reading anything else.
+// Version 2 added the LoggerSuppressedMessages counter and the ModuleAnalysis histogram, version 3 the cost
+// attribution report.
+const uint32_t TelemetryRegionVersion = 3;
+
+const uint32_t TelemetryNameLength = 32;
+// Bucket 0 counts the durations under 1us, bucket i the durations in [2^(i-1)us, 2^i us), the last bucket also
+// counts all the longer durations.
+const uint32_t TelemetryHistogramBucketCount = 24;
+// Number of integrations and assemblies of the published cost attribution report, and length of their names.
+const uint32_t TelemetryCostEntryCount = static_cast<uint32_t>(CostAttributionReportEntries);
+const uint32_t TelemetryCostNameLength = 128;
+
+enum class TelemetryCounter : uint32_t
+{
+    ReJitRequestedMethods,
+    ReJitRevertedMethods,
+    RewriteSucceeded,
+    RewriteFailed,
+    NGenFunctionsUsed,
+    NGenFunctionsRejected,
+    CallTargetInstantiations,
+    CallTargetCompiledInstantiations,
+    AssemblyReferenceCacheHits,
+    AssemblyReferenceCacheMisses,
+    LoggerErrors,
+    LoggerSuppressedMessages,
+    Count
+};
+
+// The durations of the profiler callbacks measured by Stats.
+enum class TelemetryHistogram : uint32_t
+{
+    Initialize,
+    ModuleLoadFinished,
+    CallTargetRequestRejit,
+    CallTargetRewriter,
+    AssemblyLoadFinished,
+    ModuleUnloadStarted,
+    JitCompilationStarted,
+    JitInlining,
+    JitCachedFunctionSearchStarted,
+    ModuleAnalysis,
+    Count
+};
+
+enum class TelemetryRegionState : uint32_t
+{
+    Running = 1,
+    Exited = 2
+};
+
+const uint32_t TelemetryCounterCount   = static_cast<uint32_t>(TelemetryCounter::Count);
+const uint32_t TelemetryHistogramCount = static_cast<uint32_t>(TelemetryHistogram::Count);
+
+static_assert(TelemetryCounterCount == 12 && TelemetryHistogramCount == 10 && TelemetryCostEntryCount == 20,
+              "The telemetry region layout changed, increment TelemetryRegionVersion and update these counts.");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+              "The telemetry region is read by other processes, its atomics must be plain lock-free integers.");
+
+struct TelemetryRegionHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    // Size of the whole region, in bytes.
+    uint32_t size;
+    uint32_t counter_count;
+    uint32_t histogram_count;
+    uint32_t bucket_count;
+    uint32_t name_length;
+    std::atomic<uint32_t> state;
+    uint32_t cost_entry_count;
+    uint32_t cost_name_length;
+    uint64_t process_id;
+    // Unix time, in nanoseconds, at which the profiler opened the region.
+    uint64_t start_time_ns;
+};
+
+struct TelemetryHistogramData
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> buckets[TelemetryHistogramBucketCount];
+};
+
+// Cost of an integration or an assembly, an empty name ends the list.
+struct TelemetryCostData
+{
+    char name[TelemetryCostNameLength];
+    uint64_t match_ns;
+    uint64_t match_count;
+    uint64_t rejit_ns;
+    uint64_t rejit_count;
+    uint64_t rewrite_ns;
+    uint64_t rewrite_count;
+};
+
+// Layout of the telemetry region: all the fields are little-endian and 8-byte aligned, the names are NUL-padded
+// ASCII strings in the order of the enums.
+struct TelemetryRegionLayout
+{
+    TelemetryRegionHeader header;
+    char counter_names[TelemetryCounterCount][TelemetryNameLength];
+    char histogram_names[TelemetryHistogramCount][TelemetryNameLength];
+    std::atomic<uint64_t> counters[TelemetryCounterCount];
+    TelemetryHistogramData histograms[TelemetryHistogramCount];
+    // Odd while the cost attribution report is written, the readers retry until it is even and unchanged.
+    std::atomic<uint64_t> cost_sequence;
+    TelemetryCostData cost_integrations[TelemetryCostEntryCount];
+    TelemetryCostData cost_assemblies[TelemetryCostEntryCount];
+    TelemetryCostData cost_ngen_inliners;
+};
+
+// GetTelemetryHistogramBucket returns the bucket of a duration.
+uint32_t GetTelemetryHistogramBucket(uint64_t duration_ns);
+
+// GetTelemetryRegionFilePath returns the path of the telemetry region of the process, next to its native log.
+WSTRING GetTelemetryRegionFilePath();
+
+// TelemetryRegion publishes the counters and histograms of the profiler in a memory-mapped file that external tools
+// can read while the process runs. The values are updated with relaxed atomic operations, without locks, and are
+// kept in the process until the file is opened.
+class TelemetryRegion : public Singleton<TelemetryRegion>
+{
+    friend class Singleton<TelemetryRegion>;
+
+private:
+    TelemetryRegionLayout local_{};
+    std::atomic<TelemetryRegionLayout*> layout_;
+    TelemetryRegionLayout* mapped_ = nullptr;
+    std::mutex cost_mutex_;
+#ifdef _WIN32
+    void* file_         = nullptr;
+    void* file_mapping_ = nullptr;
+#else
+    int file_ = -1;
+#endif
+
+    TelemetryRegion();
+    ~TelemetryRegion();
+
+public:
+    // Open maps the file and moves the values already recorded into it.
+    bool Open(const WSTRING& path);
+    // Close marks the region as exited, the file is kept with the last values.
+    void Close();
+    bool IsOpen() const;
+
+    void Add(TelemetryCounter counter, uint64_t value = 1)
+    {
+        layout_.load(std::memory_order_acquire)
+            ->counters[static_cast<uint32_t>(counter)]
+            .fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void Record(TelemetryHistogram histogram, uint64_t duration_ns)
+    {
+        auto& data = layout_.load(std::memory_order_acquire)->histograms[static_cast<uint32_t>(histogram)];
+        data.count.fetch_add(1, std::memory_order_relaxed);
+        data.sum_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+        data.buckets[GetTelemetryHistogramBucket(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // PublishCosts replaces the cost attribution report with the most expensive integrations and assemblies.
+    void PublishCosts(const std::vector<std::pair<WSTRING, CostEntry>>& integrations,
+                      const std::vector<std::pair<WSTRING, CostEntry>>& assemblies, const CostEntry& ngen_inliners);
+
+    uint64_t Get(TelemetryCounter counter) const;
+    const TelemetryHistogramData& Get(TelemetryHistogram histogram) const;
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_TELEMETRY_REGION_H_
@@ -0,0 +1,394 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "type_hierarchy_index.h"
+
+#include <algorithm>
+
+#include "clr_helpers.h"
+
+namespace trace
+{
+
+namespace
+{
+    // Supertypes of almost every type, they are not indexed to keep the subtypes lists short.
+    const WSTRING unindexed_supertypes[]{WStr("System.Object"), WStr("System.ValueType"), WStr("System.Enum"),
+                                         WStr("System.MulticastDelegate")};
+
+    WSTRING GetTypeName(const ComPtr<IMetaDataImport2>& metadata_import, mdToken token)
+    {
+        WCHAR   type_name[kNameMaxSize]{};
+        DWORD   type_name_len = 0;
+        HRESULT hr            = E_FAIL;
+
+        switch (TypeFromToken(token))
+        {
+            case mdtTypeDef:
+            {
+                DWORD   type_flags   = 0;
+                mdToken type_extends = mdTokenNil;
+                hr = metadata_import->GetTypeDefProps(token, type_name, kNameMaxSize, &type_name_len, &type_flags,
+                                                      &type_extends);
+                if (SUCCEEDED(hr) && IsTdNested(type_flags))
+                {
+                    mdTypeDef enclosing_type_def = mdTypeDefNil;
+                    if (SUCCEEDED(metadata_import->GetNestedClassProps(token, &enclosing_type_def)))
+                    {
+                        return GetTypeName(metadata_import, enclosing_type_def) + WStr("+") + WSTRING(type_name);
+                    }
+                }
+                break;
+            }
+            case mdtTypeRef:
+            {
+                mdToken resolution_scope = mdTokenNil;
+                hr = metadata_import->GetTypeRefProps(token, &resolution_scope, type_name, kNameMaxSize,
+                                                      &type_name_len);
+                if (SUCCEEDED(hr) && TypeFromToken(resolution_scope) == mdtTypeRef)
+                {
+                    return GetTypeName(metadata_import, resolution_scope) + WStr("+") + WSTRING(type_name);
+                }
+                break;
+            }
+            case mdtTypeSpec:
+            {
+                // Generic instantiations are indexed by their generic type definition.
+                PCCOR_SIGNATURE signature{};
+                ULONG           signature_length{};
+                hr = metadata_import->GetTypeSpecFromToken(token, &signature, &signature_length);
+                if (SUCCEEDED(hr) && signature_length >= 3 && signature[0] == ELEMENT_TYPE_GENERICINST)
+                {
+                    mdToken type_token = mdTokenNil;
+                    CorSigUncompressToken(&signature[2], &type_token);
+                    return GetTypeName(metadata_import, type_token);
+                }
+                return EmptyWStr;
+            }
+            default:
+                return EmptyWStr;
+        }
+
+        if (FAILED(hr) || type_name_len == 0)
+        {
+            return EmptyWStr;
+        }
+        return WSTRING(type_name);
+    }
+
+    void AddSupertypeName(const WSTRING& supertype_name, std::vector<WSTRING>& supertype_names)
+    {
+        if (supertype_name.empty())
+        {
+            return;
+        }
+        for (const auto& unindexed_supertype : unindexed_supertypes)
+        {
+            if (supertype_name == unindexed_supertype)
+            {
+                return;
+            }
+        }
+        supertype_names.push_back(supertype_name);
+    }
+} // namespace
+
+std::vector<TypeHierarchyEntry> GetTypeHierarchyEntries(const ComPtr<IMetaDataImport2>& metadata_import)
+{
+    std::vector<TypeHierarchyEntry> entries;
+    for (const auto type_def : EnumTypeDefs(metadata_import))
+    {
+        WCHAR   type_name[kNameMaxSize]{};
+        DWORD   type_name_len = 0;
+        DWORD   type_flags    = 0;
+        mdToken type_extends  = mdTokenNil;
+        if (FAILED(metadata_import->GetTypeDefProps(type_def, type_name, kNameMaxSize, &type_name_len, &type_flags,
+                                                    &type_extends)))
+        {
+            continue;
+        }
+
+        std::vector<WSTRING> supertype_names;
+        if (type_extends != mdTokenNil)
+        {
+            AddSupertypeName(GetTypeName(metadata_import, type_extends), supertype_names);
+        }
+        for (const auto interface_impl : EnumInterfaceImpls(metadata_import, type_def))
+        {
+            mdTypeDef class_token     = mdTypeDefNil;
+            mdToken   interface_token = mdTokenNil;
+            if (SUCCEEDED(metadata_import->GetInterfaceImplProps(interface_impl, &class_token, &interface_token)))
+            {
+                AddSupertypeName(GetTypeName(metadata_import, interface_token), supertype_names);
+            }
+        }
+
+        // A type without supertypes can't be a subtype of a target, it is only indexed as a supertype.
+        if (!supertype_names.empty())
+        {
+            entries.push_back({type_def, GetTypeName(metadata_import, type_def), std::move(supertype_names)});
+        }
+    }
+    return entries;
+}
+
+std::vector<TypeHierarchyMatch> TypeHierarchyIndex::SetTargets(
+    const std::vector<std::pair<WSTRING, WSTRING>>& targets)
+{
+    std::unordered_map<WSTRING, Target> new_targets;
+    for (const auto& assembly_and_type : targets)
+    {
+        const auto& type_name = assembly_and_type.second;
+        if (new_targets.find(type_name) != new_targets.end())
+        {
+            continue;
+        }
+
+        // The targets that are kept don't report again the subtypes already found.
+        auto existing_target = targets_.find(type_name);
+        if (existing_target != targets_.end() && existing_target->second.assembly_name == assembly_and_type.first)
+        {
+            new_targets.emplace(type_name, std::move(existing_target->second));
+            continue;
+        }
+
+        new_targets[type_name].assembly_name = assembly_and_type.first;
+    }
+    targets_ = std::move(new_targets);
+
+    std::vector<TypeHierarchyMatch> matches;
+    for (const auto& loaded_assembly : loaded_assemblies_)
+    {
+        ActivateTargets(loaded_assembly.first, matches);
+    }
+    return matches;
+}
+
+bool TypeHierarchyIndex::HasTargets() const
+{
+    return !targets_.empty();
+}
+
+std::vector<TypeHierarchyMatch> TypeHierarchyIndex::AddModule(ModuleID module_id, const WSTRING& assembly_name,
+                                                              const std::vector<TypeHierarchyEntry>& types)
+{
+    std::vector<TypeHierarchyMatch> matches;
+    if (module_assemblies_.find(module_id) != module_assemblies_.end())
+    {
+        return matches;
+    }
+
+    module_assemblies_[module_id] = assembly_name;
+    loaded_assemblies_[assembly_name]++;
+
+    auto& module_types = module_types_[module_id];
+    for (const auto& type : types)
+    {
+        module_types.push_back(type.type_name);
+        auto& definitions = definitions_[type.type_name];
+        definitions.push_back({module_id, type.type_def});
+
+        // The same type loaded by another module, e.g. in another AppDomain, is already linked to its supertypes.
+        if (definitions.size() == 1)
+        {
+            supertypes_[type.type_name] = type.supertype_names;
+            for (const auto& supertype_name : type.supertype_names)
+            {
+                subtypes_[supertype_name].push_back(type.type_name);
+            }
+        }
+    }
+
+    if (targets_.empty())
+    {
+        return matches;
+    }
+
+    // The targets of this assembly become active, all their indexed subtypes are reported at once.
+    const auto activated_targets = ActivateTargets(assembly_name, matches);
+
+    for (const auto& type : types)
+    {
+        for (const auto& target_type_name : FindTargetAncestors(type.type_name))
+        {
+            if (activated_targets.find(target_type_name) != activated_targets.end())
+            {
+                continue;
+            }
+
+            auto& target = targets_[target_type_name];
+            matches.push_back({target_type_name, module_id, type.type_def});
+
+            // The type was not linked to the target before, so neither were the subtypes already indexed.
+            if (target.matched_types.insert(type.type_name).second)
+            {
+                AddDefinitions(target_type_name, type.type_name, module_id, matches);
+                MatchSubtypes(target_type_name, target, type.type_name, module_id, matches);
+            }
+        }
+    }
+    return matches;
+}
+
+void TypeHierarchyIndex::RemoveModule(ModuleID module_id)
+{
+    auto module_types = module_types_.find(module_id);
+    if (module_types != module_types_.end())
+    {
+        for (const auto& type_name : module_types->second)
+        {
+            auto& definitions = definitions_[type_name];
+            definitions.erase(std::remove_if(definitions.begin(), definitions.end(),
+                                             [module_id](const TypeDefinition& definition) {
+                                                 return definition.module_id == module_id;
+                                             }),
+                              definitions.end());
+            if (!definitions.empty())
+            {
+                continue;
+            }
+            definitions_.erase(type_name);
+
+            // The subtypes of the type keep their own links, they are still valid if the type is loaded again.
+            for (const auto& supertype_name : supertypes_[type_name])
+            {
+                auto& subtypes = subtypes_[supertype_name];
+                subtypes.erase(std::remove(subtypes.begin(), subtypes.end(), type_name), subtypes.end());
+                if (subtypes.empty())
+                {
+                    subtypes_.erase(supertype_name);
+                }
+            }
+            supertypes_.erase(type_name);
+
+            for (auto& target : targets_)
+            {
+                target.second.matched_types.erase(type_name);
+            }
+        }
+        module_types_.erase(module_types);
+    }
+
+    auto module_assembly = module_assemblies_.find(module_id);
+    if (module_assembly != module_assemblies_.end())
+    {
+        auto loaded_assembly = loaded_assemblies_.find(module_assembly->second);
+        if (loaded_assembly != loaded_assemblies_.end() && --loaded_assembly->second == 0)
+        {
+            loaded_assemblies_.erase(loaded_assembly);
+        }
+        module_assemblies_.erase(module_assembly);
+    }
+}
+
+void TypeHierarchyIndex::Clear()
+{
+    supertypes_.clear();
+    subtypes_.clear();
+    definitions_.clear();
+    module_types_.clear();
+    module_assemblies_.clear();
+    loaded_assemblies_.clear();
+    targets_.clear();
+}
+
+std::unordered_set<WSTRING> TypeHierarchyIndex::ActivateTargets(const WSTRING&                   assembly_name,
+                                                                std::vector<TypeHierarchyMatch>& matches)
+{
+    std::unordered_set<WSTRING> activated_targets;
+    for (auto& target : targets_)
+    {
+        if (target.second.active || target.second.assembly_name != assembly_name)
+        {
+            continue;
+        }
+
+        target.second.active = true;
+        activated_targets.insert(target.first);
+        MatchSubtypes(target.first, target.second, target.first, 0, matches);
+    }
+    return activated_targets;
+}
+
+void TypeHierarchyIndex::AddDefinitions(const WSTRING& target_type_name, const WSTRING& type_name,
+                                        ModuleID skip_module_id, std::vector<TypeHierarchyMatch>& matches) const
+{
+    const auto definitions = definitions_.find(type_name);
+    if (definitions == definitions_.end())
+    {
+        return;
+    }
+
+    for (const auto& definition : definitions->second)
+    {
+        if (definition.module_id != skip_module_id)
+        {
+            matches.push_back({target_type_name, definition.module_id, definition.type_def});
+        }
+    }
+}
+
+void TypeHierarchyIndex::MatchSubtypes(const WSTRING& target_type_name, Target& target, const WSTRING& type_name,
+                                       ModuleID skip_module_id, std::vector<TypeHierarchyMatch>& matches)
+{
+    std::vector<WSTRING> pending_types{type_name};
+    while (!pending_types.empty())
+    {
+        const auto current_type_name = std::move(pending_types.back());
+        pending_types.pop_back();
+
+        const auto subtypes = subtypes_.find(current_type_name);
+        if (subtypes == subtypes_.end())
+        {
+            continue;
+        }
+
+        for (const auto& subtype_name : subtypes->second)
+        {
+            // The subtypes of an already matched type were matched with it.
+            if (target.matched_types.insert(subtype_name).second)
+            {
+                AddDefinitions(target_type_name, subtype_name, skip_module_id, matches);
+                pending_types.push_back(subtype_name);
+            }
+        }
+    }
+}
+
+std::vector<WSTRING> TypeHierarchyIndex::FindTargetAncestors(const WSTRING& type_name) const
+{
+    std::vector<WSTRING>        target_type_names;
+    std::unordered_set<WSTRING> visited_types;
+    std::vector<WSTRING>        pending_types{type_name};
+    while (!pending_types.empty())
+    {
+        const auto current_type_name = std::move(pending_types.back());
+        pending_types.pop_back();
+
+        const auto supertypes = supertypes_.find(current_type_name);
+        if (supertypes == supertypes_.end())
+        {
+            continue;
+        }
+
+        for (const auto& supertype_name : supertypes->second)
+        {
+            if (!visited_types.insert(supertype_name).second)
+            {
+                continue;
+            }
+
+            const auto target = targets_.find(supertype_name);
+            if (target != targets_.end() && target->second.active)
+            {
+                target_type_names.push_back(supertype_name);
+            }
+            pending_types.push_back(supertype_name);
+        }
+    }
+    return target_type_names;
+}
+
+} // namespace trace
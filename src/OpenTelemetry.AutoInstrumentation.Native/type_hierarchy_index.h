@@ -0,0 +1,104 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OTEL_CLR_PROFILER_TYPE_HIERARCHY_INDEX_H_
+#define OTEL_CLR_PROFILER_TYPE_HIERARCHY_INDEX_H_
+
+#include <corhlpr.h>
+#include <corprof.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "com_ptr.h"
+#include "integration.h"
+#include "string.h"
+
+namespace trace
+{
+
+// A type defined in a module with the names of its base type and of the interfaces it implements.
+// The names are the full names of the types, using '+' for the nested types and without the generic arguments.
+struct TypeHierarchyEntry
+{
+    mdTypeDef type_def;
+    WSTRING type_name;
+    std::vector<WSTRING> supertype_names;
+};
+
+// A type of a module that derives from, or implements, a target type.
+struct TypeHierarchyMatch
+{
+    WSTRING target_type_name;
+    ModuleID module_id;
+    mdTypeDef type_def;
+};
+
+// GetTypeHierarchyEntries reads the supertypes of all the types defined in a module.
+std::vector<TypeHierarchyEntry> GetTypeHierarchyEntries(const ComPtr<IMetaDataImport2>& metadata_import);
+
+// TypeHierarchyIndex keeps the base types and the interfaces of the types of the loaded modules, so the subtypes
+// of the derived and interface integration targets can be found across modules.
+// The types are indexed by name because the references to a supertype can go through a facade assembly that
+// forwards it, the assembly of a target is only used to know when the target type can be resolved.
+// Adding a module only walks the supertypes of its own types and the subtypes of the types that became
+// subtypes of a target, the cost does not depend on the number of types already indexed.
+// The index is not thread-safe, the profiler uses it under the modules lock.
+class TypeHierarchyIndex
+{
+private:
+    struct TypeDefinition
+    {
+        ModuleID module_id;
+        mdTypeDef type_def;
+    };
+
+    struct Target
+    {
+        WSTRING assembly_name;
+        bool active = false;
+        // Subtypes already reported, kept closed over the subtypes so a walk can stop at them.
+        std::unordered_set<WSTRING> matched_types;
+    };
+
+    std::unordered_map<WSTRING, std::vector<WSTRING>> supertypes_;
+    std::unordered_map<WSTRING, std::vector<WSTRING>> subtypes_;
+    std::unordered_map<WSTRING, std::vector<TypeDefinition>> definitions_;
+    std::unordered_map<ModuleID, std::vector<WSTRING>> module_types_;
+    std::unordered_map<ModuleID, WSTRING> module_assemblies_;
+    std::unordered_map<WSTRING, size_t> loaded_assemblies_;
+    std::unordered_map<WSTRING, Target> targets_;
+
+    std::unordered_set<WSTRING> ActivateTargets(const WSTRING& assembly_name,
+                                                std::vector<TypeHierarchyMatch>& matches);
+    void AddDefinitions(const WSTRING& target_type_name, const WSTRING& type_name, ModuleID skip_module_id,
+                        std::vector<TypeHierarchyMatch>& matches) const;
+    void MatchSubtypes(const WSTRING& target_type_name, Target& target, const WSTRING& type_name,
+                       ModuleID skip_module_id, std::vector<TypeHierarchyMatch>& matches);
+    std::vector<WSTRING> FindTargetAncestors(const WSTRING& type_name) const;
+
+public:
+    // SetTargets replaces the types whose subtypes are searched, given as (assembly name, type name) pairs.
+    // The subtypes of the new targets that are already indexed are returned.
+    std::vector<TypeHierarchyMatch> SetTargets(const std::vector<std::pair<WSTRING, WSTRING>>& targets);
+
+    // HasTargets returns false if there is no need to index the modules.
+    bool HasTargets() const;
+
+    // AddModule indexes the types of a loaded module and returns the types, of this or of the already indexed
+    // modules, that became subtypes of a target.
+    std::vector<TypeHierarchyMatch> AddModule(ModuleID module_id, const WSTRING& assembly_name,
+                                              const std::vector<TypeHierarchyEntry>& types);
+
+    // RemoveModule removes the types of an unloaded module.
+    void RemoveModule(ModuleID module_id);
+
+    // Clear removes all the indexed types and the targets.
+    void Clear();
+};
+
+} // namespace trace
+
+#endif // OTEL_CLR_PROFILER_TYPE_HIERARCHY_INDEX_H_
@@ -15,6 +15,7 @@
 // </copyright>
 
 using System.ComponentModel;
+using System.Diagnostics;
 using System.Runtime.CompilerServices;
 using OpenTelemetry.AutoInstrumentation.CallTarget.Handlers;
 
@@ -39,7 +40,25 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget>.Invoke(instance);
+            return BeginMethodHandler<TIntegration, TTarget>.Invoke(ref instance);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget>(ref TTarget instance)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget>.Invoke(ref instance);
         }
 
         return CallTargetState.GetDefault();
@@ -59,7 +78,47 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1>.Invoke(instance, arg1);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1>.Invoke(ref instance, ref arg1);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1>(ref TTarget instance, TArg1 arg1)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1>.Invoke(ref instance, ref arg1);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1>(ref TTarget instance, ref TArg1 arg1)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1>.Invoke(ref instance, ref arg1);
         }
 
         return CallTargetState.GetDefault();
@@ -81,7 +140,51 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2>.Invoke(instance, arg1, arg2);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2>.Invoke(ref instance, ref arg1, ref arg2);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2>(ref TTarget instance, TArg1 arg1, TArg2 arg2)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2>.Invoke(ref instance, ref arg1, ref arg2);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2>.Invoke(ref instance, ref arg1, ref arg2);
         }
 
         return CallTargetState.GetDefault();
@@ -105,7 +208,55 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3>.Invoke(instance, arg1, arg2, arg3);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3>.Invoke(ref instance, ref arg1, ref arg2, ref arg3);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3>.Invoke(ref instance, ref arg1, ref arg2, ref arg3);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3>.Invoke(ref instance, ref arg1, ref arg2, ref arg3);
         }
 
         return CallTargetState.GetDefault();
@@ -131,7 +282,59 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>.Invoke(instance, arg1, arg2, arg3, arg4);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <param name="arg4">Fourth argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <param name="arg4">Fourth argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4);
         }
 
         return CallTargetState.GetDefault();
@@ -159,7 +362,63 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>.Invoke(instance, arg1, arg2, arg3, arg4, arg5);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <param name="arg4">Fourth argument value</param>
+    /// <param name="arg5">Fifth argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <param name="arg4">Fourth argument value, passed by reference</param>
+    /// <param name="arg5">Fifth argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5);
         }
 
         return CallTargetState.GetDefault();
@@ -189,7 +448,67 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>.Invoke(instance, arg1, arg2, arg3, arg4, arg5, arg6);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <param name="arg4">Fourth argument value</param>
+    /// <param name="arg5">Fifth argument value</param>
+    /// <param name="arg6">Sixth argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5, TArg6 arg6)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <param name="arg4">Fourth argument value, passed by reference</param>
+    /// <param name="arg5">Fifth argument value, passed by reference</param>
+    /// <param name="arg6">Sixth argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5, ref TArg6 arg6)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6);
         }
 
         return CallTargetState.GetDefault();
@@ -221,7 +540,71 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>.Invoke(instance, arg1, arg2, arg3, arg4, arg5, arg6, arg7);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <typeparam name="TArg7">Seventh argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <param name="arg4">Fourth argument value</param>
+    /// <param name="arg5">Fifth argument value</param>
+    /// <param name="arg6">Sixth argument value</param>
+    /// <param name="arg7">Seventh argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5, TArg6 arg6, TArg7 arg7)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <typeparam name="TArg7">Seventh argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <param name="arg4">Fourth argument value, passed by reference</param>
+    /// <param name="arg5">Fifth argument value, passed by reference</param>
+    /// <param name="arg6">Sixth argument value, passed by reference</param>
+    /// <param name="arg7">Seventh argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5, ref TArg6 arg6, ref TArg7 arg7)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7);
         }
 
         return CallTargetState.GetDefault();
@@ -255,7 +638,75 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>.Invoke(instance, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8);
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7, ref arg8);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <typeparam name="TArg7">Seventh argument type</typeparam>
+    /// <typeparam name="TArg8">Eighth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arg1">First argument value</param>
+    /// <param name="arg2">Second argument value</param>
+    /// <param name="arg3">Third argument value</param>
+    /// <param name="arg4">Fourth argument value</param>
+    /// <param name="arg5">Fifth argument value</param>
+    /// <param name="arg6">Sixth argument value</param>
+    /// <param name="arg7">Seventh argument value</param>
+    /// <param name="arg8">Eighth argument value</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>(ref TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5, TArg6 arg6, TArg7 arg7, TArg8 arg8)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7, ref arg8);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker for the methods with by-ref or ref struct arguments
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TArg1">First argument type</typeparam>
+    /// <typeparam name="TArg2">Second argument type</typeparam>
+    /// <typeparam name="TArg3">Third argument type</typeparam>
+    /// <typeparam name="TArg4">Fourth argument type</typeparam>
+    /// <typeparam name="TArg5">Fifth argument type</typeparam>
+    /// <typeparam name="TArg6">Sixth argument type</typeparam>
+    /// <typeparam name="TArg7">Seventh argument type</typeparam>
+    /// <typeparam name="TArg8">Eighth argument type</typeparam>
+    /// <param name="instance">Instance value, passed by reference</param>
+    /// <param name="arg1">First argument value, passed by reference</param>
+    /// <param name="arg2">Second argument value, passed by reference</param>
+    /// <param name="arg3">Third argument value, passed by reference</param>
+    /// <param name="arg4">Fourth argument value, passed by reference</param>
+    /// <param name="arg5">Fifth argument value, passed by reference</param>
+    /// <param name="arg6">Sixth argument value, passed by reference</param>
+    /// <param name="arg7">Seventh argument value, passed by reference</param>
+    /// <param name="arg8">Eighth argument value, passed by reference</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5, ref TArg6 arg6, ref TArg7 arg7, ref TArg8 arg8)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TArg3, TArg4, TArg5, TArg6, TArg7, TArg8>.Invoke(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5, ref arg6, ref arg7, ref arg8);
         }
 
         return CallTargetState.GetDefault();
@@ -274,7 +725,26 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return BeginMethodSlowHandler<TIntegration, TTarget>.Invoke(instance, arguments);
+            return BeginMethodSlowHandler<TIntegration, TTarget>.Invoke(ref instance, arguments);
+        }
+
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// Begin Method Invoker Slow Path for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="arguments">Object arguments array</param>
+    /// <returns>Call target state</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetState BeginMethod<TIntegration, TTarget>(ref TTarget instance, object[] arguments)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return BeginMethodSlowHandler<TIntegration, TTarget>.Invoke(ref instance, arguments);
         }
 
         return CallTargetState.GetDefault();
@@ -294,7 +764,27 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return EndMethodHandler<TIntegration, TTarget>.Invoke(instance, exception, state);
+            return EndMethodHandler<TIntegration, TTarget>.Invoke(ref instance, exception, state);
+        }
+
+        return CallTargetReturn.GetDefault();
+    }
+
+    /// <summary>
+    /// End Method with Void return value invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="exception">Exception value</param>
+    /// <param name="state">CallTarget state</param>
+    /// <returns>CallTarget return structure</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetReturn EndMethod<TIntegration, TTarget>(ref TTarget instance, Exception exception, CallTargetState state)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return EndMethodHandler<TIntegration, TTarget>.Invoke(ref instance, exception, state);
         }
 
         return CallTargetReturn.GetDefault();
@@ -316,12 +806,93 @@ public static class CallTargetInvoker
     {
         if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
         {
-            return EndMethodHandler<TIntegration, TTarget, TReturn>.Invoke(instance, returnValue, exception, state);
+            return EndMethodHandler<TIntegration, TTarget, TReturn>.Invoke(ref instance, returnValue, exception, state);
+        }
+
+        return new CallTargetReturn<TReturn?>(returnValue);
+    }
+
+    /// <summary>
+    /// End Method with Return value invoker for the value types
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TReturn">Return type</typeparam>
+    /// <param name="instance">Instance value, passed by reference for the value types</param>
+    /// <param name="returnValue">Return value</param>
+    /// <param name="exception">Exception value</param>
+    /// <param name="state">CallTarget state</param>
+    /// <returns>CallTarget return structure</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static CallTargetReturn<TReturn?> EndMethod<TIntegration, TTarget, TReturn>(ref TTarget instance, TReturn returnValue, Exception exception, CallTargetState state)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return EndMethodHandler<TIntegration, TTarget, TReturn>.Invoke(ref instance, returnValue, exception, state);
         }
 
         return new CallTargetReturn<TReturn?>(returnValue);
     }
 
+    /// <summary>
+    /// Async Method started invoker, called by an async method instrumented through its state machine
+    /// once the state machine is started
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <param name="state">CallTarget state</param>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static void AsyncMethodStarted<TIntegration, TTarget>(CallTargetState state)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            // The state machine keeps the activity in its ExecutionContext, the caller gets back the previous one.
+            Activity.Current = state.PreviousActivity;
+        }
+    }
+
+    /// <summary>
+    /// End Async Method invoker, called by the state machine of an async method before it completes the task with a result
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TResult">Result type of the task, object for a task without result</typeparam>
+    /// <param name="result">Result of the task</param>
+    /// <param name="instance">Instance value</param>
+    /// <param name="state">CallTarget state</param>
+    /// <returns>Result of the task returned by the integration</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static TResult? EndAsyncMethod<TIntegration, TTarget, TResult>(TResult? result, TTarget instance, CallTargetState state)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            return EndAsyncMethodHandler<TIntegration, TTarget, TResult>.Invoke(instance, result, null, state);
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// End Async Method with exception invoker, called by the state machine of an async method before it completes the task with an exception
+    /// </summary>
+    /// <typeparam name="TIntegration">Integration type</typeparam>
+    /// <typeparam name="TTarget">Target type</typeparam>
+    /// <typeparam name="TResult">Result type of the task, object for a task without result</typeparam>
+    /// <param name="exception">Exception of the task</param>
+    /// <param name="instance">Instance value</param>
+    /// <param name="state">CallTarget state</param>
+    /// <returns>Exception of the task</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static Exception EndAsyncMethodWithException<TIntegration, TTarget, TResult>(Exception exception, TTarget instance, CallTargetState state)
+    {
+        if (IntegrationOptions<TIntegration, TTarget>.IsIntegrationEnabled)
+        {
+            EndAsyncMethodHandler<TIntegration, TTarget, TResult>.Invoke(instance, default, exception, state);
+        }
+
+        return exception;
+    }
+
     /// <summary>
     /// Log integration exception
     /// </summary>
@@ -0,0 +1,102 @@
+// <copyright file="CallTargetRefStruct.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.ComponentModel;
+
+#pragma warning disable CS8500 // This takes the address of, gets the size of, or declares a pointer to a managed type
+
+namespace OpenTelemetry.AutoInstrumentation.CallTarget;
+
+/// <summary>
+/// Ref struct argument (e.g. <see cref="Span{T}"/>) of an instrumented method.
+/// Ref structs can't be used as generic arguments, so the rewritten method passes the address of the argument instead.
+/// The argument lives in the stack of the instrumented method, it can only be accessed during the OnMethodBegin call.
+/// </summary>
+[Browsable(false)]
+[EditorBrowsable(EditorBrowsableState.Never)]
+public readonly unsafe struct CallTargetRefStruct
+{
+    private readonly void* _value;
+    private readonly RuntimeTypeHandle _typeHandle;
+
+    private CallTargetRefStruct(void* value, RuntimeTypeHandle typeHandle)
+    {
+        _value = value;
+        _typeHandle = typeHandle;
+    }
+
+    /// <summary>
+    /// Gets the type of the argument
+    /// </summary>
+    public Type? Type => Type.GetTypeFromHandle(_typeHandle);
+
+    /// <summary>
+    /// Creates a new instance of the <see cref="CallTargetRefStruct"/> struct.
+    /// </summary>
+    /// <param name="value">Address of the argument</param>
+    /// <param name="typeHandle">Type of the argument</param>
+    /// <returns>CallTargetRefStruct instance</returns>
+    public static CallTargetRefStruct Create(void* value, RuntimeTypeHandle typeHandle)
+    {
+        return new CallTargetRefStruct(value, typeHandle);
+    }
+
+    /// <summary>
+    /// Gets a reference to the argument as a <see cref="Span{T}"/>
+    /// </summary>
+    /// <typeparam name="T">Type of the span elements</typeparam>
+    /// <returns>Reference to the argument</returns>
+    public ref Span<T> AsSpan<T>()
+    {
+        EnsureType(typeof(Span<T>));
+        return ref *(Span<T>*)_value;
+    }
+
+    /// <summary>
+    /// Gets a reference to the argument as a <see cref="ReadOnlySpan{T}"/>
+    /// </summary>
+    /// <typeparam name="T">Type of the span elements</typeparam>
+    /// <returns>Reference to the argument</returns>
+    public ref ReadOnlySpan<T> AsReadOnlySpan<T>()
+    {
+        EnsureType(typeof(ReadOnlySpan<T>));
+        return ref *(ReadOnlySpan<T>*)_value;
+    }
+
+    internal static bool IsRefStruct(Type type)
+    {
+#if NETFRAMEWORK
+        // The span types of System.Memory are ref structs for the compilers, .NET Framework doesn't enforce them.
+        if (!type.IsGenericType)
+        {
+            return false;
+        }
+
+        var genericTypeDefinition = type.GetGenericTypeDefinition();
+        return genericTypeDefinition == typeof(Span<>) || genericTypeDefinition == typeof(ReadOnlySpan<>);
+#else
+        return type.IsByRefLike;
+#endif
+    }
+
+    private void EnsureType(Type type)
+    {
+        if (_value == null || !type.TypeHandle.Equals(_typeHandle))
+        {
+            throw new InvalidCastException($"The argument of type {Type} can't be accessed as {type}.");
+        }
+    }
+}
@@ -44,16 +44,16 @@ internal static class BeginMethodHandler<TIntegration, TTarget>
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = instance => CallTargetState.GetDefault();
+                _invokeDelegate = (ref TTarget instance) => CallTargetState.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetState InvokeDelegate(TTarget instance);
+    internal delegate CallTargetState InvokeDelegate(ref TTarget instance);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetState Invoke(TTarget instance)
+    internal static CallTargetState Invoke(ref TTarget instance)
     {
-        return new CallTargetState(Activity.Current, _invokeDelegate(instance));
+        return new CallTargetState(Activity.Current, _invokeDelegate(ref instance));
     }
 }
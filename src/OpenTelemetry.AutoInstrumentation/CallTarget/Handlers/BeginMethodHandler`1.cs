@@ -44,16 +44,16 @@ internal static class BeginMethodHandler<TIntegration, TTarget, TArg1>
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = (instance, arg1) => CallTargetState.GetDefault();
+                _invokeDelegate = (ref TTarget instance, ref TArg1 arg1) => CallTargetState.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetState InvokeDelegate(TTarget instance, TArg1 arg1);
+    internal delegate CallTargetState InvokeDelegate(ref TTarget instance, ref TArg1 arg1);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetState Invoke(TTarget instance, TArg1 arg1)
+    internal static CallTargetState Invoke(ref TTarget instance, ref TArg1 arg1)
     {
-        return new CallTargetState(Activity.Current, _invokeDelegate(instance, arg1));
+        return new CallTargetState(Activity.Current, _invokeDelegate(ref instance, ref arg1));
     }
 }
@@ -44,16 +44,16 @@ internal static class BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2>
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = (instance, arg1, arg2) => CallTargetState.GetDefault();
+                _invokeDelegate = (ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2) => CallTargetState.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetState InvokeDelegate(TTarget instance, TArg1 arg1, TArg2 arg2);
+    internal delegate CallTargetState InvokeDelegate(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetState Invoke(TTarget instance, TArg1 arg1, TArg2 arg2)
+    internal static CallTargetState Invoke(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2)
     {
-        return new CallTargetState(Activity.Current, _invokeDelegate(instance, arg1, arg2));
+        return new CallTargetState(Activity.Current, _invokeDelegate(ref instance, ref arg1, ref arg2));
     }
 }
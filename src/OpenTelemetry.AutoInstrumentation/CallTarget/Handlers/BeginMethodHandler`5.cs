@@ -44,16 +44,16 @@ internal static class BeginMethodHandler<TIntegration, TTarget, TArg1, TArg2, TA
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = (instance, arg1, arg2, arg3, arg4, arg5) => CallTargetState.GetDefault();
+                _invokeDelegate = (ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5) => CallTargetState.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetState InvokeDelegate(TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5);
+    internal delegate CallTargetState InvokeDelegate(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetState Invoke(TTarget instance, TArg1 arg1, TArg2 arg2, TArg3 arg3, TArg4 arg4, TArg5 arg5)
+    internal static CallTargetState Invoke(ref TTarget instance, ref TArg1 arg1, ref TArg2 arg2, ref TArg3 arg3, ref TArg4 arg4, ref TArg5 arg5)
     {
-        return new CallTargetState(Activity.Current, _invokeDelegate(instance, arg1, arg2, arg3, arg4, arg5));
+        return new CallTargetState(Activity.Current, _invokeDelegate(ref instance, ref arg1, ref arg2, ref arg3, ref arg4, ref arg5));
     }
 }
@@ -42,16 +42,16 @@ internal static class BeginMethodSlowHandler<TIntegration, TTarget>
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = (instance, arguments) => CallTargetState.GetDefault();
+                _invokeDelegate = (ref TTarget instance, object[] arguments) => CallTargetState.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetState InvokeDelegate(TTarget instance, object[] arguments);
+    internal delegate CallTargetState InvokeDelegate(ref TTarget instance, object[] arguments);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetState Invoke(TTarget instance, object[] arguments)
+    internal static CallTargetState Invoke(ref TTarget instance, object[] arguments)
     {
-        return new CallTargetState(Activity.Current, _invokeDelegate(instance, arguments));
+        return new CallTargetState(Activity.Current, _invokeDelegate(ref instance, arguments));
     }
 }
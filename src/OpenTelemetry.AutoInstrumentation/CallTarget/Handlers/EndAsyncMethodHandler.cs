@@ -0,0 +1,73 @@
+// <copyright file="EndAsyncMethodHandler.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Runtime.CompilerServices;
+
+namespace OpenTelemetry.AutoInstrumentation.CallTarget.Handlers;
+
+/// <summary>
+/// Calls the OnAsyncMethodEnd of an integration from the state machine of the instrumented async method,
+/// when the builder completes the returned task. Unlike the continuations of <see cref="EndMethodHandler{TIntegration, TTarget, TReturn}"/>
+/// it doesn't allocate a task or a state machine per call.
+/// </summary>
+/// <typeparam name="TIntegration">Integration type</typeparam>
+/// <typeparam name="TTarget">Target type</typeparam>
+/// <typeparam name="TResult">Result type of the task, object for a task without result</typeparam>
+internal static class EndAsyncMethodHandler<TIntegration, TTarget, TResult>
+{
+    private static readonly Func<TTarget, TResult?, Exception?, CallTargetState, TResult>? _continuation;
+
+    static EndAsyncMethodHandler()
+    {
+        try
+        {
+            var result = IntegrationMapper.CreateAsyncEndMethodDelegate(typeof(TIntegration), typeof(TTarget), typeof(TResult));
+            if (result.Method != null)
+            {
+                _continuation = (Func<TTarget, TResult?, Exception?, CallTargetState, TResult>)result.Method.CreateDelegate(typeof(Func<TTarget, TResult?, Exception?, CallTargetState, TResult>));
+            }
+        }
+        catch (Exception ex)
+        {
+            // The state machine calls the handler outside of any exception handler added by the profiler.
+            IntegrationOptions<TIntegration, TTarget>.LogException(new CallTargetInvokerException(ex));
+        }
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    internal static TResult? Invoke(TTarget instance, TResult? result, Exception? exception, CallTargetState state)
+    {
+        if (_continuation == null)
+        {
+            return result;
+        }
+
+        try
+        {
+            // *
+            // Calls the CallTarget integration continuation, exceptions here should never bubble up to the application
+            // *
+            var continuationResult = _continuation(instance, result, exception, state);
+            return exception == null ? continuationResult : result;
+        }
+        catch (Exception ex)
+        {
+            IntegrationOptions<TIntegration, TTarget>.LogException(ex, "Exception occurred when calling the CallTarget integration continuation.");
+        }
+
+        return result;
+    }
+}
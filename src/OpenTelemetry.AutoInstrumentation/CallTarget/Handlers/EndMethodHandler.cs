@@ -41,16 +41,16 @@ internal static class EndMethodHandler<TIntegration, TTarget>
         {
             if (_invokeDelegate is null)
             {
-                _invokeDelegate = (instance, exception, state) => CallTargetReturn.GetDefault();
+                _invokeDelegate = (ref TTarget instance, Exception exception, CallTargetState state) => CallTargetReturn.GetDefault();
             }
         }
     }
 
-    internal delegate CallTargetReturn InvokeDelegate(TTarget instance, Exception exception, CallTargetState state);
+    internal delegate CallTargetReturn InvokeDelegate(ref TTarget instance, Exception exception, CallTargetState state);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetReturn Invoke(TTarget instance, Exception exception, CallTargetState state)
+    internal static CallTargetReturn Invoke(ref TTarget instance, Exception exception, CallTargetState state)
     {
-        return _invokeDelegate(instance, exception, state);
+        return _invokeDelegate(ref instance, exception, state);
     }
 }
@@ -77,10 +77,10 @@ internal static class EndMethodHandler<TIntegration, TTarget, TReturn>
         }
     }
 
-    internal delegate CallTargetReturn<TReturn?> InvokeDelegate(TTarget instance, TReturn? returnValue, Exception exception, CallTargetState state);
+    internal delegate CallTargetReturn<TReturn?> InvokeDelegate(ref TTarget instance, TReturn? returnValue, Exception exception, CallTargetState state);
 
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
-    internal static CallTargetReturn<TReturn?> Invoke(TTarget instance, TReturn? returnValue, Exception exception, CallTargetState state)
+    internal static CallTargetReturn<TReturn?> Invoke(ref TTarget instance, TReturn? returnValue, Exception exception, CallTargetState state)
     {
         if (_continuationGenerator != null)
         {
@@ -93,7 +93,7 @@ internal static class EndMethodHandler<TIntegration, TTarget, TReturn>
 
         if (_invokeDelegate != null)
         {
-            CallTargetReturn<TReturn?> returnWrap = _invokeDelegate(instance, returnValue, exception, state);
+            CallTargetReturn<TReturn?> returnWrap = _invokeDelegate(ref instance, returnValue, exception, state);
             returnValue = returnWrap.GetReturnValue();
         }
 
@@ -16,6 +16,7 @@
 
 using System.Reflection;
 using System.Reflection.Emit;
+using System.Runtime.CompilerServices;
 using OpenTelemetry.AutoInstrumentation.DuckTyping;
 using OpenTelemetry.AutoInstrumentation.Logging;
 using OpenTelemetry.AutoInstrumentation.Util;
@@ -31,6 +32,7 @@ internal class IntegrationMapper
     private static readonly IOtelLogger Log = OtelLogging.GetLogger();
     private static readonly MethodInfo UnwrapReturnValueMethodInfo = typeof(IntegrationMapper).GetMethod(nameof(IntegrationMapper.UnwrapReturnValue), BindingFlags.NonPublic | BindingFlags.Static)!;
     private static readonly MethodInfo ConvertTypeMethodInfo = typeof(IntegrationMapper).GetMethod(nameof(IntegrationMapper.ConvertType), BindingFlags.NonPublic | BindingFlags.Static)!;
+    private static readonly MethodInfo ReadInstanceMethodInfo = typeof(IntegrationMapper).GetMethod(nameof(IntegrationMapper.ReadInstance), BindingFlags.NonPublic | BindingFlags.Static)!;
 
     internal static DynamicMethod? CreateBeginMethodDelegate(Type integrationType, Type targetType, Type[] argumentsTypes)
     {
@@ -40,11 +42,15 @@ internal class IntegrationMapper
          *      - CallTargetState OnMethodBegin<TTarget, TArg1>(TTarget instance, TArg1 arg1);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2>(TTarget instance, TArg1 arg1, TArg2);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(TTarget instance, TArg1 arg1, TArg2, ...);
+         *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(ref TTarget instance, TArg1 arg1, TArg2, ...);
+         *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(TTarget instance, ref TArg1 arg1, TArg2, ...);
          *      - CallTargetState OnMethodBegin<TTarget>();
          *      - CallTargetState OnMethodBegin<TTarget, TArg1>(TArg1 arg1);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2>(TArg1 arg1, TArg2);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(TArg1 arg1, TArg2, ...);
          *
+         * The arguments are received by reference, they are only copied for the parameters that are not by-ref.
+         * The ref struct arguments are received as a CallTargetRefStruct.
          */
 
         Log.Debug($"Creating BeginMethod Dynamic Method for '{integrationType.FullName}' integration. [Target={targetType.FullName}]");
@@ -74,7 +80,7 @@ internal class IntegrationMapper
         {
             throw new ArgumentException($"The method: {BeginMethodName} with {onMethodBeginParameters.Length} parameters in type: {integrationType.FullName} has more parameters than required.");
         }
-        else if (onMethodBeginParameters.Length != argumentsTypes.Length && onMethodBeginParameters[0].ParameterType != genericArgumentsTypes[0])
+        else if (onMethodBeginParameters.Length != argumentsTypes.Length && onMethodBeginParameters[0].ParameterType != genericArgumentsTypes[0] && onMethodBeginParameters[0].ParameterType != genericArgumentsTypes[0].MakeByRefType())
         {
             throw new ArgumentException($"The first generic argument for method: {BeginMethodName} in type: {integrationType.FullName} must be the same as the first parameter for the instance value.");
         }
@@ -99,7 +105,7 @@ internal class IntegrationMapper
         DynamicMethod callMethod = new DynamicMethod(
             $"{onMethodBeginMethodInfo.DeclaringType?.Name}.{onMethodBeginMethodInfo.Name}",
             typeof(CallTargetState),
-            new Type[] { targetType }.Concat(argumentsTypes),
+            new Type[] { targetType.MakeByRefType() }.Concat(argumentsTypes.Select(argumentType => argumentType.MakeByRefType()).ToArray()),
             onMethodBeginMethodInfo.Module,
             true);
 
@@ -108,12 +114,7 @@ internal class IntegrationMapper
         // Load the instance if is needed
         if (mustLoadInstance)
         {
-            ilWriter.Emit(OpCodes.Ldarg_0);
-
-            if (instanceGenericConstraint != null)
-            {
-                WriteCreateNewProxyInstance(ilWriter, instanceProxyType!, targetType);
-            }
+            WriteLoadInstance(ilWriter, onMethodBeginMethodInfo, onMethodBeginParameters[0].ParameterType, targetType, instanceProxyType, isByRefArgument: true);
         }
 
         // Load arguments
@@ -124,6 +125,12 @@ internal class IntegrationMapper
             Type? targetParameterTypeConstraint = null;
             Type? parameterProxyType = null;
 
+            bool isByRefParameter = targetParameterType.IsByRef;
+            if (isByRefParameter)
+            {
+                targetParameterType = targetParameterType.GetElementType()!;
+            }
+
             if (targetParameterType.IsGenericParameter)
             {
                 targetParameterType = genericArgumentsTypes[targetParameterType.GenericParameterPosition];
@@ -139,12 +146,23 @@ internal class IntegrationMapper
                     callGenericTypes.Add(parameterProxyType!);
                 }
             }
-            else if (!targetParameterType.IsAssignableFrom(sourceParameterType) && (!(sourceParameterType.IsEnum && targetParameterType.IsEnum)))
+            else if (isByRefParameter ? targetParameterType != sourceParameterType : !targetParameterType.IsAssignableFrom(sourceParameterType) && (!(sourceParameterType.IsEnum && targetParameterType.IsEnum)))
             {
                 throw new InvalidCastException($"The target parameter {targetParameterType} can't be assigned from {sourceParameterType}");
             }
 
             WriteLoadArgument(ilWriter, i, mustLoadInstance);
+            if (isByRefParameter)
+            {
+                if (parameterProxyType != null)
+                {
+                    throw new ArgumentException($"The parameter {i} of the method: {BeginMethodName} in type: {integrationType.FullName} can't be passed by reference with a duck type constraint.");
+                }
+
+                continue;
+            }
+
+            ilWriter.Emit(OpCodes.Ldobj, sourceParameterType);
             if (parameterProxyType != null)
             {
                 WriteCreateNewProxyInstance(ilWriter, parameterProxyType, sourceParameterType);
@@ -168,6 +186,7 @@ internal class IntegrationMapper
          *      - CallTargetState OnMethodBegin<TTarget, TArg1>(TTarget instance, TArg1 arg1);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2>(TTarget instance, TArg1 arg1, TArg2);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(TTarget instance, TArg1 arg1, TArg2, ...);
+         *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2, ...>(ref TTarget instance, TArg1 arg1, TArg2, ...);
          *      - CallTargetState OnMethodBegin<TTarget>();
          *      - CallTargetState OnMethodBegin<TTarget, TArg1>(TArg1 arg1);
          *      - CallTargetState OnMethodBegin<TTarget, TArg1, TArg2>(TArg1 arg1, TArg2);
@@ -197,7 +216,13 @@ internal class IntegrationMapper
 
         List<Type> callGenericTypes = new List<Type>();
 
-        bool mustLoadInstance = onMethodBeginParameters[0].ParameterType.IsGenericParameter && onMethodBeginParameters[0].ParameterType.GenericParameterPosition == 0;
+        Type firstParameterType = onMethodBeginParameters[0].ParameterType;
+        if (firstParameterType.IsByRef)
+        {
+            firstParameterType = firstParameterType.GetElementType()!;
+        }
+
+        bool mustLoadInstance = firstParameterType.IsGenericParameter && firstParameterType.GenericParameterPosition == 0;
         Type instanceGenericType = genericArgumentsTypes[0];
         Type? instanceGenericConstraint = instanceGenericType.GetGenericParameterConstraints().FirstOrDefault();
         Type? instanceProxyType = null;
@@ -215,7 +240,7 @@ internal class IntegrationMapper
         DynamicMethod callMethod = new DynamicMethod(
             $"{onMethodBeginMethodInfo.DeclaringType?.Name}.{onMethodBeginMethodInfo.Name}",
             typeof(CallTargetState),
-            new Type[] { targetType, typeof(object[]) },
+            new Type[] { targetType.MakeByRefType(), typeof(object[]) },
             onMethodBeginMethodInfo.Module,
             true);
 
@@ -224,12 +249,7 @@ internal class IntegrationMapper
         // Load the instance if is needed
         if (mustLoadInstance)
         {
-            ilWriter.Emit(OpCodes.Ldarg_0);
-
-            if (instanceGenericConstraint != null)
-            {
-                WriteCreateNewProxyInstance(ilWriter, instanceProxyType!, targetType);
-            }
+            WriteLoadInstance(ilWriter, onMethodBeginMethodInfo, onMethodBeginParameters[0].ParameterType, targetType, instanceProxyType, isByRefArgument: true);
         }
 
         // Load arguments
@@ -282,6 +302,7 @@ internal class IntegrationMapper
         /*
          * OnMethodEnd signatures with 2 or 3 parameters with 1 generics:
          *      - CallTargetReturn OnMethodEnd<TTarget>(TTarget instance, Exception exception, CallTargetState state);
+         *      - CallTargetReturn OnMethodEnd<TTarget>(ref TTarget instance, Exception exception, CallTargetState state);
          *      - CallTargetReturn OnMethodEnd<TTarget>(Exception exception, CallTargetState state);
          *
          */
@@ -344,7 +365,7 @@ internal class IntegrationMapper
         DynamicMethod callMethod = new DynamicMethod(
             $"{onMethodEndMethodInfo.DeclaringType?.Name}.{onMethodEndMethodInfo.Name}",
             typeof(CallTargetReturn),
-            new Type[] { targetType, typeof(Exception), typeof(CallTargetState) },
+            new Type[] { targetType.MakeByRefType(), typeof(Exception), typeof(CallTargetState) },
             onMethodEndMethodInfo.Module,
             true);
 
@@ -353,12 +374,7 @@ internal class IntegrationMapper
         // Load the instance if is needed
         if (mustLoadInstance)
         {
-            ilWriter.Emit(OpCodes.Ldarg_0);
-
-            if (instanceGenericConstraint != null)
-            {
-                WriteCreateNewProxyInstance(ilWriter, instanceProxyType!, targetType);
-            }
+            WriteLoadInstance(ilWriter, onMethodEndMethodInfo, onMethodEndParameters[0].ParameterType, targetType, instanceProxyType, isByRefArgument: true);
         }
 
         // Load the exception
@@ -382,6 +398,7 @@ internal class IntegrationMapper
         /*
          * OnMethodEnd signatures with 3 or 4 parameters with 1 or 2 generics:
          *      - CallTargetReturn<TReturn> OnMethodEnd<TTarget, TReturn>(TTarget instance, TReturn returnValue, Exception exception, CallTargetState state);
+         *      - CallTargetReturn<TReturn> OnMethodEnd<TTarget, TReturn>(ref TTarget instance, TReturn returnValue, Exception exception, CallTargetState state);
          *      - CallTargetReturn<TReturn> OnMethodEnd<TTarget, TReturn>(TReturn returnValue, Exception exception, CallTargetState state);
          *      - CallTargetReturn<[Type]> OnMethodEnd<TTarget>([Type] returnValue, Exception exception, CallTargetState state);
          *
@@ -470,7 +487,7 @@ internal class IntegrationMapper
         DynamicMethod callMethod = new DynamicMethod(
             $"{onMethodEndMethodInfo.DeclaringType?.Name}.{onMethodEndMethodInfo.Name}.{targetType.Name}.{returnType.Name}",
             typeof(CallTargetReturn<>).MakeGenericType(returnType),
-            new Type[] { targetType, returnType, typeof(Exception), typeof(CallTargetState) },
+            new Type[] { targetType.MakeByRefType(), returnType, typeof(Exception), typeof(CallTargetState) },
             onMethodEndMethodInfo.Module,
             true);
 
@@ -479,12 +496,7 @@ internal class IntegrationMapper
         // Load the instance if is needed
         if (mustLoadInstance)
         {
-            ilWriter.Emit(OpCodes.Ldarg_0);
-
-            if (instanceGenericConstraint != null)
-            {
-                WriteCreateNewProxyInstance(ilWriter, instanceProxyType!, targetType);
-            }
+            WriteLoadInstance(ilWriter, onMethodEndMethodInfo, onMethodEndParameters[0].ParameterType, targetType, instanceProxyType, isByRefArgument: true);
         }
 
         // Load the return value
@@ -625,12 +637,7 @@ internal class IntegrationMapper
         // Load the instance if is needed
         if (mustLoadInstance)
         {
-            ilWriter.Emit(OpCodes.Ldarg_0);
-
-            if (instanceGenericConstraint != null)
-            {
-                WriteCreateNewProxyInstance(ilWriter, instanceProxyType!, targetType);
-            }
+            WriteLoadInstance(ilWriter, onAsyncMethodEndMethodInfo, onAsyncMethodEndParameters[0].ParameterType, targetType, instanceProxyType, isByRefArgument: false);
         }
 
         // Load the return value
@@ -663,6 +670,40 @@ internal class IntegrationMapper
         return new CreateAsyncEndMethodResult(callMethod, preserveContext);
     }
 
+    private static void WriteLoadInstance(ILGenerator ilWriter, MethodInfo integrationMethod, Type instanceParameterType, Type targetType, Type? instanceProxyType, bool isByRefArgument)
+    {
+        // The instance of a value type is received by reference, it is only copied if the integration takes it by value.
+        if (instanceParameterType.IsByRef)
+        {
+            if (instanceProxyType != null)
+            {
+                throw new ArgumentException($"The instance parameter of the method: {integrationMethod.Name} in type: {integrationMethod.DeclaringType?.FullName} can't be passed by reference with a duck type constraint.");
+            }
+
+            if (isByRefArgument)
+            {
+                ilWriter.Emit(OpCodes.Ldarg_0);
+            }
+            else
+            {
+                ilWriter.Emit(OpCodes.Ldarga_S, (byte)0);
+            }
+
+            return;
+        }
+
+        ilWriter.Emit(OpCodes.Ldarg_0);
+        if (isByRefArgument)
+        {
+            ilWriter.EmitCall(OpCodes.Call, ReadInstanceMethodInfo.MakeGenericMethod(targetType), null);
+        }
+
+        if (instanceProxyType != null)
+        {
+            WriteCreateNewProxyInstance(ilWriter, instanceProxyType, targetType);
+        }
+    }
+
     private static void WriteCreateNewProxyInstance(ILGenerator ilWriter, Type proxyType, Type targetType)
     {
         ConstructorInfo proxyTypeCtor = proxyType.GetConstructors()[0];
@@ -745,6 +786,12 @@ internal class IntegrationMapper
         }
     }
 
+    private static T? ReadInstance<T>(ref T instance)
+    {
+        // The static methods pass a null reference as the instance.
+        return Unsafe.IsNullRef(ref instance) ? default : instance;
+    }
+
     private static T? ConvertType<T>(object value)
     {
         var conversionType = typeof(T);
@@ -0,0 +1,275 @@
+// <copyright file="InstrumentedMethodsWarmUp.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Diagnostics;
+using System.Reflection;
+using System.Runtime.CompilerServices;
+using OpenTelemetry.AutoInstrumentation.CallTarget.Handlers;
+using OpenTelemetry.AutoInstrumentation.Logging;
+
+namespace OpenTelemetry.AutoInstrumentation.CallTarget;
+
+/// <summary>
+/// Compiles, on a background thread, the methods rewritten by the bytecode instrumentation
+/// and initializes their CallTarget handlers, so that work is not done by the first call of each method.
+/// </summary>
+internal static class InstrumentedMethodsWarmUp
+{
+    // Same as FASTPATH_COUNT in the native profiler, above it the arguments are passed as an object array.
+    private const int FastPathArgumentsCount = 9;
+
+    // The list of instrumented methods grows while the application loads its assemblies,
+    // so it is polled until no new method is found for a while.
+    private const int PollingIntervalMilliseconds = 1000;
+    private const int MaxIdlePolls = 10;
+
+    private static readonly IOtelLogger Logger = OtelLogging.GetLogger();
+
+    private static readonly Type[] BeginMethodHandlerTypes =
+    {
+        typeof(BeginMethodHandler<,>),
+        typeof(BeginMethodHandler<,,>),
+        typeof(BeginMethodHandler<,,,>),
+        typeof(BeginMethodHandler<,,,,>),
+        typeof(BeginMethodHandler<,,,,,>),
+        typeof(BeginMethodHandler<,,,,,,>),
+        typeof(BeginMethodHandler<,,,,,,,>),
+        typeof(BeginMethodHandler<,,,,,,,,>),
+        typeof(BeginMethodHandler<,,,,,,,,,>),
+    };
+
+    private static int _started;
+    private static bool _canonicalArguments;
+
+    public static void Start(bool canonicalArguments)
+    {
+        if (Interlocked.Exchange(ref _started, value: 1) != 0)
+        {
+            return;
+        }
+
+        _canonicalArguments = canonicalArguments;
+
+        var thread = new Thread(Run)
+        {
+            Name = "OpenTelemetry instrumented methods warm-up",
+            IsBackground = true,
+            Priority = ThreadPriority.BelowNormal
+        };
+        thread.Start();
+    }
+
+    private static void Run()
+    {
+        try
+        {
+            var stopwatch = Stopwatch.StartNew();
+            var warmedUp = new HashSet<(Guid ModuleVersionId, int MethodDef)>();
+            var prepared = 0;
+            var idlePolls = 0;
+
+            while (idlePolls < MaxIdlePolls)
+            {
+                var count = NativeMethods.GetInstrumentedMethods(null, 0);
+                var methods = new NativeMethods.InstrumentedMethod[count];
+                count = Math.Min(count, NativeMethods.GetInstrumentedMethods(methods, methods.Length));
+
+                var modules = GetLoadedModules();
+                var found = false;
+                for (var i = 0; i < count; i++)
+                {
+                    // Methods of assemblies not loaded in this AppDomain are retried in the next polls.
+                    if (warmedUp.Contains((methods[i].ModuleVersionId, methods[i].MethodDef)) || !modules.TryGetValue(methods[i].ModuleVersionId, out var module))
+                    {
+                        continue;
+                    }
+
+                    warmedUp.Add((methods[i].ModuleVersionId, methods[i].MethodDef));
+                    found = true;
+                    if (WarmUp(module, methods[i]))
+                    {
+                        prepared++;
+                    }
+                }
+
+                idlePolls = found ? 0 : idlePolls + 1;
+                Thread.Sleep(PollingIntervalMilliseconds);
+            }
+
+            Logger.Information("Instrumented methods warm-up completed: {0} of {1} methods prepared in {2}ms.", prepared, warmedUp.Count, stopwatch.ElapsedMilliseconds);
+        }
+        catch (DllNotFoundException)
+        {
+            // The profiler is not attached.
+        }
+        catch (Exception ex)
+        {
+            Logger.Warning(ex, "Instrumented methods warm-up failed.");
+        }
+    }
+
+    private static Dictionary<Guid, Module> GetLoadedModules()
+    {
+        var modules = new Dictionary<Guid, Module>();
+        foreach (var assembly in AppDomain.CurrentDomain.GetAssemblies())
+        {
+            if (assembly.IsDynamic)
+            {
+                continue;
+            }
+
+            foreach (var module in assembly.GetModules())
+            {
+                modules[module.ModuleVersionId] = module;
+            }
+        }
+
+        return modules;
+    }
+
+    private static bool WarmUp(Module module, NativeMethods.InstrumentedMethod instrumentedMethod)
+    {
+        try
+        {
+            var method = module.ResolveMethod(instrumentedMethod.MethodDef);
+            if (method == null || method.IsAbstract || method.ContainsGenericParameters)
+            {
+                // The instantiations of generic methods are only known when they are called.
+                return false;
+            }
+
+            if (instrumentedMethod.IntegrationTypeDef != 0)
+            {
+                var integrationType = typeof(InstrumentedMethodsWarmUp).Module.ResolveType(instrumentedMethod.IntegrationTypeDef);
+                InitializeHandlers(integrationType, method, GetSelectedArguments(instrumentedMethod));
+            }
+            else if (instrumentedMethod.WrapperMethodDef != 0)
+            {
+                // The rewritten caller calls the call-site wrapper instead of the target method.
+                var wrapper = typeof(InstrumentedMethodsWarmUp).Module.ResolveMethod(instrumentedMethod.WrapperMethodDef);
+                if (wrapper != null && !wrapper.ContainsGenericParameters)
+                {
+                    RuntimeHelpers.PrepareMethod(wrapper.MethodHandle);
+                }
+            }
+
+            // Compiles the rewritten body, the CallTargetInvoker methods are inlined into it.
+            RuntimeHelpers.PrepareMethod(method.MethodHandle);
+            Logger.Debug("Instrumented method {0}.{1} warmed up.", method.DeclaringType?.FullName, method.Name);
+            return true;
+        }
+        catch (Exception ex)
+        {
+            Logger.Debug(ex, "Instrumented method 0x{0:X8} of {1} could not be warmed up.", instrumentedMethod.MethodDef, module.Name);
+            return false;
+        }
+    }
+
+    private static int[]? GetSelectedArguments(NativeMethods.InstrumentedMethod instrumentedMethod)
+    {
+        if (instrumentedMethod.SelectedArgumentCount < 0 || instrumentedMethod.SelectedArguments == null)
+        {
+            return null;
+        }
+
+        return instrumentedMethod.SelectedArguments.Take(instrumentedMethod.SelectedArgumentCount).ToArray();
+    }
+
+    private static void InitializeHandlers(Type integrationType, MethodBase method, int[]? selectedArguments)
+    {
+        // The same type arguments the rewritten method uses when calling CallTargetInvoker. When the integration
+        // selects the arguments, BeginMethod only receives those, always without an object array.
+        var targetType = method.DeclaringType!;
+        var parameterTypes = method.GetParameters().Select(p => p.ParameterType).ToArray();
+        if (selectedArguments != null)
+        {
+            parameterTypes = selectedArguments.Select(index => parameterTypes[index]).ToArray();
+        }
+
+        var argumentTypes = parameterTypes.Select(GetCallTargetArgumentType).ToArray();
+        if (argumentTypes.Any(t => t.IsPointer))
+        {
+            return;
+        }
+
+        RunClassConstructor(typeof(IntegrationOptions<,>).MakeGenericType(integrationType, targetType));
+
+        if (selectedArguments == null && argumentTypes.Length >= FastPathArgumentsCount)
+        {
+            RunClassConstructor(typeof(BeginMethodSlowHandler<,>).MakeGenericType(integrationType, targetType));
+        }
+        else
+        {
+            if (_canonicalArguments && !parameterTypes.Any(t => t.IsByRef || CallTargetRefStruct.IsRefStruct(t)))
+            {
+                SetCanonicalArgumentTypes(integrationType, argumentTypes);
+            }
+
+            var typeArguments = new[] { integrationType, targetType }.Concat(argumentTypes).ToArray();
+            RunClassConstructor(BeginMethodHandlerTypes[argumentTypes.Length].MakeGenericType(typeArguments));
+        }
+
+        var returnType = (method as MethodInfo)?.ReturnType ?? typeof(void);
+        if (returnType == typeof(void))
+        {
+            RunClassConstructor(typeof(EndMethodHandler<,>).MakeGenericType(integrationType, targetType));
+        }
+        else if (!returnType.IsByRef && !returnType.IsPointer)
+        {
+            RunClassConstructor(typeof(EndMethodHandler<,,>).MakeGenericType(integrationType, targetType, returnType));
+        }
+    }
+
+    private static Type GetCallTargetArgumentType(Type parameterType)
+    {
+        // By-ref arguments are passed with their element type, the ref structs as a CallTargetRefStruct.
+        var argumentType = parameterType.IsByRef ? parameterType.GetElementType()! : parameterType;
+        return CallTargetRefStruct.IsRefStruct(argumentType) ? typeof(CallTargetRefStruct) : argumentType;
+    }
+
+    private static void SetCanonicalArgumentTypes(Type integrationType, Type[] argumentTypes)
+    {
+        // Same rule as the native profiler: the value-type arguments that OnMethodBegin receives as object,
+        // or all of them if there is no OnMethodBegin, are passed as object.
+        var beginMethodParameters = integrationType.GetMethod("OnMethodBegin", BindingFlags.Public | BindingFlags.NonPublic | BindingFlags.Static)?.GetParameters();
+        var firstParameter = beginMethodParameters?.Length == argumentTypes.Length + 1 ? 1 : 0;
+        if (beginMethodParameters != null && beginMethodParameters.Length - firstParameter != argumentTypes.Length)
+        {
+            return;
+        }
+
+        for (var i = 0; i < argumentTypes.Length; i++)
+        {
+            if (argumentTypes[i].IsValueType && (beginMethodParameters == null || beginMethodParameters[firstParameter + i].ParameterType == typeof(object)))
+            {
+                argumentTypes[i] = typeof(object);
+            }
+        }
+    }
+
+    private static void RunClassConstructor(Type type)
+    {
+        try
+        {
+            RuntimeHelpers.RunClassConstructor(type.TypeHandle);
+        }
+        catch (TypeInitializationException ex)
+        {
+            // The same failure is reported by the instrumented method when it is called.
+            Logger.Debug(ex, "CallTarget handler {0} could not be initialized.", type);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+// <copyright file="MethodMetrics.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.ComponentModel;
+using System.Diagnostics;
+using System.Runtime.CompilerServices;
+using OpenTelemetry.AutoInstrumentation.Logging;
+
+namespace OpenTelemetry.AutoInstrumentation.CallTarget;
+
+/// <summary>
+/// Calls written by the native profiler in the methods of the MethodMetrics integrations.
+/// </summary>
+[Browsable(false)]
+[EditorBrowsable(EditorBrowsableState.Never)]
+public static class MethodMetrics
+{
+    private static readonly IOtelLogger Logger = OtelLogging.GetLogger();
+    private static readonly double NanosecondsPerTimestampTick = 1_000_000_000.0 / Stopwatch.Frequency;
+
+    private static bool _disabled;
+
+#if NET6_0_OR_GREATER
+    // The first access to the native thread-local storage can allocate and take the loader lock on Linux, it must be
+    // done by RecordMethodDuration and not by TryRecordMethodDuration, which is called without a GC transition.
+    [ThreadStatic]
+    private static bool _threadRecorded;
+#endif
+
+    /// <summary>
+    /// Returns the start timestamp of a method.
+    /// </summary>
+    /// <returns>Start timestamp</returns>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public static long Begin()
+    {
+        return Stopwatch.GetTimestamp();
+    }
+
+    /// <summary>
+    /// Records a call of a method in the native method metrics.
+    /// </summary>
+    /// <param name="methodId">Id of the method in the native method metrics</param>
+    /// <param name="startTimestamp">Start timestamp returned by <see cref="Begin"/></param>
+    public static void End(int methodId, long startTimestamp)
+    {
+        var elapsed = Stopwatch.GetTimestamp() - startTimestamp;
+        if (_disabled)
+        {
+            return;
+        }
+
+        try
+        {
+            var durationNanoseconds = (long)(elapsed * NanosecondsPerTimestampTick);
+#if NET6_0_OR_GREATER
+            // Only the first call of a method on a thread allocates its histogram, with a GC transition.
+            if (_threadRecorded && NativeMethods.TryRecordMethodDuration(methodId, durationNanoseconds))
+            {
+                return;
+            }
+
+#endif
+            NativeMethods.RecordMethodDuration(methodId, durationNanoseconds);
+#if NET6_0_OR_GREATER
+            _threadRecorded = true;
+#endif
+        }
+        catch (Exception ex)
+        {
+            // The native profiler is not loaded by the process, nothing can be recorded.
+            _disabled = true;
+            Logger.Error(ex, "The method metrics could not be recorded.");
+        }
+    }
+}
@@ -0,0 +1,117 @@
+// <copyright file="MethodMetricsMeter.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Collections.Concurrent;
+using System.Diagnostics.Metrics;
+using System.Globalization;
+
+namespace OpenTelemetry.AutoInstrumentation.CallTarget;
+
+/// <summary>
+/// Exports the calls and durations recorded by the native profiler for the methods of the MethodMetrics integrations.
+/// The native histograms are cumulative, so they are observed as counters tagged with the method name; the buckets
+/// use the Prometheus convention of cumulative counts tagged with their upper bound, in seconds. There is no observable
+/// histogram instrument, the exporters see each bucket as its own counter series and not as an OpenTelemetry histogram.
+/// </summary>
+internal static class MethodMetricsMeter
+{
+    public const string MeterName = "OpenTelemetry.AutoInstrumentation.MethodMetrics";
+
+    private const string MethodTag = "method";
+    private const string BucketUpperBoundTag = "le";
+
+    private static readonly Meter Meter = new(MeterName);
+    private static readonly ConcurrentDictionary<int, string> MethodNames = new();
+
+    private static int _initialized;
+    private static bool _disabled;
+
+    public static void Initialize()
+    {
+        if (Interlocked.Exchange(ref _initialized, value: 1) != 0)
+        {
+            return;
+        }
+
+        Meter.CreateObservableCounter("method.calls", ObserveCalls, unit: "{call}", description: "Number of calls of the method.");
+        Meter.CreateObservableCounter("method.duration", ObserveDurations, unit: "s", description: "Total duration of the calls of the method.");
+        Meter.CreateObservableCounter("method.duration.bucket", ObserveBuckets, unit: "{call}", description: "Number of calls of the method up to the duration bound.");
+    }
+
+    private static IEnumerable<Measurement<long>> ObserveCalls()
+    {
+        foreach (var metric in GetMethodMetrics())
+        {
+            yield return new Measurement<long>(metric.Count, new KeyValuePair<string, object?>(MethodTag, GetMethodName(metric.MethodId)));
+        }
+    }
+
+    private static IEnumerable<Measurement<double>> ObserveDurations()
+    {
+        foreach (var metric in GetMethodMetrics())
+        {
+            yield return new Measurement<double>(metric.SumNanoseconds / 1e9, new KeyValuePair<string, object?>(MethodTag, GetMethodName(metric.MethodId)));
+        }
+    }
+
+    private static IEnumerable<Measurement<long>> ObserveBuckets()
+    {
+        foreach (var metric in GetMethodMetrics())
+        {
+            if (metric.Buckets == null)
+            {
+                continue;
+            }
+
+            var method = new KeyValuePair<string, object?>(MethodTag, GetMethodName(metric.MethodId));
+            var count = 0L;
+            for (var bucket = 0; bucket < metric.BucketCount && bucket < metric.Buckets.Length; bucket++)
+            {
+                // Bucket 0 counts the durations under 1us, bucket i the durations under 2^i us, the last one all the others.
+                count += metric.Buckets[bucket];
+                var upperBound = bucket == metric.BucketCount - 1 ? "+Inf" : ((1L << bucket) / 1e6).ToString("R", CultureInfo.InvariantCulture);
+                yield return new Measurement<long>(count, method, new KeyValuePair<string, object?>(BucketUpperBoundTag, upperBound));
+            }
+        }
+    }
+
+    private static NativeMethods.MethodMetric[] GetMethodMetrics()
+    {
+        if (_disabled)
+        {
+            return Array.Empty<NativeMethods.MethodMetric>();
+        }
+
+        try
+        {
+            // More methods can be called between the two calls, the next collection reports them.
+            var metrics = new NativeMethods.MethodMetric[NativeMethods.GetMethodMetrics(null, 0)];
+            var count = NativeMethods.GetMethodMetrics(metrics, metrics.Length);
+            return count >= metrics.Length ? metrics : metrics.Take(count).ToArray();
+        }
+        catch (Exception)
+        {
+            // The native profiler is not loaded by the process, no method is recorded.
+            _disabled = true;
+            return Array.Empty<NativeMethods.MethodMetric>();
+        }
+    }
+
+    private static string GetMethodName(int methodId)
+    {
+        return MethodNames.GetOrAdd(methodId, id => NativeMethods.GetMethodMetricName(id));
+    }
+}
@@ -45,6 +45,23 @@ internal static class ConfigurationKeys
     /// </summary>
     public const string FlushOnUnhandledException = "OTEL_DOTNET_AUTO_FLUSH_ON_UNHANDLEDEXCEPTION";
 
+    /// <summary>
+    /// Configuration key for enabling the background warm-up of the methods rewritten by the bytecode instrumentation.
+    /// </summary>
+    public const string InstrumentedMethodsWarmUpEnabled = "OTEL_DOTNET_AUTO_INSTRUMENTED_METHODS_WARMUP_ENABLED";
+
+    /// <summary>
+    /// Configuration key for the file polled for the commands controlling the .NET CLR Profiler
+    /// in a running process, e.g. <c>detach-profiler</c>.
+    /// </summary>
+    public const string ControlFile = "OTEL_DOTNET_AUTO_CONTROL_FILE";
+
+    /// <summary>
+    /// Configuration key for how the bytecode instrumentation passes the value-type arguments to the CallTarget handlers.
+    /// Default is <c>"typed"</c>.
+    /// </summary>
+    public const string CallTargetInstantiationPolicy = "OTEL_DOTNET_AUTO_CALLTARGET_INSTANTIATION_POLICY";
+
     /// <summary>
     /// Configuration key for colon (:) separated list of plugins represented by <see cref="System.Type.AssemblyQualifiedName"/>.
     /// </summary>
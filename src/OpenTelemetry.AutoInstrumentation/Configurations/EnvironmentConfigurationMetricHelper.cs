@@ -15,6 +15,7 @@
 // </copyright>
 
 using System.Runtime.CompilerServices;
+using OpenTelemetry.AutoInstrumentation.CallTarget;
 using OpenTelemetry.AutoInstrumentation.Loading;
 using OpenTelemetry.AutoInstrumentation.Logging;
 using OpenTelemetry.AutoInstrumentation.Plugins;
@@ -43,6 +44,7 @@ internal static class EnvironmentConfigurationMetricHelper
                 MetricInstrumentation.NetRuntime => Wrappers.AddRuntimeInstrumentation(builder, pluginManager),
                 MetricInstrumentation.Process => Wrappers.AddProcessInstrumentation(builder, pluginManager),
                 MetricInstrumentation.NServiceBus => builder.AddMeter("NServiceBus.Core"),
+                MetricInstrumentation.MethodMetrics => Wrappers.AddMethodMetrics(builder),
 #if NET6_0_OR_GREATER
                 MetricInstrumentation.AspNetCore => Wrappers.AddAspNetCoreInstrumentation(builder, lazyInstrumentationLoader),
 #endif
@@ -120,6 +122,13 @@ internal static class EnvironmentConfigurationMetricHelper
             return builder.AddProcessInstrumentation();
         }
 
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        public static MeterProviderBuilder AddMethodMetrics(MeterProviderBuilder builder)
+        {
+            MethodMetricsMeter.Initialize();
+            return builder.AddMeter(MethodMetricsMeter.MeterName);
+        }
+
         // Exporters
 
         [MethodImpl(MethodImplOptions.NoInlining)]
@@ -30,6 +30,26 @@ internal class GeneralSettings : Settings
     /// </summary>
     public bool FlushOnUnhandledException { get; private set; }
 
+    /// <summary>
+    /// Gets a value indicating whether the methods rewritten by the bytecode instrumentation
+    /// should be compiled on a background thread after the startup.
+    /// Default is <c>false</c>.
+    /// </summary>
+    public bool InstrumentedMethodsWarmUpEnabled { get; private set; }
+
+    /// <summary>
+    /// Gets the path of the file polled for the commands controlling the .NET CLR Profiler.
+    /// Default is <c>null</c>, no file is polled.
+    /// </summary>
+    public string? ControlFile { get; private set; }
+
+    /// <summary>
+    /// Gets a value indicating whether the bytecode instrumentation passes the value-type arguments
+    /// that the integrations don't need typed as <see cref="object"/>.
+    /// Default is <c>false</c>.
+    /// </summary>
+    public bool CallTargetCanonicalArguments { get; private set; }
+
     /// <summary>
     /// Gets a value indicating whether OpenTelemetry .NET SDK should be set up.
     /// </summary>
@@ -47,6 +67,9 @@ internal class GeneralSettings : Settings
         }
 
         FlushOnUnhandledException = configuration.GetBool(ConfigurationKeys.FlushOnUnhandledException) ?? false;
+        InstrumentedMethodsWarmUpEnabled = configuration.GetBool(ConfigurationKeys.InstrumentedMethodsWarmUpEnabled) ?? false;
+        ControlFile = configuration.GetString(ConfigurationKeys.ControlFile);
+        CallTargetCanonicalArguments = configuration.GetString(ConfigurationKeys.CallTargetInstantiationPolicy) == "canonical";
         SetupSdk = configuration.GetBool(ConfigurationKeys.SetupSdk) ?? true;
     }
 }
@@ -52,6 +52,11 @@ internal enum MetricInstrumentation
     /// <summary>
     /// ASP.NET Core instrumentation.
     /// </summary>
-    AspNetCore = 6
+    AspNetCore = 6,
 #endif
+
+    /// <summary>
+    /// Calls and durations of the methods of the MethodMetrics bytecode integrations.
+    /// </summary>
+    MethodMetrics = 7
 }
@@ -0,0 +1,157 @@
+// <copyright file="ControlFile.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Text;
+using OpenTelemetry.AutoInstrumentation.Logging;
+
+namespace OpenTelemetry.AutoInstrumentation;
+
+/// <summary>
+/// Runs the commands written, one per line, to the file configured by <c>OTEL_DOTNET_AUTO_CONTROL_FILE</c>,
+/// so the .NET CLR Profiler can be controlled from outside of the process.
+/// A command is followed by its argument, if any, separated by a space.
+/// The file is polled and deleted once read, the outcome of its commands is written to the same path
+/// with the <c>.result</c> suffix.
+/// </summary>
+internal sealed class ControlFile : IDisposable
+{
+    private static readonly IOtelLogger Logger = OtelLogging.GetLogger();
+
+    private readonly IReadOnlyDictionary<string, Func<string, string>> _commands;
+    private readonly Timer _timer;
+    private int _polling;
+
+    public ControlFile(string path, IReadOnlyDictionary<string, Func<string, string>> commands, TimeSpan pollingInterval)
+    {
+        Path = path;
+        _commands = commands;
+        _timer = new Timer(_ => Poll(), state: null, pollingInterval, pollingInterval);
+    }
+
+    public static TimeSpan DefaultPollingInterval { get; } = TimeSpan.FromSeconds(1);
+
+    public string Path { get; }
+
+    public string ResultPath => Path + ".result";
+
+    public static IReadOnlyDictionary<string, Func<string, string>> ProfilerCommands { get; } = new Dictionary<string, Func<string, string>>
+    {
+        ["detach-profiler"] = _ => Instrumentation.DetachProfiler().ToString(),
+        ["reload-integrations"] = _ => Instrumentation.ReloadIntegrations() ? "Reloaded" : "NotReloaded",
+        ["set-log-level"] = SetLogLevel,
+        ["dump-il-rewrite"] = SetDumpILRewrite,
+    };
+
+    public void Dispose()
+    {
+        _timer.Dispose();
+    }
+
+    /// <summary>
+    /// Runs the commands of the control file, if it exists.
+    /// </summary>
+    /// <returns><c>true</c> if the control file was read; <c>false</c> otherwise.</returns>
+    internal bool Poll()
+    {
+        // A command taking longer than the polling interval must not be run twice.
+        if (Interlocked.Exchange(ref _polling, value: 1) != 0)
+        {
+            return false;
+        }
+
+        try
+        {
+            if (!File.Exists(Path))
+            {
+                return false;
+            }
+
+            string[] lines;
+            try
+            {
+                lines = File.ReadAllLines(Path);
+                File.Delete(Path);
+            }
+            catch (IOException)
+            {
+                // The file is still being written, it is read in the next poll.
+                return false;
+            }
+
+            var results = new StringBuilder();
+            foreach (var line in lines)
+            {
+                var command = line.Trim();
+                if (command.Length == 0)
+                {
+                    continue;
+                }
+
+                var separator = command.IndexOf(' ');
+                var name = separator < 0 ? command : command.Substring(0, separator);
+                var argument = separator < 0 ? string.Empty : command.Substring(separator + 1).Trim();
+
+                var outcome = _commands.TryGetValue(name, out var run) ? run(argument) : "UnknownCommand";
+                Logger.Information("Control file command {0}: {1}.", command, outcome);
+                results.Append(command).Append(": ").AppendLine(outcome);
+            }
+
+            // The result is moved in place, so it is never read partially written.
+            var temporaryPath = ResultPath + ".tmp";
+            File.WriteAllText(temporaryPath, results.ToString());
+            File.Delete(ResultPath);
+            File.Move(temporaryPath, ResultPath);
+            return true;
+        }
+        catch (Exception ex)
+        {
+            Logger.Error(ex, "The control file {0} could not be processed.", Path);
+            return false;
+        }
+        finally
+        {
+            Interlocked.Exchange(ref _polling, value: 0);
+        }
+    }
+
+    private static string SetLogLevel(string level)
+    {
+        switch (level)
+        {
+            case "none":
+            case "error":
+            case "warn":
+            case "info":
+            case "debug":
+                return Instrumentation.SetNativeLogLevel(level) ? "Changed" : "NotChanged";
+            default:
+                return "InvalidArgument";
+        }
+    }
+
+    private static string SetDumpILRewrite(string state)
+    {
+        switch (state)
+        {
+            case "on":
+                return Instrumentation.SetDumpILRewriteEnabled(enabled: true) ? "Enabled" : "NotChanged";
+            case "off":
+                return Instrumentation.SetDumpILRewriteEnabled(enabled: false) ? "Disabled" : "NotChanged";
+            default:
+                return "InvalidArgument";
+        }
+    }
+}
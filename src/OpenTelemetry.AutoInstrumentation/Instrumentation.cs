@@ -14,6 +14,7 @@
 // limitations under the License.
 // </copyright>
 
+using OpenTelemetry.AutoInstrumentation.CallTarget;
 using OpenTelemetry.AutoInstrumentation.Configurations;
 using OpenTelemetry.AutoInstrumentation.Diagnostics;
 using OpenTelemetry.AutoInstrumentation.Loading;
@@ -42,6 +43,7 @@ internal static class Instrumentation
     private static TracerProvider? _tracerProvider;
     private static MeterProvider? _meterProvider;
     private static PluginManager? _pluginManager;
+    private static ControlFile? _controlFile;
 
     /// <summary>
     /// Gets a value indicating whether OpenTelemetry's profiler is attached to the current process.
@@ -179,6 +181,122 @@ internal static class Instrumentation
         {
             EnableOpenTracing();
         }
+
+        if (GeneralSettings.Value.InstrumentedMethodsWarmUpEnabled)
+        {
+            InstrumentedMethodsWarmUp.Start(GeneralSettings.Value.CallTargetCanonicalArguments);
+        }
+
+        if (GeneralSettings.Value.ControlFile != null)
+        {
+            _controlFile = new ControlFile(GeneralSettings.Value.ControlFile, ControlFile.ProfilerCommands, ControlFile.DefaultPollingInterval);
+            Logger.Information("Polling the control file {0}.", GeneralSettings.Value.ControlFile);
+        }
+    }
+
+    /// <summary>
+    /// Reloads the bytecode instrumentation integrations, using the current values of
+    /// <c>OTEL_DOTNET_AUTO_INTEGRATIONS_FILE</c> and of the settings enabling the instrumentations.
+    /// The methods of the integrations that are no longer enabled are reverted and the methods
+    /// of the newly enabled integrations are instrumented, also in the already loaded assemblies.
+    /// </summary>
+    /// <returns><c>true</c> if the integrations were reloaded; <c>false</c> otherwise.</returns>
+    public static bool ReloadIntegrations()
+    {
+        try
+        {
+            if (!NativeMethods.ReloadIntegrations())
+            {
+                Logger.Warning("The bytecode instrumentation integrations were not reloaded. See the native logs for details.");
+                return false;
+            }
+
+            Logger.Information("The bytecode instrumentation integrations were reloaded.");
+            return true;
+        }
+        catch (DllNotFoundException)
+        {
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// Reverts the bytecode instrumentation and detaches the .NET CLR Profiler from the process,
+    /// so the process no longer pays the overhead of the profiler callbacks.
+    /// The source instrumentations and the OpenTelemetry SDK are not affected.
+    /// </summary>
+    /// <returns>The outcome of the detach.</returns>
+    public static ProfilerDetachOutcome DetachProfiler()
+    {
+        try
+        {
+            var hr = NativeMethods.DetachProfiler();
+            switch (hr)
+            {
+                case 0: // S_OK
+                    Logger.Information("The .NET CLR Profiler detach was requested.");
+                    return ProfilerDetachOutcome.Detached;
+                case 1: // S_FALSE
+                    Logger.Warning("The .NET CLR Profiler was not detached, it is not attached to the process.");
+                    return ProfilerDetachOutcome.NotAttached;
+                default:
+                    Logger.Warning("The .NET CLR Profiler cannot be unloaded, HRESULT=0x{0:X8}. The bytecode instrumentation is reverted and disabled.", hr);
+                    return ProfilerDetachOutcome.InstrumentationDisabled;
+            }
+        }
+        catch (DllNotFoundException)
+        {
+            return ProfilerDetachOutcome.NotAttached;
+        }
+    }
+
+    /// <summary>
+    /// Changes the log level of the .NET CLR Profiler without restarting the process.
+    /// </summary>
+    /// <param name="level">One of the <c>OTEL_LOG_LEVEL</c> values: <c>none</c>, <c>error</c>, <c>warn</c>, <c>info</c> or <c>debug</c>.</param>
+    /// <returns><c>true</c> if the log level was changed; <c>false</c> otherwise.</returns>
+    public static bool SetNativeLogLevel(string level)
+    {
+        try
+        {
+            if (!NativeMethods.SetNativeLogLevel(level))
+            {
+                Logger.Warning("The .NET CLR Profiler log level was not changed to {0}.", level);
+                return false;
+            }
+
+            Logger.Information("The .NET CLR Profiler log level was changed to {0}.", level);
+            return true;
+        }
+        catch (DllNotFoundException)
+        {
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// Changes whether the .NET CLR Profiler logs the IL of the methods it rewrites, as
+    /// <c>OTEL_DOTNET_AUTO_DUMP_ILREWRITE_ENABLED</c> does at startup.
+    /// </summary>
+    /// <param name="enabled">Whether the IL is logged.</param>
+    /// <returns><c>true</c> if the setting was changed; <c>false</c> otherwise.</returns>
+    public static bool SetDumpILRewriteEnabled(bool enabled)
+    {
+        try
+        {
+            if (!NativeMethods.SetDumpILRewriteEnabled(enabled))
+            {
+                Logger.Warning("The .NET CLR Profiler IL rewrite dump was not changed.");
+                return false;
+            }
+
+            Logger.Information("The .NET CLR Profiler IL rewrite dump was {0}.", enabled ? "enabled" : "disabled");
+            return true;
+        }
+        catch (DllNotFoundException)
+        {
+            return false;
+        }
     }
 
     private static void AddLazilyLoadedMetricInstrumentations(LazyInstrumentationLoader lazyInstrumentationLoader, IList<MetricInstrumentation> enabledInstrumentations)
@@ -287,6 +405,7 @@ internal static class Instrumentation
             _tracerProvider?.Dispose();
             _meterProvider?.Dispose();
             _sdkEventListener?.Dispose();
+            _controlFile?.Dispose();
 
             Logger.Information("OpenTelemetry Automatic Instrumentation exit.");
         }
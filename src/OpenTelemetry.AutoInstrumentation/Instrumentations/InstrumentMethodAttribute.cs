@@ -96,4 +96,41 @@ internal class InstrumentMethodAttribute : Attribute
     /// Gets or sets the integration type.
     /// </summary>
     public InstrumentationType Type { get; set; }
+
+    /// <summary>
+    /// Gets or sets which methods the target matches, by default only the method of <see cref="TypeName"/>.
+    /// For <see cref="TargetMethodKind.Derived"/> and <see cref="TargetMethodKind.Interface"/> targets
+    /// <see cref="AssemblyName"/> is the assembly defining <see cref="TypeName"/>.
+    /// </summary>
+    public TargetMethodKind Kind { get; set; }
+
+    /// <summary>
+    /// Gets or sets how the target methods are instrumented, by default they call the decorated class
+    /// through the CallTarget handlers.
+    /// </summary>
+    public IntegrationKind IntegrationKind { get; set; }
+
+    /// <summary>
+    /// Gets or sets the name of the assembly whose calls of the target method are replaced,
+    /// required for the <see cref="IntegrationKind.CallSite"/> integrations.
+    /// </summary>
+    public string? CallerAssemblyName { get; set; }
+
+    /// <summary>
+    /// Gets or sets the name of the type whose calls of the target method are replaced, including the types nested in it.
+    /// If null, all the types of <see cref="CallerAssemblyName"/> are selected.
+    /// </summary>
+    public string? CallerTypeName { get; set; }
+
+    /// <summary>
+    /// Gets or sets the name of the methods whose calls of the target method are replaced.
+    /// If null, all the methods of the selected types are selected.
+    /// </summary>
+    public string? CallerMethodName { get; set; }
+
+    /// <summary>
+    /// Gets or sets the indices of the target method arguments consumed by OnMethodBegin, in the order of its parameters.
+    /// Only those arguments are passed to BeginMethod. If null, all the arguments are passed.
+    /// </summary>
+    public int[]? ArgumentIndices { get; set; }
 }
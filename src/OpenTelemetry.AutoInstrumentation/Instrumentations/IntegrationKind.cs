@@ -0,0 +1,40 @@
+// <copyright file="IntegrationKind.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations;
+
+/// <summary>
+/// Tells how an <see cref="InstrumentMethodAttribute"/> integration instruments its target methods.
+/// </summary>
+internal enum IntegrationKind
+{
+    /// <summary>
+    /// The target methods call the decorated class through the CallTarget handlers.
+    /// </summary>
+    CallTarget,
+
+    /// <summary>
+    /// The target methods only record their calls and durations in the native method metrics,
+    /// the decorated class is not called.
+    /// </summary>
+    MethodMetrics,
+
+    /// <summary>
+    /// The calls of the target method made by the methods of <see cref="InstrumentMethodAttribute.CallerAssemblyName"/>
+    /// call the static method of the decorated class with the same name instead, the target method is not rewritten.
+    /// </summary>
+    CallSite
+}
@@ -0,0 +1,68 @@
+// <copyright file="AsyncMethodValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using OpenTelemetry.AutoInstrumentation.CallTarget;
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Instrumentation targeting an async method in the test application used to validate that the result of the
+/// task is passed to the integration, through a continuation or through the async state machine.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Command",
+    methodName: "ExecuteAsync",
+    returnTypeName: ClrNames.Int32Task,
+    parameterTypeNames: new[] { ClrNames.Int32 },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace)]
+public static class AsyncMethodValidation
+{
+    /// <summary>
+    /// OnMethodBegin callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="value">Value returned by the instrumented method.</param>
+    /// <returns>Calltarget state value</returns>
+    internal static CallTargetState OnMethodBegin<TTarget>(TTarget instance, int value)
+    {
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// OnAsyncMethodEnd callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <typeparam name="TReturn">Type of the result of the task</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="returnValue">Result of the task, doubled to validate it is returned to the caller.</param>
+    /// <param name="exception">Exception instance in case the original code threw an exception.</param>
+    /// <param name="state">Calltarget state value</param>
+    /// <returns>The result of the task</returns>
+    internal static TReturn OnAsyncMethodEnd<TTarget, TReturn>(TTarget instance, TReturn returnValue, Exception? exception, CallTargetState state)
+    {
+        if (returnValue is int result)
+        {
+            return (TReturn)(object)(result * 2);
+        }
+
+        return returnValue;
+    }
+}
@@ -0,0 +1,63 @@
+// <copyright file="ByRefArgumentsValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using OpenTelemetry.AutoInstrumentation.CallTarget;
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Instrumentation targeting a method with ref and out parameters in the test application used to validate
+/// that the by-ref arguments are passed to the integration by reference.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Reader",
+    methodName: "Skip",
+    returnTypeName: ClrNames.Void,
+    parameterTypeNames: new[] { ClrNames.Int32 + "&", ClrNames.Bool + "&" },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace)]
+public static class ByRefArgumentsValidation
+{
+    /// <summary>
+    /// OnMethodBegin callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="count">Number of positions to skip, doubled to validate it is the caller's variable.</param>
+    /// <param name="skipped">Out parameter of the instrumented method.</param>
+    /// <returns>Calltarget state value</returns>
+    internal static CallTargetState OnMethodBegin<TTarget>(ref TTarget instance, ref int count, ref bool skipped)
+    {
+        count *= 2;
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// OnMethodEnd callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="exception">Exception instance in case the original code threw an exception.</param>
+    /// <param name="state">Calltarget state value</param>
+    /// <returns>A response value, in an async scenario will be T of Task of T</returns>
+    internal static CallTargetReturn OnMethodEnd<TTarget>(ref TTarget instance, Exception exception, CallTargetState state)
+    {
+        return CallTargetReturn.GetDefault();
+    }
+}
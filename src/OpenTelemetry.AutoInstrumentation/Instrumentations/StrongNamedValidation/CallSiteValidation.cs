@@ -0,0 +1,48 @@
+// <copyright file="CallSiteValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Call-site integration replacing the calls of a static method of the test library made by one method of the
+/// test application, the other callers keep calling the target method.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Command",
+    methodName: "Increment",
+    returnTypeName: ClrNames.Int32,
+    parameterTypeNames: new[] { ClrNames.Int32 },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace,
+    IntegrationKind = IntegrationKind.CallSite,
+    CallerAssemblyName = "TestApplication.StrongNamed",
+    CallerTypeName = "TestApplication.StrongNamed.Program",
+    CallerMethodName = "IncrementAtCallSite")]
+public static class CallSiteValidation
+{
+    /// <summary>
+    /// Called instead of the target method by the selected callers.
+    /// </summary>
+    /// <param name="value">Value passed to the target method.</param>
+    /// <returns>The value incremented twice, to tell the wrapper from the target method.</returns>
+    public static int Increment(int value)
+    {
+        return value + 2;
+    }
+}
@@ -0,0 +1,63 @@
+// <copyright file="LoopMethodValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using OpenTelemetry.AutoInstrumentation.CallTarget;
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Instrumentation targeting a loop-heavy method in the test application used to compare the steady-state
+/// duration of the instrumented method with and without the outlining of its original body.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Command",
+    methodName: "Sum",
+    returnTypeName: ClrNames.Int32,
+    parameterTypeNames: new[] { ClrNames.Int32 + "[]" },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace)]
+public static class LoopMethodValidation
+{
+    /// <summary>
+    /// OnMethodBegin callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="values">Values summed by the instrumented method.</param>
+    /// <returns>Calltarget state value</returns>
+    internal static CallTargetState OnMethodBegin<TTarget>(TTarget instance, int[] values)
+    {
+        return CallTargetState.GetDefault();
+    }
+
+    /// <summary>
+    /// OnMethodEnd callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <typeparam name="TReturn">Type of the return value</typeparam>
+    /// <param name="instance">Instance value, aka `this` of the instrumented method.</param>
+    /// <param name="returnValue">Sum returned by the instrumented method.</param>
+    /// <param name="exception">Exception instance in case the original code threw an exception.</param>
+    /// <param name="state">Calltarget state value</param>
+    /// <returns>The sum, unchanged</returns>
+    internal static CallTargetReturn<TReturn> OnMethodEnd<TTarget, TReturn>(TTarget instance, TReturn returnValue, Exception exception, CallTargetState state)
+    {
+        return new CallTargetReturn<TReturn>(returnValue);
+    }
+}
@@ -0,0 +1,47 @@
+// <copyright file="MethodMetricsValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Method metrics integration targeting the two overloads of a method in the test application,
+/// each overload is recorded on its own.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Command",
+    methodName: "Compute",
+    returnTypeName: ClrNames.Int32,
+    parameterTypeNames: new[] { ClrNames.Int32 },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace,
+    IntegrationKind = IntegrationKind.MethodMetrics)]
+[InstrumentMethod(
+    assemblyName: "TestLibrary.InstrumentationTarget",
+    typeName: "TestLibrary.InstrumentationTarget.Command",
+    methodName: "Compute",
+    returnTypeName: ClrNames.Int64,
+    parameterTypeNames: new[] { ClrNames.Int64 },
+    minimumVersion: "1.0.0",
+    maximumVersion: "1.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace,
+    IntegrationKind = IntegrationKind.MethodMetrics)]
+public static class MethodMetricsValidation
+{
+}
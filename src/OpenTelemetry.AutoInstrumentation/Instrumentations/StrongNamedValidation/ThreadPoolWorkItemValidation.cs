@@ -0,0 +1,55 @@
+// <copyright file="ThreadPoolWorkItemValidation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using OpenTelemetry.AutoInstrumentation.CallTarget;
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations.Validations;
+
+/// <summary>
+/// Instrumentation targeting a CoreLib method used to validate that the method is also instrumented where the
+/// ReadyToRun code of CoreLib inlined it.
+/// </summary>
+[InstrumentMethod(
+    assemblyName: "System.Private.CoreLib",
+    typeName: "System.Threading.ThreadPoolWorkQueue",
+    methodName: "DispatchWorkItem",
+    returnTypeName: ClrNames.Void,
+    parameterTypeNames: new[] { ClrNames.Object, "System.Threading.Thread" },
+    minimumVersion: "6.0.0",
+    maximumVersion: "8.65535.65535",
+    integrationName: "StrongNamedValidation",
+    type: InstrumentationType.Trace)]
+public static class ThreadPoolWorkItemValidation
+{
+    /// <summary>
+    /// OnMethodBegin callback.
+    /// </summary>
+    /// <typeparam name="TTarget">Type of the target</typeparam>
+    /// <param name="instance">Instance value, the instrumented method is static.</param>
+    /// <param name="workItem">Work item executed by the thread pool.</param>
+    /// <param name="currentThread">Thread executing the work item.</param>
+    /// <returns>Calltarget state value</returns>
+    internal static CallTargetState OnMethodBegin<TTarget>(TTarget instance, object workItem, Thread currentThread)
+    {
+        // Only the work item queued by the test application is reported, the other work items run unchanged.
+        if (workItem.GetType().FullName == "TestApplication.StrongNamed.ValidatedWorkItem")
+        {
+            Console.WriteLine($"Validation: {nameof(ThreadPoolWorkItemValidation)}");
+        }
+
+        return CallTargetState.GetDefault();
+    }
+}
@@ -0,0 +1,38 @@
+// <copyright file="TargetMethodKind.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+namespace OpenTelemetry.AutoInstrumentation.Instrumentations;
+
+/// <summary>
+/// Tells which methods an <see cref="InstrumentMethodAttribute"/> target matches.
+/// </summary>
+internal enum TargetMethodKind
+{
+    /// <summary>
+    /// The method of the target type.
+    /// </summary>
+    Default,
+
+    /// <summary>
+    /// The overrides of the target virtual method in the types derived from the target type, in any assembly.
+    /// </summary>
+    Derived,
+
+    /// <summary>
+    /// The implementations of the target interface method, in any assembly.
+    /// </summary>
+    Interface
+}
@@ -15,6 +15,7 @@
 // </copyright>
 
 using System.Runtime.InteropServices;
+using System.Text;
 
 namespace OpenTelemetry.AutoInstrumentation;
 
@@ -32,12 +33,196 @@ internal static class NativeMethods
         return NonWindows.IsProfilerAttached();
     }
 
+    public static bool ReloadIntegrations()
+    {
+        if (IsWindows)
+        {
+            return Windows.ReloadIntegrations();
+        }
+
+        return NonWindows.ReloadIntegrations();
+    }
+
+    public static int DetachProfiler()
+    {
+        if (IsWindows)
+        {
+            return Windows.DetachProfiler();
+        }
+
+        return NonWindows.DetachProfiler();
+    }
+
+    public static bool SetNativeLogLevel(string level)
+    {
+        if (IsWindows)
+        {
+            return Windows.SetNativeLogLevel(level);
+        }
+
+        return NonWindows.SetNativeLogLevel(level);
+    }
+
+    public static bool SetDumpILRewriteEnabled(bool enabled)
+    {
+        if (IsWindows)
+        {
+            return Windows.SetDumpILRewriteEnabled(enabled);
+        }
+
+        return NonWindows.SetDumpILRewriteEnabled(enabled);
+    }
+
+    public static int GetInstrumentedMethods(InstrumentedMethod[]? methods, int length)
+    {
+        if (IsWindows)
+        {
+            return Windows.GetInstrumentedMethods(methods, length);
+        }
+
+        return NonWindows.GetInstrumentedMethods(methods, length);
+    }
+
+    public static void RecordMethodDuration(int methodId, long durationNanoseconds)
+    {
+        if (IsWindows)
+        {
+            Windows.RecordMethodDuration(methodId, durationNanoseconds);
+        }
+        else
+        {
+            NonWindows.RecordMethodDuration(methodId, durationNanoseconds);
+        }
+    }
+
+#if NET6_0_OR_GREATER
+    public static bool TryRecordMethodDuration(int methodId, long durationNanoseconds)
+    {
+        if (IsWindows)
+        {
+            return Windows.TryRecordMethodDuration(methodId, durationNanoseconds) != 0;
+        }
+
+        return NonWindows.TryRecordMethodDuration(methodId, durationNanoseconds) != 0;
+    }
+
+#endif
+    public static int GetMethodMetrics(MethodMetric[]? metrics, int length)
+    {
+        if (IsWindows)
+        {
+            return Windows.GetMethodMetrics(metrics, length);
+        }
+
+        return NonWindows.GetMethodMetrics(metrics, length);
+    }
+
+    public static string GetMethodMetricName(int methodId)
+    {
+        var name = new StringBuilder(256);
+        var length = GetMethodMetricName(methodId, name);
+        if (length >= name.Capacity)
+        {
+            name = new StringBuilder(length + 1);
+            GetMethodMetricName(methodId, name);
+        }
+
+        return name.ToString();
+    }
+
+    private static int GetMethodMetricName(int methodId, StringBuilder name)
+    {
+        if (IsWindows)
+        {
+            return Windows.GetMethodMetricName(methodId, name, name.Capacity);
+        }
+
+        return NonWindows.GetMethodMetricName(methodId, name, name.Capacity);
+    }
+
+    /// <summary>
+    /// Method requested for ReJIT by the native profiler.
+    /// NOTE: Must keep this layout in sync with trace::InstrumentedMethod.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct InstrumentedMethod
+    {
+        public Guid ModuleVersionId { get; }
+
+        public int MethodDef { get; }
+
+        public int IntegrationTypeDef { get; }
+
+        public int WrapperMethodDef { get; }
+
+        // -1 when all the arguments are passed to BeginMethod.
+        public int SelectedArgumentCount { get; }
+
+        // The indices of the arguments passed to BeginMethod, SelectedArgumentCount of them are used.
+        [field: MarshalAs(UnmanagedType.ByValArray, SizeConst = 8)]
+        public int[]? SelectedArguments { get; }
+    }
+
+    /// <summary>
+    /// Cumulative calls and durations of a method of a MethodMetrics integration. Bucket 0 counts the durations
+    /// under 1us, bucket i the durations in [2^(i-1)us, 2^i us), the last bucket also counts the longer durations.
+    /// NOTE: Must keep this layout in sync with trace::MethodMetric.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct MethodMetric
+    {
+        public int MethodId { get; }
+
+        public int BucketCount { get; }
+
+        public long Count { get; }
+
+        public long SumNanoseconds { get; }
+
+        // The size of trace::TelemetryHistogramBucketCount, BucketCount of them are used.
+        [field: MarshalAs(UnmanagedType.ByValArray, SizeConst = 24)]
+        public long[]? Buckets { get; }
+    }
+
     // the "dll" extension is required on .NET Framework
     // and optional on .NET Core
     private static class Windows
     {
         [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
         public static extern bool IsProfilerAttached();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern bool ReloadIntegrations();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern int DetachProfiler();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern bool SetNativeLogLevel([MarshalAs(UnmanagedType.LPWStr)] string level);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern bool SetDumpILRewriteEnabled(bool enabled);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern int GetInstrumentedMethods([In, Out] InstrumentedMethod[]? methods, int length);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern void RecordMethodDuration(int methodId, long durationNanoseconds);
+
+#if NET6_0_OR_GREATER
+        // The export neither allocates nor takes locks once the thread called RecordMethodDuration, the GC transition
+        // would cost more than the call.
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        [SuppressGCTransition]
+        public static extern int TryRecordMethodDuration(int methodId, long durationNanoseconds);
+
+#endif
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern int GetMethodMetrics([In, Out] MethodMetric[]? metrics, int length);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native.dll")]
+        public static extern int GetMethodMetricName(int methodId, [MarshalAs(UnmanagedType.LPWStr)] StringBuilder name, int length);
     }
 
     // assume .NET Core if not running on Windows
@@ -45,5 +230,38 @@ internal static class NativeMethods
     {
         [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
         public static extern bool IsProfilerAttached();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern bool ReloadIntegrations();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern int DetachProfiler();
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern bool SetNativeLogLevel([MarshalAs(UnmanagedType.LPWStr)] string level);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern bool SetDumpILRewriteEnabled(bool enabled);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern int GetInstrumentedMethods([In, Out] InstrumentedMethod[]? methods, int length);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern void RecordMethodDuration(int methodId, long durationNanoseconds);
+
+#if NET6_0_OR_GREATER
+        // The export neither allocates nor takes locks once the thread called RecordMethodDuration, the GC transition
+        // would cost more than the call.
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        [SuppressGCTransition]
+        public static extern int TryRecordMethodDuration(int methodId, long durationNanoseconds);
+
+#endif
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern int GetMethodMetrics([In, Out] MethodMetric[]? metrics, int length);
+
+        [DllImport("OpenTelemetry.AutoInstrumentation.Native")]
+        public static extern int GetMethodMetricName(int methodId, [MarshalAs(UnmanagedType.LPWStr)] StringBuilder name, int length);
     }
 }
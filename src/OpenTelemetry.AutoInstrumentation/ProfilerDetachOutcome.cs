@@ -0,0 +1,39 @@
+// <copyright file="ProfilerDetachOutcome.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+namespace OpenTelemetry.AutoInstrumentation;
+
+/// <summary>
+/// Outcome of <see cref="Instrumentation.DetachProfiler"/>.
+/// </summary>
+internal enum ProfilerDetachOutcome
+{
+    /// <summary>
+    /// The .NET CLR Profiler is not attached to the process.
+    /// </summary>
+    NotAttached,
+
+    /// <summary>
+    /// The bytecode instrumentation is reverted and the runtime unloads the .NET CLR Profiler.
+    /// </summary>
+    Detached,
+
+    /// <summary>
+    /// The bytecode instrumentation is reverted and disabled, but the runtime keeps the .NET CLR Profiler
+    /// loaded because of the settings applied at startup, e.g. disabling the NGEN images.
+    /// </summary>
+    InstrumentationDisabled,
+}
@@ -0,0 +1,58 @@
+// <copyright file="AttachTests.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+#if !NETFRAMEWORK
+
+using IntegrationTests.Helpers;
+using Microsoft.Diagnostics.NETCore.Client;
+using Xunit.Abstractions;
+
+namespace IntegrationTests;
+
+public class AttachTests : TestHelper
+{
+    public AttachTests(ITestOutputHelper output)
+        : base("StrongNamed", output)
+    {
+    }
+
+    [Fact]
+    public void InstrumentsTheMethodsJittedBeforeTheAttach()
+    {
+        using var collector = new MockSpansCollector(Output);
+        SetExporter(collector);
+        collector.Expect("TestApplication.StrongNamedValidation");
+
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+
+        // The profiler isn't enabled at startup: the application loads and runs the instrumented method, and waits
+        // for the profiler to be attached.
+        using var application = new WaitingApplication(this, Output);
+        application.WaitUntilReady();
+
+        new DiagnosticsClient(application.Process.Id).AttachProfiler(
+            TimeSpan.FromSeconds(10),
+            new Guid(EnvironmentTools.ProfilerClsId),
+            EnvironmentHelper.GetProfilerPath());
+        application.ContinueAndWaitForExit();
+
+        // Only the call made after the attach is instrumented.
+        collector.AssertExpectations();
+        collector.AssertEmpty();
+    }
+}
+#endif
@@ -0,0 +1,69 @@
+// <copyright file="DetachTests.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using FluentAssertions;
+using IntegrationTests.Helpers;
+using Xunit.Abstractions;
+
+namespace IntegrationTests;
+
+public class DetachTests : TestHelper
+{
+    public DetachTests(ITestOutputHelper output)
+        : base("StrongNamed", output)
+    {
+    }
+
+    [Fact]
+    public void RevertsTheInstrumentation()
+    {
+        using var collector = new MockSpansCollector(Output);
+        SetExporter(collector);
+        collector.Expect("TestApplication.StrongNamedValidation");
+
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        var controlFile = Path.Combine(Path.GetTempPath(), $"otel-control-{Guid.NewGuid():N}");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CONTROL_FILE", controlFile);
+        EnableBytecodeInstrumentation();
+
+        try
+        {
+            using var application = new WaitingApplication(this, Output);
+            application.WaitUntilReady();
+
+            File.WriteAllText(controlFile, "detach-profiler");
+            var resultFile = controlFile + ".result";
+            var deadline = DateTime.UtcNow + TestTimeout.ProcessExit;
+            while (!File.Exists(resultFile) && DateTime.UtcNow < deadline)
+            {
+                Thread.Sleep(100);
+            }
+
+            // The runtime never unloads a profiler that requested a ReJIT: the instrumentation is disabled instead.
+            File.ReadAllText(resultFile).Trim().Should().Be("detach-profiler: InstrumentationDisabled");
+            application.ContinueAndWaitForExit();
+        }
+        finally
+        {
+            File.Delete(controlFile + ".result");
+        }
+
+        // Only the call made before the detach is instrumented.
+        collector.AssertExpectations();
+        collector.AssertEmpty();
+    }
+}
@@ -0,0 +1,87 @@
+// <copyright file="WaitingApplication.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Diagnostics;
+using FluentAssertions;
+using Xunit.Abstractions;
+
+namespace IntegrationTests.Helpers;
+
+/// <summary>
+/// A test application started with the <c>--wait</c> argument: it signals when it is ready
+/// and waits for the test to let it continue, so the test can act on the running process.
+/// </summary>
+public sealed class WaitingApplication : IDisposable
+{
+    private readonly DirectoryInfo _directory;
+    private readonly ITestOutputHelper _output;
+    private readonly ProcessHelper _helper;
+
+    public WaitingApplication(TestHelper testHelper, ITestOutputHelper output)
+    {
+        _output = output;
+        _directory = Directory.CreateDirectory(Path.Combine(Path.GetTempPath(), $"otel-wait-{Guid.NewGuid():N}"));
+
+        var process = testHelper.StartTestApplication(new TestSettings { Arguments = $"--wait {_directory.FullName}" });
+        process.Should().NotBeNull();
+        Process = process!;
+        _helper = new ProcessHelper(Process);
+    }
+
+    public Process Process { get; }
+
+    public void WaitUntilReady()
+    {
+        var ready = Path.Combine(_directory.FullName, "ready");
+        var deadline = DateTime.UtcNow + TestTimeout.ProcessExit;
+        while (!File.Exists(ready) && !Process.HasExited && DateTime.UtcNow < deadline)
+        {
+            Thread.Sleep(100);
+        }
+
+        File.Exists(ready).Should().BeTrue("Test application did not get ready");
+    }
+
+    public string ContinueAndWaitForExit()
+    {
+        File.WriteAllText(Path.Combine(_directory.FullName, "continue"), string.Empty);
+
+        var processTimeout = !Process.WaitForExit((int)TestTimeout.ProcessExit.TotalMilliseconds);
+        if (processTimeout)
+        {
+            Process.Kill();
+        }
+
+        _output.WriteResult(_helper);
+
+        processTimeout.Should().BeFalse("Test application timed out");
+        Process.ExitCode.Should().Be(0, "Test application exited with non-zero exit code");
+        _helper.StandardOutput.Should().Contain("Executed after the wait");
+        return _helper.StandardOutput;
+    }
+
+    public void Dispose()
+    {
+        if (!Process.HasExited)
+        {
+            Process.Kill();
+        }
+
+        _helper.Dispose();
+        Process.Dispose();
+        _directory.Delete(recursive: true);
+    }
+}
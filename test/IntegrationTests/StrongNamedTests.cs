@@ -14,8 +14,10 @@
 // limitations under the License.
 // </copyright>
 
+using System.Globalization;
 using FluentAssertions;
 using IntegrationTests.Helpers;
+using OpenTelemetry.Proto.Metrics.V1;
 using Xunit.Abstractions;
 
 namespace IntegrationTests;
@@ -39,7 +41,22 @@ public class StrongNamedTests : TestHelper
         File.Exists(integrationsFile).Should().BeTrue();
         SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
         EnableBytecodeInstrumentation();
-        RunTestApplication();
+        var (standardOutput, _) = RunTestApplication();
+
+        standardOutput.Should().Contain("Reader position: 10000");
+#if !NETFRAMEWORK
+        // The instance of the instrumented value type is passed by reference, it must not be boxed.
+        standardOutput.Should().Contain("Reader allocated bytes: 0");
+#endif
+
+        // The by-ref and the ref struct arguments are passed by reference to the integrations.
+        standardOutput.Should().Contain("Reader skipped: True, position: 4");
+#if !NETFRAMEWORK
+        standardOutput.Should().Contain("Reader read: 3");
+#endif
+
+        // The integration receives the result of the async method.
+        standardOutput.Should().Contain("Command async result: 42");
 
         // TODO: When native logs are moved to an EventSource implementation check for the log
         // TODO: entries reporting the missing instrumentation type and missing instrumentation methods.
@@ -47,4 +64,202 @@ public class StrongNamedTests : TestHelper
 
         collector.AssertExpectations();
     }
+
+    [Theory]
+    [InlineData(false)]
+    [InlineData(true)]
+    public void WarmsUpTheInstrumentedMethods(bool warmUpEnabled)
+    {
+        using var collector = new MockSpansCollector(Output);
+        SetExporter(collector);
+        collector.Expect("TestApplication.StrongNamedValidation");
+
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INSTRUMENTED_METHODS_WARMUP_ENABLED", warmUpEnabled ? "true" : "false");
+        var logDirectory = Directory.CreateDirectory(Path.Combine(Path.GetTempPath(), $"otel-logs-{Guid.NewGuid():N}"));
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_LOG_DIRECTORY", logDirectory.FullName);
+        EnableBytecodeInstrumentation();
+
+        try
+        {
+            // The instrumented method is called after a delay, leaving time to the warm-up.
+            RunTestApplication(new TestSettings { Arguments = "--delay 3000" });
+
+            var logs = ReadLogs(logDirectory);
+            const string warmedUp = "Instrumented method TestLibrary.InstrumentationTarget.Command.Execute warmed up.";
+            if (warmUpEnabled)
+            {
+                logs.Should().Contain(warmedUp);
+            }
+            else
+            {
+                logs.Should().NotContain(warmedUp);
+            }
+        }
+        finally
+        {
+            logDirectory.Delete(recursive: true);
+        }
+
+        collector.AssertExpectations();
+    }
+
+    [Theory]
+    [InlineData(false)]
+    [InlineData(true)]
+    public void OutlinesTheOriginalBody(bool outliningEnabled)
+    {
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CALLTARGET_OUTLINING_ENABLED", outliningEnabled ? "true" : "false");
+        var logDirectory = Directory.CreateDirectory(Path.Combine(Path.GetTempPath(), $"otel-logs-{Guid.NewGuid():N}"));
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_LOG_DIRECTORY", logDirectory.FullName);
+        EnableBytecodeInstrumentation();
+
+        try
+        {
+            var (standardOutput, _) = RunTestApplication(new TestSettings { Arguments = "--loop" });
+            standardOutput.Should().Contain("Loop sum: 499500");
+
+            // The original body is moved to <>otel__Sum and the instrumented Sum calls it.
+            var logs = ReadLogs(logDirectory);
+            const string outlined = "Outlined the original body of TestLibrary.InstrumentationTarget.Command.Sum()";
+            const string forwarded = "TestLibrary.InstrumentationTarget.Command.Sum() forwards to its outlined body <>otel__Sum()";
+            if (outliningEnabled)
+            {
+                logs.Should().Contain(outlined).And.Contain(forwarded);
+            }
+            else
+            {
+                logs.Should().NotContain(outlined).And.NotContain(forwarded);
+            }
+        }
+        finally
+        {
+            logDirectory.Delete(recursive: true);
+        }
+    }
+
+#if !NETFRAMEWORK
+    [Fact]
+    public void InstrumentsTheCoreLibMethodsInlinedInReadyToRunCode()
+    {
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+
+        // The ReadyToRun code of CoreLib runs the work items with DispatchWorkItem inlined into Dispatch,
+        // the methods inlining it are rewritten too.
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CLR_ENABLE_NGEN", "true");
+        EnableBytecodeInstrumentation();
+        var (standardOutput, _) = RunTestApplication(new TestSettings { Arguments = "--thread-pool" });
+
+        standardOutput.Should().Contain("Validation: ThreadPoolWorkItemValidation");
+        standardOutput.Should().Contain("Work item executed");
+    }
+#endif
+
+    [Fact]
+    public void RecordsTheMethodMetricsOfEachOverload()
+    {
+        using var collector = new MockMetricsCollector(Output);
+        SetExporter(collector);
+        collector.Expect("OpenTelemetry.AutoInstrumentation.MethodMetrics", metric => metric.Name == "method.calls" && HasBothOverloads(metric));
+
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_METRICS_METHODMETRICS_INSTRUMENTATION_ENABLED", "true");
+        SetEnvironmentVariable("OTEL_METRIC_EXPORT_INTERVAL", "100");
+        EnableBytecodeInstrumentation();
+        var (standardOutput, _) = RunTestApplication(new TestSettings { Arguments = "--method-metrics" });
+
+        // The method metrics integrations don't change the results of their target methods.
+        standardOutput.Should().Contain("Compute results: 2, 4");
+        collector.AssertExpectations();
+    }
+
+    [Fact]
+    public void ReplacesTheCallsOfTheSelectedCallers()
+    {
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        EnableBytecodeInstrumentation();
+        var (standardOutput, _) = RunTestApplication(new TestSettings { Arguments = "--call-site" });
+
+        // The call made by Main keeps calling the target method.
+        standardOutput.Should().Contain("Increment results: 3, 2");
+    }
+
+    [Fact]
+    public void InstrumentsAsyncStateMachines()
+    {
+        var assemblyPath = GetTestAssemblyPath();
+        var integrationsFile = Path.Combine(assemblyPath, "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CALLTARGET_ASYNC_STATE_MACHINES_ENABLED", "true");
+        var logDirectory = Directory.CreateDirectory(Path.Combine(Path.GetTempPath(), $"otel-logs-{Guid.NewGuid():N}"));
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_LOG_DIRECTORY", logDirectory.FullName);
+        EnableBytecodeInstrumentation();
+
+        try
+        {
+            var (standardOutput, _) = RunTestApplication();
+
+            // The state machine passes the result to the integration before the task completes.
+            standardOutput.Should().Contain("Command async result: 42");
+
+            // The completion of the task is instrumented in the MoveNext of the state machine, on its builder.
+            var logs = ReadLogs(logDirectory);
+            logs.Should().Contain("Rewrote MoveNext of the async state machine of TestLibrary.InstrumentationTarget.Command.ExecuteAsync() [Builder=<>t__builder");
+        }
+        finally
+        {
+            logDirectory.Delete(recursive: true);
+        }
+    }
+
+#if !NETFRAMEWORK
+    [Fact]
+    public void InstrumentsAsyncStateMachinesWithoutTheContinuationAllocations()
+    {
+        var integrationsFile = Path.Combine(GetTestAssemblyPath(), "StrongNamedTestsIntegrations.json");
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_INTEGRATIONS_FILE", integrationsFile);
+        EnableBytecodeInstrumentation();
+
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CALLTARGET_ASYNC_STATE_MACHINES_ENABLED", "false");
+        var continuationBytes = RunAsyncAllocations();
+        SetEnvironmentVariable("OTEL_DOTNET_AUTO_CALLTARGET_ASYNC_STATE_MACHINES_ENABLED", "true");
+        var stateMachineBytes = RunAsyncAllocations();
+
+        // The continuation path allocates a task and a closure per call, the state machine path does not.
+        stateMachineBytes.Should().BeLessThan(continuationBytes);
+    }
+#endif
+
+    private static string ReadLogs(DirectoryInfo logDirectory)
+    {
+        return string.Concat(logDirectory.GetFiles().Select(file => File.ReadAllText(file.FullName)));
+    }
+
+    private static bool HasBothOverloads(Metric metric)
+    {
+        var methods = metric.Sum.DataPoints
+            .SelectMany(dataPoint => dataPoint.Attributes)
+            .Where(attribute => attribute.Key == "method")
+            .Select(attribute => attribute.Value.StringValue)
+            .ToList();
+
+        return methods.Contains("TestLibrary.InstrumentationTarget.Command.Compute(System.Int32)") &&
+               methods.Contains("TestLibrary.InstrumentationTarget.Command.Compute(System.Int64)");
+    }
+
+#if !NETFRAMEWORK
+    private long RunAsyncAllocations()
+    {
+        const string prefix = "Async allocated bytes per call: ";
+        var (standardOutput, _) = RunTestApplication(new TestSettings { Arguments = "--async-allocations" });
+        var line = standardOutput.Split('\n').Select(x => x.Trim()).Single(x => x.StartsWith(prefix, StringComparison.Ordinal));
+        return long.Parse(line.Substring(prefix.Length), CultureInfo.InvariantCulture);
+    }
+#endif
 }
@@ -0,0 +1,122 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_callsite.h"
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/il_rewriter_wrapper.h"
+
+using namespace trace;
+
+static const mdMemberRef target_method_ref  = 0x0A000001;
+static const mdMemberRef wrapper_method_ref = 0x0A000002;
+
+// ldarg.0, callvirt target, ldarg.0, constrained. T callvirt target, ldarg.0, call target, ret
+static const BYTE callsite_body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (25 << 2)),
+                                     CEE_LDARG_0,
+                                     CEE_CALLVIRT, 0x01, 0x00, 0x00, 0x0A,
+                                     CEE_LDARG_0,
+                                     0xFE, 0x16, 0x01, 0x00, 0x00, 0x1B,
+                                     CEE_CALLVIRT, 0x01, 0x00, 0x00, 0x0A,
+                                     CEE_LDARG_0,
+                                     CEE_CALL, 0x01, 0x00, 0x00, 0x0A,
+                                     CEE_RET};
+
+// instance int M(int, string)
+static const COR_SIGNATURE instance_signature[] = {IMAGE_CEE_CS_CALLCONV_HASTHIS, 2, ELEMENT_TYPE_I4, ELEMENT_TYPE_I4,
+                                                   ELEMENT_TYPE_STRING};
+
+// static void N(int)
+static const COR_SIGNATURE static_signature[] = {IMAGE_CEE_CS_CALLCONV_DEFAULT, 1, ELEMENT_TYPE_VOID, ELEMENT_TYPE_I4};
+
+static FunctionInfo CreateTarget(const COR_SIGNATURE* signature, unsigned size)
+{
+    const TypeInfo type(0x01000005, WStr("Client"), mdTypeSpecNil, mdtTypeRef, nullptr, false, false, nullptr);
+    FunctionInfo   function_info(target_method_ref, WStr("Send"), type,
+                                 MethodSignature(std::vector<BYTE>(signature, signature + size)),
+                                 FunctionMethodSignature(signature, size));
+    EXPECT_EQ(S_OK, function_info.method_signature.TryParse());
+    return function_info;
+}
+
+static mdToken GetToken(const COR_ILMETHOD_DECODER& decoder, unsigned offset)
+{
+    return *reinterpret_cast<const mdToken*>(&decoder.Code[offset]);
+}
+
+TEST(CallTargetCallSiteTest, ReplacesTheVirtualCallsOfAnInstanceMethod)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(callsite_body));
+
+    ILRewriterWrapper rewriter_wrapper(&rewriter);
+    ASSERT_TRUE(rewriter_wrapper.ReplaceMethodCalls(target_method_ref, wrapper_method_ref, true));
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    // The constrained call and the non-virtual call keep the target.
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_EQ(25, decoder.GetCodeSize());
+    EXPECT_EQ(CEE_CALL, decoder.Code[1]);
+    EXPECT_EQ(wrapper_method_ref, GetToken(decoder, 2));
+    EXPECT_EQ(CEE_CALLVIRT, decoder.Code[13]);
+    EXPECT_EQ(target_method_ref, GetToken(decoder, 14));
+    EXPECT_EQ(CEE_CALL, decoder.Code[19]);
+    EXPECT_EQ(target_method_ref, GetToken(decoder, 20));
+}
+
+TEST(CallTargetCallSiteTest, ReplacesTheCallsOfAStaticMethod)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(callsite_body));
+
+    ILRewriterWrapper rewriter_wrapper(&rewriter);
+    ASSERT_TRUE(rewriter_wrapper.ReplaceMethodCalls(target_method_ref, wrapper_method_ref, false));
+    ASSERT_FALSE(rewriter_wrapper.ReplaceMethodCalls(target_method_ref, wrapper_method_ref, false));
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    EXPECT_EQ(wrapper_method_ref, GetToken(decoder, 2));
+    EXPECT_EQ(target_method_ref, GetToken(decoder, 14));
+    EXPECT_EQ(wrapper_method_ref, GetToken(decoder, 20));
+}
+
+TEST(CallTargetCallSiteTest, ScansTheBodiesForTheCallsOfTheTargets)
+{
+    const auto target = CreateTarget(static_signature, sizeof(static_signature));
+    EXPECT_TRUE(MayCallCallSiteTargets(callsite_body, {target}));
+    EXPECT_FALSE(MayCallCallSiteTargets(callsite_body, {}));
+
+    // ldc.i4 with the bytes of the target token, ret
+    const BYTE constant_body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (6 << 2)),
+                                  CEE_LDC_I4, 0x01, 0x00, 0x00, 0x0A,
+                                  CEE_RET};
+    EXPECT_FALSE(MayCallCallSiteTargets(constant_body, {target}));
+}
+
+TEST(CallTargetCallSiteTest, WrapperSignatureTakesTheInstanceFirst)
+{
+    std::vector<BYTE> signature;
+    ASSERT_EQ(S_OK, GetCallSiteWrapperSignature(CreateTarget(instance_signature, sizeof(instance_signature)),
+                                                signature));
+    EXPECT_EQ(std::vector<BYTE>({IMAGE_CEE_CS_CALLCONV_DEFAULT, 3, ELEMENT_TYPE_I4, ELEMENT_TYPE_CLASS, 0x15,
+                                 ELEMENT_TYPE_I4, ELEMENT_TYPE_STRING}),
+              signature);
+
+    ASSERT_EQ(S_OK, GetCallSiteWrapperSignature(CreateTarget(static_signature, sizeof(static_signature)), signature));
+    EXPECT_EQ(std::vector<BYTE>(static_signature, static_signature + sizeof(static_signature)), signature);
+}
+
+TEST(CallTargetCallSiteTest, CallerTypeSelectsItsNestedTypes)
+{
+    const auto caller_type = std::make_shared<TypeInfo>(0x02000002, WStr("App.Service"), mdTypeSpecNil, mdtTypeDef,
+                                                        nullptr, false, false, nullptr);
+    const TypeInfo nested_type(0x02000003, WStr("<Run>d__1"), mdTypeSpecNil, mdtTypeDef, nullptr, false, false,
+                               caller_type);
+    const TypeInfo other_type(0x02000004, WStr("App.Other"), mdTypeSpecNil, mdtTypeDef, nullptr, false, false,
+                              nullptr);
+
+    const MethodReference caller(WStr("App"), WStr("App.Service"), EmptyWStr, {}, {}, {}, {});
+    EXPECT_TRUE(IsCallSiteCallerType(*caller_type, caller));
+    EXPECT_TRUE(IsCallSiteCallerType(nested_type, caller));
+    EXPECT_FALSE(IsCallSiteCallerType(other_type, caller));
+
+    const MethodReference assembly_caller(WStr("App"), EmptyWStr, EmptyWStr, {}, {}, {}, {});
+    EXPECT_TRUE(IsCallSiteCallerType(other_type, assembly_caller));
+}
@@ -0,0 +1,76 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_instantiations.h"
+
+using namespace trace;
+
+TEST(CallTargetInstantiationsTest, ParsePolicy)
+{
+    EXPECT_EQ(ParseCallTargetInstantiationPolicy(WStr("")), CallTargetInstantiationPolicy::Typed);
+    EXPECT_EQ(ParseCallTargetInstantiationPolicy(WStr("typed")), CallTargetInstantiationPolicy::Typed);
+    EXPECT_EQ(ParseCallTargetInstantiationPolicy(WStr("canonical")), CallTargetInstantiationPolicy::Canonical);
+    EXPECT_EQ(ParseCallTargetInstantiationPolicy(WStr("shared")), CallTargetInstantiationPolicy::Typed);
+}
+
+TEST(CallTargetInstantiationsTest, ReferenceTypesShareTheCompiledInstantiation)
+{
+    CallTargetInstantiations instantiations;
+    const CallTargetGenericArgument integration{WStr("App.Integration"), false};
+
+    EXPECT_TRUE(instantiations.Add(WStr("BeginMethod"),
+                                   {integration, {WStr("App.Client"), false}, {WStr("System.String"), false}}));
+    EXPECT_FALSE(instantiations.Add(WStr("BeginMethod"),
+                                    {integration, {WStr("App.Server"), false}, {WStr("System.Uri"), false}}));
+    EXPECT_FALSE(instantiations.Add(WStr("BeginMethod"),
+                                    {integration, {WStr("App.Client"), false}, {WStr("System.String"), false}}));
+
+    // Each value type, as the target type or as an argument, is compiled again.
+    EXPECT_TRUE(instantiations.Add(WStr("BeginMethod"),
+                                   {integration, {WStr("App.Client"), false}, {WStr("System.Int32"), true}}));
+    EXPECT_TRUE(instantiations.Add(WStr("BeginMethod"),
+                                   {integration, {WStr("App.Client"), false}, {WStr("System.Int64"), true}}));
+    EXPECT_TRUE(instantiations.Add(WStr("BeginMethod"),
+                                   {integration, {WStr("App.Point"), true}, {WStr("System.String"), false}}));
+
+    // The overloads are different methods.
+    EXPECT_TRUE(instantiations.Add(WStr("EndMethod"), {integration, {WStr("App.Client"), false}}));
+
+    EXPECT_EQ(instantiations.CallSites(), 7);
+    EXPECT_EQ(instantiations.ExactCount(), 6);
+    EXPECT_EQ(instantiations.CanonicalCount(), 5);
+}
+
+TEST(CallTargetInstantiationsTest, CanonicalArgumentsShareTheCompiledInstantiation)
+{
+    CallTargetInstantiations instantiations;
+    const CallTargetGenericArgument integration{WStr("App.Integration"), false};
+    const CallTargetGenericArgument target{WStr("App.Client"), false};
+
+    // The canonical policy passes the value-type arguments as System.Object.
+    EXPECT_TRUE(instantiations.Add(WStr("BeginMethod"), {integration, target, {WStr("System.Object"), false}}));
+    EXPECT_FALSE(instantiations.Add(WStr("BeginMethod"), {integration, target, {WStr("System.Object"), false}}));
+    EXPECT_FALSE(instantiations.Add(WStr("BeginMethod"), {integration, target, {WStr("System.String"), false}}));
+
+    EXPECT_EQ(instantiations.ExactCount(), 2);
+    EXPECT_EQ(instantiations.CanonicalCount(), 1);
+}
+
+TEST(CallTargetInstantiationsTest, SelectsTheDeclaredArguments)
+{
+    std::vector<ULONG> positions;
+    EXPECT_TRUE(SelectCallTargetArguments({2, 0}, 3, 8, positions));
+    EXPECT_EQ(std::vector<ULONG>({2, 0}), positions);
+
+    EXPECT_TRUE(SelectCallTargetArguments({}, 3, 8, positions));
+    EXPECT_TRUE(positions.empty());
+
+    // A wide method only passes the declared arguments.
+    EXPECT_TRUE(SelectCallTargetArguments({11}, 12, 8, positions));
+    EXPECT_EQ(std::vector<ULONG>({11}), positions);
+
+    EXPECT_FALSE(SelectCallTargetArguments({3}, 3, 8, positions));
+    EXPECT_TRUE(positions.empty());
+    EXPECT_FALSE(SelectCallTargetArguments({1, 1}, 3, 8, positions));
+    EXPECT_TRUE(positions.empty());
+    EXPECT_FALSE(SelectCallTargetArguments({0, 1, 2}, 3, 2, positions));
+}
@@ -0,0 +1,52 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_outline.h"
+
+using namespace trace;
+
+// instance int M(int, string)
+static const COR_SIGNATURE instance_signature[] = {IMAGE_CEE_CS_CALLCONV_HASTHIS, 2, ELEMENT_TYPE_I4, ELEMENT_TYPE_I4,
+                                                   ELEMENT_TYPE_STRING};
+
+// static void N<T>(T)
+static const COR_SIGNATURE generic_signature[] = {IMAGE_CEE_CS_CALLCONV_GENERIC, 1, 1, ELEMENT_TYPE_VOID,
+                                                  ELEMENT_TYPE_MVAR, 0};
+
+// vararg void V(int)
+static const COR_SIGNATURE vararg_signature[] = {IMAGE_CEE_CS_CALLCONV_VARARG, 1, ELEMENT_TYPE_VOID, ELEMENT_TYPE_I4};
+
+static FunctionInfo CreateFunctionInfo(const COR_SIGNATURE* signature, unsigned size)
+{
+    const TypeInfo type(0x02000002, WStr("Type"), mdTypeSpecNil, mdtTypeDef, nullptr, false, false, nullptr);
+    FunctionInfo   function_info(0x06000001, WStr("Method"), type, MethodSignature(),
+                                 FunctionMethodSignature(signature, size));
+    EXPECT_EQ(S_OK, function_info.method_signature.TryParse());
+    return function_info;
+}
+
+TEST(CallTargetOutlineTest, OnlyNonGenericMethodsAreOutlined)
+{
+    EXPECT_TRUE(CanOutlineMethod(CreateFunctionInfo(instance_signature, sizeof(instance_signature))));
+    EXPECT_FALSE(CanOutlineMethod(CreateFunctionInfo(generic_signature, sizeof(generic_signature))));
+    EXPECT_FALSE(CanOutlineMethod(CreateFunctionInfo(vararg_signature, sizeof(vararg_signature))));
+}
+
+TEST(CallTargetOutlineTest, OutlinedMethodIsCalledWithTheArguments)
+{
+    const auto function_info       = CreateFunctionInfo(instance_signature, sizeof(instance_signature));
+    const auto outlined_method_def = static_cast<mdMethodDef>(0x06000042);
+    ILRewriter rewriter(function_info.id);
+
+    ASSERT_EQ(S_OK, WriteOutlinedMethodCall(&rewriter, function_info, outlined_method_def));
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_EQ(9, decoder.GetCodeSize());
+    EXPECT_EQ(0, decoder.EHCount());
+    EXPECT_EQ(CEE_LDARG_0, decoder.Code[0]);
+    EXPECT_EQ(CEE_LDARG_1, decoder.Code[1]);
+    EXPECT_EQ(CEE_LDARG_2, decoder.Code[2]);
+    EXPECT_EQ(CEE_CALL, decoder.Code[3]);
+    EXPECT_EQ(outlined_method_def, *reinterpret_cast<const mdMethodDef*>(&decoder.Code[4]));
+    EXPECT_EQ(CEE_RET, decoder.Code[8]);
+}
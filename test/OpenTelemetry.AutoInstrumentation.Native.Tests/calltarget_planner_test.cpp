@@ -0,0 +1,85 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_planner.h"
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/il_rewriter.h"
+
+using namespace trace;
+
+// Tiny method body: ldarg.0, brfalse.s +1, ret, ret
+static const BYTE two_returns_body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (5 << 2)),
+                                        CEE_LDARG_0,
+                                        CEE_BRFALSE_S,
+                                        0x01,
+                                        CEE_RET,
+                                        CEE_RET};
+
+// Fat method body: try { nop, leave.s +1 } finally { endfinally } ret
+static const BYTE try_finally_body[] = {
+    static_cast<BYTE>(CorILMethod_FatFormat | CorILMethod_MoreSects), 0x30, 0x08, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, CEE_NOP, CEE_LEAVE_S, 0x01, CEE_ENDFINALLY, CEE_RET, 0x00, 0x00, 0x00,
+    // Small exception handling section with a finally clause
+    CorILMethod_Sect_EHTable, 16, 0x00, 0x00, COR_ILEXCEPTION_CLAUSE_FINALLY, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x00};
+
+// static void M()
+static const COR_SIGNATURE static_void_signature[] = {IMAGE_CEE_CS_CALLCONV_DEFAULT, 0, ELEMENT_TYPE_VOID};
+
+static std::vector<BYTE> InsertNops(LPCBYTE original_body, int count)
+{
+    ILRewriter rewriter(mdTokenNil);
+    EXPECT_EQ(S_OK, rewriter.Import(original_body));
+    for (int i = 0; i < count; i++)
+    {
+        ILInstr* nop  = rewriter.NewILInstr();
+        nop->m_opcode = CEE_NOP;
+        rewriter.InsertBefore(rewriter.GetILList()->m_pNext, nop);
+    }
+    EXPECT_EQ(S_OK, rewriter.Export());
+    return rewriter.GetExportedBody();
+}
+
+TEST(CallTargetPlannerTest, MeasureRewriteComparesTheOriginalAndRewrittenBodies)
+{
+    const auto rewritten = InsertNops(two_returns_body, 3);
+
+    const auto size = CallTarget_MeasureRewrite(two_returns_body, rewritten);
+
+    EXPECT_EQ(5, size.original_code_size);
+    EXPECT_EQ(2, size.return_count);
+    EXPECT_EQ(8, size.rewritten_code_size);
+    EXPECT_EQ(rewritten.size(), size.rewritten_body_size);
+    EXPECT_EQ(0, size.exception_clauses);
+}
+
+TEST(CallTargetPlannerTest, MeasureRewriteCountsTheExceptionClauses)
+{
+    const auto rewritten = InsertNops(try_finally_body, 1);
+
+    const auto size = CallTarget_MeasureRewrite(try_finally_body, rewritten);
+
+    EXPECT_EQ(5, size.original_code_size);
+    EXPECT_EQ(1, size.return_count);
+    EXPECT_EQ(6, size.rewritten_code_size);
+    EXPECT_EQ(1, size.exception_clauses);
+}
+
+TEST(CallTargetPlannerTest, GenericValueTypeMethodsAreRejected)
+{
+    const TypeInfo value_type(0x02000002, WStr("Point`1"), mdTypeSpecNil, mdtTypeDef, nullptr, true, true, nullptr);
+    FunctionInfo   function_info(0x06000001, WStr("Method"), value_type, MethodSignature(),
+                                 FunctionMethodSignature(static_void_signature, sizeof(static_void_signature)));
+
+    EXPECT_FALSE(CallTarget_GetRewriteRejection(function_info).empty());
+}
+
+TEST(CallTargetPlannerTest, CoreLibTargetsMustBeAllowListed)
+{
+    EXPECT_TRUE(CallTarget_IsTargetAllowed(WStr("System.Net.Http"), WStr("System.Net.Http.HttpClient"),
+                                           WStr("SendAsync")));
+    EXPECT_TRUE(CallTarget_IsTargetAllowed(WStr("System.Private.CoreLib"),
+                                           WStr("System.Threading.ThreadPoolWorkQueue"), WStr("DispatchWorkItem")));
+    EXPECT_FALSE(CallTarget_IsTargetAllowed(WStr("System.Private.CoreLib"), WStr("System.Threading.Monitor"),
+                                            WStr("Enter")));
+    EXPECT_FALSE(CallTarget_IsTargetAllowed(WStr("mscorlib"), WStr("System.Threading.ThreadPoolWorkQueue"),
+                                            WStr("Dispatch")));
+}
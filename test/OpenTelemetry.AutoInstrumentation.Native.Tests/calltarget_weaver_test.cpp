@@ -0,0 +1,261 @@
+#include "pch.h"
+
+#include <fstream>
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_weaver.h"
+#include "test_helpers.h"
+
+using namespace trace;
+
+class CallTargetWeaverTest : public ::CLRHelperTestBase
+{
+protected:
+    const WSTRING assembly_path_ = WStr("TestApplication.ExampleLibrary.dll");
+    const WSTRING woven_path_    = WStr("TestApplication.ExampleLibrary.Woven.dll");
+
+    std::vector<IntegrationMethod> AddIntegration(bool declares_arguments = false,
+                                                  std::vector<USHORT> argument_indices = {}) const
+    {
+        const MethodReference target(WStr("TestApplication.ExampleLibrary"), WStr("TestApplication.ExampleLibrary.Class1"),
+                                     WStr("Add"), min_ver_, max_ver_, {},
+                                     {WStr("System.Int32"), WStr("System.Int32"), WStr("System.Int32")});
+        const MethodReference wrapper(WStr("OpenTelemetry.AutoInstrumentation"),
+                                      WStr("OpenTelemetry.AutoInstrumentation.Instrumentations.Example.AddIntegration"),
+                                      EmptyWStr, min_ver_, min_ver_, {}, {});
+        return {IntegrationMethod(WStr("Example"), MethodReplacement({}, target, wrapper, IntegrationKind::CallTarget,
+                                                                     declares_arguments, argument_indices))};
+    }
+
+    // Returns the number of type arguments of the BeginMethod instantiation called by the woven Add method.
+    ULONG GetBeginMethodTypeArgumentCount(const WSTRING& woven_path) const
+    {
+        CallTargetAssemblyFile woven;
+        EXPECT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, woven_path, woven).empty());
+        const auto& metadata_import = woven.module_metadata->metadata_import;
+
+        const auto add = FunctionToTest(WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"));
+        ULONG      rva = 0;
+        EXPECT_EQ(S_OK, metadata_import->GetMethodProps(add.id, nullptr, nullptr, 0, nullptr, nullptr, nullptr,
+                                                        nullptr, &rva, nullptr));
+
+        ILRewriter rewriter(add.id);
+        EXPECT_EQ(S_OK, rewriter.Import(CallTarget_GetMethodBodyFromImage(woven.image, rva)));
+        for (ILInstr* pInstr = rewriter.GetILList()->m_pNext; pInstr != rewriter.GetILList(); pInstr = pInstr->m_pNext)
+        {
+            if (pInstr->m_opcode != CEE_CALL || TypeFromToken(pInstr->m_Arg32) != mdtMethodSpec)
+            {
+                continue;
+            }
+
+            mdToken         parent    = mdTokenNil;
+            PCCOR_SIGNATURE signature = nullptr;
+            ULONG           length    = 0;
+            WCHAR           name[kNameMaxSize]{};
+            ULONG           name_length = 0;
+            if (SUCCEEDED(metadata_import->GetMethodSpecProps(pInstr->m_Arg32, &parent, &signature, &length)) &&
+                SUCCEEDED(metadata_import->GetMemberRefProps(parent, nullptr, name, kNameMaxSize, &name_length,
+                                                             nullptr, nullptr)) &&
+                WSTRING(name) == WStr("BeginMethod"))
+            {
+                // IMAGE_CEE_CS_CALLCONV_GENERICINST followed by the number of type arguments.
+                PCCOR_SIGNATURE type_arguments = signature + 1;
+                return CorSigUncompressData(type_arguments);
+            }
+        }
+        return 0;
+    }
+};
+
+TEST_F(CallTargetWeaverTest, WeavesTheMatchedMethodsOfAnAssemblyFile)
+{
+    const auto report = CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, woven_path_, AddIntegration());
+
+    ASSERT_FALSE(report.contains("error")) << report.dump();
+    ASSERT_EQ(1, report["methods"].size());
+    EXPECT_EQ("Add", report["methods"][0]["method"]);
+    EXPECT_FALSE(report["resign_required"].get<bool>());
+
+    // The woven assembly is reopened from the disk: the method points to the woven body, with the CallTarget
+    // exception handling clauses.
+    CallTargetAssemblyFile woven;
+    ASSERT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, woven_path_, woven).empty());
+
+    const auto add = FunctionToTest(WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"));
+    ULONG      rva = 0;
+    ASSERT_EQ(S_OK, woven.module_metadata->metadata_import->GetMethodProps(add.id, nullptr, nullptr, 0, nullptr,
+                                                                           nullptr, nullptr, nullptr, &rva, nullptr));
+    EXPECT_EQ(report["methods"][0]["rva"].get<ULONG>(), rva);
+
+    const auto body = CallTarget_GetMethodBodyFromImage(woven.image, rva);
+    ASSERT_NE(nullptr, body);
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)body);
+    EXPECT_TRUE(decoder.IsFat());
+    ASSERT_NE(nullptr, decoder.EH);
+    EXPECT_EQ(4, decoder.EH->EHCount());
+}
+
+TEST_F(CallTargetWeaverTest, DoesNotWeaveAnAssemblyTwice)
+{
+    const auto report = CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, woven_path_, AddIntegration());
+    ASSERT_FALSE(report.contains("error")) << report.dump();
+
+    const auto second = CallTarget_WeaveAssemblyFile(metadata_dispenser_, woven_path_,
+                                                     WStr("TestApplication.ExampleLibrary.Woven2.dll"),
+                                                     AddIntegration());
+    EXPECT_EQ("The assembly is already woven.", second["error"]);
+}
+
+TEST_F(CallTargetWeaverTest, RecordsOnlyTheWovenMethods)
+{
+    auto integrations = AddIntegration();
+    integrations.push_back(IntegrationMethod(
+        WStr("ExampleMetrics"),
+        MethodReplacement({}, integrations[0].replacement.target_method, {}, IntegrationKind::MethodMetrics)));
+    const auto report = CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, woven_path_, integrations);
+    ASSERT_FALSE(report.contains("error")) << report.dump();
+    ASSERT_EQ(1, report["methods"].size());
+
+    CallTargetAssemblyFile woven;
+    ASSERT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, woven_path_, woven).empty());
+
+    // The profiler skips the CallTarget rewrite of Add only, the other integrations are still applied at runtime.
+    std::unordered_set<mdMethodDef> woven_method_defs;
+    ASSERT_TRUE(CallTarget_IsWovenModule(woven.module_metadata->metadata_import,
+                                         woven.module_metadata->assembly_import, &woven_method_defs));
+    const auto add = FunctionToTest(WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"));
+    EXPECT_EQ(std::unordered_set<mdMethodDef>{add.id}, woven_method_defs);
+}
+
+TEST_F(CallTargetWeaverTest, DoesNotTakeAReferenceToTheInvokerForAWovenAssembly)
+{
+    CallTargetAssemblyFile file;
+    ASSERT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, assembly_path_, file).empty());
+
+    // An assembly using the invoker, e.g. with typeof(CallTargetInvoker), references it without being woven.
+    const auto&      metadata = *file.module_metadata;
+    ASSEMBLYMETADATA assembly_metadata{};
+    mdAssemblyRef    assembly_ref = mdAssemblyRefNil;
+    mdTypeRef        invoker_ref  = mdTypeRefNil;
+    ASSERT_EQ(S_OK, metadata.assembly_emit->DefineAssemblyRef(nullptr, 0, WStr("OpenTelemetry.AutoInstrumentation"),
+                                                              &assembly_metadata, nullptr, 0, 0, &assembly_ref));
+    ASSERT_EQ(S_OK, metadata.metadata_emit->DefineTypeRefByName(
+                        assembly_ref, WStr("OpenTelemetry.AutoInstrumentation.CallTarget.CallTargetInvoker"),
+                        &invoker_ref));
+
+    EXPECT_FALSE(CallTarget_IsWovenModule(metadata.metadata_import, metadata.assembly_import));
+}
+
+TEST_F(CallTargetWeaverTest, PlansTheSizesOfTheWovenBodies)
+{
+    const auto plan   = CallTarget_PlanAssemblyFile(metadata_dispenser_, assembly_path_, AddIntegration());
+    const auto report = CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, woven_path_, AddIntegration());
+
+    ASSERT_EQ(1, plan["methods"].size());
+    ASSERT_EQ(1, report["methods"].size());
+    EXPECT_EQ(report["methods"][0]["body_size"], plan["methods"][0]["predicted_body_size"]);
+    EXPECT_EQ(4, plan["methods"][0]["exception_clauses"]);
+    EXPECT_EQ(plan["metadata_tokens"], plan["methods"][0]["metadata_tokens"]);
+}
+
+TEST_F(CallTargetWeaverTest, PassesOnlyTheSelectedArgumentsToBeginMethod)
+{
+    const WSTRING selected_path = WStr("TestApplication.ExampleLibrary.Selected.dll");
+    ASSERT_EQ(1, CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, woven_path_, AddIntegration())
+                     ["methods"].size());
+    ASSERT_EQ(1, CallTarget_WeaveAssemblyFile(metadata_dispenser_, assembly_path_, selected_path,
+                                              AddIntegration(true, {1}))["methods"].size());
+
+    // TIntegration, TTarget and the arguments passed to BeginMethod.
+    EXPECT_EQ(4, GetBeginMethodTypeArgumentCount(woven_path_));
+    EXPECT_EQ(3, GetBeginMethodTypeArgumentCount(selected_path));
+}
+
+TEST_F(CallTargetWeaverTest, PlansTheSelectedArguments)
+{
+    const auto plan     = CallTarget_PlanAssemblyFile(metadata_dispenser_, assembly_path_, AddIntegration());
+    const auto selected = CallTarget_PlanAssemblyFile(metadata_dispenser_, assembly_path_, AddIntegration(true, {}));
+
+    // The woven body doesn't load the arguments that BeginMethod doesn't receive.
+    ASSERT_EQ(1, plan["methods"].size());
+    ASSERT_EQ(1, selected["methods"].size());
+    EXPECT_LT(selected["methods"][0]["predicted_body_size"].get<unsigned>(),
+              plan["methods"][0]["predicted_body_size"].get<unsigned>());
+}
+
+TEST_F(CallTargetWeaverTest, PlansReportTheAssembliesThatCannotBeRead)
+{
+    const auto plan = CallTarget_PlanAssemblyFile(metadata_dispenser_, WStr("missing.dll"), AddIntegration());
+
+    EXPECT_TRUE(plan.contains("error"));
+    EXPECT_TRUE(plan["methods"].empty());
+    EXPECT_TRUE(plan["rejections"].empty());
+}
+
+TEST_F(CallTargetWeaverTest, PlansSkipTheFilesThatAreNotTargetedAssemblies)
+{
+    // A native library has no metadata, it is skipped and not reported as a failure.
+    const WSTRING native_path = WStr("native.dll");
+    std::ofstream(ToString(native_path), std::ios::binary) << "MZ";
+    const auto native_plan = CallTarget_PlanAssemblyFile(metadata_dispenser_, native_path, AddIntegration());
+    EXPECT_EQ("The file is not a .NET assembly.", native_plan["skipped"]);
+    EXPECT_FALSE(native_plan.contains("error"));
+
+    const MethodReference target(WStr("TestApplication.Other"), WStr("TestApplication.Other.Class1"), WStr("Add"),
+                                 min_ver_, max_ver_, {}, {WStr("System.Int32"), WStr("System.Int32")});
+    const auto                           wrapper = AddIntegration()[0].replacement.wrapper_method;
+    const std::vector<IntegrationMethod> other_integrations{
+        IntegrationMethod(WStr("Other"), MethodReplacement({}, target, wrapper))};
+    const auto other_plan = CallTarget_PlanAssemblyFile(metadata_dispenser_, assembly_path_, other_integrations);
+    EXPECT_EQ("No integration targets the assembly.", other_plan["skipped"]);
+    EXPECT_EQ("TestApplication.ExampleLibrary", other_plan["assembly"]);
+    EXPECT_TRUE(other_plan["methods"].empty());
+}
+
+TEST_F(CallTargetWeaverTest, PlansListTheIntegrationsMatchedAtRuntime)
+{
+    const auto add = AddIntegration()[0].replacement;
+    const MethodReference derived(add.target_method.assembly.name, add.target_method.type_name,
+                                  add.target_method.method_name, min_ver_, max_ver_, {},
+                                  add.target_method.signature_types, TargetMethodKind::Derived);
+    const MethodReference caller(add.target_method.assembly.name, add.target_method.type_name, WStr("Multiply"),
+                                 min_ver_, max_ver_, {}, {});
+    const std::vector<IntegrationMethod> integrations{
+        IntegrationMethod(WStr("Derived"), MethodReplacement({}, derived, add.wrapper_method)),
+        IntegrationMethod(WStr("CallSite"),
+                          MethodReplacement(caller, add.target_method, add.wrapper_method, IntegrationKind::CallSite))};
+
+    const auto plan = CallTarget_PlanAssemblyFile(metadata_dispenser_, assembly_path_, integrations);
+
+    ASSERT_FALSE(plan.contains("error")) << plan.dump();
+    EXPECT_TRUE(plan["methods"].empty());
+    ASSERT_EQ(2, plan["not_planned"].size());
+    EXPECT_EQ("Derived", plan["not_planned"][0]["integration"]);
+    EXPECT_EQ("CallSite", plan["not_planned"][1]["integration"]);
+    EXPECT_FALSE(plan["not_planned"][1]["reason"].get<std::string>().empty());
+}
+
+TEST_F(CallTargetWeaverTest, MatchesTheAssemblyExtensionsWhateverTheirCase)
+{
+    EXPECT_TRUE(CallTarget_HasAssemblyExtension("app/Library.dll"));
+    EXPECT_TRUE(CallTarget_HasAssemblyExtension("app/Library.DLL"));
+    EXPECT_TRUE(CallTarget_HasAssemblyExtension("app/App.Exe"));
+    EXPECT_FALSE(CallTarget_HasAssemblyExtension("app/Library.pdb"));
+    EXPECT_FALSE(CallTarget_HasAssemblyExtension("app/dll"));
+}
+
+TEST_F(CallTargetWeaverTest, DoesNotReturnTheMethodBodiesTruncatedInTheImage)
+{
+    CallTargetAssemblyFile file;
+    ASSERT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, assembly_path_, file).empty());
+
+    const auto add = FunctionToTest(WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"));
+    ULONG      rva = 0;
+    ASSERT_EQ(S_OK, file.module_metadata->metadata_import->GetMethodProps(add.id, nullptr, nullptr, 0, nullptr,
+                                                                          nullptr, nullptr, nullptr, &rva, nullptr));
+    const auto body = CallTarget_GetMethodBodyFromImage(file.image, rva);
+    ASSERT_NE(nullptr, body);
+
+    // The header of the body is in the image, its code isn't.
+    const std::vector<BYTE> truncated(file.image.begin(), file.image.begin() + (body - file.image.data()) + 1);
+    EXPECT_EQ(nullptr, CallTarget_GetMethodBodyFromImage(truncated, rva));
+}
@@ -0,0 +1,102 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/cost_attribution.h"
+
+using namespace trace;
+
+TEST(CostAttributionTest, NothingIsRecordedUntilEnabled)
+{
+    CostAttribution cost_attribution;
+    cost_attribution.AddIntegrationCost(WStr("MongoDB"), CostPhase::Match, 1000, 1);
+    cost_attribution.AddAssemblyCost(WStr("MongoDB.Driver"), CostPhase::Match, 1000, 1);
+    cost_attribution.AddNGenInlinersCost(1000, 1);
+
+    EXPECT_FALSE(cost_attribution.IsEnabled());
+    EXPECT_TRUE(cost_attribution.GetIntegrations().empty());
+    EXPECT_TRUE(cost_attribution.GetAssemblies().empty());
+    EXPECT_EQ(cost_attribution.GetNGenInliners().TotalNs(), 0);
+}
+
+TEST(CostAttributionTest, CostsAreSortedByTotalDuration)
+{
+    CostAttribution cost_attribution;
+    cost_attribution.Enable();
+    cost_attribution.AddAssemblyCost(WStr("System.Net.Http"), CostPhase::Match, 3000, 2);
+    cost_attribution.AddAssemblyCost(WStr("Generated"), CostPhase::Match, 2000, 0);
+    cost_attribution.AddAssemblyCost(WStr("Generated"), CostPhase::Rewrite, 5000, 1);
+    cost_attribution.AddAssemblyCost(WStr("System.Net.Http"), CostPhase::ReJit, 1000, 2);
+
+    const auto assemblies = cost_attribution.GetAssemblies();
+    ASSERT_EQ(assemblies.size(), 2);
+    EXPECT_EQ(assemblies[0].first, WStr("Generated"));
+    EXPECT_EQ(assemblies[0].second.TotalNs(), 7000);
+    EXPECT_EQ(assemblies[0].second.rewrite_count, 1);
+    EXPECT_EQ(assemblies[1].first, WStr("System.Net.Http"));
+    EXPECT_EQ(assemblies[1].second.match_ns, 3000);
+    EXPECT_EQ(assemblies[1].second.match_count, 2);
+    EXPECT_EQ(assemblies[1].second.rejit_count, 2);
+}
+
+TEST(CostAttributionTest, RewritesAreAttributedToTheIntegrationOfTheWrapper)
+{
+    CostAttribution cost_attribution;
+    cost_attribution.Enable();
+    cost_attribution.SetWrapperIntegration(WStr("App.MongoIntegration"), WStr("MongoDB"));
+    cost_attribution.AddWrapperCost(WStr("App.MongoIntegration"), CostPhase::Rewrite, 4000, 1);
+    cost_attribution.AddWrapperCost(WStr("App.UnknownIntegration"), CostPhase::Rewrite, 1000, 1);
+    cost_attribution.AddIntegrationCost(WStr("MongoDB"), CostPhase::Match, 1000, 3);
+
+    const auto integrations = cost_attribution.GetIntegrations();
+    ASSERT_EQ(integrations.size(), 2);
+    EXPECT_EQ(integrations[0].first, WStr("MongoDB"));
+    EXPECT_EQ(integrations[0].second.TotalNs(), 5000);
+    EXPECT_EQ(integrations[0].second.match_count, 3);
+    EXPECT_EQ(integrations[0].second.rewrite_count, 1);
+    EXPECT_EQ(integrations[1].first, WStr("App.UnknownIntegration"));
+}
+
+TEST(CostAttributionTest, ReportListsTheMostExpensiveEntries)
+{
+    CostAttribution cost_attribution;
+    cost_attribution.Enable();
+    cost_attribution.AddIntegrationCost(WStr("MongoDB"), CostPhase::Rewrite, 2500000, 2);
+    cost_attribution.AddIntegrationCost(WStr("GraphQL"), CostPhase::Rewrite, 1000000, 1);
+    cost_attribution.AddNGenInlinersCost(500000, 3);
+
+    EXPECT_EQ(cost_attribution.ToString(1),
+              "[Integrations=[MongoDB=2.50ms (Match=0.00ms/0, ReJit=0.00ms/0, Rewrite=2.50ms/2), 1 more], "
+              "Assemblies=[], NGenInliners=0.50ms/3]");
+}
+
+TEST(CostAttributionTest, EntriesAreCappedForUnloadedAssemblies)
+{
+    CostAttribution cost_attribution;
+    cost_attribution.Enable();
+
+    // Each cycle loads an assembly with a new name in a collectible AssemblyLoadContext, and unloads it.
+    for (int i = 0; i < 10000; i++)
+    {
+        const auto name = WStr("Generated") + ToWSTRING(std::to_string(i));
+        cost_attribution.AddAssemblyCost(name, CostPhase::Match, 1000, 1);
+        cost_attribution.SetWrapperIntegration(name, WStr("Generated"));
+        cost_attribution.AddWrapperCost(name, CostPhase::Rewrite, 1000, 1);
+    }
+
+    const auto assemblies = cost_attribution.GetAssemblies();
+    ASSERT_EQ(assemblies.size(), CostAttributionMaxEntries);
+    EXPECT_EQ(assemblies[0].first, CostAttributionOtherEntry);
+    EXPECT_EQ(assemblies[0].second.match_count, 10000 - (CostAttributionMaxEntries - 1));
+
+    // The wrapper types recorded after the first ones are unknown, their rewrites are attributed by type name.
+    const auto integrations = cost_attribution.GetIntegrations();
+    ASSERT_EQ(integrations.size(), CostAttributionMaxEntries);
+    EXPECT_EQ(integrations[0].first, CostAttributionOtherEntry);
+    EXPECT_EQ(integrations[1].first, WStr("Generated"));
+    EXPECT_EQ(integrations[1].second.rewrite_count, CostAttributionMaxEntries);
+    unsigned long long rewrite_count = 0;
+    for (const auto& integration : integrations)
+    {
+        rewrite_count += integration.second.rewrite_count;
+    }
+    EXPECT_EQ(rewrite_count, 10000);
+}
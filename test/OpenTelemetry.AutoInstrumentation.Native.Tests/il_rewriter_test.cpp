@@ -0,0 +1,329 @@
+#include "pch.h"
+
+#include <vector>
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_rewriter.h"
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/calltarget_weaver.h"
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/il_rewriter.h"
+#include "test_helpers.h"
+
+using namespace trace;
+
+// Tiny method body: ldarg.0, ret
+static const BYTE tiny_body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (2 << 2)), CEE_LDARG_0, CEE_RET};
+
+TEST(ILRewriterTest, OfflineImportRequiresMethodBody)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_TRUE(rewriter.IsOffline());
+    ASSERT_EQ(E_UNEXPECTED, rewriter.Import());
+    ASSERT_EQ(E_INVALIDARG, rewriter.Import(nullptr));
+}
+
+TEST(ILRewriterTest, OfflineRoundTripKeepsOriginalCode)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(tiny_body));
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    const auto& body = rewriter.GetExportedBody();
+    ASSERT_FALSE(body.empty());
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)body.data());
+    ASSERT_EQ(2, decoder.GetCodeSize());
+    ASSERT_EQ(CEE_LDARG_0, decoder.Code[0]);
+    ASSERT_EQ(CEE_RET, decoder.Code[1]);
+}
+
+TEST(ILRewriterTest, OfflineExportContainsInsertedInstructions)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(tiny_body));
+
+    ILInstr* nop  = rewriter.NewILInstr();
+    nop->m_opcode = CEE_NOP;
+    rewriter.InsertBefore(rewriter.GetILList()->m_pNext, nop);
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_EQ(3, decoder.GetCodeSize());
+    ASSERT_EQ(CEE_NOP, decoder.Code[0]);
+    ASSERT_EQ(CEE_LDARG_0, decoder.Code[1]);
+    ASSERT_EQ(CEE_RET, decoder.Code[2]);
+}
+
+static void ExpectILMap(const std::vector<COR_IL_MAP>& map, const std::vector<std::pair<ULONG32, ULONG32>>& expected)
+{
+    ASSERT_EQ(expected.size(), map.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].first, map[i].oldOffset);
+        EXPECT_EQ(expected[i].second, map[i].newOffset);
+        EXPECT_TRUE(map[i].fAccurate);
+    }
+}
+
+static void InsertNops(ILRewriter& rewriter, ILInstr* where, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        ILInstr* nop  = rewriter.NewILInstr();
+        nop->m_opcode = CEE_NOP;
+        rewriter.InsertBefore(where, nop);
+    }
+}
+
+TEST(ILRewriterTest, InstrumentedCodeMapSkipsPrologue)
+{
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(tiny_body));
+    InsertNops(rewriter, rewriter.GetILList()->m_pNext, 3);
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    ExpectILMap(rewriter.GetILInstrumentedCodeMap(), {{0, 3}, {1, 4}});
+    ASSERT_EQ(S_FALSE, rewriter.SetILInstrumentedCodeMap());
+}
+
+TEST(ILRewriterTest, InstrumentedCodeMapFollowsWidenedBranches)
+{
+    // ldarg.0, brtrue.s +1, nop, ret
+    static const BYTE body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (5 << 2)),
+                                CEE_LDARG_0,
+                                CEE_BRTRUE_S,
+                                1,
+                                CEE_NOP,
+                                CEE_RET};
+
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(body));
+
+    // The branch over the inserted code doesn't fit in a short form anymore.
+    ILInstr* original_nop = rewriter.GetILList()->m_pNext->m_pNext->m_pNext;
+    InsertNops(rewriter, original_nop, 200);
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_EQ(208, decoder.GetCodeSize());
+    ASSERT_EQ(CEE_BRTRUE, decoder.Code[1]);
+    ExpectILMap(rewriter.GetILInstrumentedCodeMap(), {{0, 0}, {1, 1}, {3, 206}, {4, 207}});
+}
+
+TEST(ILRewriterTest, InstrumentedCodeMapSkipsSwitchTargets)
+{
+    // ldarg.0, switch (2 targets), ret
+    static const BYTE body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (15 << 2)),
+                                CEE_LDARG_0,
+                                CEE_SWITCH,
+                                2, 0, 0, 0,
+                                0, 0, 0, 0,
+                                0, 0, 0, 0,
+                                CEE_RET};
+
+    ILRewriter rewriter(mdTokenNil);
+    ASSERT_EQ(S_OK, rewriter.Import(body));
+    InsertNops(rewriter, rewriter.GetILList()->m_pNext, 1);
+    InsertNops(rewriter, rewriter.GetILList(), 2);
+    ASSERT_EQ(S_OK, rewriter.Export());
+
+    ExpectILMap(rewriter.GetILInstrumentedCodeMap(), {{0, 1}, {1, 2}, {14, 15}});
+}
+
+// Rewrites hand-written method bodies with the CallTarget rewrite, offline, as the weaver does.
+class ILRewriterCallTargetTest : public ::CLRHelperTestBase
+{
+protected:
+    CallTargetAssemblyFile file_;
+    mdTypeRef              wrapper_type_ref_ = mdTypeRefNil;
+
+    void SetUp() override
+    {
+        CLRHelperTestBase::SetUp();
+        const WSTRING assembly_path = WStr("TestApplication.ExampleLibrary.dll");
+        ASSERT_TRUE(CallTarget_OpenAssemblyFile(metadata_dispenser_, assembly_path, file_).empty());
+
+        const auto&      metadata = *file_.module_metadata;
+        ASSEMBLYMETADATA assembly_metadata{};
+        mdAssemblyRef    assembly_ref = mdAssemblyRefNil;
+        ASSERT_EQ(S_OK, metadata.assembly_emit->DefineAssemblyRef(nullptr, 0, WStr("OpenTelemetry.AutoInstrumentation"),
+                                                                  &assembly_metadata, nullptr, 0, 0, &assembly_ref));
+        const WSTRING wrapper_type = WStr("OpenTelemetry.AutoInstrumentation.Instrumentations.Example.AddIntegration");
+        ASSERT_EQ(S_OK, metadata.metadata_emit->DefineTypeRefByName(assembly_ref, wrapper_type.c_str(),
+                                                                    &wrapper_type_ref_));
+    }
+
+    // Applies the CallTarget rewrite of a method to the given body, as if it was the body of the method.
+    void Rewrite(ILRewriter& rewriter, const WSTRING& type_name, const WSTRING& method_name, LPCBYTE body)
+    {
+        const auto target = FunctionToTest(type_name, method_name);
+        auto       caller = GetFunctionInfo(file_.module_metadata->metadata_import, target.id);
+        ASSERT_EQ(S_OK, caller.method_signature.TryParse());
+        ASSERT_EQ(S_OK, rewriter.Import(body));
+        ASSERT_EQ(S_OK, CallTarget_RewriteMethodBody(&rewriter, file_.module_metadata.get(), &caller,
+                                                     wrapper_type_ref_));
+        ASSERT_EQ(S_OK, rewriter.Export());
+    }
+
+    // Returns the new offset of an original offset, or UINT32_MAX if it is not mapped.
+    static ULONG32 MapOffset(const ILRewriter& rewriter, ULONG32 old_offset)
+    {
+        for (const auto& entry : rewriter.GetILInstrumentedCodeMap())
+        {
+            if (entry.oldOffset == old_offset)
+            {
+                return entry.newOffset;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    // Expects each original instruction, given by its offset and opcode, to be mapped in order to the same
+    // instruction of the rewritten code. The returns leave the CallTarget try block, and the short branches can be
+    // widened by the rewrite.
+    static void ExpectOriginalInstructionsMapped(const ILRewriter&                             rewriter,
+                                                 const std::vector<std::pair<ULONG32, BYTE>>& original)
+    {
+        const auto& map = rewriter.GetILInstrumentedCodeMap();
+        ASSERT_EQ(original.size(), map.size());
+
+        COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+        for (size_t i = 0; i < original.size(); i++)
+        {
+            EXPECT_EQ(original[i].first, map[i].oldOffset);
+            EXPECT_TRUE(map[i].fAccurate);
+            ASSERT_LT(map[i].newOffset, decoder.GetCodeSize());
+            if (i > 0)
+            {
+                EXPECT_GT(map[i].newOffset, map[i - 1].newOffset);
+            }
+
+            const BYTE opcode         = original[i].second;
+            const BYTE rewritten      = decoder.Code[map[i].newOffset];
+            const bool short_branch   = opcode >= CEE_BR_S && opcode <= CEE_BLT_UN_S;
+            const BYTE widened_opcode = short_branch            ? static_cast<BYTE>(opcode + CEE_BR - CEE_BR_S)
+                                        : opcode == CEE_LEAVE_S ? static_cast<BYTE>(CEE_LEAVE)
+                                                                : opcode;
+            if (opcode == CEE_RET)
+            {
+                EXPECT_TRUE(rewritten == CEE_LEAVE_S || rewritten == CEE_LEAVE) << "offset " << original[i].first;
+            }
+            else
+            {
+                EXPECT_TRUE(rewritten == opcode || rewritten == widened_opcode) << "offset " << original[i].first;
+            }
+        }
+    }
+};
+
+TEST_F(ILRewriterCallTargetTest, MapsTheOriginalOffsetsOfAVoidMethodWithASwitchAndMultipleReturns)
+{
+    // ldc.i4.1, switch (1 target: +1), ret, nop, ret
+    static const BYTE body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (13 << 2)),
+                                CEE_LDC_I4_1,
+                                CEE_SWITCH,
+                                1, 0, 0, 0,
+                                1, 0, 0, 0,
+                                CEE_RET,
+                                CEE_NOP,
+                                CEE_RET};
+
+    ILRewriter rewriter(mdTokenNil);
+    Rewrite(rewriter, WStr("TestApplication.ExampleLibrary.FakeClient.DogClient`2"), WStr("Silence"), body);
+
+    // The CallTarget prologue shifts the original instructions.
+    ExpectOriginalInstructionsMapped(rewriter, {{0, CEE_LDC_I4_1}, {1, CEE_SWITCH}, {10, CEE_RET}, {11, CEE_NOP},
+                                                {12, CEE_RET}});
+    EXPECT_GT(MapOffset(rewriter, 0), 0u);
+
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_NE(nullptr, decoder.EH);
+    EXPECT_EQ(2, decoder.EH->EHCount());
+}
+
+TEST_F(ILRewriterCallTargetTest, MapsTheOriginalOffsetsOfANonVoidMethodWithMultipleReturns)
+{
+    // ldarg.1, brtrue.s +2, ldc.i4.0, ret, ldarg.1, ldarg.2, add, ret
+    static const BYTE body[] = {static_cast<BYTE>(CorILMethod_TinyFormat | (9 << 2)),
+                                CEE_LDARG_1,
+                                CEE_BRTRUE_S,
+                                2,
+                                CEE_LDC_I4_0,
+                                CEE_RET,
+                                CEE_LDARG_1,
+                                CEE_LDARG_2,
+                                CEE_ADD,
+                                CEE_RET};
+
+    ILRewriter rewriter(mdTokenNil);
+    Rewrite(rewriter, WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"), body);
+
+    // The value returned by each ret is stored before leaving the try block, the ret keeps its mapping.
+    ExpectOriginalInstructionsMapped(rewriter, {{0, CEE_LDARG_1}, {1, CEE_BRTRUE_S}, {3, CEE_LDC_I4_0}, {4, CEE_RET},
+                                                {5, CEE_LDARG_1}, {6, CEE_LDARG_2}, {7, CEE_ADD}, {8, CEE_RET}});
+    EXPECT_GT(MapOffset(rewriter, 4), MapOffset(rewriter, 3) + 1);
+    EXPECT_GT(MapOffset(rewriter, 8), MapOffset(rewriter, 7) + 1);
+}
+
+TEST_F(ILRewriterCallTargetTest, MapsTheOriginalOffsetsOfANonVoidMethodWithATryCatchAndASwitch)
+{
+    // The catch type is only copied by the rewrite.
+    const mdTypeRef catch_type = TokenFromRid(1, mdtTypeRef);
+
+    //  0: ldarg.1
+    //  1: switch (2 targets: +2, +4)
+    // 14: br.s +4
+    // 16: ldc.i4.1, ret
+    // 18: ldc.i4.2, ret
+    // 20: try { ldarg.1, ldarg.2, div, pop, leave.s +3 }
+    // 26: catch { pop, leave.s +0 }
+    // 29: ldc.i4.0, ret
+    const std::vector<BYTE> code = {CEE_LDARG_1,
+                                    CEE_SWITCH, 2, 0, 0, 0, 2, 0, 0, 0, 4, 0, 0, 0,
+                                    CEE_BR_S, 4,
+                                    CEE_LDC_I4_1, CEE_RET,
+                                    CEE_LDC_I4_2, CEE_RET,
+                                    CEE_LDARG_1, CEE_LDARG_2, CEE_DIV, CEE_POP, CEE_LEAVE_S, 3,
+                                    CEE_POP, CEE_LEAVE_S, 0,
+                                    CEE_LDC_I4_0, CEE_RET};
+
+    // Fat header with a small exception handling section.
+    std::vector<BYTE> body = {static_cast<BYTE>(CorILMethod_FatFormat | CorILMethod_MoreSects), 0x30, 8, 0};
+    const auto        code_size = static_cast<DWORD>(code.size());
+    body.insert(body.end(), reinterpret_cast<const BYTE*>(&code_size),
+                reinterpret_cast<const BYTE*>(&code_size) + sizeof(code_size));
+    body.insert(body.end(), sizeof(mdSignature), 0);
+    body.insert(body.end(), code.begin(), code.end());
+    body.resize((body.size() + 3) & ~static_cast<size_t>(3), 0);
+    body.insert(body.end(), {CorILMethod_Sect_EHTable, 16, 0, 0, COR_ILEXCEPTION_CLAUSE_NONE, 0, 20, 0, 6, 26, 0, 3});
+    body.insert(body.end(), reinterpret_cast<const BYTE*>(&catch_type),
+                reinterpret_cast<const BYTE*>(&catch_type) + sizeof(catch_type));
+
+    ILRewriter rewriter(mdTokenNil);
+    Rewrite(rewriter, WStr("TestApplication.ExampleLibrary.Class1"), WStr("Add"), body.data());
+
+    ExpectOriginalInstructionsMapped(rewriter, {{0, CEE_LDARG_1},  {1, CEE_SWITCH},   {14, CEE_BR_S},
+                                                {16, CEE_LDC_I4_1}, {17, CEE_RET},     {18, CEE_LDC_I4_2},
+                                                {19, CEE_RET},      {20, CEE_LDARG_1}, {21, CEE_LDARG_2},
+                                                {22, CEE_DIV},      {23, CEE_POP},     {24, CEE_LEAVE_S},
+                                                {26, CEE_POP},      {27, CEE_LEAVE_S}, {29, CEE_LDC_I4_0},
+                                                {30, CEE_RET}});
+
+    // The original clause is kept, nested in the CallTarget clauses, at the new offsets of its instructions.
+    COR_ILMETHOD_DECODER decoder((COR_ILMETHOD*)rewriter.GetExportedBody().data());
+    ASSERT_NE(nullptr, decoder.EH);
+    ASSERT_EQ(3, decoder.EH->EHCount());
+    bool found_original_clause = false;
+    for (unsigned i = 0; i < decoder.EH->EHCount(); i++)
+    {
+        IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT buffer;
+        const auto clause = decoder.EH->EHClause(i, &buffer);
+        if (clause->Flags == COR_ILEXCEPTION_CLAUSE_NONE && clause->ClassToken == catch_type)
+        {
+            found_original_clause = true;
+            EXPECT_EQ(MapOffset(rewriter, 20), clause->TryOffset);
+            EXPECT_EQ(MapOffset(rewriter, 26), clause->TryOffset + clause->TryLength);
+            EXPECT_EQ(MapOffset(rewriter, 26), clause->HandlerOffset);
+            EXPECT_EQ(MapOffset(rewriter, 29), clause->HandlerOffset + clause->HandlerLength);
+        }
+    }
+    EXPECT_TRUE(found_original_clause);
+}
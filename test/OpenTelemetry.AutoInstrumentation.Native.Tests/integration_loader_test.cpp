@@ -237,6 +237,186 @@ TEST(IntegrationLoaderTest, DeserializesSignatureTypeArray)
     EXPECT_STREQ(L"FakeClient.Pipeline'1<T>", target.signature_types[2].c_str());
 }
 
+TEST(IntegrationLoaderTest, DeserializesTargetKind)
+{
+    std::vector<IntegrationMethod> integrations;
+    std::stringstream              str(R"TEXT(
+        [{
+            "name": "test-integration",
+            "type": "Trace",
+            "method_replacements": [{
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.One", "kind": "Derived" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" }
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Two", "kind": "Interface" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" }
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Three" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" }
+            }]
+        }]
+    )TEXT");
+
+    const LoadIntegrationConfiguration configuration(true, {L"test-integration"}, true, {}, true, {});
+    LoadIntegrationsFromStream(str, integrations, configuration);
+    ASSERT_EQ(3, integrations.size());
+    for (const auto& integration : integrations)
+    {
+        const auto& target = integration.replacement.target_method;
+        if (target.method_name == WStr("Method.One"))
+        {
+            EXPECT_EQ(TargetMethodKind::Derived, target.kind);
+        }
+        else if (target.method_name == WStr("Method.Two"))
+        {
+            EXPECT_EQ(TargetMethodKind::Interface, target.kind);
+        }
+        else
+        {
+            EXPECT_EQ(TargetMethodKind::Default, target.kind);
+            EXPECT_FALSE(target.IsHierarchyTarget());
+        }
+    }
+}
+
+TEST(IntegrationLoaderTest, DeserializesIntegrationKind)
+{
+    std::vector<IntegrationMethod> integrations;
+    std::stringstream              str(R"TEXT(
+        [{
+            "name": "test-integration",
+            "type": "Metric",
+            "method_replacements": [{
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.One" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "integration_kind": "MethodMetrics"
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Two" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" }
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Three" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "integration_kind": "Unknown"
+            }]
+        }]
+    )TEXT");
+
+    const LoadIntegrationConfiguration configuration(true, {}, true, {L"test-integration"}, true, {});
+    LoadIntegrationsFromStream(str, integrations, configuration);
+    ASSERT_EQ(2, integrations.size());
+    for (const auto& integration : integrations)
+    {
+        if (integration.replacement.target_method.method_name == WStr("Method.One"))
+        {
+            EXPECT_EQ(IntegrationKind::MethodMetrics, integration.replacement.integration_kind);
+        }
+        else
+        {
+            EXPECT_EQ(IntegrationKind::CallTarget, integration.replacement.integration_kind);
+        }
+    }
+}
+
+TEST(IntegrationLoaderTest, DeserializesCallSiteIntegrations)
+{
+    std::vector<IntegrationMethod> integrations;
+    std::stringstream              str(R"TEXT(
+        [{
+            "name": "test-integration",
+            "type": "Trace",
+            "method_replacements": [{
+                "caller": { "assembly": "Caller.One", "type": "Caller.Type" },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.One" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two", "method": "Wrapper.One" },
+                "integration_kind": "CallSite"
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Two" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "integration_kind": "CallSite"
+            }, {
+                "caller": { "assembly": "Caller.One" },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Three", "kind": "Derived" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "integration_kind": "CallSite"
+            }]
+        }]
+    )TEXT");
+
+    const LoadIntegrationConfiguration configuration(true, {L"test-integration"}, true, {}, true, {});
+    LoadIntegrationsFromStream(str, integrations, configuration);
+    ASSERT_EQ(1, integrations.size());
+
+    const auto& mr = integrations[0].replacement;
+    EXPECT_EQ(IntegrationKind::CallSite, mr.integration_kind);
+    EXPECT_STREQ(L"Caller.One", mr.caller_method.assembly.name.c_str());
+    EXPECT_STREQ(L"Caller.Type", mr.caller_method.type_name.c_str());
+    EXPECT_STREQ(L"", mr.caller_method.method_name.c_str());
+    EXPECT_STREQ(L"Wrapper.One", mr.wrapper_method.method_name.c_str());
+    EXPECT_STREQ(L"Caller.One", mr.InstrumentedAssemblyName().c_str());
+}
+
+TEST(IntegrationLoaderTest, DeserializesTheArgumentIndices)
+{
+    std::vector<IntegrationMethod> integrations;
+    std::stringstream              str(R"TEXT(
+        [{
+            "name": "test-integration",
+            "type": "Trace",
+            "method_replacements": [{
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.One" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "argument_indices": [2, 0]
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Two" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "argument_indices": []
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Three" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" }
+            }, {
+                "caller": { },
+                "target": { "assembly": "Assembly.One", "type": "Type.One", "method": "Method.Four" },
+                "wrapper": { "assembly": "Assembly.Two", "type": "Type.Two" },
+                "argument_indices": [-1]
+            }]
+        }]
+    )TEXT");
+
+    const LoadIntegrationConfiguration configuration(true, {L"test-integration"}, true, {}, true, {});
+    LoadIntegrationsFromStream(str, integrations, configuration);
+    ASSERT_EQ(3, integrations.size());
+
+    for (const auto& integration : integrations)
+    {
+        const auto& mr = integration.replacement;
+        if (mr.target_method.method_name == L"Method.One")
+        {
+            EXPECT_TRUE(mr.declares_arguments);
+            EXPECT_EQ(std::vector<USHORT>({2, 0}), mr.argument_indices);
+        }
+        else if (mr.target_method.method_name == L"Method.Two")
+        {
+            EXPECT_TRUE(mr.declares_arguments);
+            EXPECT_TRUE(mr.argument_indices.empty());
+        }
+        else
+        {
+            EXPECT_STREQ(L"Method.Three", mr.target_method.method_name.c_str());
+            EXPECT_FALSE(mr.declares_arguments);
+        }
+    }
+}
+
 TEST(IntegrationLoaderTest, SupportsEnabledTraceIntegrations)
 {
     std::vector<IntegrationMethod> integrations;
@@ -0,0 +1,56 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/log_rate_limiter.h"
+
+using namespace trace;
+
+TEST(LogRateLimiterTest, SuppressesTheMessagesOverTheBurst)
+{
+    LogRateLimiter     limiter(2, std::chrono::seconds(10));
+    const auto         start      = std::chrono::steady_clock::time_point();
+    unsigned long long suppressed = 0;
+
+    EXPECT_TRUE(limiter.Acquire("ReJITError", start, &suppressed));
+    EXPECT_EQ(suppressed, 0);
+    EXPECT_TRUE(limiter.Acquire("ReJITError", start + std::chrono::seconds(1), &suppressed));
+    EXPECT_FALSE(limiter.Acquire("ReJITError", start + std::chrono::seconds(2), &suppressed));
+    EXPECT_FALSE(limiter.Acquire("ReJITError", start + std::chrono::seconds(3), &suppressed));
+
+    // The keys are limited separately.
+    EXPECT_TRUE(limiter.Acquire("RequestRejit", start + std::chrono::seconds(3), &suppressed));
+    EXPECT_EQ(suppressed, 0);
+
+    // The first message of the next window reports the suppressed ones.
+    EXPECT_TRUE(limiter.Acquire("ReJITError", start + std::chrono::seconds(10), &suppressed));
+    EXPECT_EQ(suppressed, 2);
+    EXPECT_TRUE(limiter.Acquire("ReJITError", start + std::chrono::seconds(11), &suppressed));
+    EXPECT_EQ(suppressed, 0);
+    EXPECT_EQ(limiter.SuppressedCount(), 2);
+}
+
+TEST(LogRateLimiterTest, TakeSuppressedReportsTheKeysOnce)
+{
+    LogRateLimiter     limiter(1, std::chrono::seconds(10));
+    const auto         start      = std::chrono::steady_clock::time_point();
+    unsigned long long suppressed = 0;
+
+    limiter.Acquire("ReJITError", start, &suppressed);
+    limiter.Acquire("ReJITError", start, &suppressed);
+    limiter.Acquire("ReJITError", start, &suppressed);
+    limiter.Acquire("RequestRejit", start, &suppressed);
+    limiter.Acquire("RequestRevert", start, &suppressed);
+    limiter.Acquire("RequestRevert", start, &suppressed);
+
+    const auto keys = limiter.TakeSuppressed();
+    ASSERT_EQ(keys.size(), 2);
+    EXPECT_EQ(keys[0].first, "ReJITError");
+    EXPECT_EQ(keys[0].second, 2);
+    EXPECT_EQ(keys[1].first, "RequestRevert");
+    EXPECT_EQ(keys[1].second, 1);
+    EXPECT_TRUE(limiter.TakeSuppressed().empty());
+
+    // The suppressed messages already reported are not reported again by the next message.
+    EXPECT_TRUE(limiter.Acquire("ReJITError", start + std::chrono::seconds(10), &suppressed));
+    EXPECT_EQ(suppressed, 0);
+    EXPECT_EQ(limiter.SuppressedCount(), 3);
+}
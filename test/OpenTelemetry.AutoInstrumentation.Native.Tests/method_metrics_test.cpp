@@ -0,0 +1,117 @@
+#include "pch.h"
+
+#include <thread>
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/method_metrics.h"
+
+using namespace trace;
+
+namespace
+{
+
+const MethodMetric* FindMethodMetric(const std::vector<MethodMetric>& metrics, int32_t method_id)
+{
+    for (const auto& metric : metrics)
+    {
+        if (metric.method_id == method_id)
+        {
+            return &metric;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(MethodMetricsTest, RegistersEachMethodOnce)
+{
+    const auto metrics   = MethodMetrics::Instance();
+    const auto assembly  = WStr("RegistersEachMethodOnce");
+    const auto method_id = metrics->Register(assembly, 0x06000001, WStr("Type.Method(System.Int32)"));
+    EXPECT_GE(method_id, 0);
+    EXPECT_EQ(method_id, metrics->Register(assembly, 0x06000001, WStr("Type.Method(System.Int32)")));
+
+    // The overloads and the methods of other assemblies get their own ids.
+    const auto overload_id = metrics->Register(assembly, 0x06000002, WStr("Type.Method(System.Int64)"));
+    EXPECT_NE(method_id, overload_id);
+    EXPECT_NE(method_id, metrics->Register(WStr("Other"), 0x06000001, WStr("Type.Method(System.Int32)")));
+
+    EXPECT_EQ(WStr("Type.Method(System.Int32)"), metrics->GetMethodName(method_id));
+    EXPECT_EQ(WStr("Type.Method(System.Int64)"), metrics->GetMethodName(overload_id));
+    EXPECT_EQ(EmptyWStr, metrics->GetMethodName(-1));
+}
+
+TEST(MethodMetricsTest, CollectsTheCallsOfAllTheThreads)
+{
+    const auto method_id =
+        MethodMetrics::Instance()->Register(WStr("CollectsTheCallsOfAllTheThreads"), 0x06000001, WStr("Type.Method()"));
+    const auto unused_id =
+        MethodMetrics::Instance()->Register(WStr("CollectsTheCallsOfAllTheThreads"), 0x06000002, WStr("Type.Unused()"));
+
+    // The thread exits before the collection, its calls are kept.
+    std::thread exited_thread([method_id]() {
+        for (int i = 0; i < 10; i++)
+        {
+            MethodMetrics::Instance()->Record(method_id, 500);
+        }
+    });
+    exited_thread.join();
+
+    MethodMetrics::Instance()->Record(method_id, 3000);
+    MethodMetrics::Instance()->Record(MethodMetricsMaxMethods, 3000);
+
+    std::vector<MethodMetric> metrics;
+    MethodMetrics::Instance()->Collect(metrics);
+    EXPECT_EQ(nullptr, FindMethodMetric(metrics, unused_id));
+
+    const auto metric = FindMethodMetric(metrics, method_id);
+    ASSERT_NE(nullptr, metric);
+    EXPECT_EQ(TelemetryHistogramBucketCount, metric->bucket_count);
+    EXPECT_EQ(11, metric->count);
+    EXPECT_EQ(8000, metric->sum_ns);
+    EXPECT_EQ(10, metric->buckets[0]);
+    EXPECT_EQ(1, metric->buckets[GetTelemetryHistogramBucket(3000)]);
+}
+
+TEST(MethodMetricsTest, ReloadedMethodsKeepTheirIds)
+{
+    const auto assembly  = WStr("ReloadedMethodsKeepTheirIds");
+    const auto method_id = MethodMetrics::Instance()->Register(assembly, 0x06000001, WStr("Type.Method()"));
+
+    // Each cycle loads the assembly in a collectible AssemblyLoadContext, rewrites the method again and unloads it.
+    for (int i = 0; i < 10000; i++)
+    {
+        ASSERT_EQ(method_id, MethodMetrics::Instance()->Register(assembly, 0x06000001, WStr("Type.Method()")));
+        MethodMetrics::Instance()->Record(method_id, 500);
+    }
+
+    // No id was taken by the cycles.
+    EXPECT_EQ(method_id + 1, MethodMetrics::Instance()->Register(assembly, 0x06000002, WStr("Type.Other()")));
+
+    std::vector<MethodMetric> metrics;
+    MethodMetrics::Instance()->Collect(metrics);
+    const auto metric = FindMethodMetric(metrics, method_id);
+    ASSERT_NE(nullptr, metric);
+    EXPECT_EQ(10000, metric->count);
+}
+
+TEST(MethodMetricsTest, TryRecordOnlyRecordsIntoAllocatedHistograms)
+{
+    const auto method_id = MethodMetrics::Instance()->Register(WStr("TryRecordOnlyRecordsIntoAllocatedHistograms"),
+                                                               0x06000001, WStr("Type.Method()"));
+
+    std::thread thread([method_id]() {
+        // The histograms of the thread are allocated by the first Record.
+        EXPECT_FALSE(MethodMetrics::TryRecord(method_id, 500));
+        MethodMetrics::Instance()->Record(method_id, 500);
+        EXPECT_TRUE(MethodMetrics::TryRecord(method_id, 500));
+        EXPECT_FALSE(MethodMetrics::TryRecord(MethodMetricsMaxMethods, 500));
+    });
+    thread.join();
+
+    std::vector<MethodMetric> metrics;
+    MethodMetrics::Instance()->Collect(metrics);
+    const auto metric = FindMethodMetric(metrics, method_id);
+    ASSERT_NE(nullptr, metric);
+    EXPECT_EQ(2, metric->count);
+}
@@ -0,0 +1,69 @@
+#include "pch.h"
+
+#include <chrono>
+#include <map>
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/module_analysis_pool.h"
+
+using namespace trace;
+
+namespace
+{
+
+void WaitForPendingWork(const ModuleAnalysisPool& pool)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (pool.PendingCount() > 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+TEST(ModuleAnalysisPoolTest, RunsTheWorkOfAModuleInOrder)
+{
+    ModuleAnalysisPool pool(4);
+    EXPECT_EQ(pool.ThreadCount(), 4);
+
+    std::mutex                          mutex;
+    std::map<size_t, std::vector<int>> runs;
+    for (int i = 0; i < 100; i++)
+    {
+        for (size_t module_id = 1; module_id <= 8; module_id++)
+        {
+            EXPECT_TRUE(pool.Enqueue(module_id, [&mutex, &runs, module_id, i]() {
+                std::lock_guard<std::mutex> guard(mutex);
+                runs[module_id].push_back(i);
+            }));
+        }
+    }
+
+    WaitForPendingWork(pool);
+    pool.Stop();
+
+    EXPECT_EQ(pool.PendingCount(), 0);
+    EXPECT_EQ(runs.size(), 8);
+    for (const auto& module_runs : runs)
+    {
+        EXPECT_EQ(module_runs.second.size(), 100);
+        for (int i = 0; i < static_cast<int>(module_runs.second.size()); i++)
+        {
+            EXPECT_EQ(module_runs.second[i], i);
+        }
+    }
+}
+
+TEST(ModuleAnalysisPoolTest, RefusesTheWorkOnceStopped)
+{
+    ModuleAnalysisPool pool(2);
+    pool.Stop();
+
+    EXPECT_FALSE(pool.Enqueue(1, []() {}));
+    EXPECT_EQ(pool.PendingCount(), 0);
+
+    // Without threads the callers always do the work themselves.
+    ModuleAnalysisPool disabled(0);
+    EXPECT_EQ(disabled.ThreadCount(), 0);
+    EXPECT_FALSE(disabled.Enqueue(1, []() {}));
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/rejit_handler.h"
+
+using namespace trace;
+
+TEST(RejitHandlerTest, UnloadedModulesAreReclaimed)
+{
+    RejitHandler handler(nullptr, nullptr);
+
+    const ModuleID app_module_id = 1;
+    handler.GetOrAddModule(app_module_id)->AddMethod(0x06000001);
+
+    // Each cycle loads a module in a collectible AssemblyLoadContext, with a new ModuleID, and unloads it.
+    for (ModuleID module_id = 2; module_id < 10002; module_id++)
+    {
+        auto module_handler = handler.GetOrAddModule(module_id);
+        module_handler->AddMethod(0x06000001);
+        module_handler->AddMethod(0x06000002);
+        handler.AddNGenModule(module_id);
+        handler.RemoveModule(module_id);
+
+        RejitHandlerModule* removed_module_handler = nullptr;
+        ASSERT_FALSE(handler.TryGetModule(module_id, &removed_module_handler));
+    }
+
+    std::vector<ModuleID>    modules;
+    std::vector<mdMethodDef> methods;
+    handler.GetMethods(modules, methods);
+    ASSERT_EQ(methods.size(), 1);
+    EXPECT_EQ(modules[0], app_module_id);
+    EXPECT_EQ(methods[0], 0x06000001);
+}
+
+TEST(RejitHandlerTest, MethodReplacementsAreShared)
+{
+    RejitHandler handler(nullptr, nullptr);
+
+    const MethodReference wrapper(WStr("OpenTelemetry.AutoInstrumentation"), WStr("App.Integration"), EmptyWStr,
+                                  Version(0, 0, 0, 0), Version(0, 0, 0, 0), {}, {});
+    const MethodReference target(WStr("App"), WStr("App.Client"), WStr("Send"), Version(1, 0, 0, 0),
+                                 Version(1, 65535, 65535, 0), {}, {WStr("System.Void")});
+    const MethodReplacement replacement({}, target, wrapper);
+
+    // The methods are added in any order, the instrumented methods share the same replacement.
+    auto module_handler = handler.GetOrAddModule(1);
+    module_handler->SetMethod(0x06000003, replacement);
+    module_handler->AddMethod(0x06000002);
+    module_handler->SetMethod(0x06000001, MethodReplacement({}, target, wrapper));
+
+    RejitHandlerModuleMethod first;
+    RejitHandlerModuleMethod second;
+    RejitHandlerModuleMethod third;
+    ASSERT_TRUE(module_handler->TryGetMethod(0x06000001, &first));
+    ASSERT_TRUE(module_handler->TryGetMethod(0x06000002, &second));
+    ASSERT_TRUE(module_handler->TryGetMethod(0x06000003, &third));
+    EXPECT_EQ(first.methodReplacement, third.methodReplacement);
+    EXPECT_EQ(first.methodReplacement, handler.InternMethodReplacement(replacement));
+    EXPECT_EQ(second.methodReplacement, nullptr);
+
+    RejitHandlerModuleMethod missing;
+    EXPECT_FALSE(module_handler->TryGetMethod(0x06000004, &missing));
+
+    std::vector<mdMethodDef> removed;
+    module_handler->RemoveMethodsWithReplacements({replacement}, removed);
+    EXPECT_EQ(removed, std::vector<mdMethodDef>({0x06000001, 0x06000003}));
+
+    std::vector<mdMethodDef> methods;
+    module_handler->GetMethodDefs(methods);
+    EXPECT_EQ(methods, std::vector<mdMethodDef>({0x06000002}));
+}
+
+TEST(RejitHandlerTest, InlinersAreRecordedToBeReverted)
+{
+    RejitHandler handler(nullptr, nullptr);
+    handler.GetOrAddModule(1)->AddMethod(0x06000001);
+
+    // The inliners ReJITed by RequestReJITWithInliners are unknown until their ReJIT parameters are requested.
+    EXPECT_EQ(S_FALSE, handler.NotifyReJITParameters(2, 0x06000002, nullptr, nullptr));
+
+    std::vector<ModuleID>    modules;
+    std::vector<mdMethodDef> methods;
+    handler.GetMethods(modules, methods);
+    ASSERT_EQ(methods.size(), 2);
+
+    RejitHandlerModule*      inliner_module = nullptr;
+    RejitHandlerModuleMethod inliner;
+    ASSERT_TRUE(handler.TryGetModule(2, &inliner_module));
+    ASSERT_TRUE(inliner_module->TryGetMethod(0x06000002, &inliner));
+    EXPECT_EQ(inliner.methodReplacement, nullptr);
+}
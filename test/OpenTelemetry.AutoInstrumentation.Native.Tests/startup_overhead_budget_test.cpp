@@ -0,0 +1,63 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/startup_overhead_budget.h"
+
+using namespace trace;
+
+TEST(StartupOverheadBudgetTest, ParseDegradationSteps)
+{
+    const auto steps = ParseStartupDegradationSteps(
+        {WStr("ngen_inliners"), WStr("unknown"), WStr("low_priority_instrumentations"), WStr("all_instrumentations")});
+
+    ASSERT_EQ(steps.size(), 3);
+    EXPECT_EQ(steps[0], StartupDegradationStep::NGenInliners);
+    EXPECT_EQ(steps[1], StartupDegradationStep::LowPriorityInstrumentations);
+    EXPECT_EQ(steps[2], StartupDegradationStep::AllInstrumentations);
+    EXPECT_EQ(GetStartupDegradationStepName(steps[0]), WStr("ngen_inliners"));
+}
+
+TEST(StartupOverheadBudgetTest, DisabledWithoutBudget)
+{
+    StartupOverheadBudget budget(0, {StartupDegradationStep::AllInstrumentations});
+
+    EXPECT_FALSE(budget.IsEnabled());
+    EXPECT_TRUE(budget.Consume(1000, 0).empty());
+}
+
+TEST(StartupOverheadBudgetTest, AppliesOneStepPerBudgetExceeded)
+{
+    StartupOverheadBudget budget(100, {StartupDegradationStep::LowPriorityInstrumentations,
+                                       StartupDegradationStep::NGenInliners,
+                                       StartupDegradationStep::AllInstrumentations});
+
+    EXPECT_TRUE(budget.Consume(100, 0).empty());
+
+    auto steps = budget.Consume(101, 0);
+    ASSERT_EQ(steps.size(), 1);
+    EXPECT_EQ(steps[0], StartupDegradationStep::LowPriorityInstrumentations);
+
+    EXPECT_TRUE(budget.Consume(200, 0).empty());
+
+    // A single measure can exceed the remaining thresholds at once.
+    steps = budget.Consume(350, 0);
+    ASSERT_EQ(steps.size(), 2);
+    EXPECT_EQ(steps[0], StartupDegradationStep::NGenInliners);
+    EXPECT_EQ(steps[1], StartupDegradationStep::AllInstrumentations);
+
+    EXPECT_FALSE(budget.IsEnabled());
+    EXPECT_TRUE(budget.Consume(1000, 0).empty());
+}
+
+TEST(StartupOverheadBudgetTest, StopsAtTheEndOfTheStartupWindow)
+{
+    StartupOverheadBudget budget(100, {StartupDegradationStep::LowPriorityInstrumentations,
+                                       StartupDegradationStep::AllInstrumentations},
+                                 1000);
+
+    EXPECT_EQ(budget.Consume(150, 500).size(), 1);
+
+    // The overhead of the modules loaded after the startup doesn't degrade the instrumentation.
+    EXPECT_TRUE(budget.Consume(1000, 1001).empty());
+    EXPECT_FALSE(budget.IsEnabled());
+    EXPECT_TRUE(budget.Consume(1000, 500).empty());
+}
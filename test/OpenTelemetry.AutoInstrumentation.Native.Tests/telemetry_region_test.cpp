@@ -0,0 +1,70 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/telemetry_region.h"
+
+using namespace trace;
+
+TEST(TelemetryRegionTest, HistogramBuckets)
+{
+    EXPECT_EQ(GetTelemetryHistogramBucket(0), 0);
+    EXPECT_EQ(GetTelemetryHistogramBucket(999), 0);
+    EXPECT_EQ(GetTelemetryHistogramBucket(1000), 1);
+    EXPECT_EQ(GetTelemetryHistogramBucket(1999), 1);
+    EXPECT_EQ(GetTelemetryHistogramBucket(2000), 2);
+    EXPECT_EQ(GetTelemetryHistogramBucket(1000000), 10);
+    EXPECT_EQ(GetTelemetryHistogramBucket(UINT64_MAX), TelemetryHistogramBucketCount - 1);
+}
+
+TEST(TelemetryRegionTest, PublishesTheValuesInTheFile)
+{
+    const auto path = std::filesystem::temp_directory_path() / "otel-dotnet-auto-native-test.stats";
+    auto       region = TelemetryRegion::Instance();
+
+    // The values recorded before the file is opened are kept.
+    region->Add(TelemetryCounter::RewriteSucceeded, 2);
+    ASSERT_TRUE(region->Open(ToWSTRING(path.string())));
+    region->Add(TelemetryCounter::RewriteSucceeded);
+    region->Record(TelemetryHistogram::CallTargetRewriter, 1500);
+
+    CostAttribution cost_attribution;
+    cost_attribution.Enable();
+    cost_attribution.AddIntegrationCost(WStr("MongoDB"), CostPhase::Rewrite, 2500000, 2);
+    cost_attribution.AddAssemblyCost(WStr("MongoDB.Driver"), CostPhase::Match, 1000, 1);
+    cost_attribution.AddNGenInlinersCost(500000, 3);
+    region->PublishCosts(cost_attribution.GetIntegrations(), cost_attribution.GetAssemblies(),
+                         cost_attribution.GetNGenInliners());
+
+    TelemetryRegionLayout layout;
+    std::ifstream         file(path, std::ios::binary);
+    ASSERT_TRUE(file.read(reinterpret_cast<char*>(&layout), sizeof(layout)).good());
+
+    EXPECT_EQ(layout.header.magic, TelemetryRegionMagic);
+    EXPECT_EQ(layout.header.version, TelemetryRegionVersion);
+    EXPECT_EQ(layout.header.size, sizeof(TelemetryRegionLayout));
+    EXPECT_EQ(layout.header.state.load(), static_cast<uint32_t>(TelemetryRegionState::Running));
+    EXPECT_EQ(std::string(layout.counter_names[static_cast<uint32_t>(TelemetryCounter::RewriteSucceeded)]),
+              "RewriteSucceeded");
+    EXPECT_EQ(layout.counters[static_cast<uint32_t>(TelemetryCounter::RewriteSucceeded)].load(), 3);
+
+    const auto& histogram = layout.histograms[static_cast<uint32_t>(TelemetryHistogram::CallTargetRewriter)];
+    EXPECT_GE(histogram.count.load(), 1);
+    EXPECT_GE(histogram.buckets[1].load(), 1);
+
+    EXPECT_EQ(layout.header.cost_entry_count, TelemetryCostEntryCount);
+    EXPECT_EQ(layout.cost_sequence.load() % 2, 0);
+    EXPECT_EQ(std::string(layout.cost_integrations[0].name), "MongoDB");
+    EXPECT_EQ(layout.cost_integrations[0].rewrite_ns, 2500000);
+    EXPECT_EQ(layout.cost_integrations[0].rewrite_count, 2);
+    EXPECT_EQ(std::string(layout.cost_integrations[1].name), "");
+    EXPECT_EQ(std::string(layout.cost_assemblies[0].name), "MongoDB.Driver");
+    EXPECT_EQ(layout.cost_assemblies[0].match_count, 1);
+    EXPECT_EQ(std::string(layout.cost_ngen_inliners.name), "NGenInliners");
+    EXPECT_EQ(layout.cost_ngen_inliners.rejit_count, 3);
+
+    file.close();
+    region->Close();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "../../src/OpenTelemetry.AutoInstrumentation.Native/type_hierarchy_index.h"
+
+using namespace trace;
+
+namespace
+{
+bool HasMatch(const std::vector<TypeHierarchyMatch>& matches, const WSTRING& target_type_name, ModuleID module_id,
+              mdTypeDef type_def)
+{
+    for (const auto& match : matches)
+    {
+        if (match.target_type_name == target_type_name && match.module_id == module_id && match.type_def == type_def)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const WSTRING delegating_handler = WStr("System.Net.Http.DelegatingHandler");
+const WSTRING db_command_interface = WStr("System.Data.IDbCommand");
+} // namespace
+
+TEST(TypeHierarchyIndexTest, TargetsAreMatchedOnceTheirAssemblyIsLoaded)
+{
+    TypeHierarchyIndex index;
+    EXPECT_TRUE(index.SetTargets({{WStr("System.Net.Http"), delegating_handler}}).empty());
+
+    auto matches = index.AddModule(1, WStr("App"),
+                                   {{0x02000002, WStr("App.Handler"), {delegating_handler}},
+                                    {0x02000003, WStr("App.RetryHandler"), {WStr("App.Handler")}},
+                                    {0x02000004, WStr("App.Other"), {WStr("System.IDisposable")}}});
+    EXPECT_TRUE(matches.empty());
+
+    matches = index.AddModule(2, WStr("System.Net.Http"),
+                              {{0x02000010, delegating_handler, {WStr("System.Net.Http.HttpMessageHandler")}}});
+    ASSERT_EQ(matches.size(), 2);
+    EXPECT_TRUE(HasMatch(matches, delegating_handler, 1, 0x02000002));
+    EXPECT_TRUE(HasMatch(matches, delegating_handler, 1, 0x02000003));
+
+    matches = index.AddModule(3, WStr("Lib"), {{0x02000002, WStr("Lib.Handler"), {WStr("App.RetryHandler")}}});
+    ASSERT_EQ(matches.size(), 1);
+    EXPECT_TRUE(HasMatch(matches, delegating_handler, 3, 0x02000002));
+}
+
+TEST(TypeHierarchyIndexTest, SubtypesLinkedByALaterModuleAreMatched)
+{
+    TypeHierarchyIndex index;
+    index.SetTargets({{WStr("System.Data.Common"), db_command_interface}});
+    index.AddModule(1, WStr("System.Data.Common"),
+                    {{0x02000002, WStr("System.Data.Common.DbCommand"), {db_command_interface}}});
+
+    // Lib.Command derives from Provider.Command, which is defined by a module loaded later.
+    auto matches = index.AddModule(2, WStr("Lib"), {{0x02000002, WStr("Lib.Command"), {WStr("Provider.Command")}}});
+    EXPECT_TRUE(matches.empty());
+
+    matches = index.AddModule(3, WStr("Provider"),
+                              {{0x02000005, WStr("Provider.Command"), {WStr("System.Data.Common.DbCommand")}}});
+    ASSERT_EQ(matches.size(), 2);
+    EXPECT_TRUE(HasMatch(matches, db_command_interface, 3, 0x02000005));
+    EXPECT_TRUE(HasMatch(matches, db_command_interface, 2, 0x02000002));
+
+    // The same assembly loaded by another module is matched again.
+    matches = index.AddModule(4, WStr("Provider"),
+                              {{0x02000005, WStr("Provider.Command"), {WStr("System.Data.Common.DbCommand")}}});
+    ASSERT_EQ(matches.size(), 1);
+    EXPECT_TRUE(HasMatch(matches, db_command_interface, 4, 0x02000005));
+}
+
+TEST(TypeHierarchyIndexTest, NewTargetsMatchTheIndexedSubtypes)
+{
+    TypeHierarchyIndex index;
+    index.SetTargets({{WStr("System.Net.Http"), delegating_handler}});
+    index.AddModule(1, WStr("System.Net.Http"),
+                    {{0x02000010, delegating_handler, {WStr("System.Net.Http.HttpMessageHandler")}}});
+    index.AddModule(2, WStr("App"),
+                    {{0x02000002, WStr("App.Handler"), {delegating_handler}},
+                     {0x02000003, WStr("App.RetryHandler"), {WStr("App.Handler")}}});
+
+    // The kept target doesn't report again its subtypes.
+    auto matches =
+        index.SetTargets({{WStr("System.Net.Http"), delegating_handler}, {WStr("App"), WStr("App.Handler")}});
+    ASSERT_EQ(matches.size(), 1);
+    EXPECT_TRUE(HasMatch(matches, WStr("App.Handler"), 2, 0x02000003));
+
+    index.RemoveModule(2);
+    matches = index.AddModule(3, WStr("App"),
+                              {{0x02000002, WStr("App.Handler"), {delegating_handler}},
+                               {0x02000003, WStr("App.RetryHandler"), {WStr("App.Handler")}}});
+    EXPECT_EQ(matches.size(), 3);
+    EXPECT_TRUE(HasMatch(matches, delegating_handler, 3, 0x02000002));
+    EXPECT_TRUE(HasMatch(matches, delegating_handler, 3, 0x02000003));
+    EXPECT_TRUE(HasMatch(matches, WStr("App.Handler"), 3, 0x02000003));
+
+    index.Clear();
+    EXPECT_FALSE(index.HasTargets());
+}
+
+TEST(TypeHierarchyIndexTest, UnloadedModulesAreReclaimed)
+{
+    TypeHierarchyIndex index;
+    index.SetTargets({{WStr("System.Net.Http"), delegating_handler}});
+    index.AddModule(1, WStr("System.Net.Http"),
+                    {{0x02000010, delegating_handler, {WStr("System.Net.Http.HttpMessageHandler")}}});
+
+    // Each cycle loads a plugin in a collectible AssemblyLoadContext, with a new ModuleID, and unloads it.
+    // A definition left behind by an unloaded module would be reported again with the next plugin.
+    for (ModuleID module_id = 2; module_id < 10002; module_id++)
+    {
+        const auto matches = index.AddModule(module_id, WStr("Plugin"),
+                                             {{0x02000002, WStr("Plugin.Handler"), {delegating_handler}},
+                                              {0x02000003, WStr("Plugin.RetryHandler"), {WStr("Plugin.Handler")}}});
+        ASSERT_EQ(matches.size(), 2);
+        EXPECT_TRUE(HasMatch(matches, delegating_handler, module_id, 0x02000002));
+        EXPECT_TRUE(HasMatch(matches, delegating_handler, module_id, 0x02000003));
+        index.RemoveModule(module_id);
+    }
+}
@@ -47,6 +47,9 @@ public class SettingsTests : IDisposable
         {
             settings.Plugins.Should().BeEmpty();
             settings.FlushOnUnhandledException.Should().BeFalse();
+            settings.InstrumentedMethodsWarmUpEnabled.Should().BeFalse();
+            settings.CallTargetCanonicalArguments.Should().BeFalse();
+            settings.ControlFile.Should().BeNull();
             settings.OtlpExportProtocol.Should().Be(OtlpExportProtocol.HttpProtobuf);
         }
     }
@@ -233,6 +236,7 @@ public class SettingsTests : IDisposable
     [InlineData("HTTPCLIENT", MetricInstrumentation.HttpClient)]
     [InlineData("PROCESS", MetricInstrumentation.Process)]
     [InlineData("NSERVICEBUS", MetricInstrumentation.NServiceBus)]
+    [InlineData("METHODMETRICS", MetricInstrumentation.MethodMetrics)]
 #if NET6_0_OR_GREATER
     [InlineData("ASPNETCORE", MetricInstrumentation.AspNetCore)]
 #endif
@@ -299,6 +303,32 @@ public class SettingsTests : IDisposable
         settings.FlushOnUnhandledException.Should().Be(expectedValue);
     }
 
+    [Theory]
+    [InlineData("true", true)]
+    [InlineData("false", false)]
+    [InlineData(null, false)]
+    internal void InstrumentedMethodsWarmUpEnabled_DependsOnCorrespondingEnvVariable(string warmUpEnabled, bool expectedValue)
+    {
+        Environment.SetEnvironmentVariable(ConfigurationKeys.InstrumentedMethodsWarmUpEnabled, warmUpEnabled);
+
+        var settings = Settings.FromDefaultSources<GeneralSettings>();
+
+        settings.InstrumentedMethodsWarmUpEnabled.Should().Be(expectedValue);
+    }
+
+    [Theory]
+    [InlineData("canonical", true)]
+    [InlineData("typed", false)]
+    [InlineData(null, false)]
+    internal void CallTargetCanonicalArguments_DependsOnCorrespondingEnvVariable(string instantiationPolicy, bool expectedValue)
+    {
+        Environment.SetEnvironmentVariable(ConfigurationKeys.CallTargetInstantiationPolicy, instantiationPolicy);
+
+        var settings = Settings.FromDefaultSources<GeneralSettings>();
+
+        settings.CallTargetCanonicalArguments.Should().Be(expectedValue);
+    }
+
     private static void ClearEnvVars()
     {
         Environment.SetEnvironmentVariable(ConfigurationKeys.Logs.LogsInstrumentationEnabled, null);
@@ -329,6 +359,9 @@ public class SettingsTests : IDisposable
         Environment.SetEnvironmentVariable(ConfigurationKeys.Traces.InstrumentationOptions.GraphQLSetDocument, null);
         Environment.SetEnvironmentVariable(ConfigurationKeys.ExporterOtlpProtocol, null);
         Environment.SetEnvironmentVariable(ConfigurationKeys.FlushOnUnhandledException, null);
+        Environment.SetEnvironmentVariable(ConfigurationKeys.InstrumentedMethodsWarmUpEnabled, null);
+        Environment.SetEnvironmentVariable(ConfigurationKeys.ControlFile, null);
+        Environment.SetEnvironmentVariable(ConfigurationKeys.CallTargetInstantiationPolicy, null);
         Environment.SetEnvironmentVariable(ConfigurationKeys.Sdk.Propagators, null);
     }
 }
@@ -0,0 +1,106 @@
+// <copyright file="ControlFileTests.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using FluentAssertions;
+using Xunit;
+
+namespace OpenTelemetry.AutoInstrumentation.Tests;
+
+public class ControlFileTests : IDisposable
+{
+    private readonly string _path = Path.Combine(Path.GetTempPath(), $"otel-control-{Guid.NewGuid():N}");
+
+    public void Dispose()
+    {
+        File.Delete(_path);
+        File.Delete(_path + ".result");
+    }
+
+    [Fact]
+    public void RunsTheCommandsOfTheFileOnce()
+    {
+        var runs = 0;
+        var commands = new Dictionary<string, Func<string, string>>
+        {
+            ["detach-profiler"] = _ =>
+            {
+                runs++;
+                return "Detached";
+            }
+        };
+        using var controlFile = new ControlFile(_path, commands, Timeout.InfiniteTimeSpan);
+
+        controlFile.Poll().Should().BeFalse();
+
+        File.WriteAllLines(_path, new[] { "detach-profiler", string.Empty, "unknown" });
+        controlFile.Poll().Should().BeTrue();
+        controlFile.Poll().Should().BeFalse();
+
+        runs.Should().Be(1);
+        File.Exists(_path).Should().BeFalse();
+        File.ReadAllLines(controlFile.ResultPath).Should().Equal("detach-profiler: Detached", "unknown: UnknownCommand");
+    }
+
+    [Fact]
+    public void PassesTheArgumentOfTheCommands()
+    {
+        var arguments = new List<string>();
+        var commands = new Dictionary<string, Func<string, string>>
+        {
+            ["set-log-level"] = argument =>
+            {
+                arguments.Add(argument);
+                return "Changed";
+            }
+        };
+        using var controlFile = new ControlFile(_path, commands, Timeout.InfiniteTimeSpan);
+
+        File.WriteAllLines(_path, new[] { "set-log-level  debug ", "set-log-level", "set-log-levels debug" });
+        controlFile.Poll().Should().BeTrue();
+
+        arguments.Should().Equal("debug", string.Empty);
+        File.ReadAllLines(controlFile.ResultPath).Should().Equal("set-log-level  debug: Changed", "set-log-level: Changed", "set-log-levels debug: UnknownCommand");
+    }
+
+    [Theory]
+    [InlineData("set-log-level")]
+    [InlineData("set-log-level verbose")]
+    [InlineData("dump-il-rewrite")]
+    [InlineData("dump-il-rewrite yes")]
+    public void RejectsTheInvalidArgumentsOfTheProfilerCommands(string command)
+    {
+        using var controlFile = new ControlFile(_path, ControlFile.ProfilerCommands, Timeout.InfiniteTimeSpan);
+
+        File.WriteAllLines(_path, new[] { command });
+        controlFile.Poll().Should().BeTrue();
+
+        File.ReadAllLines(controlFile.ResultPath).Should().Equal($"{command}: InvalidArgument");
+    }
+
+    [Theory]
+    [InlineData("set-log-level debug")]
+    [InlineData("dump-il-rewrite on")]
+    [InlineData("dump-il-rewrite off")]
+    public void ReportsTheProfilerCommandsNotChangedWithoutTheProfiler(string command)
+    {
+        using var controlFile = new ControlFile(_path, ControlFile.ProfilerCommands, Timeout.InfiniteTimeSpan);
+
+        File.WriteAllLines(_path, new[] { command });
+        controlFile.Poll().Should().BeTrue();
+
+        File.ReadAllLines(controlFile.ResultPath).Should().Equal($"{command}: NotChanged");
+    }
+}
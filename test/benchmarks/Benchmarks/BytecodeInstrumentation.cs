@@ -0,0 +1,84 @@
+// <copyright file="BytecodeInstrumentation.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Runtime.InteropServices;
+using BenchmarkDotNet.Jobs;
+
+namespace Benchmarks;
+
+/// <summary>
+/// Runs the benchmarks with the .NET CLR Profiler and the instrumentation built in <c>bin/tracer-home</c>,
+/// the way the integration tests run the test applications.
+/// </summary>
+internal static class BytecodeInstrumentation
+{
+    private const string ProfilerClsId = "{918728DD-259F-4A6A-AC2B-B85E1B658318}";
+
+    public static Job WithBytecodeInstrumentation(this Job job, params (string Key, string Value)[] settings)
+    {
+        var tracerHome = Path.Combine(GetSolutionDirectory(), "bin", "tracer-home");
+        if (!Directory.Exists(tracerHome))
+        {
+            throw new InvalidOperationException($"Unable to find Nuke output at: {tracerHome}. Ensure Nuke has run first.");
+        }
+
+        var variables = new Dictionary<string, string>
+        {
+            ["CORECLR_ENABLE_PROFILING"] = "1",
+            ["CORECLR_PROFILER"] = ProfilerClsId,
+            ["CORECLR_PROFILER_PATH"] = GetProfilerPath(tracerHome),
+            ["DOTNET_STARTUP_HOOKS"] = Path.Combine(tracerHome, "net", "OpenTelemetry.AutoInstrumentation.StartupHook.dll"),
+            ["DOTNET_SHARED_STORE"] = Path.Combine(tracerHome, "store"),
+            ["DOTNET_ADDITIONAL_DEPS"] = Path.Combine(tracerHome, "AdditionalDeps"),
+            ["OTEL_DOTNET_AUTO_HOME"] = tracerHome,
+            ["OTEL_DOTNET_AUTO_INTEGRATIONS_FILE"] = Path.Combine(AppContext.BaseDirectory, "StrongNamedTestsIntegrations.json"),
+            ["OTEL_TRACES_EXPORTER"] = "none",
+            ["OTEL_METRICS_EXPORTER"] = "none",
+            ["OTEL_LOGS_EXPORTER"] = "none",
+        };
+
+        foreach (var (key, value) in settings)
+        {
+            variables[key] = value;
+        }
+
+        return job.WithEnvironmentVariables(variables.Select(variable => new EnvironmentVariable(variable.Key, variable.Value)).ToArray());
+    }
+
+    private static string GetProfilerPath(string tracerHome)
+    {
+        var (directory, extension) =
+            RuntimeInformation.IsOSPlatform(OSPlatform.Windows) ? ("win", "dll") :
+            RuntimeInformation.IsOSPlatform(OSPlatform.OSX) ? ("osx", "dylib") :
+            ("linux", "so");
+
+        var platform = RuntimeInformation.ProcessArchitecture.ToString().ToLowerInvariant();
+        return Path.Combine(tracerHome, $"{directory}-{platform}", $"OpenTelemetry.AutoInstrumentation.Native.{extension}");
+    }
+
+    private static string GetSolutionDirectory()
+    {
+        for (var directory = new DirectoryInfo(AppContext.BaseDirectory); directory != null; directory = directory.Parent)
+        {
+            if (File.Exists(Path.Combine(directory.FullName, "OpenTelemetry.AutoInstrumentation.sln")))
+            {
+                return directory.FullName;
+            }
+        }
+
+        throw new InvalidOperationException("Unable to find the solution directory.");
+    }
+}
@@ -0,0 +1,62 @@
+// <copyright file="FirstCallBenchmarks.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using BenchmarkDotNet.Attributes;
+using BenchmarkDotNet.Configs;
+using BenchmarkDotNet.Engines;
+using BenchmarkDotNet.Jobs;
+using TestLibrary.InstrumentationTarget;
+
+namespace Benchmarks;
+
+/// <summary>
+/// Measures the first call of an instrumented method, which compiles its rewritten body and initializes its
+/// CallTarget handlers unless the instrumented methods warm-up did it.
+/// </summary>
+[Config(typeof(Config))]
+public class FirstCallBenchmarks
+{
+    private Command? _command;
+
+    [GlobalSetup]
+    public void GlobalSetup()
+    {
+        // Loads the instrumented assembly, then leaves time to the warm-up, when it is enabled.
+        _command = new Command();
+        Thread.Sleep(TimeSpan.FromSeconds(3));
+    }
+
+    [Benchmark]
+    public void Execute()
+    {
+        _command!.Execute();
+    }
+
+    private class Config : ManualConfig
+    {
+        public Config()
+        {
+            // Each launch is a new process measuring a single call, without the pilot and warm-up iterations.
+            var job = Job.Default
+                .WithStrategy(RunStrategy.ColdStart)
+                .WithLaunchCount(20)
+                .WithIterationCount(1);
+
+            AddJob(job.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_INSTRUMENTED_METHODS_WARMUP_ENABLED", "false")).WithId("WarmUpDisabled"));
+            AddJob(job.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_INSTRUMENTED_METHODS_WARMUP_ENABLED", "true")).WithId("WarmUpEnabled"));
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// <copyright file="LoopMethodBenchmarks.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using BenchmarkDotNet.Attributes;
+using BenchmarkDotNet.Configs;
+using BenchmarkDotNet.Jobs;
+using TestLibrary.InstrumentationTarget;
+
+namespace Benchmarks;
+
+/// <summary>
+/// Measures the steady state of an instrumented method running a loop. With the outlining, the loop runs
+/// in a method without exception handling, which the JIT optimizes as before the instrumentation.
+/// </summary>
+[Config(typeof(Config))]
+public class LoopMethodBenchmarks
+{
+    private readonly Command _command = new();
+    private readonly int[] _values = Enumerable.Range(0, 1_000).ToArray();
+
+    [Benchmark]
+    public int Sum()
+    {
+        return _command.Sum(_values);
+    }
+
+    private class Config : ManualConfig
+    {
+        public Config()
+        {
+            AddJob(Job.Default.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_CALLTARGET_OUTLINING_ENABLED", "false")).WithId("OutliningDisabled"));
+            AddJob(Job.Default.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_CALLTARGET_OUTLINING_ENABLED", "true")).WithId("OutliningEnabled"));
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// <copyright file="ParallelAssemblyLoadBenchmarks.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Runtime.Loader;
+using BenchmarkDotNet.Attributes;
+using BenchmarkDotNet.Configs;
+using BenchmarkDotNet.Jobs;
+using TestLibrary.InstrumentationTarget;
+
+namespace Benchmarks;
+
+/// <summary>
+/// Measures the loading of instrumented assemblies from parallel threads. Without the module analysis threads, each
+/// loading thread searches the integration targets of its module and requests their ReJIT before the load completes.
+/// </summary>
+[Config(typeof(Config))]
+public class ParallelAssemblyLoadBenchmarks
+{
+    private const int AssemblyCount = 64;
+
+    private readonly string _assemblyPath = typeof(Command).Assembly.Location;
+
+    [Benchmark]
+    public void LoadAssemblies()
+    {
+        // Each context loads its own copy of the assembly, the profiler analyzes a new module for each of them.
+        Parallel.For(0, AssemblyCount, i =>
+        {
+            var context = new AssemblyLoadContext($"ParallelAssemblyLoad{i}", isCollectible: true);
+            context.LoadFromAssemblyPath(_assemblyPath);
+            context.Unload();
+        });
+    }
+
+    private class Config : ManualConfig
+    {
+        public Config()
+        {
+            AddJob(Job.Default.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_MODULE_ANALYSIS_THREADS", "0")).WithId("AnalysisThreads0"));
+            AddJob(Job.Default.WithBytecodeInstrumentation(("OTEL_DOTNET_AUTO_MODULE_ANALYSIS_THREADS", "4")).WithId("AnalysisThreads4"));
+        }
+    }
+}
@@ -14,6 +14,7 @@
 // limitations under the License.
 // </copyright>
 
+using System.Runtime.CompilerServices;
 using TestLibrary.InstrumentationTarget;
 
 namespace TestApplication.StrongNamed;
@@ -23,8 +24,160 @@ public static class Program
     public static void Main(string[] args)
     {
         var command = new Command();
+        if (args.Length == 2 && args[0] == "--wait")
+        {
+            ExecuteAroundWait(command, args[1]);
+            return;
+        }
+
+        if (args.Length == 2 && args[0] == "--delay")
+        {
+            ExecuteAfterDelay(command, TimeSpan.FromMilliseconds(int.Parse(args[1])));
+            return;
+        }
+
+        if (args.Length == 1 && args[0] == "--loop")
+        {
+            // The loop runs in the outlined original body, when the outlining is enabled.
+            Console.WriteLine($"Loop sum: {command.Sum(Enumerable.Range(0, 1_000).ToArray())}");
+            return;
+        }
+
+        if (args.Length == 1 && args[0] == "--method-metrics")
+        {
+            // Each overload is recorded in its own histograms.
+            Console.WriteLine($"Compute results: {command.Compute(1)}, {command.Compute(2L)}");
+            return;
+        }
+
+        if (args.Length == 1 && args[0] == "--call-site")
+        {
+            // Only the calls made by IncrementAtCallSite are replaced.
+            Console.WriteLine($"Increment results: {IncrementAtCallSite(1)}, {Command.Increment(1)}");
+            return;
+        }
+
+#if !NETFRAMEWORK
+        if (args.Length == 1 && args[0] == "--thread-pool")
+        {
+            var workItem = new ValidatedWorkItem();
+            ThreadPool.UnsafeQueueUserWorkItem(workItem, preferLocal: false);
+            workItem.Wait();
+            return;
+        }
+
+        if (args.Length == 1 && args[0] == "--async-allocations")
+        {
+            ExecuteAsyncAllocations(command).GetAwaiter().GetResult();
+            return;
+        }
+#endif
+
         command.Execute();
         command.InstrumentationTargetMissingBytecodeInstrumentationType();
         command.InstrumentationTargetMissingBytecodeInstrumentationMethod();
+
+        // The integration doubles the result of the async method.
+        var result = command.ExecuteAsync(21).GetAwaiter().GetResult();
+        Console.WriteLine($"Command async result: {result}");
+
+        AdvanceReader();
+        SkipReader();
+#if !NETFRAMEWORK
+        ReadReader();
+#endif
+    }
+
+    private static void ExecuteAroundWait(Command command, string directory)
+    {
+        // The instrumented method is called before and after the test changes the profiler, e.g. attaches it.
+        command.Execute();
+        File.WriteAllText(Path.Combine(directory, "ready"), string.Empty);
+
+        var proceed = Path.Combine(directory, "continue");
+        while (!File.Exists(proceed))
+        {
+            Thread.Sleep(100);
+        }
+
+        command.Execute();
+        Console.WriteLine("Executed after the wait");
+    }
+
+    private static void ExecuteAfterDelay(Command command, TimeSpan delay)
+    {
+        // The delay leaves time to the instrumented methods warm-up, when it is enabled.
+        Thread.Sleep(delay);
+        command.Execute();
+    }
+
+#if !NETFRAMEWORK
+    private static async Task ExecuteAsyncAllocations(Command command)
+    {
+        const int iterations = 10_000;
+
+        // The first call initializes the CallTarget handlers of the instrumented method.
+        await command.ExecuteAsync(21);
+
+        // The continuations of the awaited calls run on the thread pool, all the threads are accounted.
+        var allocatedBytes = GC.GetTotalAllocatedBytes(precise: true);
+        for (var i = 0; i < iterations; i++)
+        {
+            await command.ExecuteAsync(21);
+        }
+
+        allocatedBytes = GC.GetTotalAllocatedBytes(precise: true) - allocatedBytes;
+        Console.WriteLine($"Async allocated bytes per call: {allocatedBytes / iterations}");
+    }
+#endif
+
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    private static int IncrementAtCallSite(int value)
+    {
+        return Command.Increment(value);
+    }
+
+    private static void AdvanceReader()
+    {
+        const int iterations = 10_000;
+
+        // The first call initializes the CallTarget handlers of the instrumented method.
+        var reader = new Reader();
+        reader.Advance();
+
+#if !NETFRAMEWORK
+        var allocatedBytes = GC.GetAllocatedBytesForCurrentThread();
+#endif
+        for (var i = 1; i < iterations; i++)
+        {
+            reader.Advance();
+        }
+
+#if !NETFRAMEWORK
+        allocatedBytes = GC.GetAllocatedBytesForCurrentThread() - allocatedBytes;
+        Console.WriteLine($"Reader allocated bytes: {allocatedBytes}");
+#endif
+
+        // The instrumented method must update the caller's struct, not a copy of it.
+        Console.WriteLine($"Reader position: {reader.Position}");
+    }
+
+    private static void SkipReader()
+    {
+        // The integration doubles the count, it receives the caller's variable and not a copy of it.
+        var reader = new Reader();
+        var count = 2;
+        reader.Skip(ref count, out var skipped);
+        Console.WriteLine($"Reader skipped: {skipped}, position: {reader.Position}");
+    }
+
+#if !NETFRAMEWORK
+    private static void ReadReader()
+    {
+        // The integration slices the span argument of the instrumented method.
+        var reader = new Reader();
+        var read = reader.Read(new byte[4]);
+        Console.WriteLine($"Reader read: {read}");
     }
+#endif
 }
@@ -0,0 +1,39 @@
+// <copyright file="ValidatedWorkItem.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+#if !NETFRAMEWORK
+
+namespace TestApplication.StrongNamed;
+
+/// <summary>
+/// Work item executed by the thread pool, recognized by the ThreadPoolWorkItemValidation integration.
+/// </summary>
+internal sealed class ValidatedWorkItem : IThreadPoolWorkItem
+{
+    private readonly ManualResetEventSlim _executed = new();
+
+    public void Execute()
+    {
+        Console.WriteLine("Work item executed");
+        _executed.Set();
+    }
+
+    public void Wait()
+    {
+        _executed.Wait();
+    }
+}
+#endif
@@ -15,6 +15,7 @@
 // </copyright>
 
 using System.Threading;
+using System.Threading.Tasks;
 
 namespace TestLibrary.InstrumentationTarget;
 
@@ -34,4 +35,36 @@ public class Command
     {
         Thread.Yield(); // Just to have some call to outside code.
     }
+
+    public int Sum(int[] values)
+    {
+        var sum = 0;
+        for (var i = 0; i < values.Length; i++)
+        {
+            sum += values[i];
+        }
+
+        return sum;
+    }
+
+    public int Compute(int value)
+    {
+        return value * 2;
+    }
+
+    public long Compute(long value)
+    {
+        return value * 2;
+    }
+
+    public static int Increment(int value)
+    {
+        return value + 1;
+    }
+
+    public async Task<int> ExecuteAsync(int value)
+    {
+        await Task.Yield(); // Completes the task asynchronously.
+        return value;
+    }
 }
@@ -0,0 +1,47 @@
+// <copyright file="Reader.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+
+using System.Runtime.CompilerServices;
+
+namespace TestLibrary.InstrumentationTarget;
+
+public struct Reader
+{
+    public int Position { get; private set; }
+
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    public void Advance()
+    {
+        Position++;
+    }
+
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    public void Skip(ref int count, out bool skipped)
+    {
+        Position += count;
+        skipped = count > 0;
+    }
+
+#if !NETFRAMEWORK
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    public int Read(ReadOnlySpan<byte> buffer)
+    {
+        Position += buffer.Length;
+        return buffer.Length;
+    }
+#endif
+}
@@ -0,0 +1,92 @@
+// <copyright file="NativeMethods.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Reflection;
+using System.Runtime.InteropServices;
+
+namespace CallTargetWeaver;
+
+internal static class NativeMethods
+{
+    private const string NativeLibraryName = "OpenTelemetry.AutoInstrumentation.Native";
+
+    private static readonly Guid CorMetaDataDispenserClassId = new("E5CB7A31-7512-11D2-89CE-0080C792E5D8");
+    private static readonly Guid MetaDataDispenserInterfaceId = new("809C652E-7396-11D2-9771-00A0C9B4D50C");
+
+    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+    private delegate int MetaDataGetDispenserDelegate(ref Guid classId, ref Guid interfaceId, out IntPtr dispenser);
+
+    // The native library is loaded from the OTEL_DOTNET_AUTO_HOME installation when it is set.
+    public static void UseInstallation(string? home)
+    {
+        if (string.IsNullOrEmpty(home))
+        {
+            return;
+        }
+
+        var path = Path.Combine(home, RuntimeInformation.RuntimeIdentifier, NativeLibraryName + NativeLibraryExtension());
+        NativeLibrary.SetDllImportResolver(Assembly.GetExecutingAssembly(), (name, _, _) =>
+            name == NativeLibraryName && File.Exists(path) ? NativeLibrary.Load(path) : IntPtr.Zero);
+    }
+
+    // The metadata dispenser of the runtime running the tool reads and writes the assemblies metadata.
+    public static IntPtr CreateMetaDataDispenser()
+    {
+        var coreClr = NativeLibrary.Load(Path.Combine(RuntimeEnvironment.GetRuntimeDirectory(), CoreClrFileName()));
+        var getDispenser = Marshal.GetDelegateForFunctionPointer<MetaDataGetDispenserDelegate>(
+            NativeLibrary.GetExport(coreClr, "MetaDataGetDispenser"));
+
+        var classId = CorMetaDataDispenserClassId;
+        var interfaceId = MetaDataDispenserInterfaceId;
+        Marshal.ThrowExceptionForHR(getDispenser(ref classId, ref interfaceId, out var dispenser));
+        return dispenser;
+    }
+
+    [DllImport(NativeLibraryName)]
+    public static extern bool PlanAssemblies(
+        IntPtr dispenser,
+        [MarshalAs(UnmanagedType.LPWStr)] string integrationsPath,
+        [MarshalAs(UnmanagedType.LPWStr)] string directory,
+        [MarshalAs(UnmanagedType.LPWStr)] string reportPath);
+
+    [DllImport(NativeLibraryName)]
+    public static extern bool WeaveAssemblies(
+        IntPtr dispenser,
+        [MarshalAs(UnmanagedType.LPWStr)] string integrationsPath,
+        [MarshalAs(UnmanagedType.LPWStr)] string directory,
+        [MarshalAs(UnmanagedType.LPWStr)] string outputDirectory,
+        [MarshalAs(UnmanagedType.LPWStr)] string reportPath);
+
+    private static string CoreClrFileName()
+    {
+        if (OperatingSystem.IsWindows())
+        {
+            return "coreclr.dll";
+        }
+
+        return OperatingSystem.IsMacOS() ? "libcoreclr.dylib" : "libcoreclr.so";
+    }
+
+    private static string NativeLibraryExtension()
+    {
+        if (OperatingSystem.IsWindows())
+        {
+            return ".dll";
+        }
+
+        return OperatingSystem.IsMacOS() ? ".dylib" : ".so";
+    }
+}
@@ -0,0 +1,95 @@
+// <copyright file="Program.cs" company="OpenTelemetry Authors">
+// Copyright The OpenTelemetry Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// </copyright>
+
+using System.Runtime.InteropServices;
+
+namespace CallTargetWeaver;
+
+internal class Program
+{
+    private const string PlanCommand = "plan";
+    private const string WeaveCommand = "weave";
+
+    public static int Main(string[] args)
+    {
+        if (args.Length >= 3 && args[0] == PlanCommand)
+        {
+            var integrationsPath = GetIntegrationsPath(args[1]);
+            var directory = GetDirectory(args[2]);
+            var reportPath = Path.GetFullPath(args.Length > 3 ? args[3] : "calltarget-plan.json");
+            return Run(dispenser => NativeMethods.PlanAssemblies(dispenser, integrationsPath, directory, reportPath), $"Planned {directory}, see {reportPath}.");
+        }
+
+        if (args.Length >= 4 && args[0] == WeaveCommand)
+        {
+            var integrationsPath = GetIntegrationsPath(args[1]);
+            var directory = GetDirectory(args[2]);
+            var outputDirectory = Path.GetFullPath(args[3]);
+            var reportPath = Path.GetFullPath(args.Length > 4 ? args[4] : Path.Combine(outputDirectory, "calltarget-weaving.json"));
+            Directory.CreateDirectory(outputDirectory);
+            return Run(dispenser => NativeMethods.WeaveAssemblies(dispenser, integrationsPath, directory, outputDirectory, reportPath), $"Woven {directory} into {outputDirectory}, see {reportPath}.");
+        }
+
+        Console.Error.WriteLine("Usage:");
+        Console.Error.WriteLine("  CallTargetWeaver plan <integrations.json> <application directory> [plan.json]");
+        Console.Error.WriteLine("  CallTargetWeaver weave <integrations.json> <application directory> <output directory> [report.json]");
+        return 1;
+    }
+
+    private static string GetIntegrationsPath(string path)
+    {
+        var integrationsPath = Path.GetFullPath(path);
+        if (!File.Exists(integrationsPath))
+        {
+            throw new FileNotFoundException($"Integrations file does not exist: {integrationsPath}");
+        }
+
+        return integrationsPath;
+    }
+
+    private static string GetDirectory(string path)
+    {
+        var directory = Path.GetFullPath(path);
+        if (!Directory.Exists(directory))
+        {
+            throw new DirectoryNotFoundException($"Directory does not exist: {directory}");
+        }
+
+        return directory;
+    }
+
+    private static int Run(Func<IntPtr, bool> command, string successMessage)
+    {
+        NativeMethods.UseInstallation(Environment.GetEnvironmentVariable("OTEL_DOTNET_AUTO_HOME"));
+
+        var dispenser = NativeMethods.CreateMetaDataDispenser();
+        try
+        {
+            if (!command(dispenser))
+            {
+                Console.Error.WriteLine("Failed to write the report.");
+                return 1;
+            }
+        }
+        finally
+        {
+            Marshal.Release(dispenser);
+        }
+
+        Console.WriteLine($"Success: {successMessage}");
+        return 0;
+    }
+}
@@ -21,11 +21,19 @@ namespace IntegrationsJsonGenerator;
 internal class MethodReplacement
 {
     [JsonPropertyName("caller")]
-    public object Caller { get; set; } = new();
+    public Caller Caller { get; set; } = new();
 
     [JsonPropertyName("target")]
     public Target Target { get; set; } = new();
 
     [JsonPropertyName("wrapper")]
     public Wrapper Wrapper { get; set; } = new();
+
+    [JsonPropertyName("integration_kind")]
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public string? IntegrationKind { get; set; }
+
+    [JsonPropertyName("argument_indices")]
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public int[]? ArgumentIndices { get; set; }
 }
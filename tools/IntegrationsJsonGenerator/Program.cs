@@ -119,6 +119,31 @@ bool InheritsFrom(Type type, string baseType)
                 }
     };
 
+    // Only the derived and interface targets are written, the native profiler defaults to the target method.
+    var kind = GetPropertyValue<object>("Kind", attribute).ToString();
+    if (kind != "Default")
+    {
+        methodReplacement.Target.Kind = kind;
+    }
+
+    // Only the MethodMetrics and CallSite integrations are written, the native profiler defaults to CallTarget.
+    var integrationKind = GetPropertyValue<object>("IntegrationKind", attribute).ToString();
+    if (integrationKind != "CallTarget")
+    {
+        methodReplacement.IntegrationKind = integrationKind;
+    }
+
+    // The caller is only used by the CallSite integrations.
+    if (integrationKind == "CallSite")
+    {
+        methodReplacement.Caller.Assembly = GetPropertyValue<string?>("CallerAssemblyName", attribute);
+        methodReplacement.Caller.Type = GetPropertyValue<string?>("CallerTypeName", attribute);
+        methodReplacement.Caller.Method = GetPropertyValue<string?>("CallerMethodName", attribute);
+    }
+
+    // The argument indices are only written when the integration declares them, all the arguments are passed otherwise.
+    methodReplacement.ArgumentIndices = GetPropertyValue<int[]?>("ArgumentIndices", attribute);
+
     var returnTypeName = GetPropertyValue<string>("ReturnTypeName", attribute);
     var parameterTypeNames = GetPropertyValue<string[]>("ParameterTypeNames", attribute);
     methodReplacement.Target.SignatureTypes = new[] { returnTypeName }.Concat(parameterTypeNames).ToArray();
@@ -49,4 +49,8 @@ internal class Target
 
     [JsonPropertyName("maximum_patch")]
     public int MaximumPath { get; set; } = 65535;
+
+    [JsonPropertyName("kind")]
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public string? Kind { get; set; }
 }